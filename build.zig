@@ -77,6 +77,7 @@ const sync_lang_c_sources = [_][]const u8{
     "lib/src/core/core.c",
     "lib/src/core/exceptional.c",
     "lib/src/core/builtin_functions/sort.cpp",
+    "lib/src/core/builtin_functions/parallel_for.cpp",
     "lib/src/core/builtin_traits/iterator.cpp",
     "lib/src/util/simd.cpp",
     "lib/src/mem/os_mem.cpp",
@@ -84,6 +85,7 @@ const sync_lang_c_sources = [_][]const u8{
     "lib/src/mem/protected_allocator.cpp",
     "lib/src/threading/sync_queue.cpp",
     "lib/src/threading/sync_obj_val.cpp",
+    "lib/src/threading/work_stealing_deque.cpp",
     "lib/src/threading/locks/locks_internal.cpp",
     "lib/src/threading/locks/rwlock.cpp",
     "lib/src/threading/generation/gen_pool.cpp",
@@ -103,6 +105,7 @@ const sync_lang_c_sources = [_][]const u8{
     "lib/src/types/option/option.cpp",
     "lib/src/types/result/result.cpp",
     "lib/src/types/task/task.cpp",
+    "lib/src/types/task/task_pool.cpp",
     "lib/src/types/box/box.cpp",
     "lib/src/types/anyerror/anyerror.cpp",
     "lib/src/interpreter/stack/frame.cpp",
@@ -111,6 +114,12 @@ const sync_lang_c_sources = [_][]const u8{
     "lib/src/interpreter/bytecode.cpp",
     "lib/src/interpreter/interpreter.cpp",
     "lib/src/interpreter/function_builder.cpp",
+    "lib/src/interpreter/aot_c.cpp",
+    "lib/src/interpreter/jit.cpp",
+    "lib/src/interpreter/verifier.cpp",
+    "lib/src/interpreter/profiler.cpp",
+    "lib/src/interpreter/sampler.cpp",
+    "lib/src/interpreter/coroutine.cpp",
     "lib/src/compiler/compiler.cpp",
     "lib/src/compiler/tokenizer/token.cpp",
     "lib/src/compiler/tokenizer/tokenizer.cpp",
@@ -128,6 +137,7 @@ const sync_lang_c_sources = [_][]const u8{
     "lib/src/compiler/parser/ast.cpp",
     "lib/src/program/program.cpp",
     "lib/src/program/program_error.cpp",
+    "lib/src/program/program_image.cpp",
     "lib/src/testing/assert_handler.cpp",
 
     "lib/test/test_runner.cpp",
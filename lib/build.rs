@@ -11,6 +11,7 @@ fn main() {
         .file("src/core/core.c")
         .file("src/core/exceptional.c")
         .file("src/core/builtin_functions/sort.cpp")
+        .file("src/core/builtin_functions/parallel_for.cpp")
         .file("src/core/builtin_traits/iterator.cpp")
         .file("src/util/simd.cpp")
         .file("src/mem/allocator.cpp")
@@ -18,6 +19,7 @@ fn main() {
         .file("src/mem/protected_allocator.cpp")
         .file("src/threading/sync_queue.cpp")
         .file("src/threading/sync_obj_val.cpp")
+        .file("src/threading/work_stealing_deque.cpp")
         .file("src/threading/locks/locks_internal.cpp")
         .file("src/threading/locks/rwlock.cpp")
         .file("src/threading/generation/gen_pool.cpp")
@@ -37,6 +39,7 @@ fn main() {
         .file("src/types/option/option.cpp")
         .file("src/types/result/result.cpp")
         .file("src/types/task/task.cpp")
+        .file("src/types/task/task_pool.cpp")
         .file("src/types/box/box.cpp")
         .file("src/types/anyerror/anyerror.cpp")
         .file("src/interpreter/stack/frame.cpp")
@@ -45,6 +48,12 @@ fn main() {
         .file("src/interpreter/bytecode.cpp")
         .file("src/interpreter/interpreter.cpp")
         .file("src/interpreter/function_builder.cpp")
+        .file("src/interpreter/aot_c.cpp")
+        .file("src/interpreter/jit.cpp")
+        .file("src/interpreter/verifier.cpp")
+        .file("src/interpreter/profiler.cpp")
+        .file("src/interpreter/sampler.cpp")
+        .file("src/interpreter/coroutine.cpp")
         .file("src/compiler/compiler.cpp")
         .file("src/compiler/tokenizer/token.cpp")
         .file("src/compiler/tokenizer/tokenizer.cpp")
@@ -62,6 +71,7 @@ fn main() {
         .file("src/compiler/parser/ast.cpp")
         .file("src/program/program.cpp")
         .file("src/program/program_error.cpp")
+        .file("src/program/program_image.cpp")
         .file("src/testing/assert_handler.cpp")
         .file("test/test_runner.cpp")
         .compile("SyncLib");
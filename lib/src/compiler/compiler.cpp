@@ -1,11 +1,18 @@
 #include "compiler.hpp"
 #include "../core/core_internal.h"
+#include "../interpreter/call_site_cache.hpp"
+#include "../interpreter/function_builder.hpp"
+#include "../interpreter/jit.hpp"
+#include "../interpreter/profiler.hpp"
+#include "../interpreter/stack/stack.hpp"
+#include "../interpreter/verifier.hpp"
 #include "../program/program_error.hpp"
 #include "../program/program_internal.hpp"
 #include "../types/array/dynamic_array.hpp"
 #include "../types/hash/map.hpp"
 #include "../types/string/string.hpp"
 #include "graph/module_dependency_graph.hpp"
+#include "lazy_function.hpp"
 #include "parser/base_nodes.hpp"
 #include "parser/parser.hpp"
 #include "source_tree/source_tree.hpp"
@@ -13,6 +20,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 using namespace sy;
 namespace fs = std::filesystem;
@@ -24,6 +32,7 @@ struct CompilerImpl {
     Allocator alloc;
     MapUnmanaged<StringSlice, DynArrayUnmanaged<SemVer>> versions;
     MapUnmanaged<ModuleVersion, Module*> modules;
+    bool lazyFunctions = false;
 };
 
 struct ModuleImpl {
@@ -193,6 +202,11 @@ Result<Module*, AllocErr> sy::Compiler::addOrGetModule(StringSlice name, SemVer
     return mod;
 }
 
+void sy::Compiler::setLazyFunctionCompilation(bool lazy) noexcept {
+    CompilerImpl* self = reinterpret_cast<CompilerImpl*>(this->inner_);
+    self->lazyFunctions = lazy;
+}
+
 Result<DynArray<const Module*>, AllocErr> sy::Compiler::allModules() const noexcept {
     const CompilerImpl* self = reinterpret_cast<const CompilerImpl*>(this->inner_);
     DynArray<const Module*> modules(self->alloc);
@@ -219,10 +233,193 @@ getCompileOrder(Allocator alloc, const MapUnmanaged<ModuleVersion, Module*>& mod
     return res.takeValue();
 }
 
+/// Writes the return and argument types of `builder` into `function`.
+static Result<void, CompileError> setFunctionSignature(RawFunction* function,
+                                                       const FunctionBuilder& builder,
+                                                       Allocator protAlloc) noexcept {
+    function->returnType = builder.retType.hasValue() ? builder.retType.value() : nullptr;
+    function->argsTypes = nullptr;
+    function->argsLen = static_cast<uint16_t>(builder.args.len());
+    if (builder.args.len() == 0) {
+        return {};
+    }
+
+    auto argsRes = protAlloc.allocArray<const Type*>(builder.args.len());
+    if (argsRes.hasErr()) {
+        return Error(CompileError::OutOfMemory);
+    }
+    for (size_t i = 0; i < builder.args.len(); i++) {
+        argsRes.value()[i] = builder.args[i];
+    }
+    function->argsTypes = argsRes.value();
+    return {};
+}
+
+/// Writes the bytecode, frame size, and unwind slots of `builder` into the script info of
+/// `function`, with their memory in `protAlloc`. Call site caches and JIT state are written to
+/// while running, so live on the heap.
+static Result<void, CompileError> emitScriptFunction(const FunctionBuilder& builder,
+                                                     const RawFunction* function,
+                                                     Allocator protAlloc) noexcept {
+    InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<InterpreterFunctionScriptInfo*>(function->fptr);
+
+    // Frames are pushed aligned to their function, so must span a multiple of its alignment.
+    const size_t alignSlots =
+        function->alignment > sizeof(uint64_t) ? function->alignment / sizeof(uint64_t) : 1;
+    const size_t frameLength =
+        ((builder.stackSpaceRequired + alignSlots - 1) / alignSlots) * alignSlots;
+    sy_assert(frameLength <= Stack::MAX_FRAME_LEN,
+              "Function frame exceeds the maximum frame length");
+
+    auto bytecodeRes = protAlloc.allocArray<Bytecode>(builder.bytecode.len());
+    if (bytecodeRes.hasErr()) {
+        return Error(CompileError::OutOfMemory);
+    }
+    memcpy(bytecodeRes.value(), builder.bytecode.data(), builder.bytecode.len() * sizeof(Bytecode));
+
+    int16_t* unwindSlots = nullptr;
+    if (builder.unwindSlots.len() > 0) {
+        auto unwindRes = protAlloc.allocArray<int16_t>(builder.unwindSlots.len());
+        if (unwindRes.hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+        unwindSlots = unwindRes.value();
+        memcpy(unwindSlots, builder.unwindSlots.data(),
+               builder.unwindSlots.len() * sizeof(int16_t));
+    }
+
+    CallSiteCache* callSiteCaches = nullptr;
+    if (builder.callSiteCacheCount > 0) {
+        Allocator cacheAlloc{};
+        auto cachesRes = cacheAlloc.allocArray<CallSiteCache>(builder.callSiteCacheCount);
+        if (cachesRes.hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+        callSiteCaches = cachesRes.value();
+        for (uint32_t i = 0; i < builder.callSiteCacheCount; i++) {
+            new (&callSiteCaches[i]) CallSiteCache();
+        }
+    }
+
+    // Also holds code compiled ahead of time, so exists even if the JIT is unsupported.
+    JitFunctionState* jit = nullptr;
+    {
+        Allocator jitAlloc{};
+        auto jitRes = jitAlloc.allocObject<JitFunctionState>();
+        if (jitRes.hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+        jit = new (jitRes.value()) JitFunctionState();
+    }
+
+    scriptInfo->stackSpaceRequired = static_cast<uint16_t>(frameLength);
+    scriptInfo->bytecodeCount = builder.bytecode.len();
+    scriptInfo->bytecode = bytecodeRes.value();
+    scriptInfo->unwindSlots = unwindSlots;
+    scriptInfo->unwindLen = static_cast<uint16_t>(builder.unwindSlots.len());
+    scriptInfo->callSiteCaches = callSiteCaches;
+    scriptInfo->callSiteCachesLen = builder.callSiteCacheCount;
+    scriptInfo->jit = jit;
+    return {};
+}
+
+/// Runs `verifyScriptFunction(...)` on `function`, reporting it as within `moduleName` if it's
+/// malformed.
+static Result<void, CompileError> verifyFunctionBytecode(StringSlice moduleName,
+                                                         const RawFunction* function,
+                                                         CompileErrorReporter errReporter,
+                                                         void* errReporterArg) noexcept {
+    auto verifyRes = verifyScriptFunction(function);
+    if (verifyRes.hasErr()) {
+        const BytecodeVerifyError err = verifyRes.takeErr();
+        if (err.kind == BytecodeVerifyErrorKind::OutOfMemory) {
+            return Error(CompileError::OutOfMemory);
+        }
+        SourceFileLocation location{};
+        location.moduleName = moduleName;
+        errReporter(CompileError::BytecodeVerification, location, function->qualifiedName,
+                    errReporterArg);
+        return Error(CompileError::BytecodeVerification);
+    }
+    return {};
+}
+
+/// Writes the names, signature, and script info of `func` as the function at `index` of `module`.
+/// Lazily compiled functions get a stub script info, whereas the bodies of all others are compiled
+/// once every function of the module has an entry.
+static Result<void, CompileError> addFunctionEntry(ProgramModuleInternal* module, size_t index,
+                                                   const IFunctionDefinition* func,
+                                                   ProgramInternal* program, bool lazyFunctions,
+                                                   Allocator tempAlloc) noexcept {
+    Allocator protAlloc = program->protAlloc.asAllocator();
+    auto unqualifiedRes = String::init(func->unqualifiedName(), protAlloc);
+    if (unqualifiedRes.hasErr())
+        return Error(CompileError::OutOfMemory);
+    auto qualifiedRes = String::init(func->qualifiedName(), protAlloc);
+    if (qualifiedRes.hasErr())
+        return Error(CompileError::OutOfMemory);
+
+    new (&module->allFunctionNames[index]) String(std::move(unqualifiedRes.takeValue()));
+    new (&module->allFunctionQualifiedNames[index]) String(std::move(qualifiedRes.takeValue()));
+
+    InterpreterFunctionScriptInfo* scriptInfo =
+        new (&module->allFunctionScriptInfo[index]) InterpreterFunctionScriptInfo();
+
+    RawFunction _emptyFunc{};
+    RawFunction* function = &module->allFunctions[index];
+    *function = _emptyFunc;
+    function->name = module->allFunctionNames[index].asSlice();
+    function->qualifiedName = module->allFunctionQualifiedNames[index].asSlice();
+    function->tag = FunctionType::Script;
+    function->fptr = scriptInfo;
+
+    // Callers only need the signature, which is all lazily compiled functions get until they're
+    // reached.
+    FunctionBuilder signature(tempAlloc);
+    if (auto res = func->compileSignature(&signature); res.hasErr()) {
+        return Error(res.takeErr());
+    }
+    if (auto res = setFunctionSignature(function, signature, protAlloc); res.hasErr()) {
+        return Error(res.takeErr());
+    }
+
+    if (lazyFunctions) {
+        Allocator lazyAlloc{};
+        auto lazyRes = lazyAlloc.allocObject<LazyFunction>();
+        if (lazyRes.hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+        scriptInfo->lazy = new (lazyRes.value())
+            LazyFunction(func, program, module->name.asSlice(), function);
+    }
+    return {};
+}
+
+/// Parsed files of a module, keyed by their source. Files are owned by the map until they're
+/// taken by a program whose functions are compiled lazily.
+struct ModuleAsts {
+    Allocator alloc;
+    MapUnmanaged<const SourceTreeNode*, FileAst*> files{};
+
+    explicit ModuleAsts(Allocator inAlloc) : alloc(inAlloc) {}
+
+    ~ModuleAsts() noexcept {
+        for (auto entry : this->files) {
+            if (entry.value != nullptr) {
+                entry.value->~FileAst();
+                this->alloc.freeObject(entry.value);
+            }
+        }
+        this->files.destroy(this->alloc);
+    }
+};
+
 static Result<ProgramModuleInternal*, CompileError>
-compileModule(const ModuleImpl* mod, Allocator protAlloc, Allocator tempAlloc,
-              CompileErrorReporter errReporter, void* errReporterArg) {
-    MapUnmanaged<const SourceTreeNode*, FileAst> asts;
+compileModule(const ModuleImpl* mod, ProgramInternal* program, bool lazyFunctions,
+              Allocator tempAlloc, CompileErrorReporter errReporter, void* errReporterArg) {
+    Allocator protAlloc = program->protAlloc.asAllocator();
+    ModuleAsts asts(tempAlloc);
     DynArray<const SourceTreeNode*> nodesToProcess(tempAlloc);
     (void)nodesToProcess;
 
@@ -233,7 +430,14 @@ compileModule(const ModuleImpl* mod, Allocator protAlloc, Allocator tempAlloc,
         }
         FileAst ast = result.takeValue();
         sy_assert(ast.imports.len() == 0, "Imports not yet supported");
-        if (asts.insert(tempAlloc, mod->rootFile, std::move(ast)).hasErr()) {
+        auto astRes = tempAlloc.allocObject<FileAst>();
+        if (astRes.hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+        FileAst* heapAst = new (astRes.value()) FileAst(std::move(ast));
+        if (asts.files.insert(tempAlloc, mod->rootFile, heapAst).hasErr()) {
+            heapAst->~FileAst();
+            tempAlloc.freeObject(heapAst);
             return Error(CompileError::OutOfMemory);
         }
         // TODO importing
@@ -245,9 +449,9 @@ compileModule(const ModuleImpl* mod, Allocator protAlloc, Allocator tempAlloc,
     { // initialize module memory with protected allocator
         size_t functionCount = 0;
         size_t structCount = 0;
-        for (const auto astEntry : asts) {
-            functionCount += astEntry.value.nonGenericFunctions.len();
-            structCount += astEntry.value.nonGenericStructs.len();
+        for (const auto astEntry : asts.files) {
+            functionCount += astEntry.value->nonGenericFunctions.len();
+            structCount += astEntry.value->nonGenericStructs.len();
         }
 
         auto res = ProgramModuleInternal::init(protAlloc, mod->name.asSlice(), mod->version,
@@ -260,27 +464,13 @@ compileModule(const ModuleImpl* mod, Allocator protAlloc, Allocator tempAlloc,
 
     { // add entries for all functions so that recursion can work, and so that function names work
         size_t iter = 0;
-        for (const auto astEntry : asts) {
-            for (const IFunctionDefinition* func : astEntry.value.nonGenericFunctions) {
-                auto unqualifiedRes = String::init(func->unqualifiedName(), protAlloc);
-                if (unqualifiedRes.hasErr())
-                    return Error(CompileError::OutOfMemory);
-                auto qualifiedRes = String::init(func->qualifiedName(), protAlloc);
-                if (qualifiedRes.hasErr())
-                    return Error(CompileError::OutOfMemory);
-
-                new (&moduleInternal->allFunctionNames[iter])
-                    String(std::move(unqualifiedRes.takeValue()));
-                new (&moduleInternal->allFunctionQualifiedNames[iter])
-                    String(std::move(qualifiedRes.takeValue()));
-
-                RawFunction _emptyFunc{};
-                moduleInternal->allFunctions[iter] = _emptyFunc;
-                moduleInternal->allFunctions[iter].name =
-                    moduleInternal->allFunctionNames[iter].asSlice();
-                moduleInternal->allFunctions[iter].qualifiedName =
-                    moduleInternal->allFunctionQualifiedNames[iter].asSlice();
-
+        for (const auto astEntry : asts.files) {
+            for (const IFunctionDefinition* func : astEntry.value->nonGenericFunctions) {
+                if (auto res = addFunctionEntry(moduleInternal, iter, func, program, lazyFunctions,
+                                                tempAlloc);
+                    res.hasErr()) {
+                    return Error(res.takeErr());
+                }
                 iter += 1;
             }
         }
@@ -288,17 +478,105 @@ compileModule(const ModuleImpl* mod, Allocator protAlloc, Allocator tempAlloc,
         sy_assert(iter == moduleInternal->allFunctionsLen, "Iterator should match");
     }
 
+    if (lazyFunctions) {
+        // Definitions are compiled whenever their functions are first reached, so the program
+        // takes the files owning them.
+        Allocator lazyAlloc{};
+        for (auto astEntry : asts.files) {
+            if (program->lazyFiles.push(astEntry.value, lazyAlloc).hasErr()) {
+                return Error(CompileError::OutOfMemory);
+            }
+            astEntry.value = nullptr;
+        }
+    } else {
+        size_t iter = 0;
+        for (const auto astEntry : asts.files) {
+            for (const IFunctionDefinition* func : astEntry.value->nonGenericFunctions) {
+                auto builderRes = func->compile();
+                if (builderRes.hasErr()) {
+                    return Error(builderRes.takeErr());
+                }
+                if (auto res = emitScriptFunction(builderRes.value(),
+                                                  &moduleInternal->allFunctions[iter], protAlloc);
+                    res.hasErr()) {
+                    return Error(res.takeErr());
+                }
+                iter += 1;
+            }
+        }
+    }
+
     // TODO same for structs
 
     return moduleInternal;
 }
 
+/// Runs `verifyScriptFunction(...)` on every script function of `module`, so that malformed
+/// bytecode is rejected once, before anything within the program can execute. Lazily compiled
+/// functions are verified once they're compiled instead.
+static Result<void, CompileError> verifyModuleBytecode(const ProgramModuleInternal* module,
+                                                       CompileErrorReporter errReporter,
+                                                       void* errReporterArg) noexcept {
+    for (size_t i = 0; i < module->allFunctionsLen; i++) {
+        const RawFunction* function = &module->allFunctions[i];
+        if (function->tag != FunctionType::Script || function->fptr == nullptr) {
+            continue;
+        }
+        const InterpreterFunctionScriptInfo* scriptInfo =
+            reinterpret_cast<const InterpreterFunctionScriptInfo*>(function->fptr);
+        if (scriptInfo->lazy != nullptr) {
+            continue;
+        }
+
+        if (auto res = verifyFunctionBytecode(module->name.asSlice(), function, errReporter,
+                                              errReporterArg);
+            res.hasErr()) {
+            return Error(res.takeErr());
+        }
+    }
+    return {};
+}
+
+void sy::LazyFunction::compile() noexcept {
+    uint32_t expected = PENDING;
+    if (this->state_.compare_exchange_strong(expected, COMPILING, std::memory_order_acquire)) {
+        Result<void, CompileError> res = [this]() -> Result<void, CompileError> {
+            auto builderRes = this->definition_->compile();
+            if (builderRes.hasErr()) {
+                return Error(builderRes.takeErr());
+            }
+            return emitScriptFunction(builderRes.value(), this->function_,
+                                      this->program_->protAlloc.asAllocator());
+        }();
+        if (res.hasErr()) {
+            SourceFileLocation location{};
+            location.moduleName = this->moduleName_;
+            this->program_->errReporter(res.err(), location, this->function_->qualifiedName,
+                                        this->program_->errReporterArg);
+        }
+        sy_assert_release(res.hasValue(), "Lazily compiled function failed to compile");
+        sy_assert_release(verifyFunctionBytecode(this->moduleName_, this->function_,
+                                                 this->program_->errReporter,
+                                                 this->program_->errReporterArg)
+                              .hasValue(),
+                          "Lazily compiled function failed bytecode verification");
+
+        this->state_.store(COMPILED, std::memory_order_release);
+        return;
+    }
+
+    // Another thread is compiling, and the bytecode is needed either way.
+    while (this->state_.load(std::memory_order_acquire) != COMPILED) {
+        std::this_thread::yield();
+    }
+}
+
 static_assert(sizeof(Module) == sizeof(ModuleImpl*));
 static_assert(sizeof(ProgramModule) == sizeof(ProgramModuleInternal*));
 
 static Result<void, CompileError>
 compileModules(ProgramInternal* programInternal, Allocator tempAlloc,
-               const MapUnmanaged<ModuleVersion, Module*>& modules,
+               const MapUnmanaged<ModuleVersion, Module*>& modules, bool lazyFunctions,
                CompileErrorReporter errReporter, void* errReporterArg) noexcept {
 
     { // allocate memory for all modules
@@ -322,13 +600,22 @@ compileModules(ProgramInternal* programInternal, Allocator tempAlloc,
     for (const Module* mod : compileOrder) {
         // compile module
         const ModuleImpl* asImpl = *reinterpret_cast<const ModuleImpl* const*>(mod);
-        auto moduleCompileResult = compileModule(asImpl, programInternal->protAlloc.asAllocator(),
-                                                 tempAlloc, errReporter, errReporterArg);
+        auto moduleCompileResult = compileModule(asImpl, programInternal, lazyFunctions, tempAlloc,
+                                                 errReporter, errReporterArg);
         if (moduleCompileResult.hasErr()) {
             return Error(moduleCompileResult.takeErr());
         }
 
         ProgramModuleInternal* innerMem = moduleCompileResult.takeValue();
+        if (auto verifyRes = verifyModuleBytecode(innerMem, errReporter, errReporterArg);
+            verifyRes.hasErr()) {
+            return Error(verifyRes.takeErr());
+        }
+        if (auto indexRes = innerMem->buildLookupIndex(programInternal->protAlloc.asAllocator());
+            indexRes.hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+
         ProgramModule* programModule = &programInternal->allModules[index];
         ProgramModuleInternal** programModuleInternal =
             reinterpret_cast<ProgramModuleInternal**>(programModule);
@@ -360,10 +647,20 @@ Result<Program, CompileError> sy::Compiler::compile(CompileErrorReporter errRepo
         programInternal->errReporter = errReporter == nullptr ? defaultErrReporter : errReporter;
         programInternal->errReporterArg = errReporterArg;
     }
+#if SY_INTERPRETER_PROFILER
+    { // profiles are written while running, so can't live in protected memory
+        Allocator profileAlloc{};
+        auto profileRes = profileAlloc.allocObject<ProgramProfile>();
+        if (profileRes.hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+        programInternal->profile = new (profileRes.value()) ProgramProfile();
+    }
+#endif
 
     const CompilerImpl* self = reinterpret_cast<const CompilerImpl*>(this->inner_);
-    if (auto compErr = compileModules(programInternal, self->alloc, self->modules, errReporter,
-                                      errReporterArg);
+    if (auto compErr = compileModules(programInternal, self->alloc, self->modules,
+                                      self->lazyFunctions, errReporter, errReporterArg);
         compErr.hasErr()) {
         return Error(compErr.takeErr());
     }
@@ -606,6 +903,9 @@ Result<Module*, AllocErr> Module::create(Allocator& alloc, StringSlice inName,
 #if SYNC_LIB_WITH_TESTS
 
 #include "../doctest.h"
+#include "../interpreter/bytecode.hpp"
+#include "../types/type_info.hpp"
+#include <atomic>
 
 TEST_CASE("[Compiler] empty compiler") {
     Compiler c = Compiler::create().takeValue();
@@ -627,4 +927,160 @@ TEST_CASE("[ModuleImpl] addOrGetModule empty module") {
     CHECK_EQ(impl.rootFile->elem.syncSourceFile.value().asSlice(), "a");
 }
 
+namespace {
+/// Function definition with a hand written body, counting how many times it's compiled.
+class CountingFunctionDefinition final : public IFunctionDefinition {
+  public:
+    CountingFunctionDefinition() : IFunctionDefinition(Allocator()) {}
+
+    Result<void, CompileError> init(ParseInfo*, Scope*) noexcept override { return {}; }
+
+    Result<void, CompileError> compileSignature(FunctionBuilder* builder) const noexcept override {
+        builder->retType = Option<const Type*>(Reflect<int32_t>::get());
+        return {};
+    }
+
+    // return 7;
+    Result<FunctionBuilder, CompileError> compile() const noexcept override {
+        this->compileCount.fetch_add(1);
+        FunctionBuilder builder(this->alloc());
+        (void)this->compileSignature(&builder);
+
+        operators::LoadImmediateScalarSetType load{};
+        load.reserveOpcode = static_cast<uint64_t>(operators::LoadImmediateScalarSetType::OPCODE);
+        load.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+        load.dst = 0;
+        load.immediate = 7;
+        operators::ReturnValue ret{};
+        ret.reserveOpcode = static_cast<uint64_t>(operators::ReturnValue::OPCODE);
+        ret.src = 0;
+        const Bytecode bytecode[] = {Bytecode(load), Bytecode(ret)};
+        if (builder.pushBytecode(bytecode, 2).hasErr()) {
+            return Error(CompileError::OutOfMemory);
+        }
+        builder.stackSpaceRequired = 1;
+        return builder;
+    }
+
+    StringSlice unqualifiedName() const noexcept override { return "seven"; }
+
+    StringSlice qualifiedName() const noexcept override { return "math.seven"; }
+
+    mutable std::atomic<int> compileCount{0};
+};
+} // namespace
+
+TEST_CASE("[Compiler] lazily compiled functions are compiled when first looked up") {
+    CountingFunctionDefinition definition;
+    ProgramInternal program{};
+    program.errReporter = defaultErrReporter;
+    ProgramModuleInternal* module =
+        ProgramModuleInternal::init(program.protAlloc.asAllocator(), "math", SemVer{}, 1, 0)
+            .value();
+    REQUIRE(addFunctionEntry(module, 0, &definition, &program, true, Allocator()));
+    REQUIRE(module->buildLookupIndex(program.protAlloc.asAllocator()));
+
+    const InterpreterFunctionScriptInfo& scriptInfo = module->allFunctionScriptInfo[0];
+    REQUIRE_NE(scriptInfo.lazy, nullptr);
+    CHECK_FALSE(scriptInfo.lazy->isCompiled());
+    CHECK_EQ(scriptInfo.bytecode, nullptr);
+    CHECK_EQ(module->allFunctions[0].returnType, Reflect<int32_t>::get());
+    CHECK_EQ(definition.compileCount.load(), 0);
+
+    auto found = module->getFunctionByQualifiedName("math.seven");
+    REQUIRE(found.hasValue());
+    CHECK(scriptInfo.lazy->isCompiled());
+    CHECK_EQ(scriptInfo.bytecodeCount, 2);
+    CHECK_EQ(definition.compileCount.load(), 1);
+
+    int32_t result = 0;
+    REQUIRE(found.value()->startCall().call(&result));
+    CHECK_EQ(result, 7);
+    CHECK_EQ(definition.compileCount.load(), 1);
+
+    scriptInfo.lazy->~LazyFunction();
+    Allocator().freeObject(scriptInfo.lazy);
+}
+
+TEST_CASE("[Compiler] lazily compiled functions are compiled once by concurrent callers") {
+    CountingFunctionDefinition definition;
+    ProgramInternal program{};
+    program.errReporter = defaultErrReporter;
+    ProgramModuleInternal* module =
+        ProgramModuleInternal::init(program.protAlloc.asAllocator(), "math", SemVer{}, 1, 0)
+            .value();
+    REQUIRE(addFunctionEntry(module, 0, &definition, &program, true, Allocator()));
+    const RawFunction* function = &module->allFunctions[0];
+
+    constexpr int THREADS = 8;
+    std::atomic<int> sum{0};
+    std::thread threads[THREADS];
+    for (std::thread& thread : threads) {
+        thread = std::thread([function, &sum]() {
+            int32_t result = 0;
+            if (function->startCall().call(&result).hasValue()) {
+                sum.fetch_add(result);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    CHECK_EQ(sum.load(), 7 * THREADS);
+    CHECK_EQ(definition.compileCount.load(), 1);
+
+    const InterpreterFunctionScriptInfo& scriptInfo = module->allFunctionScriptInfo[0];
+    scriptInfo.lazy->~LazyFunction();
+    Allocator().freeObject(scriptInfo.lazy);
+}
+
+
+TEST_CASE("[Compiler] compiled functions run fused superinstructions") {
+    ModuleImpl impl{Allocator()};
+    REQUIRE(impl.setRootFileFromString("/example.sync", "fn yes() bool { return true; }"));
+    ProgramInternal program{};
+    program.errReporter = defaultErrReporter;
+    auto moduleRes =
+        compileModule(&impl, &program, false, Allocator(), defaultErrReporter, nullptr);
+    REQUIRE(moduleRes);
+    const ProgramModuleInternal* module = moduleRes.value();
+    REQUIRE_EQ(module->allFunctionsLen, 1);
+    CHECK(verifyModuleBytecode(module, defaultErrReporter, nullptr));
+
+    // `true` loads and types the same slot, which fuse into one instruction.
+    const InterpreterFunctionScriptInfo& scriptInfo = module->allFunctionScriptInfo[0];
+    REQUIRE_EQ(scriptInfo.bytecodeCount, 2);
+    CHECK_EQ(scriptInfo.bytecode[0].getOpcode(), OpCode::LoadImmediateScalarSetType);
+    CHECK_EQ(scriptInfo.bytecode[1].getOpcode(), OpCode::ReturnValue);
+
+    bool result = false;
+    REQUIRE(module->allFunctions[0].startCall().call(&result));
+    CHECK(result);
+}
+
+#if SY_JIT_SUPPORTED
+TEST_CASE("[Compiler] compiled functions are JIT compiled once hot") {
+    ModuleImpl impl{Allocator()};
+    REQUIRE(impl.setRootFileFromString("/example.sync", "fn no() bool { return false; }"));
+    ProgramInternal program{};
+    program.errReporter = defaultErrReporter;
+    auto moduleRes =
+        compileModule(&impl, &program, false, Allocator(), defaultErrReporter, nullptr);
+    REQUIRE(moduleRes);
+    const ProgramModuleInternal* module = moduleRes.value();
+    CHECK(verifyModuleBytecode(module, defaultErrReporter, nullptr));
+
+    JitFunctionState* jit = module->allFunctionScriptInfo[0].jit;
+    REQUIRE_NE(jit, nullptr);
+    CHECK_EQ(jit->entry(), nullptr);
+
+    for (int i = 0; i <= SYNC_JIT_CALL_THRESHOLD; i++) {
+        bool result = true;
+        REQUIRE(module->allFunctions[0].startCall().call(&result));
+        CHECK_FALSE(result);
+    }
+    CHECK_NE(jit->entry(), nullptr);
+}
+#endif // SY_JIT_SUPPORTED
+
 #endif // SYNC_LIB_WITH_TESTS
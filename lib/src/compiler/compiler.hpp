@@ -50,6 +50,15 @@ class SY_API Compiler final {
 
     [[nodiscard]] Result<DynArray<const Module*>, AllocErr> allModules() const noexcept;
 
+    /// @brief Sets whether function bodies are compiled when the program is compiled, or when
+    /// each function is first reached. Lazily compiled functions are still parsed and type checked
+    /// by `compile(...)`, but their bytecode is generated and verified the first time they're
+    /// looked up by name or called, which shortens compiling programs that only use a few of
+    /// their functions. Code generation and verification failures of lazily compiled functions
+    /// abort the process after being reported, rather than failing `compile(...)`. Disabled by
+    /// default.
+    void setLazyFunctionCompilation(bool lazy) noexcept;
+
     [[nodiscard]] Result<Program, CompileError> compile(CompileErrorReporter errReporter,
                                                         void* errReporterArg) const noexcept;
 
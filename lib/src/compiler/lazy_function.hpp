@@ -0,0 +1,76 @@
+#pragma once
+#ifndef SY_COMPILER_LAZY_FUNCTION_HPP_
+#define SY_COMPILER_LAZY_FUNCTION_HPP_
+
+#include "../core/core.h"
+#include "../program/program_internal.hpp"
+#include "../types/function/function.hpp"
+#include <atomic>
+
+namespace sy {
+class IFunctionDefinition;
+
+/// Script function of a program compiled with `Compiler::setLazyFunctionCompilation(true)`, whose
+/// body has been parsed and type checked, but not yet turned into bytecode. Until then, its script
+/// info is a stub with no bytecode, and a frame size of zero. The body is compiled the first time
+/// the function is looked up by name, or called, and written into the stub.
+class LazyFunction final {
+  public:
+    LazyFunction() = default;
+
+    LazyFunction(const LazyFunction& other) = delete;
+
+    LazyFunction& operator=(const LazyFunction& other) = delete;
+
+    LazyFunction(const IFunctionDefinition* definition, ProgramInternal* program,
+                 StringSlice moduleName, RawFunction* function) noexcept
+        : definition_(definition), program_(program), moduleName_(moduleName),
+          function_(function) {}
+
+    /// Compiles and verifies the function's bytecode, if not already compiled. Thread safe, with
+    /// concurrent callers waiting for the first to finish.
+    /// # Release Asserts
+    /// Code generation and verification must succeed. Anything they fail on, other than running out
+    /// of memory, is a compiler bug rather than an error in the source, as the body was already
+    /// type checked. Failures are passed to the program's error reporter before aborting.
+    void ensureCompiled() noexcept {
+        if (this->state_.load(std::memory_order_acquire) != COMPILED) {
+            this->compile();
+        }
+    }
+
+    [[nodiscard]] bool isCompiled() const noexcept {
+        return this->state_.load(std::memory_order_acquire) == COMPILED;
+    }
+
+  private:
+    void compile() noexcept;
+
+    static constexpr uint32_t PENDING = 0;
+    static constexpr uint32_t COMPILING = 1;
+    static constexpr uint32_t COMPILED = 2;
+
+    std::atomic<uint32_t> state_{PENDING};
+    /// Kept alive by `ProgramInternal::lazyFiles`.
+    const IFunctionDefinition* definition_ = nullptr;
+    ProgramInternal* program_ = nullptr;
+    StringSlice moduleName_{};
+    RawFunction* function_ = nullptr;
+};
+
+/// Compiles `function` if it's a lazily compiled script function that hasn't been compiled yet.
+/// Must be called before reading anything of the script info of a function that may be lazy, other
+/// than `lazy` itself.
+inline void ensureFunctionCompiled(const RawFunction* function) noexcept {
+    if (function->tag != FunctionType::Script) {
+        return;
+    }
+    const InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<const InterpreterFunctionScriptInfo*>(function->fptr);
+    if (scriptInfo != nullptr && scriptInfo->lazy != nullptr) {
+        scriptInfo->lazy->ensureCompiled();
+    }
+}
+} // namespace sy
+
+#endif // SY_COMPILER_LAZY_FUNCTION_HPP_
@@ -222,6 +222,15 @@ Result<void, CompileError> sy::FunctionDefinitionNode::init(ParseInfo* parseInfo
             }
             this->retType = Option<TypeResolutionInfo>(typeParseRes.takeValue());
             // step forward
+            auto braceResult = parseInfo->tokenIter.next();
+            if (braceResult.has_value() == false) {
+                return makeEndOfFileError();
+            }
+            if (braceResult.value().tag() != TokenType::LeftBraceSymbol) {
+                parseInfo->reportErr(CompileError::CompileFunctionSignature,
+                                     braceResult.value().location(), "Expected { symbol");
+                return Error(CompileError::CompileFunctionSignature);
+            }
             if (parseInfo->tokenIter.next().has_value() == false) {
                 return makeEndOfFileError();
             }
@@ -241,31 +250,38 @@ Result<void, CompileError> sy::FunctionDefinitionNode::init(ParseInfo* parseInfo
         this->scope->isSync = false;
         this->scope->parent = outerScope;
 
-        auto statementRes = parseStatement(parseInfo, &this->localVariables, this->scope);
-        if (statementRes.hasErr()) {
-            return Error(statementRes.takeErr());
-        }
-        auto statement = statementRes.takeValue();
-        if (statement.hasValue()) {
+        // Each statement ends on its own last token, so step past it until the closing }.
+        while (true) {
+            auto statementRes = parseStatement(parseInfo, &this->localVariables, this->scope);
+            if (statementRes.hasErr()) {
+                return Error(statementRes.takeErr());
+            }
+            auto statement = statementRes.takeValue();
+            if (statement.hasValue() == false) {
+                break;
+            }
             if (this->statements.push(statement.value()).hasErr()) {
                 parseInfo->reportErr(CompileError::OutOfMemory,
                                      parseInfo->tokenIter.current().location(), "Out of memory");
                 return Error(CompileError::OutOfMemory);
             }
+            if (parseInfo->tokenIter.next().has_value() == false) {
+                return makeEndOfFileError();
+            }
         }
     }
 
     return {};
 }
 
-Result<FunctionBuilder, CompileError> sy::FunctionDefinitionNode::compile() const noexcept {
-    FunctionBuilder builder(this->alloc());
+Result<void, CompileError>
+sy::FunctionDefinitionNode::compileSignature(FunctionBuilder* builder) const noexcept {
     if (this->retType.hasValue()) {
         const auto& optKnown = this->retType.value().knownType;
         if (optKnown.hasValue() == false) {
             return Error(CompileError::CompileUnknownType);
         }
-        builder.retType = optKnown;
+        builder->retType = optKnown;
     }
 
     for (const auto& arg : this->args) {
@@ -273,10 +289,18 @@ Result<FunctionBuilder, CompileError> sy::FunctionDefinitionNode::compile() cons
         if (optKnown.hasValue() == false) {
             return Error(CompileError::CompileUnknownType);
         }
-        if (auto res = builder.addArg(optKnown.value()); res.hasErr()) {
+        if (auto res = builder->addArg(optKnown.value()); res.hasErr()) {
             return Error(CompileError::OutOfMemory);
         }
     }
+    return {};
+}
+
+Result<FunctionBuilder, CompileError> sy::FunctionDefinitionNode::compile() const noexcept {
+    FunctionBuilder builder(this->alloc());
+    if (auto res = this->compileSignature(&builder); res.hasErr()) {
+        return Error(res.takeErr());
+    }
 
     for (const auto& statement : this->statements) {
         if (auto res = statement->compileStatement(&builder); res.hasErr()) {
@@ -284,6 +308,22 @@ Result<FunctionBuilder, CompileError> sy::FunctionDefinitionNode::compile() cons
         }
     }
 
+    // Slots of operations whose operands can't be decoded are at most the index of a variable.
+    bool allKnown = true;
+    builder.stackSpaceRequired = builder.slotExtent(allKnown);
+    if (!allKnown) {
+        const size_t variables = this->args.len() + this->localVariables.len();
+        builder.stackSpaceRequired =
+            variables > builder.stackSpaceRequired ? variables : builder.stackSpaceRequired;
+    }
+
+    if (auto res = builder.coalesceSlots(); res.hasErr()) {
+        return Error(CompileError::OutOfMemory);
+    }
+    if (auto res = builder.fuseSuperinstructions(); res.hasErr()) {
+        return Error(CompileError::OutOfMemory);
+    }
+
     return builder;
 }
 
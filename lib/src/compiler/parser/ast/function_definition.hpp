@@ -21,6 +21,9 @@ class FunctionDefinitionNode : public IFunctionDefinition {
 
     virtual Result<FunctionBuilder, CompileError> compile() const noexcept override;
 
+    virtual Result<void, CompileError>
+    compileSignature(FunctionBuilder* builder) const noexcept override;
+
     virtual StringSlice unqualifiedName() const noexcept override { return functionName; }
 
     virtual StringSlice qualifiedName() const noexcept override {
@@ -36,6 +36,16 @@ sy::ReturnNode::init(ParseInfo* parseInfo, DynArray<StackVariable>* variables, S
     }
 
     this->retValue = expressionResult.takeValue();
+
+    auto semicolonResult = parseInfo->tokenIter.next();
+    if (semicolonResult.has_value() == false) {
+        return makeEndOfFileError();
+    }
+    if (semicolonResult.value().tag() != TokenType::SemicolonSymbol) {
+        parseInfo->reportErr(CompileError::CompileFunctionStatement,
+                             semicolonResult.value().location(), "Expected ; symbol");
+        return Error(CompileError::CompileFunctionStatement);
+    }
     return {};
 }
 
@@ -48,11 +58,18 @@ sy::ReturnNode::compileStatement(FunctionBuilder* builder) const noexcept {
             return Error(CompileError::OutOfMemory);
         }
     } else {
+        const size_t expressionStart = builder->bytecode.len();
         auto expressionErr = this->retValue.value().compileExpression(builder);
         if (expressionErr.hasErr()) {
             return expressionErr;
         }
 
+        // `return f(...)` reuses this function's frame for `f`, which returns on our behalf.
+        const uint16_t retSrc = static_cast<uint16_t>(this->retValue.value().variableIndex);
+        if (builder->tryRewriteTailCall(expressionStart, retSrc)) {
+            return {};
+        }
+
         const operators::ReturnValue ret = {
             static_cast<uint64_t>(operators::ReturnValue::OPCODE),
             static_cast<uint64_t>(this->retValue.value().variableIndex)};
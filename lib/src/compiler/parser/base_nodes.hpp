@@ -66,6 +66,11 @@ class IFunctionDefinition : public detail::IBaseParserNode {
 
     virtual Result<FunctionBuilder, CompileError> compile() const noexcept = 0;
 
+    /// Resolves only the return and argument types into `builder`, leaving the body uncompiled.
+    /// Lets functions be called, and type checked against, before `compile()` is ever called.
+    virtual Result<void, CompileError>
+    compileSignature(FunctionBuilder* builder) const noexcept = 0;
+
     virtual StringSlice unqualifiedName() const noexcept = 0;
 
     virtual StringSlice qualifiedName() const noexcept = 0;
@@ -106,8 +106,13 @@ Result<void, CompileError> sy::Expression::compileExpression(FunctionBuilder* bu
         loadBoolImmediate.scalarTag = static_cast<uint64_t>(ScalarTag::Bool);
         loadBoolImmediate.dst = static_cast<uint64_t>(this->variableIndex);
         loadBoolImmediate.immediate = static_cast<uint64_t>(this->metadata.boolLit);
-        const Bytecode asBytecode = Bytecode(loadBoolImmediate);
-        if (builder->pushBytecode(&asBytecode, 1).hasErr()) {
+        operators::SetType setBoolType;
+        setBoolType.reserveOpcode = static_cast<uint64_t>(setBoolType.OPCODE);
+        setBoolType.dst = static_cast<uint64_t>(this->variableIndex);
+        setBoolType.isScalar = true;
+        setBoolType.scalarTag = static_cast<uint64_t>(ScalarTag::Bool);
+        const Bytecode asBytecode[2] = {Bytecode(loadBoolImmediate), Bytecode(setBoolType)};
+        if (builder->pushBytecode(asBytecode, 2).hasErr()) {
             return Error(CompileError::OutOfMemory);
         }
     } break;
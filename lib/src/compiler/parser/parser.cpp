@@ -29,6 +29,8 @@ sy::FileAst::~FileAst() noexcept {
 
     this->nonGenericFunctions.destroy(this->alloc);
     this->nonGenericStructs.destroy(this->alloc);
+    this->scope.symbols.destroy(this->alloc);
+    this->imports.destroy(this->alloc);
 }
 
 Result<Option<IFunctionStatement*>, CompileError>
@@ -120,7 +122,6 @@ Result<FileAst, CompileError> sy::parseFile(Allocator alloc, const SourceTreeNod
                                         parseInfo.tokenIter.current().location(), "Out of memory");
                     return Error(CompileError::OutOfMemory);
                 }
-                nextOpt = parseInfo.tokenIter.next();
             } break;
             case TokenType::StructKeyword: {
                 sy_assert(false, "Struct not yet implemented");
@@ -0,0 +1,305 @@
+#include "parallel_for.hpp"
+#include "../../mem/allocator.hpp"
+#include "../../types/function/function.hpp"
+#include "../../types/task/task.hpp"
+#include "../../types/task/task_internal.hpp"
+#include "../../types/type_info.hpp"
+#include "../core_internal.h"
+#include <chrono>
+#include <new>
+
+using namespace sy;
+
+/// Nanoseconds a chunk should take at least, so the cost of its task is amortized.
+static constexpr uint64_t TARGET_CHUNK_NS = 50'000;
+/// Nanoseconds spent running chunks on the calling thread to measure the cost per item.
+static constexpr uint64_t PROBE_NS = 20'000;
+/// Chunks per worker, so workers that finish early can steal the remaining chunks.
+static constexpr size_t CHUNKS_PER_WORKER = 8;
+
+namespace {
+/// A range when `data` is null, otherwise a slice.
+struct ChunkedLoop {
+    const RawFunction* body;
+    uint8_t* data;
+    size_t elemSize;
+
+    /// Writes the arguments of the chunk `[begin, end)` to `outFirst` and `outSecond`.
+    void chunkArgs(size_t begin, size_t end, void* outFirst, void* outSecond) const noexcept {
+        if (this->data == nullptr) {
+            *reinterpret_cast<size_t*>(outFirst) = begin;
+        } else {
+            *reinterpret_cast<void**>(outFirst) = &this->data[begin * this->elemSize];
+        }
+        *reinterpret_cast<size_t*>(outSecond) = this->data == nullptr ? end : end - begin;
+    }
+
+    Result<void, AnyError> runInline(size_t begin, size_t end) const noexcept {
+        union {
+            size_t index;
+            void* chunk;
+        } first{};
+        size_t second = 0;
+        this->chunkArgs(begin, end, &first, &second);
+        RawFunction::CallArgs callArgs = this->body->startCall();
+        if (!callArgs.push(&first, this->body->argsTypes[0]) ||
+            !callArgs.push(&second, this->body->argsTypes[1])) {
+            return Error(AnyError(Exceptional::Capacity));
+        }
+        return callArgs.call(nullptr);
+    }
+
+    /// Creates the task of the chunk `[begin, end)` without submitting it.
+    Result<void*, AnyError> createChunkTask(size_t begin, size_t end) const noexcept {
+        auto taskRes = detail::TaskUtils::createTask(this->body);
+        if (taskRes.hasErr()) {
+            return Error(taskRes.takeErr());
+        }
+        void* const* args = detail::TaskUtils::taskArgs(taskRes.value());
+        this->chunkArgs(begin, end, args[0], args[1]);
+        return taskRes.value();
+    }
+};
+} // namespace
+
+static bool isIndexType(const Type* type) {
+    return type->tag == Type::Tag::Int && !type->extra.intInfo.isSigned &&
+           type->extra.intInfo.bits == (sizeof(size_t) * 8);
+}
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+static Result<void, AnyError> runChunked(const ChunkedLoop& loop, size_t len,
+                                         size_t grainSize) noexcept {
+    size_t cursor = 0;
+    if (grainSize == 0) {
+        // Chunks double in size until they take long enough to be measured reliably.
+        uint64_t probeNs = 0;
+        size_t probeLen = 1;
+        while (cursor < len && probeNs < PROBE_NS) {
+            const size_t end = (len - cursor) < probeLen ? len : cursor + probeLen;
+            const auto start = std::chrono::steady_clock::now();
+            if (auto res = loop.runInline(cursor, end); res.hasErr()) {
+                return res;
+            }
+            probeNs += elapsedNs(start);
+            cursor = end;
+            probeLen *= 2;
+        }
+        if (cursor == len) {
+            return {};
+        }
+
+        const uint64_t measuredNs = probeNs == 0 ? 1 : probeNs;
+        const uint64_t costGrain = ((TARGET_CHUNK_NS * cursor) + measuredNs - 1) / measuredNs;
+        const size_t chunkCount = static_cast<size_t>(taskParallelism()) * CHUNKS_PER_WORKER;
+        const size_t balanceGrain = ((len - cursor) + chunkCount - 1) / chunkCount;
+        grainSize = costGrain > balanceGrain ? static_cast<size_t>(costGrain) : balanceGrain;
+    }
+
+    const size_t remaining = len - cursor;
+    if (grainSize >= remaining) {
+        return loop.runInline(cursor, len);
+    }
+
+    const size_t chunkCount = (remaining + grainSize - 1) / grainSize;
+    Allocator alloc{};
+    auto executorsRes = alloc.allocArray<TaskExecutor>(chunkCount);
+    if (executorsRes.hasErr()) {
+        return Error(AnyError(Exceptional::OOM));
+    }
+    auto tasksRes = alloc.allocArray<RawTask>(chunkCount);
+    if (tasksRes.hasErr()) {
+        alloc.freeArray(executorsRes.value(), chunkCount);
+        return Error(AnyError(Exceptional::OOM));
+    }
+    TaskExecutor* executors = executorsRes.value();
+    RawTask* tasks = tasksRes.value();
+
+    for (size_t i = 0; i < chunkCount; i++) {
+        const size_t begin = cursor + (i * grainSize);
+        const size_t end = (len - begin) < grainSize ? len : begin + grainSize;
+        auto taskRes = loop.createChunkTask(begin, end);
+        if (taskRes.hasErr()) {
+            for (size_t j = 0; j < i; j++) {
+                detail::TaskUtils::destroyTask(detail::TaskUtils::executorTask(executors[j]));
+            }
+            alloc.freeArray(tasks, chunkCount);
+            alloc.freeArray(executors, chunkCount);
+            return Error(taskRes.takeErr());
+        }
+        new (&executors[i]) TaskExecutor(detail::TaskUtils::makeExecutor(taskRes.value()));
+        new (&tasks[i]) RawTask(detail::TaskUtils::ownTask(taskRes.value()));
+    }
+
+    // Chunks that couldn't be submitted run here instead, before helping with the rest.
+    const size_t submitted = submitBatchToTaskPool(executors, chunkCount);
+    for (size_t i = submitted; i < chunkCount; i++) {
+        executors[i].run();
+    }
+    auto res = RawTask::awaitAll(tasks, chunkCount, nullptr);
+
+    for (size_t i = 0; i < chunkCount; i++) {
+        tasks[i].~RawTask();
+    }
+    alloc.freeArray(tasks, chunkCount);
+    alloc.freeArray(executors, chunkCount);
+    return res;
+}
+
+Result<void, AnyError> sy::parallelForRange(size_t len, const RawFunction* body,
+                                            size_t grainSize) noexcept {
+    sy_assert(body->argsLen == 2 && isIndexType(body->argsTypes[0]) &&
+                  isIndexType(body->argsTypes[1]) && body->returnType == nullptr,
+              "Parallel for body must take the chunk's begin and end as usize");
+    if (len == 0) {
+        return {};
+    }
+    const ChunkedLoop loop = {body, nullptr, 0};
+    return runChunked(loop, len, grainSize);
+}
+
+Result<void, AnyError> sy::parallelForSlice(void* data, size_t len, const Type* elemType,
+                                            const RawFunction* body, size_t grainSize) noexcept {
+    sy_assert(body->argsLen == 2 && body->returnType == nullptr,
+              "Parallel for body must take the chunk and its length, and return nothing");
+    sy_assert(body->argsTypes[0] == elemType->mutRef ||
+                  body->argsTypes[0]->tag == Type::Tag::OpaquePointer,
+              "Parallel for body must take a mutable reference to the chunk's first element");
+    sy_assert(isIndexType(body->argsTypes[1]), "Parallel for body must take the length as usize");
+    if (len == 0) {
+        return {};
+    }
+    const ChunkedLoop loop = {body, reinterpret_cast<uint8_t*>(data), elemType->sizeType};
+    return runChunked(loop, len, grainSize);
+}
+
+Result<void, AnyError> sy::parallelForList(SyList* list, const Type* elemType,
+                                           const RawFunction* body, size_t grainSize) noexcept {
+    return parallelForSlice(list->data_, list->len, elemType, body, grainSize);
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../../doctest.h"
+#include <atomic>
+#include <vector>
+
+namespace {
+constexpr size_t LOOP_LEN = 100'000;
+
+std::atomic<uint32_t>* rangeHits = nullptr;
+
+void markRange(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        rangeHits[i].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void doubleChunk(void* chunk, size_t len) {
+    int32_t* values = reinterpret_cast<int32_t*>(chunk);
+    for (size_t i = 0; i < len; i++) {
+        values[i] *= 2;
+    }
+}
+
+std::atomic<size_t> chunkCalls{0};
+
+void countChunk(size_t begin, size_t end) {
+    (void)begin;
+    (void)end;
+    chunkCalls.fetch_add(1);
+}
+
+Result<void, AnyError> failContaining(size_t begin, size_t end) {
+    if (begin <= 5000 && 5000 < end) {
+        return Error(AnyError(Exceptional::Arithmetic));
+    }
+    return {};
+}
+} // namespace
+
+TEST_CASE("[parallelFor] every index of a range is visited exactly once") {
+    rangeHits = new std::atomic<uint32_t>[LOOP_LEN];
+    for (size_t i = 0; i < LOOP_LEN; i++) {
+        rangeHits[i].store(0);
+    }
+    const Function<void(size_t, size_t)> body(markRange);
+    REQUIRE(parallelForRange(LOOP_LEN, reinterpret_cast<const RawFunction*>(&body)));
+
+    size_t wrongCount = 0;
+    for (size_t i = 0; i < LOOP_LEN; i++) {
+        if (rangeHits[i].load() != 1) {
+            wrongCount += 1;
+        }
+    }
+    CHECK_EQ(wrongCount, 0);
+    delete[] rangeHits;
+    rangeHits = nullptr;
+    TaskPool::shutdown();
+}
+
+TEST_CASE("[parallelFor] chunks of a list are passed as pointers to their first element") {
+    std::vector<int32_t> values(LOOP_LEN);
+    for (size_t i = 0; i < LOOP_LEN; i++) {
+        values[i] = static_cast<int32_t>(i);
+    }
+    SyList list{};
+    list.data_ = values.data();
+    list.len = values.size();
+
+    const Function<void(void*, size_t)> body(doubleChunk);
+    REQUIRE(parallelForList(&list, Reflect<int32_t>::get(),
+                            reinterpret_cast<const RawFunction*>(&body)));
+    size_t wrongCount = 0;
+    for (size_t i = 0; i < LOOP_LEN; i++) {
+        if (values[i] != static_cast<int32_t>(i * 2)) {
+            wrongCount += 1;
+        }
+    }
+    CHECK_EQ(wrongCount, 0);
+
+    // Empty lists call nothing.
+    list.len = 0;
+    REQUIRE(parallelForList(&list, Reflect<int32_t>::get(),
+                            reinterpret_cast<const RawFunction*>(&body)));
+    CHECK_EQ(values[1], 2);
+    TaskPool::shutdown();
+}
+
+TEST_CASE("[parallelFor] explicit grain sizes split the range evenly") {
+    chunkCalls.store(0);
+    const Function<void(size_t, size_t)> body(countChunk);
+    const RawFunction* raw = reinterpret_cast<const RawFunction*>(&body);
+    REQUIRE(parallelForRange(10'000, raw, 1000));
+    CHECK_EQ(chunkCalls.load(), 10);
+
+    chunkCalls.store(0);
+    REQUIRE(parallelForRange(10'001, raw, 1000));
+    CHECK_EQ(chunkCalls.load(), 11);
+
+    // A grain covering the whole range runs it as one chunk on the calling thread.
+    chunkCalls.store(0);
+    REQUIRE(parallelForRange(500, raw, 1000));
+    CHECK_EQ(chunkCalls.load(), 1);
+    TaskPool::shutdown();
+}
+
+TEST_CASE("[parallelFor] errors of chunks are returned") {
+    const Function<void(size_t, size_t)> body(failContaining);
+    const RawFunction* raw = reinterpret_cast<const RawFunction*>(&body);
+    auto res = parallelForRange(LOOP_LEN, raw);
+    REQUIRE(res.hasErr());
+    CHECK_EQ(res.takeErr().exceptional().value(), Exceptional::Arithmetic);
+
+    auto explicitRes = parallelForRange(LOOP_LEN, raw, 64);
+    REQUIRE(explicitRes.hasErr());
+    CHECK_EQ(explicitRes.takeErr().exceptional().value(), Exceptional::Arithmetic);
+    TaskPool::shutdown();
+}
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -0,0 +1,37 @@
+#ifndef _SY_CORE_BUILTIN_FUNCTIONS_PARALLEL_FOR_HPP_
+#define _SY_CORE_BUILTIN_FUNCTIONS_PARALLEL_FOR_HPP_
+
+#include "../../types/anyerror/anyerror.hpp"
+#include "../../types/array/list.h"
+#include "../../types/result/result.hpp"
+#include "../core.h"
+
+namespace sy {
+class RawFunction;
+class Type;
+
+/// Calls `body(begin, end)` over consecutive chunks of the range `[0, len)`, running the chunks as
+/// parallel tasks, and returns once all of them have finished. The calling thread runs chunks too.
+///
+/// If `grainSize` is zero, the amount of items per chunk is chosen automatically. The first few
+/// chunks run on the calling thread, growing until their time per item can be measured. Chunks are
+/// then made large enough to amortize the cost of a task, but small enough that each worker gets
+/// several, so workers that finish early can steal from the rest.
+/// @param body Takes two `usize`, and returns nothing.
+/// @return The error of the first failed chunk, if any. Other chunks may still have run.
+Result<void, AnyError> parallelForRange(size_t len, const RawFunction* body,
+                                        size_t grainSize = 0) noexcept;
+
+/// Calls `body(chunk, chunkLen)` over consecutive chunks of the `len` elements of `elemType` at
+/// `data`, the same way as `parallelForRange(...)`.
+/// @param body Takes a `*mut T` or opaque pointer to the first element of the chunk, then the
+/// amount of elements as `usize`, and returns nothing.
+Result<void, AnyError> parallelForSlice(void* data, size_t len, const Type* elemType,
+                                        const RawFunction* body, size_t grainSize = 0) noexcept;
+
+/// `parallelForSlice(...)` over the elements of a `List[T]`.
+Result<void, AnyError> parallelForList(SyList* list, const Type* elemType, const RawFunction* body,
+                                       size_t grainSize = 0) noexcept;
+} // namespace sy
+
+#endif // _SY_CORE_BUILTIN_FUNCTIONS_PARALLEL_FOR_HPP_
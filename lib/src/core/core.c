@@ -242,6 +242,30 @@ void sy_make_pages_read_write(void* pagesStart, size_t len) {
     "Improperly configured on whether to use page memory operations or not. Please define 'SYNC_NO_PAGES'"
 #endif
 }
+
+void sy_make_pages_executable(void* pagesStart, size_t len) {
+    const size_t pageSize = sy_page_size();
+    sy_assert_release((len % pageSize) == 0,
+                      "[sy_make_pages_executable] len must be multiple of sy_page_size");
+#if defined(SYNC_NO_PAGES)
+    (void)pagesStart;
+    (void)len;
+    sy_assert_release(false, "[sy_make_pages_executable] unsupported without page memory");
+#elif defined(_WIN32)
+    const DWORD newProtect = PAGE_EXECUTE_READ;
+    DWORD oldProtect;
+    const bool success = VirtualProtect(pagesStart, len, newProtect, &oldProtect);
+    sy_assert_release(success == true,
+                      "[sy_make_pages_executable] failed to make pages read / execute");
+#elif defined(__APPLE__) || defined(__GNUC__)
+    const int success = mprotect(pagesStart, len, PROT_READ | PROT_EXEC);
+    sy_assert_release(success == 0,
+                      "[sy_make_pages_executable] failed to make pages read / execute");
+#else
+#error                                                                                             \
+    "Improperly configured on whether to use page memory operations or not. Please define 'SYNC_NO_PAGES'"
+#endif
+}
 #endif // SYNC_CUSTOM_PAGE_MEMORY
 
 #if defined(_MSC_VER) && defined(__STDC_NO_ATOMICS__)
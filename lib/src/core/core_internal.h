@@ -72,6 +72,15 @@ extern void sy_make_pages_read_only(void* pagesStart, size_t len);
 /// @warning If `len` is not a multiple of `sy_page_size` the fatal error handler is invoked.
 extern void sy_make_pages_read_write(void* pagesStart, size_t len);
 
+/// Makes one or more virtual memory pages read / execute enabled, such as for generated machine
+/// code. If `SYNC_NO_PAGES` is defined, the fatal error handler is invoked, as arbitrary memory
+/// cannot be made executable. Alternatively, can be overridden by defining
+/// `SYNC_CUSTOM_PAGE_MEMORY`
+/// @param pagesStart Pointer to the beginning of the pages memory.
+/// @param len Amount of bytes that the pages span.
+/// @warning If `len` is not a multiple of `sy_page_size` the fatal error handler is invoked.
+extern void sy_make_pages_executable(void* pagesStart, size_t len);
+
 /// @brief Same as https://en.cppreference.com/w/cpp/atomic/memory_order.html
 typedef enum SyMemoryOrder {
     SY_MEMORY_ORDER_RELAXED = 0,
@@ -1,10 +1,25 @@
 #include "exceptional.hpp"
+#include "exceptional.h"
 #include <filesystem>
 #include <ios>
 #include <new>
 #include <stdexcept>
 #include <system_error>
 
+static_assert(static_cast<int>(sy::Exceptional::OOM) == static_cast<int>(SY_EXCEPTIONAL_OOM));
+static_assert(static_cast<int>(sy::Exceptional::Bounds) == static_cast<int>(SY_EXCEPTIONAL_BOUNDS));
+static_assert(static_cast<int>(sy::Exceptional::System) == static_cast<int>(SY_EXCEPTIONAL_SYSTEM));
+static_assert(static_cast<int>(sy::Exceptional::Io) == static_cast<int>(SY_EXCEPTIONAL_IO));
+static_assert(static_cast<int>(sy::Exceptional::Arithmetic) ==
+              static_cast<int>(SY_EXCEPTIONAL_ARITHMETIC));
+static_assert(static_cast<int>(sy::Exceptional::Capacity) ==
+              static_cast<int>(SY_EXCEPTIONAL_CAPACITY));
+static_assert(static_cast<int>(sy::Exceptional::Other) == static_cast<int>(SY_EXCEPTIONAL_OTHER));
+static_assert(static_cast<int>(sy::Exceptional::Cancelled) ==
+              static_cast<int>(SY_EXCEPTIONAL_CANCELLED));
+static_assert(static_cast<int>(sy::Exceptional::Signature) ==
+              static_cast<int>(SY_EXCEPTIONAL_SIGNATURE));
+
 namespace sy {
 namespace internal {
 SY_API Exceptional translateCurrentException() noexcept {
@@ -14,6 +14,8 @@ typedef enum SyExceptional {
     SY_EXCEPTIONAL_ARITHMETIC = 5,
     SY_EXCEPTIONAL_CAPACITY = 6,
     SY_EXCEPTIONAL_OTHER = 7,
+    SY_EXCEPTIONAL_CANCELLED = 8,
+    SY_EXCEPTIONAL_SIGNATURE = 9,
 
     _SY_EXCEPTIONAL_MAX = 0x7FFFFFFF,
 } SyExceptional;
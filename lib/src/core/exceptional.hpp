@@ -18,6 +18,10 @@ enum class Exceptional : int {
     Arithmetic = 5,
     Capacity = 6,
     Other = 7,
+    /// The task was cancelled before it finished. See `RawTask::cancel()`.
+    Cancelled = 8,
+    /// A function was called with arguments that don't match its signature.
+    Signature = 9,
 };
 
 namespace internal {
@@ -0,0 +1,715 @@
+#include "aot_c.hpp"
+#include "../compiler/lazy_function.hpp"
+#include "../core/core_internal.h"
+#include "../program/program_image_internal.hpp"
+#include "../program/program_internal.hpp"
+#include "../types/array/dynamic_array.hpp"
+#include "../types/function/function.hpp"
+#include "../types/type_info.hpp"
+#include "bytecode.hpp"
+#include "jit.hpp"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+using namespace sy;
+
+static_assert(sizeof(Bytecode) == sizeof(uint64_t));
+static_assert(sizeof(Node::TypeOfValue) == sizeof(uintptr_t));
+
+namespace {
+/// Names used by the generated C for each `ScalarTag`, in order of the tags.
+struct CScalar {
+    /// Suffix of the `sy_aot_ld_*` and `sy_aot_st_*` accessors.
+    const char* suffix;
+    /// Unsigned type to do wrapping integer arithmetic in, or null for floats and bools.
+    const char* unsignedType;
+    /// Suffix of the `SY_TYPE_*` global of the type.
+    const char* typeGlobal;
+};
+
+constexpr CScalar C_SCALARS[] = {
+    {"bool", nullptr, "BOOL"},    {"i8", "uint8_t", "I8"},      {"i16", "uint16_t", "I16"},
+    {"i32", "uint32_t", "I32"},   {"i64", "uint64_t", "I64"},   {"u8", "uint8_t", "U8"},
+    {"u16", "uint16_t", "U16"},   {"u32", "uint32_t", "U32"},   {"u64", "uint64_t", "U64"},
+    {"usize", "size_t", "USIZE"}, {"f32", nullptr, "F32"},      {"f64", nullptr, "F64"},
+};
+static_assert(sizeof(C_SCALARS) / sizeof(CScalar) == static_cast<size_t>(ScalarTag::F64) + 1);
+
+/// C operators of the comparisons, indexed by the offset of the comparison `OpCode` from
+/// `OpCode::Equal`.
+constexpr const char* C_COMPARE_OPERATORS[] = {"==", "!=", "<", "<=", ">", ">="};
+
+const CScalar& cScalar(uint64_t scalarTag) {
+    sy_assert(scalarTag < sizeof(C_SCALARS) / sizeof(CScalar), "Invalid scalar tag");
+    return C_SCALARS[scalarTag];
+}
+
+/// Everything generated functions depend on. Scalar accessors go through `memcpy`, which compilers
+/// reduce to a single load or store, rather than type punning the frame.
+constexpr const char C_PREAMBLE[] =
+    "#include <stddef.h>\n"
+    "#include <stdint.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "struct SyType;\n"
+    "extern const struct SyType* SY_TYPE_BOOL;\n"
+    "extern const struct SyType* SY_TYPE_I8;\n"
+    "extern const struct SyType* SY_TYPE_I16;\n"
+    "extern const struct SyType* SY_TYPE_I32;\n"
+    "extern const struct SyType* SY_TYPE_I64;\n"
+    "extern const struct SyType* SY_TYPE_U8;\n"
+    "extern const struct SyType* SY_TYPE_U16;\n"
+    "extern const struct SyType* SY_TYPE_U32;\n"
+    "extern const struct SyType* SY_TYPE_U64;\n"
+    "extern const struct SyType* SY_TYPE_USIZE;\n"
+    "extern const struct SyType* SY_TYPE_F32;\n"
+    "extern const struct SyType* SY_TYPE_F64;\n"
+    "\n"
+    "#define SY_AOT_SCALAR(name, T)                                          \\\n"
+    "    static inline T sy_aot_ld_##name(const uint64_t* v, size_t offset) { \\\n"
+    "        T x;                                                        \\\n"
+    "        memcpy(&x, (const char*)v + offset, sizeof(T));             \\\n"
+    "        return x;                                                   \\\n"
+    "    }                                                               \\\n"
+    "    static inline void sy_aot_st_##name(uint64_t* v, size_t offset, T x) { \\\n"
+    "        memcpy((char*)v + offset, &x, sizeof(T));                   \\\n"
+    "    }\n"
+    "SY_AOT_SCALAR(bool, uint8_t)\n"
+    "SY_AOT_SCALAR(i8, int8_t)\n"
+    "SY_AOT_SCALAR(i16, int16_t)\n"
+    "SY_AOT_SCALAR(i32, int32_t)\n"
+    "SY_AOT_SCALAR(i64, int64_t)\n"
+    "SY_AOT_SCALAR(u8, uint8_t)\n"
+    "SY_AOT_SCALAR(u16, uint16_t)\n"
+    "SY_AOT_SCALAR(u32, uint32_t)\n"
+    "SY_AOT_SCALAR(u64, uint64_t)\n"
+    "SY_AOT_SCALAR(usize, size_t)\n"
+    "SY_AOT_SCALAR(f32, float)\n"
+    "SY_AOT_SCALAR(f64, double)\n"
+    "#undef SY_AOT_SCALAR\n"
+    "\n"
+    "typedef const uint64_t* (*sy_aot_entry_t)(uint64_t*, uintptr_t*, const uint64_t*);\n"
+    "\n"
+    "typedef struct SyAotFunction {\n"
+    "    const char* qualifiedName;\n"
+    "    size_t qualifiedNameLen;\n"
+    "    uint64_t bytecodeHash;\n"
+    "    sy_aot_entry_t entry;\n"
+    "} SyAotFunction;\n";
+
+/// Appends C source text, remembering if any allocation failed.
+class CWriter {
+  public:
+    StringBuilder builder;
+    bool outOfMemory = false;
+
+    void write(StringSlice str) {
+        if (this->builder.write(str).hasErr()) {
+            this->outOfMemory = true;
+        }
+    }
+
+    void fmt(const char* format, ...) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        const int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        sy_assert(len >= 0 && static_cast<size_t>(len) < sizeof(buf), "Generated C line too long");
+        this->write(StringSlice(buf, static_cast<size_t>(len)));
+    }
+
+    /// Writes `str` as a C string literal, escaping anything that isn't printable ASCII.
+    void stringLiteral(StringSlice str) {
+        this->write("\"");
+        for (size_t i = 0; i < str.len(); i++) {
+            const unsigned char c = static_cast<unsigned char>(str[i]);
+            if (c == '"' || c == '\\' || c == '?' || c < 0x20 || c > 0x7E) {
+                this->fmt("\\%03o", c);
+            } else {
+                this->write(StringSlice(str.data() + i, 1));
+            }
+        }
+        this->write("\"");
+    }
+};
+
+/// Translates a single operation into C statements. Mirrors the JIT's `Translator`, so the same
+/// operations run natively, and everything else returns to the interpreter at that operation.
+class CTranslator {
+  public:
+    CTranslator(CWriter& w, const Bytecode* bytecode, size_t bytecodeCount, uint16_t frameLength)
+        : w_(w), bytecode_(bytecode), bytecodeCount_(bytecodeCount), frameLength_(frameLength) {}
+
+    /// If the operation at `pos` is translatable and jumps, stores where to in `outTarget`.
+    bool jumpTargetOf(size_t pos, size_t& outTarget) const {
+        const Bytecode* ip = &this->bytecode_[pos];
+        switch (ip->getOpcode()) {
+        case OpCode::Jump:
+            return this->jumpTarget(pos, ip->toOperands<operators::Jump>().amount, outTarget);
+        case OpCode::JumpIfFalse:
+            return this->jumpTarget(pos, ip->toOperands<operators::JumpIfFalse>().amount,
+                                    outTarget);
+        case OpCode::CompareJumpIfFalse:
+            return this->jumpTarget(pos, static_cast<int64_t>(ip[1].value), outTarget);
+        default:
+            return false;
+        }
+    }
+
+    bool translate(size_t pos) {
+        const Bytecode* ip = &this->bytecode_[pos];
+        switch (ip->getOpcode()) {
+        case OpCode::Noop:
+            return true;
+        case OpCode::LoadDefault: {
+            const auto operands = ip->toOperands<operators::LoadDefault>();
+            if (!operands.isScalar || !this->inFrame(operands.dst)) {
+                return false;
+            }
+            this->w_.fmt("    sy_aot_st_%s(v, %u, 0);\n", cScalar(operands.scalarTag).suffix,
+                         slot(operands.dst));
+            return true;
+        }
+        case OpCode::LoadImmediateScalar: {
+            const auto operands = ip->toOperands<operators::LoadImmediateScalar>();
+            return this->loadImmediate(ip, static_cast<ScalarTag>(operands.scalarTag), operands.dst,
+                                       static_cast<uint32_t>(operands.immediate));
+        }
+        case OpCode::SetType: {
+            const auto operands = ip->toOperands<operators::SetType>();
+            if (!operands.isScalar || !this->inFrame(operands.dst)) {
+                return false;
+            }
+            this->setType(operands.scalarTag, operands.dst);
+            return true;
+        }
+        case OpCode::SetNullType: {
+            const auto operands = ip->toOperands<operators::SetNullType>();
+            if (!this->inFrame(operands.dst)) {
+                return false;
+            }
+            this->w_.fmt("    t[%u] = 0;\n", static_cast<unsigned>(operands.dst));
+            return true;
+        }
+        case OpCode::Jump: {
+            size_t target = 0;
+            if (!this->jumpTargetOf(pos, target)) {
+                return false;
+            }
+            this->w_.fmt("    goto L%zu;\n", target);
+            return true;
+        }
+        case OpCode::JumpIfFalse: {
+            const auto operands = ip->toOperands<operators::JumpIfFalse>();
+            size_t target = 0;
+            if (!this->inFrame(operands.src) || !this->jumpTargetOf(pos, target)) {
+                return false;
+            }
+            this->w_.fmt("    if (!sy_aot_ld_bool(v, %u)) goto L%zu;\n", slot(operands.src),
+                         target);
+            return true;
+        }
+        case OpCode::Move: {
+            const auto operands = ip->toOperands<operators::Move>();
+            return operands.isScalar && this->copySlot(operands.dst, operands.src);
+        }
+        case OpCode::Clone: {
+            const auto operands = ip->toOperands<operators::Clone>();
+            return operands.isScalar && this->copySlot(operands.dst, operands.src);
+        }
+        case OpCode::GetMember: {
+            const auto operands = ip->toOperands<operators::GetMember>();
+            if (!operands.isScalar) {
+                return false;
+            }
+            const uint32_t memberOffset = slot(operands.src) + operands.memberOffset;
+            if (!this->inFrame(operands.dst) ||
+                !this->inFrameBytes(memberOffset, operands.scalarTag)) {
+                return false;
+            }
+            const char* suffix = cScalar(operands.scalarTag).suffix;
+            this->w_.fmt("    sy_aot_st_%s(v, %u, sy_aot_ld_%s(v, %u));\n", suffix,
+                         slot(operands.dst), suffix, memberOffset);
+            return true;
+        }
+        case OpCode::SetMember: {
+            const auto operands = ip->toOperands<operators::SetMember>();
+            if (!operands.isScalar) {
+                return false;
+            }
+            const uint32_t memberOffset = slot(operands.dst) + operands.memberOffset;
+            if (!this->inFrame(operands.src) ||
+                !this->inFrameBytes(memberOffset, operands.scalarTag)) {
+                return false;
+            }
+            const char* suffix = cScalar(operands.scalarTag).suffix;
+            this->w_.fmt("    sy_aot_st_%s(v, %u, sy_aot_ld_%s(v, %u));\n", suffix, memberOffset,
+                         suffix, slot(operands.src));
+            return true;
+        }
+        case OpCode::Equal:
+            return this->compare<operators::Equal>(ip);
+        case OpCode::NotEqual:
+            return this->compare<operators::NotEqual>(ip);
+        case OpCode::Less:
+            return this->compare<operators::Less>(ip);
+        case OpCode::LessEqual:
+            return this->compare<operators::LessEqual>(ip);
+        case OpCode::Greater:
+            return this->compare<operators::Greater>(ip);
+        case OpCode::GreaterEqual:
+            return this->compare<operators::GreaterEqual>(ip);
+        case OpCode::Add:
+            return this->add(ip->toOperands<operators::Add>());
+        case OpCode::CompareJumpIfFalse: {
+            const auto operands = ip->toOperands<operators::CompareJumpIfFalse>();
+            size_t target = 0;
+            if (!this->jumpTargetOf(pos, target) ||
+                !this->compareToDst(operands.scalarTag, static_cast<uint8_t>(operands.compareOp),
+                                    operands.dst, operands.lhs, operands.rhs)) {
+                return false;
+            }
+            this->w_.fmt("    if (!sy_aot_ld_bool(v, %u)) goto L%zu;\n", slot(operands.dst),
+                         target);
+            return true;
+        }
+        case OpCode::LoadImmediateScalarSetType: {
+            const auto operands = ip->toOperands<operators::LoadImmediateScalarSetType>();
+            if (!this->loadImmediate(ip, static_cast<ScalarTag>(operands.scalarTag), operands.dst,
+                                     static_cast<uint32_t>(operands.immediate))) {
+                return false;
+            }
+            this->setType(operands.scalarTag, operands.dst);
+            return true;
+        }
+        case OpCode::LoadDefaultSetType: {
+            const auto operands = ip->toOperands<operators::LoadDefaultSetType>();
+            if (!this->inFrame(operands.dst)) {
+                return false;
+            }
+            this->w_.fmt("    sy_aot_st_%s(v, %u, 0);\n", cScalar(operands.scalarTag).suffix,
+                         slot(operands.dst));
+            this->setType(operands.scalarTag, operands.dst);
+            return true;
+        }
+        default:
+            // Calls, returns, destructors, and non scalar operations go through the interpreter.
+            return false;
+        }
+    }
+
+  private:
+    CWriter& w_;
+    const Bytecode* bytecode_;
+    size_t bytecodeCount_;
+    uint16_t frameLength_;
+
+    static uint32_t slot(uint64_t s) { return static_cast<uint32_t>(s * sizeof(uint64_t)); }
+
+    bool inFrame(uint64_t s) const { return s < this->frameLength_; }
+
+    bool inFrameBytes(uint64_t offset, uint64_t scalarTag) const {
+        const size_t size = scalarTypeFromTag(static_cast<ScalarTag>(scalarTag))->sizeType;
+        return (offset + size) <= (static_cast<uint64_t>(this->frameLength_) * sizeof(uint64_t));
+    }
+
+    bool jumpTarget(size_t pos, int64_t amount, size_t& outTarget) const {
+        const int64_t target = static_cast<int64_t>(pos) + amount;
+        if (target < 0 || static_cast<size_t>(target) >= this->bytecodeCount_) {
+            return false;
+        }
+        outTarget = static_cast<size_t>(target);
+        return true;
+    }
+
+    void setType(uint64_t scalarTag, uint64_t dst) {
+        this->w_.fmt("    t[%u] = (uintptr_t)SY_TYPE_%s;\n", static_cast<unsigned>(dst),
+                     cScalar(scalarTag).typeGlobal);
+    }
+
+    bool copySlot(uint64_t dst, uint64_t src) {
+        if (!this->inFrame(dst) || !this->inFrame(src)) {
+            return false;
+        }
+        this->w_.fmt("    v[%u] = v[%u];\n", static_cast<unsigned>(dst),
+                     static_cast<unsigned>(src));
+        return true;
+    }
+
+    bool loadImmediate(const Bytecode* ip, ScalarTag tag, uint64_t dst, uint32_t immediate) {
+        if (!this->inFrame(dst)) {
+            return false;
+        }
+        if (scalarTypeFromTag(tag)->sizeType <= 4) {
+            // Same as the interpreter, which always writes the full 32 bit immediate.
+            this->w_.fmt("    sy_aot_st_u32(v, %u, %uU);\n", slot(dst), immediate);
+        } else {
+            this->w_.fmt("    v[%u] = %lluULL;\n", static_cast<unsigned>(dst),
+                         static_cast<unsigned long long>(ip[1].value));
+        }
+        return true;
+    }
+
+    bool compareToDst(uint64_t scalarTag, uint8_t compareOp, uint64_t dst, uint64_t lhs,
+                      uint64_t rhs) {
+        if (!this->inFrame(dst) || !this->inFrame(lhs) || !this->inFrame(rhs)) {
+            return false;
+        }
+        sy_assert(compareOp < sizeof(C_COMPARE_OPERATORS) / sizeof(const char*),
+                  "Invalid comparison");
+        const char* suffix = cScalar(scalarTag).suffix;
+        this->w_.fmt("    sy_aot_st_bool(v, %u, sy_aot_ld_%s(v, %u) %s sy_aot_ld_%s(v, %u));\n",
+                     slot(dst), suffix, slot(lhs), C_COMPARE_OPERATORS[compareOp], suffix,
+                     slot(rhs));
+        return true;
+    }
+
+    template <typename OperandsT> bool compare(const Bytecode* ip) {
+        const OperandsT operands = ip->toOperands<OperandsT>();
+        if (!operands.isScalar) {
+            return false;
+        }
+        return this->compareToDst(operands.scalarTag,
+                                  static_cast<uint8_t>(static_cast<uint8_t>(OperandsT::OPCODE) -
+                                                       static_cast<uint8_t>(OpCode::Equal)),
+                                  operands.dst, operands.lhs, operands.rhs);
+    }
+
+    bool add(const operators::Add operands) {
+        if (!operands.isScalar || operands.scalarTag == static_cast<uint64_t>(ScalarTag::Bool) ||
+            !this->inFrame(operands.dst) || !this->inFrame(operands.lhs) ||
+            !this->inFrame(operands.rhs)) {
+            return false;
+        }
+        const CScalar& scalar = cScalar(operands.scalarTag);
+        const char* suffix = scalar.suffix;
+        if (scalar.unsignedType == nullptr) {
+            this->w_.fmt("    sy_aot_st_%s(v, %u, sy_aot_ld_%s(v, %u) + sy_aot_ld_%s(v, %u));\n",
+                         suffix, slot(operands.dst), suffix, slot(operands.lhs), suffix,
+                         slot(operands.rhs));
+        } else {
+            // Unsigned arithmetic wraps, same as the interpreter.
+            const char* u = scalar.unsignedType;
+            this->w_.fmt(
+                "    sy_aot_st_%s(v, %u, (%s)sy_aot_ld_%s(v, %u) + (%s)sy_aot_ld_%s(v, %u));\n",
+                suffix, slot(operands.dst), u, suffix, slot(operands.lhs), u, suffix,
+                slot(operands.rhs));
+        }
+        return true;
+    }
+};
+
+/// Pointer operand following the first word of an operation, if it has one.
+enum class PointerOperand : uint8_t { None, Function, Type };
+
+PointerOperand pointerOperandOf(const Bytecode& op) {
+    switch (op.getOpcode()) {
+    case OpCode::CallImmediateNoReturn:
+    case OpCode::CallImmediateWithReturn:
+    case OpCode::TailCallImmediate:
+        return PointerOperand::Function;
+    case OpCode::LoadDefault:
+        return op.toOperands<operators::LoadDefault>().isScalar ? PointerOperand::None
+                                                                : PointerOperand::Type;
+    case OpCode::SetType:
+        return op.toOperands<operators::SetType>().isScalar ? PointerOperand::None
+                                                            : PointerOperand::Type;
+    case OpCode::GetMember:
+        return op.toOperands<operators::GetMember>().isScalar ? PointerOperand::None
+                                                              : PointerOperand::Type;
+    case OpCode::SetMember:
+        return op.toOperands<operators::SetMember>().isScalar ? PointerOperand::None
+                                                              : PointerOperand::Type;
+    default:
+        return PointerOperand::None;
+    }
+}
+
+/// FNV-1a over the bytecode and frame length, which is everything the generated code depends on.
+/// Functions and types are hashed by name rather than address, as the generated code is built
+/// into a different process than the one it was emitted from.
+uint64_t scriptFunctionHash(const InterpreterFunctionScriptInfo* scriptInfo) {
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+    uint64_t hash = FNV_OFFSET;
+    auto mixByte = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= FNV_PRIME;
+    };
+    auto mix = [&mixByte](uint64_t value) {
+        for (size_t i = 0; i < sizeof(uint64_t); i++) {
+            mixByte(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    };
+    auto mixName = [&mix, &mixByte](StringSlice name) {
+        mix(name.len());
+        for (size_t i = 0; i < name.len(); i++) {
+            mixByte(static_cast<uint8_t>(name[i]));
+        }
+    };
+
+    if (scriptInfo->image != nullptr) {
+        scriptInfo->image->ensureRelocated();
+    }
+    mix(scriptInfo->stackSpaceRequired);
+    const Bytecode* bytecode = scriptInfo->bytecode;
+    const size_t bytecodeCount = scriptInfo->bytecodeCount;
+    for (size_t pos = 0; pos < bytecodeCount;) {
+        const Bytecode& op = bytecode[pos];
+        size_t width = op.bytecodeUsed();
+        if (width == 0 || width > bytecodeCount - pos) {
+            width = bytecodeCount - pos;
+        }
+        const PointerOperand pointer = width > 1 ? pointerOperandOf(op) : PointerOperand::None;
+        for (size_t i = 0; i < width; i++) {
+            const uint64_t value = bytecode[pos + i].value;
+            if (i != 1 || pointer == PointerOperand::None) {
+                mix(value);
+            } else if (pointer == PointerOperand::Function) {
+                const RawFunction* function =
+                    reinterpret_cast<const RawFunction*>(static_cast<uintptr_t>(value));
+                mixName(function->qualifiedName);
+            } else {
+                const Type* type = reinterpret_cast<const Type*>(static_cast<uintptr_t>(value));
+                mixName(type != nullptr ? type->name : StringSlice());
+            }
+        }
+        pos += width;
+    }
+    return hash;
+}
+
+/// Writes the module name, with anything that isn't valid in a C identifier replaced by `_`.
+void writeIdentifier(CWriter& w, StringSlice name) {
+    for (size_t i = 0; i < name.len(); i++) {
+        const char c = name[i];
+        const bool valid =
+            (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        w.write(valid ? StringSlice(name.data() + i, 1) : StringSlice("_"));
+    }
+}
+
+bool isTranslatable(const ProgramModuleInternal* module, size_t i) {
+    // Lazily compiled functions have no bytecode to translate until they're compiled.
+    ensureFunctionCompiled(&module->allFunctions[i]);
+    const InterpreterFunctionScriptInfo& scriptInfo = module->allFunctionScriptInfo[i];
+    return module->allFunctions[i].tag == FunctionType::Script && scriptInfo.bytecode != nullptr &&
+           scriptInfo.bytecodeCount > 0;
+}
+
+void writeFunction(CWriter& w, const ProgramModuleInternal* module, size_t index) {
+    const InterpreterFunctionScriptInfo* scriptInfo = &module->allFunctionScriptInfo[index];
+    if (scriptInfo->image != nullptr) {
+        // Calls and types are translated from the pointer operands, which are written lazily.
+        scriptInfo->image->ensureRelocated();
+    }
+    const Bytecode* bytecode = scriptInfo->bytecode;
+    const size_t bytecodeCount = scriptInfo->bytecodeCount;
+    CTranslator translator(w, bytecode, bytecodeCount, scriptInfo->stackSpaceRequired);
+
+    // Only jump targets get labels, to avoid unused label warnings.
+    DynArray<bool> isJumpTarget{Allocator{}};
+    if (isJumpTarget.reserve(bytecodeCount).hasErr()) {
+        w.outOfMemory = true;
+        return;
+    }
+    for (size_t i = 0; i < bytecodeCount; i++) {
+        (void)isJumpTarget.push(false);
+    }
+    for (size_t pos = 0; pos < bytecodeCount; pos += bytecode[pos].bytecodeUsed()) {
+        size_t target = 0;
+        if (translator.jumpTargetOf(pos, target)) {
+            isJumpTarget[target] = true;
+        }
+    }
+
+    w.write("\nstatic const uint64_t* sy_aot_");
+    writeIdentifier(w, module->name.asSlice());
+    w.fmt("_%zu(uint64_t* v, uintptr_t* t, const uint64_t* bytecode) {\n", index);
+    w.write("    (void)t;\n");
+    size_t pos = 0;
+    while (pos < bytecodeCount) {
+        if (isJumpTarget[pos]) {
+            w.fmt("L%zu:\n", pos);
+        }
+        if (!translator.translate(pos)) {
+            w.fmt("    return bytecode + %zu;\n", pos);
+        }
+        pos += bytecode[pos].bytecodeUsed();
+    }
+    // Malformed bytecode running off the end is handed back to the interpreter.
+    w.fmt("    return bytecode + %zu;\n}\n", bytecodeCount);
+}
+} // namespace
+
+Result<String, AllocErr> sy::emitModuleC(const ProgramModuleInternal* module,
+                                         Allocator alloc) noexcept {
+    auto builderRes = StringBuilder::init(alloc);
+    if (builderRes.hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    CWriter w{builderRes.takeValue()};
+
+    w.write("/* Generated by sync for module ");
+    w.stringLiteral(module->name.asSlice());
+    w.write(". Do not edit. */\n\n");
+    w.write(StringSlice(C_PREAMBLE, sizeof(C_PREAMBLE) - 1));
+
+    for (size_t i = 0; i < module->allFunctionsLen; i++) {
+        if (isTranslatable(module, i)) {
+            writeFunction(w, module, i);
+        }
+    }
+
+    // Static initialization of an empty array is not valid C, so there is always a terminator.
+    w.write("\nconst SyAotFunction sy_aot_");
+    writeIdentifier(w, module->name.asSlice());
+    w.write("_functions[] = {\n");
+    size_t functionsLen = 0;
+    for (size_t i = 0; i < module->allFunctionsLen; i++) {
+        if (!isTranslatable(module, i)) {
+            continue;
+        }
+        const StringSlice qualifiedName = module->allFunctionQualifiedNames[i].asSlice();
+        w.write("    {");
+        w.stringLiteral(qualifiedName);
+        w.fmt(", %zu, 0x%016llxULL, sy_aot_", qualifiedName.len(),
+              static_cast<unsigned long long>(
+                  scriptFunctionHash(&module->allFunctionScriptInfo[i])));
+        writeIdentifier(w, module->name.asSlice());
+        w.fmt("_%zu},\n", i);
+        functionsLen += 1;
+    }
+    w.write("    {NULL, 0, 0, NULL},\n};\n");
+    w.write("const size_t sy_aot_");
+    writeIdentifier(w, module->name.asSlice());
+    w.fmt("_functions_len = %zu;\n", functionsLen);
+
+    if (w.outOfMemory) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    return w.builder.build();
+}
+
+size_t sy::registerModuleC(const ProgramModuleInternal* module, const AotCFunction* functions,
+                           size_t len) noexcept {
+    static_assert(sizeof(AotCEntryFn) == sizeof(JitEntryFn));
+
+    size_t registered = 0;
+    for (size_t i = 0; i < module->allFunctionsLen; i++) {
+        if (!isTranslatable(module, i)) {
+            continue;
+        }
+        const InterpreterFunctionScriptInfo* scriptInfo = &module->allFunctionScriptInfo[i];
+        sy_assert(scriptInfo->jit != nullptr, "Script functions must have JIT state");
+
+        const StringSlice qualifiedName = module->allFunctionQualifiedNames[i].asSlice();
+        for (size_t j = 0; j < len; j++) {
+            const AotCFunction& function = functions[j];
+            if (function.entry == nullptr ||
+                StringSlice(function.qualifiedName, function.qualifiedNameLen) != qualifiedName) {
+                continue;
+            }
+            if (function.bytecodeHash != scriptFunctionHash(scriptInfo)) {
+                break;
+            }
+            // Both take the same pointers, as `Bytecode` and `Node::TypeOfValue` wrap integers.
+            JitEntryFn entry = nullptr;
+            memcpy(&entry, &function.entry, sizeof(JitEntryFn));
+            if (scriptInfo->jit->usePrecompiled(entry)) {
+                registered += 1;
+            }
+            break;
+        }
+    }
+    return registered;
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include "../testing/script_function.hpp"
+#include "interpreter.hpp"
+#include <string_view>
+
+using namespace sy::testing;
+
+namespace {
+/// Module of a single script function, bypassing the protected allocator.
+struct AotTestModule {
+    JitFunctionState jit{};
+    TestScriptFunction script;
+    String name;
+    String qualifiedName;
+    ProgramModuleInternal module{};
+
+    AotTestModule(const Bytecode* bytecode, size_t bytecodeCount, uint16_t stackSpaceRequired)
+        : script(bytecode, bytecodeCount, stackSpaceRequired, Reflect<int32_t>::get()),
+          name("test"), qualifiedName("tests.test") {
+        this->script.info.jit = &this->jit;
+        this->script.function.name = this->name.asSlice();
+        this->script.function.qualifiedName = this->qualifiedName.asSlice();
+
+        this->module.name = String("tests.mod-1");
+        this->module.allFunctions = &this->script.function;
+        this->module.allFunctionNames = &this->name;
+        this->module.allFunctionQualifiedNames = &this->qualifiedName;
+        this->module.allFunctionScriptInfo = &this->script.info;
+        this->module.allFunctionsLen = 1;
+    }
+};
+
+// What the generated C would be for `emitsC` below, stopping at the return.
+const uint64_t* precompiledReturnNine(uint64_t* v, uintptr_t* t, const uint64_t* bytecode) {
+    const int32_t value = 9;
+    memcpy(&v[0], &value, sizeof(int32_t));
+    t[0] = reinterpret_cast<uintptr_t>(Reflect<int32_t>::get());
+    return bytecode + 2;
+}
+} // namespace
+
+TEST_CASE("[emitModuleC] emits translated operations and exits") {
+    auto jump = makeOperands<operators::Jump>();
+    jump.amount = -1;
+
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 9),
+                                 setScalarType(ScalarTag::I32, 0), returnValue(0), Bytecode(jump)};
+    AotTestModule test(bytecode, 4, 2);
+
+    auto res = emitModuleC(&test.module);
+    REQUIRE(res.hasValue());
+    const std::string_view source = res.value();
+
+    CHECK_NE(source.find("static const uint64_t* sy_aot_tests_mod_1_0("), std::string_view::npos);
+    CHECK_NE(source.find("sy_aot_st_u32(v, 0, 9U);"), std::string_view::npos);
+    CHECK_NE(source.find("t[0] = (uintptr_t)SY_TYPE_I32;"), std::string_view::npos);
+    // Return goes through the interpreter, and is a jump target.
+    CHECK_NE(source.find("L2:\n    return bytecode + 2;"), std::string_view::npos);
+    CHECK_NE(source.find("goto L2;"), std::string_view::npos);
+    CHECK_NE(source.find("{\"tests.test\", 10, 0x"), std::string_view::npos);
+    CHECK_NE(source.find("sy_aot_tests_mod_1_functions_len = 1;"), std::string_view::npos);
+}
+
+TEST_CASE("[registerModuleC] runs precompiled code") {
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 9),
+                                 setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    AotTestModule test(bytecode, 3, 2);
+
+    AotCFunction function{"tests.test", 10, 0, precompiledReturnNine};
+
+    // Stale code is never used.
+    CHECK_EQ(registerModuleC(&test.module, &function, 1), 0);
+    CHECK_EQ(test.jit.entry(), nullptr);
+
+    function.bytecodeHash = scriptFunctionHash(&test.script.info);
+    CHECK_EQ(registerModuleC(&test.module, &function, 1), 1);
+    CHECK_NE(test.jit.entry(), nullptr);
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&test.script.function, &result));
+    CHECK_EQ(result, 9);
+}
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef SY_INTERPRETER_AOT_C_HPP_
+#define SY_INTERPRETER_AOT_C_HPP_
+
+#include "../core/core.h"
+#include "../mem/allocator.hpp"
+#include "../types/result/result.hpp"
+#include "../types/string/string.hpp"
+
+namespace sy {
+struct ProgramModuleInternal;
+
+/// Signature of the functions generated by `emitModuleC(...)`, which is the C equivalent of
+/// `JitEntryFn`. Frame types are the masks of `Node::TypeOfValue`, and `bytecode` is the start of
+/// the script function's bytecode, which is needed to hand execution back to the interpreter.
+using AotCEntryFn = const uint64_t* (*)(uint64_t* frameValues, uintptr_t* frameTypes,
+                                        const uint64_t* bytecode);
+
+/// Layout of an element of the function table within a generated C translation unit. The table is
+/// named `sy_aot_<module>_functions`, with it's length being `sy_aot_<module>_functions_len`.
+struct AotCFunction {
+    const char* qualifiedName;
+    size_t qualifiedNameLen;
+    /// Checksum of the bytecode and frame length that `entry` was generated from. Generated code
+    /// with a mismatching checksum is stale, and is never used.
+    uint64_t bytecodeHash;
+    AotCEntryFn entry;
+};
+
+/// Emits a C translation unit for every script function within `module`, walking
+/// `ProgramModuleInternal::allFunctionScriptInfo`. The generated functions operate directly on the
+/// same `Stack` frame layout as the interpreter, handing execution back to it for operations that
+/// are not translated, such as calls, returns, and destructors. Unwinding still uses the
+/// function's unwind slots, so generated code never owns any objects.
+///
+/// Compiling the generated source into a host binary, and passing it's function table to
+/// `registerModuleC(...)`, skips interpreting those operations entirely, without changing how
+/// functions are found through `Program` or called through `RawFunction`.
+[[nodiscard]] Result<String, AllocErr> emitModuleC(const ProgramModuleInternal* module,
+                                                   Allocator alloc = {}) noexcept;
+
+/// Makes script functions within `module` run the ahead of time compiled code of the matching
+/// entry within `functions`, using `JitFunctionState::usePrecompiled(...)`. Entries are matched by
+/// qualified name, and are skipped if their bytecode checksum does not match. The checksum covers
+/// called functions and types by name, so it matches across processes.
+/// @return The amount of functions now using generated code.
+size_t registerModuleC(const ProgramModuleInternal* module, const AotCFunction* functions,
+                       size_t len) noexcept;
+} // namespace sy
+
+#endif // SY_INTERPRETER_AOT_C_HPP_
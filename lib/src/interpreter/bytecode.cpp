@@ -5,17 +5,94 @@
 using namespace sy;
 using sy::internal::ReflectImpl;
 
-OpCode sy::Bytecode::getOpcode() const {
-    // This is safe.
-    return static_cast<OpCode>(this->value & OPCODE_BITMASK);
-}
-
 void sy::Bytecode::assertOpCodeMatch(OpCode actual, OpCode expected) {
     sy_assert(actual == expected, "Cannot convert this bytecode to an invalid operand");
     (void)actual;
     (void)expected;
 }
 
+const char* sy::opcodeName(OpCode opcode) {
+    switch (opcode) {
+    case OpCode::Noop:
+        return "Noop";
+    case OpCode::Return:
+        return "Return";
+    case OpCode::ReturnValue:
+        return "ReturnValue";
+    case OpCode::CallImmediateNoReturn:
+        return "CallImmediateNoReturn";
+    case OpCode::CallSrcNoReturn:
+        return "CallSrcNoReturn";
+    case OpCode::CallImmediateWithReturn:
+        return "CallImmediateWithReturn";
+    case OpCode::CallSrcWithReturn:
+        return "CallSrcWithReturn";
+    case OpCode::LoadDefault:
+        return "LoadDefault";
+    case OpCode::LoadImmediateScalar:
+        return "LoadImmediateScalar";
+    case OpCode::MemsetUninitialized:
+        return "MemsetUninitialized";
+    case OpCode::SetType:
+        return "SetType";
+    case OpCode::SetNullType:
+        return "SetNullType";
+    case OpCode::Jump:
+        return "Jump";
+    case OpCode::JumpIfFalse:
+        return "JumpIfFalse";
+    case OpCode::Destruct:
+        return "Destruct";
+    case OpCode::Sync:
+        return "Sync";
+    case OpCode::Unsync:
+        return "Unsync";
+    case OpCode::Move:
+        return "Move";
+    case OpCode::Clone:
+        return "Clone";
+    case OpCode::Dereference:
+        return "Dereference";
+    case OpCode::SetReference:
+        return "SetReference";
+    case OpCode::MakeReference:
+        return "MakeReference";
+    case OpCode::GetMember:
+        return "GetMember";
+    case OpCode::SetMember:
+        return "SetMember";
+    case OpCode::Equal:
+        return "Equal";
+    case OpCode::NotEqual:
+        return "NotEqual";
+    case OpCode::Less:
+        return "Less";
+    case OpCode::LessEqual:
+        return "LessEqual";
+    case OpCode::Greater:
+        return "Greater";
+    case OpCode::GreaterEqual:
+        return "GreaterEqual";
+    case OpCode::Add:
+        return "Add";
+    case OpCode::TailCallImmediate:
+        return "TailCallImmediate";
+    case OpCode::TailCallSrc:
+        return "TailCallSrc";
+    case OpCode::Yield:
+        return "Yield";
+    case OpCode::CompareJumpIfFalse:
+        return "CompareJumpIfFalse";
+    case OpCode::LoadImmediateScalarSetType:
+        return "LoadImmediateScalarSetType";
+    case OpCode::LoadDefaultSetType:
+        return "LoadDefaultSetType";
+    case OpCode::DestructMany:
+        return "DestructMany";
+    }
+    return "Unknown";
+}
+
 const sy::Type* sy::scalarTypeFromTag(ScalarTag tag) {
     switch (tag) {
     case ScalarTag::Bool:
@@ -46,6 +123,47 @@ const sy::Type* sy::scalarTypeFromTag(ScalarTag tag) {
     sync_unreachable();
 }
 
+size_t sy::Bytecode::bytecodeUsed() const {
+    switch (this->getOpcode()) {
+    case OpCode::CallImmediateNoReturn:
+        return operators::CallImmediateNoReturn::bytecodeUsed(
+            this->toOperands<operators::CallImmediateNoReturn>().argCount);
+    case OpCode::CallSrcNoReturn:
+        return operators::CallSrcNoReturn::bytecodeUsed(
+            this->toOperands<operators::CallSrcNoReturn>().argCount);
+    case OpCode::CallImmediateWithReturn:
+        return operators::CallImmediateWithReturn::bytecodeUsed(
+            this->toOperands<operators::CallImmediateWithReturn>().argCount);
+    case OpCode::CallSrcWithReturn:
+        return operators::CallSrcWithReturn::bytecodeUsed(
+            this->toOperands<operators::CallSrcWithReturn>().argCount);
+    case OpCode::TailCallImmediate:
+        return operators::TailCallImmediate::bytecodeUsed(
+            this->toOperands<operators::TailCallImmediate>().argCount);
+    case OpCode::TailCallSrc:
+        return operators::TailCallSrc::bytecodeUsed(
+            this->toOperands<operators::TailCallSrc>().argCount);
+    case OpCode::LoadDefault:
+        return this->toOperands<operators::LoadDefault>().isScalar ? 1 : 2;
+    case OpCode::LoadImmediateScalar:
+        return operators::LoadImmediateScalar::bytecodeUsed(
+            static_cast<ScalarTag>(this->toOperands<operators::LoadImmediateScalar>().scalarTag));
+    case OpCode::SetType:
+        return this->toOperands<operators::SetType>().isScalar ? 1 : 2;
+    case OpCode::GetMember:
+        return this->toOperands<operators::GetMember>().isScalar ? 1 : 2;
+    case OpCode::SetMember:
+        return this->toOperands<operators::SetMember>().isScalar ? 1 : 2;
+    case OpCode::CompareJumpIfFalse:
+        return 2;
+    case OpCode::LoadImmediateScalarSetType:
+        return operators::LoadImmediateScalarSetType::bytecodeUsed(static_cast<ScalarTag>(
+            this->toOperands<operators::LoadImmediateScalarSetType>().scalarTag));
+    default:
+        return 1;
+    }
+}
+
 size_t sy::operators::CallImmediateNoReturn::bytecodeUsed(uint16_t argCount) {
     /// Initial bytecode + immediate function
     size_t used = 1 + 1;
@@ -58,8 +176,8 @@ size_t sy::operators::CallImmediateNoReturn::bytecodeUsed(uint16_t argCount) {
 }
 
 size_t sy::operators::CallSrcNoReturn::bytecodeUsed(uint16_t argCount) {
-    /// Initial bytecode
-    size_t used = 1;
+    /// Initial bytecode + call site cache index
+    size_t used = 1 + 1;
     if ((argCount % 4) == 0) {
         used += (argCount / 4);
     } else {
@@ -80,8 +198,8 @@ size_t sy::operators::CallImmediateWithReturn::bytecodeUsed(uint16_t argCount) {
 }
 
 size_t sy::operators::CallSrcWithReturn::bytecodeUsed(uint16_t argCount) {
-    /// Initial bytecode
-    size_t used = 1;
+    /// Initial bytecode + call site cache index
+    size_t used = 1 + 1;
     if ((argCount % 4) == 0) {
         used += (argCount / 4);
     } else {
@@ -90,6 +208,14 @@ size_t sy::operators::CallSrcWithReturn::bytecodeUsed(uint16_t argCount) {
     return used;
 }
 
+size_t sy::operators::TailCallImmediate::bytecodeUsed(uint16_t argCount) {
+    return CallImmediateNoReturn::bytecodeUsed(argCount);
+}
+
+size_t sy::operators::TailCallSrc::bytecodeUsed(uint16_t argCount) {
+    return CallSrcNoReturn::bytecodeUsed(argCount);
+}
+
 size_t sy::operators::LoadImmediateScalar::bytecodeUsed(ScalarTag scalarTag) {
     const sy::Type* scalarType = scalarTypeFromTag(scalarTag);
     if (scalarType->sizeType <= 4) {
@@ -100,3 +226,7 @@ size_t sy::operators::LoadImmediateScalar::bytecodeUsed(ScalarTag scalarTag) {
         return 1 + (1 + scalarType->sizeType / alignof(Bytecode));
     }
 }
+
+size_t sy::operators::LoadImmediateScalarSetType::bytecodeUsed(ScalarTag scalarTag) {
+    return LoadImmediateScalar::bytecodeUsed(scalarTag);
+}
@@ -23,16 +23,20 @@ enum class OpCode : uint8_t {
     /// extending as necessary as an array of `uint16_t` values. The function returns no value.
     /// Is at least 2 wide, but often more depending on function arguments. Uses `operators::CallImmediateNoReturn`.
     CallImmediateNoReturn,
-    /// Calls a function at `src`. The function argument sources start after the initial bytecode, extending as
-    /// necessary as an array of `uint16_t` values. The function returns no value. Uses `operators::CallSrcNoReturn`.
+    /// Calls a function at `src`. The bytecode after the initial one is the `uint64_t` index of the call site's
+    /// `sy::CallSiteCache` within the function's script info, or `NO_CALL_SITE_CACHE`. The function argument sources
+    /// start after it, extending as necessary as an array of `uint16_t` values. The function returns no value.
+    /// Is at least 2 wide. Uses `operators::CallSrcNoReturn`.
     CallSrcNoReturn,
     /// Calls a function whose `const sy::Function*` instance is provided within the bytecode as the one after the
     /// initial bytecode. The function argument sources started at the bytecode after the immediate function bytecode,
     /// extending as necessary as an array of `uint16_t` values. The function returns a value.
     /// Is at least 2 wide, but often more depending on function arguments. Uses `operators::CallImmediateWithReturn`.
     CallImmediateWithReturn,
-    /// Calls a function at `src`. The function argument sources start after the initial bytecode, extending as
-    /// necessary as an array of `uint16_t` values. The function returns a value. Uses `operators::CallSrcWithReturn`.
+    /// Calls a function at `src`. The bytecode after the initial one is the `uint64_t` index of the call site's
+    /// `sy::CallSiteCache` within the function's script info, or `NO_CALL_SITE_CACHE`. The function argument sources
+    /// start after it, extending as necessary as an array of `uint16_t` values. The function returns a value.
+    /// Is at least 2 wide. Uses `operators::CallSrcWithReturn`.
     CallSrcWithReturn,
     /// May be 2 wide instruction if loading the default value for non scalar types.
     /// For scalar types, loads zero values. Uses `operators::LoadDefault`.
@@ -64,22 +68,78 @@ enum class OpCode : uint8_t {
     Destruct,
     Sync,
     Unsync,
+    /// Moves the object at `src` into `dst`. For non scalar types, the type info of `src` is moved to `dst`, leaving
+    /// `src` with a null type. Scalar moves are a plain slot copy, and don't touch type info. Uses `operators::Move`.
     Move,
+    /// Clones the object at `src` into `dst`. For non scalar types, uses the type's clone function, and sets the type
+    /// of `dst`. Scalar clones are a plain slot copy, and don't touch type info. Uses `operators::Clone`.
     Clone,
     Dereference,
     SetReference,
     MakeReference,
+    /// Clones the member at byte offset `memberOffset` within the object at `src` into `dst`.
+    /// May be 2 wide instruction, if the member is not a scalar type, thus `isScalar` flag is false, with the second
+    /// "bytecode" being the member's `const sy::Type*`. Uses `operators::GetMember`.
     GetMember,
+    /// Moves `src` into the member at byte offset `memberOffset` within the object at `dst`, destroying the previous
+    /// member. May be 2 wide instruction, if the member is not a scalar type, thus `isScalar` flag is false, with the
+    /// second "bytecode" being the member's `const sy::Type*`. Uses `operators::SetMember`.
     SetMember,
+    /// Stores `lhs == rhs` as a bool in `dst`. Uses `operators::Equal`.
     Equal,
+    /// Stores `lhs != rhs` as a bool in `dst`. Uses `operators::NotEqual`.
     NotEqual,
+    /// Stores `lhs < rhs` as a bool in `dst`. Uses `operators::Less`.
     Less,
+    /// Stores `lhs <= rhs` as a bool in `dst`. Uses `operators::LessEqual`.
     LessEqual,
+    /// Stores `lhs > rhs` as a bool in `dst`. Uses `operators::Greater`.
     Greater,
+    /// Stores `lhs >= rhs` as a bool in `dst`. Uses `operators::GreaterEqual`.
     GreaterEqual,
+    /// Stores `lhs + rhs` in `dst`. Integer addition wraps on overflow. Only scalar numeric types are supported.
+    /// Uses `operators::Add`.
     Add,
+    /// Tail call form of `CallImmediateWithReturn` and `CallImmediateNoReturn`, for `return f(...)`. The callee's
+    /// return value goes directly to the current function's return value destination, so the callee must have the
+    /// same return type as the current function. The current frame is unwinded, and then reused by the callee
+    /// rather than pushing a new frame, so recursion through tail calls runs in constant stack space. Arguments are
+    /// moved into the callee, as the current frame no longer exists once it runs. Is at least 2 wide, with the same
+    /// layout as `CallImmediateNoReturn`. Uses `operators::TailCallImmediate`.
+    TailCallImmediate,
+    /// Tail call form of `CallSrcWithReturn` and `CallSrcNoReturn`, calling the function at `src`. See
+    /// `TailCallImmediate`. Has the same layout as `CallSrcNoReturn`, including the call site cache index.
+    /// Uses `operators::TailCallSrc`.
+    TailCallSrc,
+    /// Suspends the coroutine or preemptible execution running the current function, returning control to whoever
+    /// resumed it. Execution continues from the following operation once resumed. Does nothing when the function isn't
+    /// being run by either, as nothing can resume it. Uses `operators::Yield`.
+    Yield,
+
+    // Superinstructions. These are not emitted by the compiler directly, but are instead produced by
+    // `FunctionBuilder::fuseSuperinstructions()` from common sequences of the operations above.
+
+    /// Scalar comparison (`Equal` through `GreaterEqual`) followed by a `JumpIfFalse` on its result. Stores the
+    /// comparison result in `dst`, then jumps by `amount` bytecodes if it is false. Is 2 wide, with the second
+    /// "bytecode" being the `int64_t` jump amount. Uses `operators::CompareJumpIfFalse`.
+    CompareJumpIfFalse,
+    /// `LoadImmediateScalar` followed by a scalar `SetType` of the same `dst`. Is as wide as the
+    /// `LoadImmediateScalar` it replaces. Uses `operators::LoadImmediateScalarSetType`.
+    LoadImmediateScalarSetType,
+    /// Scalar `LoadDefault` and scalar `SetType` of the same `dst`, in either order.
+    /// Uses `operators::LoadDefaultSetType`.
+    LoadDefaultSetType,
+    /// Run of up to 3 `Destruct` operations. Uses `operators::DestructMany`.
+    DestructMany,
 };
 
+/// Amount of opcodes within `OpCode`. Must be kept in sync with the last opcode, as the interpreter
+/// dispatch table is sized by it.
+constexpr size_t OPCODE_COUNT = static_cast<size_t>(OpCode::DestructMany) + 1;
+
+/// Name of `opcode`, matching its enumerator, such as `"LoadDefault"`. Unknown opcodes are `"Unknown"`.
+const char* opcodeName(OpCode opcode);
+
 constexpr size_t OPCODE_USED_BITS = 8;
 constexpr size_t OPCODE_BITMASK = 0b11111111;
 
@@ -97,12 +157,18 @@ struct Bytecode {
         *this = reinterpret_cast<const Bytecode&>(operands);
     }
 
-    OpCode getOpcode() const;
+    /// Inline as this is read once per dispatched instruction.
+    OpCode getOpcode() const { return static_cast<OpCode>(this->value & OPCODE_BITMASK); }
+
+    /// Amount of bytecodes used by the operation starting at this bytecode, including itself.
+    size_t bytecodeUsed() const;
 
     template <typename OperandsT> OperandsT toOperands() const {
         static_assert(sizeof(OperandsT) == sizeof(Bytecode));
         static_assert(alignof(OperandsT) == alignof(Bytecode));
+#ifndef NDEBUG
         assertOpCodeMatch(this->getOpcode(), OperandsT::OPCODE);
+#endif
         return *reinterpret_cast<const OperandsT*>(this);
     }
 
@@ -110,6 +176,9 @@ struct Bytecode {
     static void assertOpCodeMatch(OpCode actual, OpCode expected);
 };
 
+/// Operations carrying a `ScalarTag` with their `isScalar` flag set execute a typed kernel directly on the slot
+/// memory. They neither read nor write type info, so the type of their destination must already be set, usually with
+/// `OpCode::SetType`.
 enum class ScalarTag : uint8_t {
     Bool,
     I8,
@@ -190,6 +259,32 @@ struct CallSrcWithReturn {
     static constexpr OpCode OPCODE = OpCode::CallSrcWithReturn;
 };
 
+struct TailCallImmediate {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    uint64_t argCount : 16;
+
+    static size_t bytecodeUsed(uint16_t argCount);
+
+    static constexpr OpCode OPCODE = OpCode::TailCallImmediate;
+};
+
+struct TailCallSrc {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    uint64_t src : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t argCount : 16;
+
+    static size_t bytecodeUsed(uint16_t argCount);
+
+    static constexpr OpCode OPCODE = OpCode::TailCallSrc;
+};
+
+/// Suspends the current coroutine.
+struct Yield {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+
+    static constexpr OpCode OPCODE = OpCode::Yield;
+};
+
 /// If `isScalar == false`, this is a wide instruction, with the second "bytecode" being a
 /// `const Sy::Type*` instance.
 struct LoadDefault {
@@ -264,6 +359,192 @@ struct Destruct {
     static constexpr OpCode OPCODE = OpCode::Destruct;
 };
 
+struct Move {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t src : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::Move;
+};
+
+struct Clone {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t src : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::Clone;
+};
+
+/// If `isScalar == false`, this is a wide instruction, with the second "bytecode" being a
+/// `const Sy::Type*` instance of the member.
+struct GetMember {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t src : Stack::BITS_PER_STACK_OPERAND;
+    /// Offset in bytes of the member from the start of the object at `src`.
+    uint64_t memberOffset : 16;
+
+    static constexpr OpCode OPCODE = OpCode::GetMember;
+};
+
+/// If `isScalar == false`, this is a wide instruction, with the second "bytecode" being a
+/// `const Sy::Type*` instance of the member.
+struct SetMember {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t src : Stack::BITS_PER_STACK_OPERAND;
+    /// Offset in bytes of the member from the start of the object at `dst`.
+    uint64_t memberOffset : 16;
+
+    static constexpr OpCode OPCODE = OpCode::SetMember;
+};
+
+struct Equal {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::Equal;
+};
+
+struct NotEqual {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::NotEqual;
+};
+
+struct Less {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::Less;
+};
+
+struct LessEqual {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::LessEqual;
+};
+
+struct Greater {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::Greater;
+};
+
+struct GreaterEqual {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    /// Used if `isScalar == true`
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::GreaterEqual;
+};
+
+/// Only scalar numeric types are supported, so `isScalar` must be true.
+struct Add {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Boolean
+    uint64_t isScalar : 1;
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::Add;
+};
+
+/// The second "bytecode" is the `int64_t` jump amount, relative to this bytecode.
+struct CompareJumpIfFalse {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Offset of the comparison's `OpCode` from `OpCode::Equal`.
+    uint64_t compareOp : 3;
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t lhs : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t rhs : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::CompareJumpIfFalse;
+};
+
+struct LoadImmediateScalarSetType {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t immediate : 32;
+
+    static size_t bytecodeUsed(ScalarTag scalarTag);
+
+    static constexpr OpCode OPCODE = OpCode::LoadImmediateScalarSetType;
+};
+
+struct LoadDefaultSetType {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    uint64_t scalarTag : SCALAR_TAG_USED_BITS;
+    uint64_t dst : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::LoadDefaultSetType;
+};
+
+struct DestructMany {
+    uint64_t reserveOpcode : OPCODE_USED_BITS;
+    /// Amount of used sources. Must be 2 or 3.
+    uint64_t count : 2;
+    uint64_t src0 : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t src1 : Stack::BITS_PER_STACK_OPERAND;
+    uint64_t src2 : Stack::BITS_PER_STACK_OPERAND;
+
+    static constexpr OpCode OPCODE = OpCode::DestructMany;
+};
+
 } // namespace operators
 } // namespace sy
 
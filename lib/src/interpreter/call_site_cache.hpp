@@ -0,0 +1,120 @@
+#pragma once
+#ifndef SY_INTERPRETER_CALL_SITE_CACHE_HPP_
+#define SY_INTERPRETER_CALL_SITE_CACHE_HPP_
+
+#include "../core/core.h"
+#include "../program/program_internal.hpp"
+#include "../types/function/function.hpp"
+#include <atomic>
+
+namespace sy {
+
+/// Cache index operand of an indirect call that has no inline cache. See `CallSiteCache`.
+constexpr uint64_t NO_CALL_SITE_CACHE = UINT64_MAX;
+
+/// How to call a function from an indirect call site, as resolved by `CallSiteCache`.
+struct ResolvedCall {
+    /// If `false`, the function is a C function, and the other fields are unused.
+    bool isScript = false;
+    /// `InterpreterFunctionScriptInfo::stackSpaceRequired` of the function.
+    uint16_t frameLength = 0;
+    /// `RawFunction::alignment` of the function.
+    uint16_t frameAlign = 0;
+};
+
+/// Monomorphic inline cache of an indirect call site, being `CallSrcNoReturn`,
+/// `CallSrcWithReturn`, or `TailCallSrc`. Remembers the last function called through the site,
+/// having made sure it is compiled, along with the layout of its frame, so calling the same
+/// function again skips the lazy compilation check, and pushes its arguments without reading its
+/// script info. Function objects called indirectly are copies living within frames, so functions
+/// are identified by `RawFunction::fptr` rather than by their address. C functions sharing a
+/// trampoline share an entry, which is fine as they have nothing to resolve.
+///
+/// Bytecode is read only, so the caches of a function live in
+/// `InterpreterFunctionScriptInfo::callSiteCaches`, with each call site holding the index of its
+/// cache. Multiple threads may execute the same call site, so updates are guarded by a sequence
+/// number. A lookup racing with an update is a miss.
+class CallSiteCache final {
+  public:
+    CallSiteCache() = default;
+
+    CallSiteCache(const CallSiteCache& other) = delete;
+
+    CallSiteCache& operator=(const CallSiteCache& other) = delete;
+
+    /// @return `true` if `callee` is the cached function, storing how to call it in `outResolved`.
+    [[nodiscard]] bool lookup(const RawFunction* callee, ResolvedCall& outResolved) const noexcept {
+        const uint32_t sequence = this->sequence_.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0) {
+            return false;
+        }
+        if (this->target_.load(std::memory_order_relaxed) != callee->fptr) {
+            return false;
+        }
+        const uint64_t resolved = this->resolved_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (this->sequence_.load(std::memory_order_relaxed) != sequence) {
+            return false;
+        }
+        outResolved = unpack(resolved);
+        return true;
+    }
+
+    /// @return How to call `callee`, which must already be compiled, without caching it.
+    static ResolvedCall resolve(const RawFunction* callee) noexcept {
+        ResolvedCall resolved{};
+        if (callee->tag == FunctionType::Script) {
+            const InterpreterFunctionScriptInfo* scriptInfo =
+                reinterpret_cast<const InterpreterFunctionScriptInfo*>(callee->fptr);
+            resolved.isScript = true;
+            resolved.frameLength = scriptInfo->stackSpaceRequired;
+            resolved.frameAlign = callee->alignment;
+        }
+        return resolved;
+    }
+
+    /// Caches `callee`, replacing whichever function was cached before. Does nothing if another
+    /// thread is updating the cache at the same time. `callee` must already be compiled.
+    /// @return How to call `callee`.
+    ResolvedCall update(const RawFunction* callee) noexcept {
+        const ResolvedCall resolved = resolve(callee);
+        uint32_t sequence = this->sequence_.load(std::memory_order_relaxed);
+        if ((sequence & 1) != 0 ||
+            !this->sequence_.compare_exchange_strong(sequence, sequence + 1,
+                                                     std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+            return resolved;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        this->target_.store(callee->fptr, std::memory_order_relaxed);
+        this->resolved_.store(pack(resolved), std::memory_order_relaxed);
+        this->sequence_.store(sequence + 2, std::memory_order_release);
+        return resolved;
+    }
+
+  private:
+    static uint64_t pack(ResolvedCall resolved) noexcept {
+        return static_cast<uint64_t>(resolved.isScript) |
+               (static_cast<uint64_t>(resolved.frameLength) << 16) |
+               (static_cast<uint64_t>(resolved.frameAlign) << 32);
+    }
+
+    static ResolvedCall unpack(uint64_t packed) noexcept {
+        ResolvedCall resolved{};
+        resolved.isScript = (packed & 1) != 0;
+        resolved.frameLength = static_cast<uint16_t>(packed >> 16);
+        resolved.frameAlign = static_cast<uint16_t>(packed >> 32);
+        return resolved;
+    }
+
+    /// Odd while being updated.
+    std::atomic<uint32_t> sequence_{0};
+    /// `RawFunction::fptr` of the cached function.
+    std::atomic<const void*> target_{nullptr};
+    /// `ResolvedCall` of the cached function, packed into a single word.
+    std::atomic<uint64_t> resolved_{0};
+};
+
+} // namespace sy
+
+#endif // SY_INTERPRETER_CALL_SITE_CACHE_HPP_
@@ -0,0 +1,158 @@
+#include "coroutine.hpp"
+#include "../core/core_internal.h"
+#include "../types/function/function.hpp"
+#include "stack/stack.hpp"
+#include <utility>
+
+using namespace sy;
+
+Result<Coroutine, AnyError> Coroutine::create(const RawFunction* scriptFunction,
+                                              void* const* args,
+                                              void* outReturnValue) noexcept {
+    sy_assert(scriptFunction->tag == FunctionType::Script,
+              "Coroutines can only run script functions");
+
+    auto startRes = PreemptibleExecution::start(scriptFunction, args, outReturnValue);
+    if (startRes.hasErr()) {
+        return Error(startRes.takeErr());
+    }
+
+    Coroutine coroutine;
+    coroutine.execution_ = startRes.takeValue();
+    return coroutine;
+}
+
+Result<ExecutionStatus, AnyError> Coroutine::resume(uint64_t budget) noexcept {
+    sy_assert(!this->isFinished(), "Cannot resume a finished coroutine");
+    return this->execution_.resume(budget);
+}
+
+void Coroutine::cancel() noexcept { this->execution_.cancel(); }
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include "../testing/script_function.hpp"
+#include "../types/type_info.hpp"
+
+using namespace sy::testing;
+
+namespace {
+Bytecode yield() {
+    operators::Yield operands{};
+    operands.reserveOpcode = static_cast<uint64_t>(operators::Yield::OPCODE);
+    return Bytecode(operands);
+}
+} // namespace
+
+TEST_CASE("[coroutine] yields and resumes on its own stack") {
+    // x = 1; yield; x += 10; yield; return x;
+    const Bytecode bytecode[] = {loadI32(0, 1), loadI32(1, 10), yield(), addI32(0, 0, 1),
+                                 yield(),       returnValue(0)};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                          Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    auto createRes = Coroutine::create(&fn.function, nullptr, &result);
+    REQUIRE(createRes);
+    Coroutine coroutine = createRes.takeValue();
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+
+    CHECK_EQ(coroutine.resume().value(), ExecutionStatus::Yielded);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+    CHECK_EQ(coroutine.resume().value(), ExecutionStatus::Yielded);
+    CHECK_EQ(result, 0);
+    CHECK_EQ(coroutine.resume().value(), ExecutionStatus::Finished);
+    CHECK(coroutine.isFinished());
+    CHECK_EQ(result, 11);
+}
+
+TEST_CASE("[coroutine] many coroutines interleave") {
+    operators::CompareJumpIfFalse compareJump{};
+    compareJump.reserveOpcode = static_cast<uint64_t>(operators::CompareJumpIfFalse::OPCODE);
+    compareJump.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+    compareJump.compareOp =
+        static_cast<uint64_t>(OpCode::Less) - static_cast<uint64_t>(OpCode::Equal);
+    compareJump.dst = 2;
+    compareJump.lhs = 1;
+    compareJump.rhs = 0;
+    Bytecode exitAmount;
+    exitAmount.value = 6;
+
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = -5;
+
+    // sum(n) { total = 0; for (i = 0; i < n; i += 1) { total += i; yield; } return total; }
+    const Bytecode bytecode[] = {
+        loadI32(1, 0),       loadI32(3, 1),   loadI32(4, 0),
+        Bytecode(compareJump), exitAmount,    // loop header
+        addI32(4, 4, 1),     addI32(1, 1, 3), yield(),
+        Bytecode(jump),      returnValue(4),
+    };
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 6,
+                          Reflect<int32_t>::get());
+    const Type* argsTypes[1] = {Reflect<int32_t>::get()};
+    fn.function.argsTypes = argsTypes;
+    fn.function.argsLen = 1;
+
+    constexpr int32_t COUNT = 256;
+    Coroutine coroutines[COUNT];
+    int32_t results[COUNT] = {};
+    for (int32_t i = 0; i < COUNT; i++) {
+        int32_t n = i % 7;
+        void* args[1] = {&n};
+        auto createRes = Coroutine::create(&fn.function, args, &results[i]);
+        REQUIRE(createRes);
+        coroutines[i] = createRes.takeValue();
+    }
+
+    // Round robin, each coroutine running one iteration at a time.
+    size_t rounds = 0;
+    bool anyRunning = true;
+    while (anyRunning) {
+        anyRunning = false;
+        for (Coroutine& coroutine : coroutines) {
+            if (coroutine.isFinished()) {
+                continue;
+            }
+            auto res = coroutine.resume();
+            REQUIRE(res);
+            anyRunning = anyRunning || res.value() != ExecutionStatus::Finished;
+        }
+        rounds += 1;
+    }
+    CHECK_EQ(rounds, 7);
+
+    for (int32_t i = 0; i < COUNT; i++) {
+        const int32_t n = i % 7;
+        CHECK_EQ(results[i], (n * (n - 1)) / 2);
+    }
+}
+
+TEST_CASE("[coroutine] unfinished coroutines can be moved and cancelled") {
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = -1;
+
+    // while (true) { yield; }
+    const Bytecode bytecode[] = {yield(), Bytecode(jump)};
+    TestScriptFunction fn(bytecode, 2, 2, nullptr);
+
+    auto createRes = Coroutine::create(&fn.function, nullptr, nullptr);
+    REQUIRE(createRes);
+    Coroutine coroutine = createRes.takeValue();
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQ(coroutine.resume().value(), ExecutionStatus::Yielded);
+    }
+    CHECK_EQ(coroutine.resume(1).value(), ExecutionStatus::Suspended);
+    CHECK_FALSE(coroutine.isFinished());
+
+    Coroutine moved = std::move(coroutine);
+    CHECK(coroutine.isFinished());
+    CHECK_FALSE(moved.isFinished());
+    moved.cancel();
+    CHECK(moved.isFinished());
+}
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef SY_INTERPRETER_COROUTINE_HPP_
+#define SY_INTERPRETER_COROUTINE_HPP_
+
+#include "../core/core.h"
+#include "../types/anyerror/anyerror.hpp"
+#include "../types/result/result.hpp"
+#include "interpreter.hpp"
+
+namespace sy {
+class RawFunction;
+class Stack;
+
+/// Call of a script function running on a `Stack` of its own, which can yield back to whoever
+/// resumed it with the `Yield` operation, and be resumed later on, without an OS thread of its own.
+/// Resuming makes the coroutine's stack the active stack until it stops, then restores the
+/// previously active one, so coroutines are as cheap as their stack.
+///
+/// Coroutines are asymmetric, meaning they always yield back to whoever resumed them. One coroutine
+/// transfers control to another by resuming it, such as through a C function, continuing once the
+/// other yields or finishes. A coroutine can be resumed by different threads over its lifetime, but
+/// not concurrently.
+class Coroutine final {
+  public:
+    Coroutine() = default;
+
+    /// Cancels the coroutine if it hasn't finished, and frees its stack.
+    ~Coroutine() noexcept = default;
+
+    Coroutine(Coroutine&& other) noexcept = default;
+
+    Coroutine& operator=(Coroutine&& other) noexcept = default;
+
+    Coroutine(const Coroutine& other) = delete;
+
+    Coroutine& operator=(const Coroutine& other) = delete;
+
+    /// Creates a coroutine with a new stack, starting a call of `scriptFunction` on it without
+    /// executing any of it. The arguments are moved from `args`, which must have the types of the
+    /// function's arguments, in order. The return value is stored in `outReturnValue` once the
+    /// coroutine finishes, so must remain valid until then. Same return value requirements as
+    /// `interpreterExecuteScriptFunction(...)`.
+    [[nodiscard]] static Result<Coroutine, AnyError>
+    create(const RawFunction* scriptFunction, void* const* args, void* outReturnValue) noexcept;
+
+    /// Runs the coroutine until it yields or finishes, or `budget` preemption points have passed.
+    /// See `PreemptibleExecution::resume(...)`.
+    /// # Debug Asserts
+    /// The coroutine must not have finished, and must not be running, such as by resuming itself.
+    Result<ExecutionStatus, AnyError> resume(uint64_t budget = UINT64_MAX) noexcept;
+
+    /// Unwinds the coroutine's frames without finishing its function, if it hasn't finished.
+    void cancel() noexcept;
+
+    /// @return `true` if the function has returned, failed, or been cancelled, in which case the
+    /// coroutine can't be resumed.
+    [[nodiscard]] bool isFinished() const noexcept { return !this->execution_.isSuspended(); }
+
+  private:
+    PreemptibleExecution execution_{};
+};
+} // namespace sy
+
+#endif // SY_INTERPRETER_COROUTINE_HPP_
@@ -27,3 +27,867 @@ Result<void, AllocErr> sy::FunctionBuilder::pushUnwindSlot(int16_t slot) noexcep
               "Slot to unwind cannot exceed the stack space required by a function");
     return this->unwindSlots.push(slot);
 }
+
+uint64_t sy::FunctionBuilder::addCallSiteCache() noexcept {
+    const uint64_t index = this->callSiteCacheCount;
+    this->callSiteCacheCount += 1;
+    return index;
+}
+
+namespace {
+struct JumpFixup {
+    /// Position of the jump operation within the fused bytecode.
+    size_t newPos;
+    /// Position of the jump target within the original bytecode.
+    size_t oldTarget;
+};
+} // namespace
+
+/// If the operation at `pos` is a jump, stores the position it jumps to in `outTarget`.
+static bool jumpTargetOf(const Bytecode* bytecode, const size_t pos, size_t& outTarget) {
+    int64_t amount = 0;
+    switch (bytecode[pos].getOpcode()) {
+    case OpCode::Jump:
+        amount = bytecode[pos].toOperands<operators::Jump>().amount;
+        break;
+    case OpCode::JumpIfFalse:
+        amount = bytecode[pos].toOperands<operators::JumpIfFalse>().amount;
+        break;
+    case OpCode::CompareJumpIfFalse:
+        amount = static_cast<int64_t>(bytecode[pos + 1].value);
+        break;
+    default:
+        return false;
+    }
+    outTarget = static_cast<size_t>(static_cast<int64_t>(pos) + amount);
+    return true;
+}
+
+template <typename OperandsT>
+static bool fuseCompareJump(const Bytecode compare, const Bytecode jump, Bytecode* out) {
+    const OperandsT compareOperands = compare.toOperands<OperandsT>();
+    const operators::JumpIfFalse jumpOperands = jump.toOperands<operators::JumpIfFalse>();
+    if (!compareOperands.isScalar || compareOperands.dst != jumpOperands.src) {
+        return false;
+    }
+
+    operators::CompareJumpIfFalse fused{};
+    fused.reserveOpcode = static_cast<uint64_t>(operators::CompareJumpIfFalse::OPCODE);
+    fused.compareOp = static_cast<uint64_t>(static_cast<uint8_t>(OperandsT::OPCODE) -
+                                            static_cast<uint8_t>(OpCode::Equal));
+    fused.scalarTag = compareOperands.scalarTag;
+    fused.dst = compareOperands.dst;
+    fused.lhs = compareOperands.lhs;
+    fused.rhs = compareOperands.rhs;
+    out[0] = Bytecode(fused);
+    // Amount is written once all jump targets have been relocated.
+    out[1] = Bytecode();
+    return true;
+}
+
+/// Fuses a scalar comparison followed by a `JumpIfFalse` on it's result into `out`, which must
+/// have space for 2 bytecodes.
+static bool tryFuseCompareJump(const Bytecode compare, const Bytecode jump, Bytecode* out) {
+    if (jump.getOpcode() != OpCode::JumpIfFalse) {
+        return false;
+    }
+    switch (compare.getOpcode()) {
+    case OpCode::Equal:
+        return fuseCompareJump<operators::Equal>(compare, jump, out);
+    case OpCode::NotEqual:
+        return fuseCompareJump<operators::NotEqual>(compare, jump, out);
+    case OpCode::Less:
+        return fuseCompareJump<operators::Less>(compare, jump, out);
+    case OpCode::LessEqual:
+        return fuseCompareJump<operators::LessEqual>(compare, jump, out);
+    case OpCode::Greater:
+        return fuseCompareJump<operators::Greater>(compare, jump, out);
+    case OpCode::GreaterEqual:
+        return fuseCompareJump<operators::GreaterEqual>(compare, jump, out);
+    default:
+        return false;
+    }
+}
+
+/// Fuses a scalar `LoadDefault` and scalar `SetType` of the same slot, in either order.
+static bool tryFuseLoadDefaultSetType(const Bytecode first, const Bytecode second, Bytecode* out) {
+    Bytecode loadDefault;
+    Bytecode setType;
+    if (first.getOpcode() == OpCode::LoadDefault && second.getOpcode() == OpCode::SetType) {
+        loadDefault = first;
+        setType = second;
+    } else if (first.getOpcode() == OpCode::SetType && second.getOpcode() == OpCode::LoadDefault) {
+        setType = first;
+        loadDefault = second;
+    } else {
+        return false;
+    }
+
+    const operators::LoadDefault loadOperands = loadDefault.toOperands<operators::LoadDefault>();
+    const operators::SetType setTypeOperands = setType.toOperands<operators::SetType>();
+    if (!loadOperands.isScalar || !setTypeOperands.isScalar ||
+        loadOperands.dst != setTypeOperands.dst ||
+        loadOperands.scalarTag != setTypeOperands.scalarTag) {
+        return false;
+    }
+
+    operators::LoadDefaultSetType fused{};
+    fused.reserveOpcode = static_cast<uint64_t>(operators::LoadDefaultSetType::OPCODE);
+    fused.scalarTag = loadOperands.scalarTag;
+    fused.dst = loadOperands.dst;
+    out[0] = Bytecode(fused);
+    return true;
+}
+
+Result<void, AllocErr> sy::FunctionBuilder::fuseSuperinstructions() noexcept {
+    const size_t oldLen = this->bytecode.len();
+    const Bytecode* old = this->bytecode.data();
+    Allocator alloc = this->bytecode.alloc();
+
+    // Operations that are jumped to must remain the start of an operation, so they cannot be fused
+    // into the one before them. The end of the bytecode is a valid jump target.
+    DynArray<bool> isJumpTarget(alloc);
+    DynArray<size_t> newOffsets(alloc);
+    DynArray<Bytecode> fused(alloc);
+    DynArray<JumpFixup> fixups(alloc);
+    if (isJumpTarget.reserve(oldLen + 1).hasErr() || newOffsets.reserve(oldLen + 1).hasErr() ||
+        fused.reserve(oldLen).hasErr() || fixups.reserve(oldLen).hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    for (size_t i = 0; i <= oldLen; i++) {
+        (void)isJumpTarget.push(false);
+        (void)newOffsets.push(0);
+    }
+
+    for (size_t pos = 0; pos < oldLen; pos += old[pos].bytecodeUsed()) {
+        size_t target = 0;
+        if (jumpTargetOf(old, pos, target)) {
+            sy_assert(target <= oldLen, "Jump target out of bounds of bytecode");
+            isJumpTarget[target] = true;
+        }
+    }
+
+    size_t pos = 0;
+    while (pos < oldLen) {
+        const size_t width = old[pos].bytecodeUsed();
+        const size_t nextPos = pos + width;
+        const bool canFuseNext = nextPos < oldLen && !isJumpTarget[nextPos];
+        newOffsets[pos] = fused.len();
+
+        Bytecode out[2];
+        if (canFuseNext && tryFuseCompareJump(old[pos], old[nextPos], out)) {
+            size_t target = 0;
+            (void)jumpTargetOf(old, nextPos, target);
+            (void)fixups.push(JumpFixup{fused.len(), target});
+            (void)fused.push(out[0]);
+            (void)fused.push(out[1]);
+            newOffsets[nextPos] = newOffsets[pos];
+            pos = nextPos + 1;
+            continue;
+        }
+
+        if (canFuseNext && tryFuseLoadDefaultSetType(old[pos], old[nextPos], out)) {
+            (void)fused.push(out[0]);
+            newOffsets[nextPos] = newOffsets[pos];
+            pos = nextPos + 1;
+            continue;
+        }
+
+        if (canFuseNext && old[pos].getOpcode() == OpCode::LoadImmediateScalar &&
+            old[nextPos].getOpcode() == OpCode::SetType) {
+            const operators::LoadImmediateScalar loadOperands =
+                old[pos].toOperands<operators::LoadImmediateScalar>();
+            const operators::SetType setTypeOperands =
+                old[nextPos].toOperands<operators::SetType>();
+            if (setTypeOperands.isScalar && loadOperands.dst == setTypeOperands.dst &&
+                loadOperands.scalarTag == setTypeOperands.scalarTag) {
+                operators::LoadImmediateScalarSetType fusedOperands{};
+                fusedOperands.reserveOpcode =
+                    static_cast<uint64_t>(operators::LoadImmediateScalarSetType::OPCODE);
+                fusedOperands.scalarTag = loadOperands.scalarTag;
+                fusedOperands.dst = loadOperands.dst;
+                fusedOperands.immediate = loadOperands.immediate;
+                (void)fused.push(Bytecode(fusedOperands));
+                // Immediate values wider than 32 bits follow the initial bytecode.
+                for (size_t i = 1; i < width; i++) {
+                    (void)fused.push(old[pos + i]);
+                }
+                newOffsets[nextPos] = newOffsets[pos];
+                pos = nextPos + 1;
+                continue;
+            }
+        }
+
+        if (canFuseNext && old[pos].getOpcode() == OpCode::Destruct &&
+            old[nextPos].getOpcode() == OpCode::Destruct) {
+            operators::DestructMany fusedOperands{};
+            fusedOperands.reserveOpcode = static_cast<uint64_t>(operators::DestructMany::OPCODE);
+            fusedOperands.count = 2;
+            fusedOperands.src0 = old[pos].toOperands<operators::Destruct>().src;
+            fusedOperands.src1 = old[nextPos].toOperands<operators::Destruct>().src;
+            newOffsets[nextPos] = newOffsets[pos];
+            pos = nextPos + 1;
+
+            if (pos < oldLen && !isJumpTarget[pos] && old[pos].getOpcode() == OpCode::Destruct) {
+                fusedOperands.count = 3;
+                fusedOperands.src2 = old[pos].toOperands<operators::Destruct>().src;
+                newOffsets[pos] = newOffsets[nextPos];
+                pos += 1;
+            }
+            (void)fused.push(Bytecode(fusedOperands));
+            continue;
+        }
+
+        size_t target = 0;
+        if (jumpTargetOf(old, pos, target)) {
+            (void)fixups.push(JumpFixup{fused.len(), target});
+        }
+        for (size_t i = 0; i < width; i++) {
+            (void)fused.push(old[pos + i]);
+        }
+        pos = nextPos;
+    }
+    newOffsets[oldLen] = fused.len();
+
+    for (size_t i = 0; i < fixups.len(); i++) {
+        const JumpFixup& fixup = fixups[i];
+        const int64_t amount = static_cast<int64_t>(newOffsets[fixup.oldTarget]) -
+                               static_cast<int64_t>(fixup.newPos);
+        Bytecode& jump = fused[fixup.newPos];
+        switch (jump.getOpcode()) {
+        case OpCode::Jump: {
+            operators::Jump operands = jump.toOperands<operators::Jump>();
+            operands.amount = amount;
+            jump = Bytecode(operands);
+        } break;
+        case OpCode::JumpIfFalse: {
+            operators::JumpIfFalse operands = jump.toOperands<operators::JumpIfFalse>();
+            operands.amount = amount;
+            jump = Bytecode(operands);
+        } break;
+        case OpCode::CompareJumpIfFalse: {
+            fused[fixup.newPos + 1].value = static_cast<uint64_t>(amount);
+        } break;
+        default:
+            sy_assert(false, "Expected jump operation");
+        }
+    }
+
+    this->bytecode = std::move(fused);
+    return {};
+}
+
+namespace {
+/// How an operation uses a frame slot operand.
+enum class SlotUse : uint8_t {
+    /// Holds a scalar, occupying a single slot.
+    Scalar,
+    /// Reads or clears whatever object is in the slot, without depending on its size.
+    Any,
+    /// Must stay at its offset, occupying the given amount of slots from it.
+    Pinned,
+};
+
+struct SlotLifetime {
+    /// Position of the first operation using the slot, or `SIZE_MAX` if unused.
+    size_t first = SIZE_MAX;
+    /// Position of the last operation using the slot.
+    size_t last = 0;
+};
+} // namespace
+
+static uint16_t slotsOfType(const Type* type) {
+    if (type == nullptr || type->sizeType <= sizeof(uint64_t)) {
+        return 1;
+    }
+    return static_cast<uint16_t>((type->sizeType + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+}
+
+template <typename OperandsT, typename VisitFn>
+static void visitCompareSlots(Bytecode* ip, VisitFn& visit) {
+    OperandsT operands = ip->toOperands<OperandsT>();
+    const SlotUse use = operands.isScalar ? SlotUse::Scalar : SlotUse::Pinned;
+    operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+    operands.lhs = visit(static_cast<uint16_t>(operands.lhs), use, 1);
+    operands.rhs = visit(static_cast<uint16_t>(operands.rhs), use, 1);
+    ip[0] = Bytecode(operands);
+}
+
+template <typename VisitFn>
+static void visitArgSlots(Bytecode* argsStart, const uint16_t argCount, VisitFn& visit) {
+    uint16_t* argsSrcs = reinterpret_cast<uint16_t*>(argsStart);
+    for (uint16_t i = 0; i < argCount; i++) {
+        argsSrcs[i] = visit(argsSrcs[i], SlotUse::Any, 1);
+    }
+}
+
+/// Calls `visit(slot, use, slotsOccupied)` for every frame slot operand of the operation at `ip`,
+/// replacing the operand with the returned slot.
+/// @return `false` if the operation isn't known, in which case some operands may not be visited.
+template <typename VisitFn> static bool visitSlotOperands(Bytecode* ip, VisitFn&& visit) {
+    switch (ip->getOpcode()) {
+    case OpCode::Noop:
+    case OpCode::Return:
+    case OpCode::Jump:
+    case OpCode::Yield:
+        return true;
+    case OpCode::ReturnValue: {
+        operators::ReturnValue operands = ip->toOperands<operators::ReturnValue>();
+        operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Any, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::CallImmediateNoReturn: {
+        const operators::CallImmediateNoReturn operands =
+            ip->toOperands<operators::CallImmediateNoReturn>();
+        visitArgSlots(&ip[2], static_cast<uint16_t>(operands.argCount), visit);
+    } break;
+    case OpCode::CallSrcNoReturn: {
+        operators::CallSrcNoReturn operands = ip->toOperands<operators::CallSrcNoReturn>();
+        operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Pinned, 1);
+        ip[0] = Bytecode(operands);
+        visitArgSlots(&ip[2], static_cast<uint16_t>(operands.argCount), visit);
+    } break;
+    case OpCode::CallImmediateWithReturn: {
+        operators::CallImmediateWithReturn operands =
+            ip->toOperands<operators::CallImmediateWithReturn>();
+        const RawFunction* callee = reinterpret_cast<const RawFunction*>(ip[1].value);
+        const uint16_t retSlots = callee == nullptr ? 1 : slotsOfType(callee->returnType);
+        const SlotUse retUse = retSlots == 1 ? SlotUse::Any : SlotUse::Pinned;
+        operands.retDst = visit(static_cast<uint16_t>(operands.retDst), retUse, retSlots);
+        ip[0] = Bytecode(operands);
+        visitArgSlots(&ip[2], static_cast<uint16_t>(operands.argCount), visit);
+    } break;
+    case OpCode::CallSrcWithReturn: {
+        operators::CallSrcWithReturn operands = ip->toOperands<operators::CallSrcWithReturn>();
+        operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Pinned, 1);
+        operands.retDst = visit(static_cast<uint16_t>(operands.retDst), SlotUse::Pinned, 1);
+        ip[0] = Bytecode(operands);
+        visitArgSlots(&ip[2], static_cast<uint16_t>(operands.argCount), visit);
+    } break;
+    case OpCode::TailCallImmediate: {
+        const operators::TailCallImmediate operands =
+            ip->toOperands<operators::TailCallImmediate>();
+        visitArgSlots(&ip[2], static_cast<uint16_t>(operands.argCount), visit);
+    } break;
+    case OpCode::TailCallSrc: {
+        operators::TailCallSrc operands = ip->toOperands<operators::TailCallSrc>();
+        operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Pinned, 1);
+        ip[0] = Bytecode(operands);
+        visitArgSlots(&ip[2], static_cast<uint16_t>(operands.argCount), visit);
+    } break;
+    case OpCode::LoadDefault: {
+        operators::LoadDefault operands = ip->toOperands<operators::LoadDefault>();
+        if (operands.isScalar) {
+            operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+        } else {
+            const Type* type = reinterpret_cast<const Type*>(ip[1].value);
+            operands.dst =
+                visit(static_cast<uint16_t>(operands.dst), SlotUse::Pinned, slotsOfType(type));
+        }
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::LoadImmediateScalar: {
+        operators::LoadImmediateScalar operands = ip->toOperands<operators::LoadImmediateScalar>();
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::MemsetUninitialized: {
+        operators::MemsetUninitialized operands = ip->toOperands<operators::MemsetUninitialized>();
+        const uint16_t slots = operands.slots == 0 ? 1 : static_cast<uint16_t>(operands.slots);
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Pinned, slots);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::SetType: {
+        operators::SetType operands = ip->toOperands<operators::SetType>();
+        if (operands.isScalar) {
+            operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+        } else {
+            const Type* type = reinterpret_cast<const Type*>(ip[1].value);
+            operands.dst =
+                visit(static_cast<uint16_t>(operands.dst), SlotUse::Pinned, slotsOfType(type));
+        }
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::SetNullType: {
+        operators::SetNullType operands = ip->toOperands<operators::SetNullType>();
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Any, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::JumpIfFalse: {
+        operators::JumpIfFalse operands = ip->toOperands<operators::JumpIfFalse>();
+        operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Scalar, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::Destruct: {
+        operators::Destruct operands = ip->toOperands<operators::Destruct>();
+        operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Any, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::Move: {
+        operators::Move operands = ip->toOperands<operators::Move>();
+        const SlotUse use = operands.isScalar ? SlotUse::Scalar : SlotUse::Pinned;
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), use, 1);
+        operands.src = visit(static_cast<uint16_t>(operands.src), use, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::Clone: {
+        operators::Clone operands = ip->toOperands<operators::Clone>();
+        const SlotUse use = operands.isScalar ? SlotUse::Scalar : SlotUse::Pinned;
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), use, 1);
+        operands.src = visit(static_cast<uint16_t>(operands.src), use, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::GetMember: {
+        operators::GetMember operands = ip->toOperands<operators::GetMember>();
+        operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Pinned, 1);
+        if (operands.isScalar) {
+            operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+        } else {
+            const Type* type = reinterpret_cast<const Type*>(ip[1].value);
+            operands.dst =
+                visit(static_cast<uint16_t>(operands.dst), SlotUse::Pinned, slotsOfType(type));
+        }
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::SetMember: {
+        operators::SetMember operands = ip->toOperands<operators::SetMember>();
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Pinned, 1);
+        if (operands.isScalar) {
+            operands.src = visit(static_cast<uint16_t>(operands.src), SlotUse::Scalar, 1);
+        } else {
+            const Type* type = reinterpret_cast<const Type*>(ip[1].value);
+            operands.src =
+                visit(static_cast<uint16_t>(operands.src), SlotUse::Pinned, slotsOfType(type));
+        }
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::Equal:
+        visitCompareSlots<operators::Equal>(ip, visit);
+        break;
+    case OpCode::NotEqual:
+        visitCompareSlots<operators::NotEqual>(ip, visit);
+        break;
+    case OpCode::Less:
+        visitCompareSlots<operators::Less>(ip, visit);
+        break;
+    case OpCode::LessEqual:
+        visitCompareSlots<operators::LessEqual>(ip, visit);
+        break;
+    case OpCode::Greater:
+        visitCompareSlots<operators::Greater>(ip, visit);
+        break;
+    case OpCode::GreaterEqual:
+        visitCompareSlots<operators::GreaterEqual>(ip, visit);
+        break;
+    case OpCode::Add:
+        visitCompareSlots<operators::Add>(ip, visit);
+        break;
+    case OpCode::CompareJumpIfFalse: {
+        operators::CompareJumpIfFalse operands = ip->toOperands<operators::CompareJumpIfFalse>();
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+        operands.lhs = visit(static_cast<uint16_t>(operands.lhs), SlotUse::Scalar, 1);
+        operands.rhs = visit(static_cast<uint16_t>(operands.rhs), SlotUse::Scalar, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::LoadImmediateScalarSetType: {
+        operators::LoadImmediateScalarSetType operands =
+            ip->toOperands<operators::LoadImmediateScalarSetType>();
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::LoadDefaultSetType: {
+        operators::LoadDefaultSetType operands = ip->toOperands<operators::LoadDefaultSetType>();
+        operands.dst = visit(static_cast<uint16_t>(operands.dst), SlotUse::Scalar, 1);
+        ip[0] = Bytecode(operands);
+    } break;
+    case OpCode::DestructMany: {
+        operators::DestructMany operands = ip->toOperands<operators::DestructMany>();
+        operands.src0 = visit(static_cast<uint16_t>(operands.src0), SlotUse::Any, 1);
+        operands.src1 = visit(static_cast<uint16_t>(operands.src1), SlotUse::Any, 1);
+        if (operands.count == 3) {
+            operands.src2 = visit(static_cast<uint16_t>(operands.src2), SlotUse::Any, 1);
+        }
+        ip[0] = Bytecode(operands);
+    } break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+/// Arguments are laid out one after the other, the same as `RawFunction::CallArgs::push(...)`.
+static size_t argSlotsOf(const DynArray<const Type*>& args) {
+    size_t argSlots = 0;
+    for (size_t i = 0; i < args.len(); i++) {
+        argSlots += (args[i]->sizeType + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    }
+    return argSlots;
+}
+
+size_t sy::FunctionBuilder::slotExtent(bool& outAllKnown) noexcept {
+    const size_t len = this->bytecode.len();
+    Bytecode* code = this->bytecode.data();
+
+    outAllKnown = true;
+    size_t frameLength = argSlotsOf(this->args);
+    for (size_t i = 0; i < this->unwindSlots.len(); i++) {
+        const size_t end = static_cast<size_t>(this->unwindSlots[i]) + 1;
+        frameLength = end > frameLength ? end : frameLength;
+    }
+    for (size_t pos = 0; pos < len; pos += code[pos].bytecodeUsed()) {
+        const bool known =
+            visitSlotOperands(&code[pos], [&frameLength](uint16_t slot, SlotUse, uint16_t slots) {
+                const size_t end = static_cast<size_t>(slot) + slots;
+                frameLength = end > frameLength ? end : frameLength;
+                return slot;
+            });
+        outAllKnown = outAllKnown && known;
+    }
+    return frameLength;
+}
+
+Result<void, AllocErr> sy::FunctionBuilder::coalesceSlots() noexcept {
+    const size_t len = this->bytecode.len();
+    Bytecode* code = this->bytecode.data();
+    Allocator alloc = this->bytecode.alloc();
+
+    const size_t argSlots = argSlotsOf(this->args);
+    bool allKnown = true;
+    const size_t frameLength = this->slotExtent(allKnown);
+    if (!allKnown) {
+        return {};
+    }
+
+    DynArray<SlotLifetime> lifetimes(alloc);
+    // Slots that are occupied by a pinned object, and so can't be given to anything else.
+    DynArray<bool> reserved(alloc);
+    DynArray<uint16_t> remap(alloc);
+    if (lifetimes.reserve(frameLength).hasErr() || reserved.reserve(frameLength).hasErr() ||
+        remap.reserve(frameLength).hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    for (size_t i = 0; i < frameLength; i++) {
+        (void)lifetimes.push(SlotLifetime{});
+        (void)reserved.push(i < argSlots);
+        (void)remap.push(static_cast<uint16_t>(i));
+    }
+    for (size_t i = 0; i < this->unwindSlots.len(); i++) {
+        reserved[static_cast<size_t>(this->unwindSlots[i])] = true;
+    }
+
+    for (size_t pos = 0; pos < len; pos += code[pos].bytecodeUsed()) {
+        auto markLifetime = [&lifetimes, &reserved, pos](uint16_t slot, SlotUse use,
+                                                         uint16_t slots) {
+            SlotLifetime& lifetime = lifetimes[slot];
+            lifetime.first = pos < lifetime.first ? pos : lifetime.first;
+            lifetime.last = pos > lifetime.last ? pos : lifetime.last;
+            if (use == SlotUse::Pinned) {
+                for (uint16_t i = 0; i < slots; i++) {
+                    reserved[static_cast<size_t>(slot) + i] = true;
+                }
+            }
+            return slot;
+        };
+        (void)visitSlotOperands(&code[pos], markLifetime);
+    }
+
+    // A slot used within a loop may carry its value around the loop, so it lives for all of it.
+    bool extended = true;
+    while (extended) {
+        extended = false;
+        for (size_t pos = 0; pos < len; pos += code[pos].bytecodeUsed()) {
+            size_t target = 0;
+            if (!jumpTargetOf(code, pos, target) || target > pos) {
+                continue;
+            }
+            for (size_t slot = 0; slot < frameLength; slot++) {
+                SlotLifetime& lifetime = lifetimes[slot];
+                if (lifetime.first == SIZE_MAX || lifetime.last < target || lifetime.first > pos) {
+                    continue;
+                }
+                if (lifetime.first > target || lifetime.last < pos) {
+                    lifetime.first = lifetime.first < target ? lifetime.first : target;
+                    lifetime.last = lifetime.last > pos ? lifetime.last : pos;
+                    extended = true;
+                }
+            }
+        }
+    }
+
+    // Linear scan, giving each movable slot, in order of when it's first used, the lowest slot
+    // that isn't reserved and is free by then.
+    DynArray<uint16_t> movable(alloc);
+    DynArray<size_t> busyUntil(alloc);
+    if (movable.reserve(frameLength).hasErr() || busyUntil.reserve(frameLength).hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    for (size_t slot = 0; slot < frameLength; slot++) {
+        (void)busyUntil.push(0);
+        if (reserved[slot] || lifetimes[slot].first == SIZE_MAX) {
+            continue;
+        }
+        size_t insertAt = movable.len();
+        while (insertAt > 0 && lifetimes[movable[insertAt - 1]].first > lifetimes[slot].first) {
+            insertAt -= 1;
+        }
+        (void)movable.push(static_cast<uint16_t>(slot));
+        for (size_t i = movable.len() - 1; i > insertAt; i--) {
+            movable[i] = movable[i - 1];
+        }
+        movable[insertAt] = static_cast<uint16_t>(slot);
+    }
+
+    size_t newFrameLength = 0;
+    for (size_t slot = 0; slot < frameLength; slot++) {
+        if (reserved[slot]) {
+            newFrameLength = slot + 1;
+        }
+    }
+    for (size_t i = 0; i < movable.len(); i++) {
+        const SlotLifetime& lifetime = lifetimes[movable[i]];
+        size_t newSlot = 0;
+        while (reserved[newSlot] || busyUntil[newSlot] > lifetime.first) {
+            newSlot += 1;
+        }
+        // Positions start at 0, so store one past the last use to tell free slots apart.
+        busyUntil[newSlot] = lifetime.last + 1;
+        remap[movable[i]] = static_cast<uint16_t>(newSlot);
+        newFrameLength = newSlot + 1 > newFrameLength ? newSlot + 1 : newFrameLength;
+    }
+
+    for (size_t pos = 0; pos < len; pos += code[pos].bytecodeUsed()) {
+        (void)visitSlotOperands(&code[pos],
+                                [&remap](uint16_t slot, SlotUse, uint16_t) { return remap[slot]; });
+    }
+    this->stackSpaceRequired = newFrameLength;
+    return {};
+}
+
+bool sy::FunctionBuilder::tryRewriteTailCall(size_t start, uint16_t retSrc) noexcept {
+    const size_t len = this->bytecode.len();
+    size_t callPos = len;
+    size_t setTypePos = len;
+    for (size_t pos = start; pos < len; pos += this->bytecode[pos].bytecodeUsed()) {
+        const OpCode opcode = this->bytecode[pos].getOpcode();
+        if (opcode == OpCode::CallImmediateWithReturn || opcode == OpCode::CallSrcWithReturn) {
+            callPos = pos;
+            setTypePos = len;
+        } else if (callPos != len && setTypePos == len && opcode == OpCode::SetType &&
+                   this->bytecode[pos].toOperands<operators::SetType>().dst == retSrc) {
+            setTypePos = pos;
+        } else {
+            callPos = len;
+        }
+    }
+    if (callPos == len) {
+        return false;
+    }
+
+    Bytecode& call = this->bytecode[callPos];
+    if (call.getOpcode() == OpCode::CallImmediateWithReturn) {
+        const operators::CallImmediateWithReturn operands =
+            call.toOperands<operators::CallImmediateWithReturn>();
+        if (operands.retDst != retSrc) {
+            return false;
+        }
+        operators::TailCallImmediate tailCall{};
+        tailCall.reserveOpcode = static_cast<uint64_t>(operators::TailCallImmediate::OPCODE);
+        tailCall.argCount = operands.argCount;
+        call = Bytecode(tailCall);
+    } else {
+        const operators::CallSrcWithReturn operands =
+            call.toOperands<operators::CallSrcWithReturn>();
+        if (operands.retDst != retSrc) {
+            return false;
+        }
+        operators::TailCallSrc tailCall{};
+        tailCall.reserveOpcode = static_cast<uint64_t>(operators::TailCallSrc::OPCODE);
+        tailCall.src = operands.src;
+        tailCall.argCount = operands.argCount;
+        call = Bytecode(tailCall);
+    }
+
+    // The callee sets the type of the return value itself.
+    if (setTypePos != len) {
+        this->bytecode.removeAt(setTypePos);
+    }
+    return true;
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+
+static Bytecode makeDestruct(uint16_t src) {
+    operators::Destruct operands{};
+    operands.reserveOpcode = static_cast<uint64_t>(operators::Destruct::OPCODE);
+    operands.src = src;
+    return Bytecode(operands);
+}
+
+TEST_CASE("[FunctionBuilder] fuse adjacent destructs") {
+    FunctionBuilder builder(Allocator{});
+    const Bytecode bytecode[] = {makeDestruct(0), makeDestruct(1), makeDestruct(2),
+                                 makeDestruct(3)};
+    CHECK(builder.pushBytecode(bytecode, 4));
+    CHECK(builder.fuseSuperinstructions());
+
+    REQUIRE_EQ(builder.bytecode.len(), 2);
+    const operators::DestructMany fused = builder.bytecode[0].toOperands<operators::DestructMany>();
+    CHECK_EQ(fused.count, 3);
+    CHECK_EQ(fused.src0, 0);
+    CHECK_EQ(fused.src1, 1);
+    CHECK_EQ(fused.src2, 2);
+    CHECK_EQ(builder.bytecode[1].getOpcode(), OpCode::Destruct);
+}
+
+TEST_CASE("[FunctionBuilder] jump targets are not fused and are relocated") {
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = 3;
+
+    // The jump skips over the first 2 destructs, landing on the third, so only the first 2 fuse.
+    FunctionBuilder builder(Allocator{});
+    const Bytecode bytecode[] = {Bytecode(jump), makeDestruct(0), makeDestruct(1), makeDestruct(2),
+                                 makeDestruct(3)};
+    CHECK(builder.pushBytecode(bytecode, 5));
+    CHECK(builder.fuseSuperinstructions());
+
+    REQUIRE_EQ(builder.bytecode.len(), 3);
+    CHECK_EQ(builder.bytecode[0].toOperands<operators::Jump>().amount, 2);
+    CHECK_EQ(builder.bytecode[1].toOperands<operators::DestructMany>().count, 2);
+    CHECK_EQ(builder.bytecode[2].toOperands<operators::DestructMany>().count, 2);
+}
+
+static Bytecode makeLoadImmediate(uint16_t dst, uint32_t immediate) {
+    operators::LoadImmediateScalar operands{};
+    operands.reserveOpcode = static_cast<uint64_t>(operators::LoadImmediateScalar::OPCODE);
+    operands.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+    operands.dst = dst;
+    operands.immediate = immediate;
+    return Bytecode(operands);
+}
+
+TEST_CASE("[FunctionBuilder] dead temporaries share slots") {
+    operators::ReturnValue ret{};
+    ret.reserveOpcode = static_cast<uint64_t>(operators::ReturnValue::OPCODE);
+    ret.src = 5;
+
+    FunctionBuilder builder(Allocator{});
+    builder.stackSpaceRequired = 6;
+    const Bytecode bytecode[] = {makeLoadImmediate(3, 1), makeDestruct(3), makeLoadImmediate(5, 2),
+                                 Bytecode(ret)};
+    CHECK(builder.pushBytecode(bytecode, 4));
+    CHECK(builder.coalesceSlots());
+
+    CHECK_EQ(builder.stackSpaceRequired, 1);
+    CHECK_EQ(builder.bytecode[0].toOperands<operators::LoadImmediateScalar>().dst, 0);
+    CHECK_EQ(builder.bytecode[1].toOperands<operators::Destruct>().src, 0);
+    CHECK_EQ(builder.bytecode[2].toOperands<operators::LoadImmediateScalar>().dst, 0);
+    CHECK_EQ(builder.bytecode[3].toOperands<operators::ReturnValue>().src, 0);
+}
+
+TEST_CASE("[FunctionBuilder] slot extent covers every slot of multi slot values") {
+    const size_t stringSlots = (sizeof(String) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    operators::SetType setString{};
+    setString.reserveOpcode = static_cast<uint64_t>(operators::SetType::OPCODE);
+    setString.dst = 2;
+    setString.isScalar = false;
+    Bytecode stringType;
+    stringType.value = reinterpret_cast<uint64_t>(Reflect<String>::get());
+
+    FunctionBuilder builder(Allocator{});
+    CHECK(builder.addArg(Reflect<String>::get()));
+    const Bytecode bytecode[] = {Bytecode(setString), stringType};
+    CHECK(builder.pushBytecode(bytecode, 2));
+    bool allKnown = false;
+    CHECK_EQ(builder.slotExtent(allKnown), 2 + stringSlots);
+    CHECK(allKnown);
+
+    // Operations whose slots aren't understood are skipped, and coalescing leaves the frame be.
+    Bytecode sync;
+    sync.value = static_cast<uint64_t>(OpCode::Sync);
+    CHECK(builder.pushBytecode(&sync, 1));
+    CHECK_EQ(builder.slotExtent(allKnown), 2 + stringSlots);
+    CHECK_FALSE(allKnown);
+    builder.stackSpaceRequired = 2 + stringSlots;
+    CHECK(builder.coalesceSlots());
+    CHECK_EQ(builder.stackSpaceRequired, 2 + stringSlots);
+}
+
+TEST_CASE("[FunctionBuilder] values live around a loop keep their slot") {
+    operators::JumpIfFalse exitLoop{};
+    exitLoop.reserveOpcode = static_cast<uint64_t>(operators::JumpIfFalse::OPCODE);
+    exitLoop.src = 3;
+    exitLoop.amount = 4;
+    operators::Jump loop{};
+    loop.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    loop.amount = -3;
+    operators::Return ret{};
+    ret.reserveOpcode = static_cast<uint64_t>(operators::Return::OPCODE);
+
+    // Slot 3 is last read at the loop condition, before slot 5 is first written, but the next
+    // iteration reads slot 3 again, so they can't share.
+    FunctionBuilder builder(Allocator{});
+    builder.stackSpaceRequired = 6;
+    const Bytecode bytecode[] = {makeLoadImmediate(3, 1), Bytecode(exitLoop),
+                                 makeLoadImmediate(5, 2), makeDestruct(5), Bytecode(loop),
+                                 Bytecode(ret)};
+    CHECK(builder.pushBytecode(bytecode, 6));
+    CHECK(builder.coalesceSlots());
+
+    CHECK_EQ(builder.stackSpaceRequired, 2);
+    CHECK_EQ(builder.bytecode[0].toOperands<operators::LoadImmediateScalar>().dst, 0);
+    CHECK_EQ(builder.bytecode[1].toOperands<operators::JumpIfFalse>().src, 0);
+    CHECK_EQ(builder.bytecode[2].toOperands<operators::LoadImmediateScalar>().dst, 1);
+    CHECK_EQ(builder.bytecode[3].toOperands<operators::Destruct>().src, 1);
+}
+
+TEST_CASE("[FunctionBuilder] trailing call is rewritten into a tail call") {
+    operators::CallSrcWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallSrcWithReturn::OPCODE);
+    call.src = 0;
+    call.argCount = 1;
+    call.retDst = 2;
+    Bytecode cacheIndex;
+    cacheIndex.value = 0;
+    Bytecode argsSrcs;
+    argsSrcs.value = 1;
+    operators::SetType setType{};
+    setType.reserveOpcode = static_cast<uint64_t>(operators::SetType::OPCODE);
+    setType.dst = 2;
+    setType.isScalar = true;
+    setType.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+
+    SUBCASE("returned call") {
+        FunctionBuilder builder(Allocator{});
+        const Bytecode bytecode[] = {Bytecode(call), cacheIndex, argsSrcs, Bytecode(setType)};
+        CHECK(builder.pushBytecode(bytecode, 4));
+        CHECK(builder.tryRewriteTailCall(0, 2));
+
+        REQUIRE_EQ(builder.bytecode.len(), 3);
+        REQUIRE_EQ(builder.bytecode[0].getOpcode(), OpCode::TailCallSrc);
+        const operators::TailCallSrc tailCall =
+            builder.bytecode[0].toOperands<operators::TailCallSrc>();
+        CHECK_EQ(tailCall.src, 0);
+        CHECK_EQ(tailCall.argCount, 1);
+        CHECK_EQ(builder.bytecode[1].value, 0);
+        CHECK_EQ(builder.bytecode[2].value, 1);
+    }
+    SUBCASE("call result not returned") {
+        FunctionBuilder builder(Allocator{});
+        const Bytecode bytecode[] = {Bytecode(call), cacheIndex, argsSrcs, Bytecode(setType)};
+        CHECK(builder.pushBytecode(bytecode, 4));
+        CHECK_FALSE(builder.tryRewriteTailCall(0, 3));
+        CHECK_EQ(builder.bytecode[0].getOpcode(), OpCode::CallSrcWithReturn);
+    }
+    SUBCASE("call not last") {
+        FunctionBuilder builder(Allocator{});
+        const Bytecode bytecode[] = {Bytecode(call), cacheIndex, argsSrcs, makeDestruct(1)};
+        CHECK(builder.pushBytecode(bytecode, 4));
+        CHECK_FALSE(builder.tryRewriteTailCall(0, 2));
+        CHECK_EQ(builder.bytecode.len(), 4);
+    }
+}
+
+#endif // SYNC_LIB_WITH_TESTS
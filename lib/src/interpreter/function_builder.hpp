@@ -16,6 +16,9 @@ struct FunctionBuilder {
     DynArray<Bytecode> bytecode;
     DynArray<int16_t> unwindSlots;
     size_t stackSpaceRequired = 0;
+    /// Amount of inline caches used by the indirect call sites within `bytecode`. See
+    /// `InterpreterFunctionScriptInfo::callSiteCaches`.
+    uint32_t callSiteCacheCount = 0;
 
     FunctionBuilder(Allocator alloc) noexcept;
 
@@ -25,8 +28,40 @@ struct FunctionBuilder {
 
     [[nodiscard]] Result<void, AllocErr> pushBytecode(const Bytecode* bytecodeArr, size_t count) noexcept;
 
+    /// Reserves an inline cache for an indirect call site.
+    /// @return The cache index operand of the call site's operation.
+    [[nodiscard]] uint64_t addCallSiteCache() noexcept;
+
     /// @param slot Which slot to unwind. Must be in range of [0 - `stackSpaceRequired`)
     [[nodiscard]] Result<void, AllocErr> pushUnwindSlot(int16_t slot) noexcept;
+
+    /// Peephole pass replacing common sequences of operations within `bytecode` with single
+    /// superinstructions, such as a comparison followed by a conditional jump on it's result.
+    /// Jump amounts are adjusted for the shrunk bytecode, and operations that are the target of a
+    /// jump are never fused into the operation before them. Should be called once all bytecode
+    /// has been pushed.
+    [[nodiscard]] Result<void, AllocErr> fuseSuperinstructions() noexcept;
+
+    /// Frame length required by the arguments, the unwind slots, and the slot operands of
+    /// `bytecode`. Operations `coalesceSlots()` doesn't understand are skipped, in which case
+    /// `outAllKnown` is set to false.
+    [[nodiscard]] size_t slotExtent(bool& outAllKnown) noexcept;
+
+    /// Liveness based slot allocation pass, letting temporaries whose lifetimes don't overlap share
+    /// frame slots, and shrinking `stackSpaceRequired` to the slots actually used. Only slots that
+    /// always hold a scalar are moved. Arguments, unwind slots, and slots holding non scalar
+    /// objects keep their offsets. Lifetimes span from the first to the last operation using a
+    /// slot, extended over whole loops they overlap. Should be called once all bytecode has been
+    /// pushed, and before `fuseSuperinstructions()`. Leaves the bytecode untouched if it contains
+    /// operations the pass doesn't understand.
+    [[nodiscard]] Result<void, AllocErr> coalesceSlots() noexcept;
+
+    /// If the operations pushed since `start` end with a call writing its return value to `retSrc`,
+    /// optionally followed by setting the type of `retSrc`, rewrites that call into the equivalent
+    /// tail call, which reuses the current frame instead of pushing a new one.
+    /// @return `true` if the call was rewritten, in which case no return operation should be pushed
+    /// after it, as the tail call returns on behalf of this function.
+    bool tryRewriteTailCall(size_t start, uint16_t retSrc) noexcept;
 };
 } // namespace sy
 
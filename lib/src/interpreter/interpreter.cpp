@@ -1,20 +1,61 @@
 #include "interpreter.hpp"
+#include "../compiler/lazy_function.hpp"
 #include "../core/core_internal.h"
 #include "../program/program.hpp"
 #include "../program/program_internal.hpp"
+#include "../program/program_image_internal.hpp"
 #include "../types/function/function.hpp"
+#include "../types/function/function_internal.hpp"
+#include "../types/task/task_internal.hpp"
 #include "../types/type_info.hpp"
 #include "bytecode.hpp"
+#include "call_site_cache.hpp"
+#include "jit.hpp"
+#include "profiler.hpp"
 #include "stack/stack.hpp"
 #include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+
+// Computed goto (GCC / Clang "labels as values") gives every operation its own indirect jump to
+// the next one, which is far friendlier to branch prediction than the single shared jump of a
+// `switch`. MSVC has no equivalent, so it falls back to a `switch` within a loop.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(SYNC_INTERPRETER_NO_COMPUTED_GOTO)
+#define SY_INTERPRETER_COMPUTED_GOTO 1
+#else
+#define SY_INTERPRETER_COMPUTED_GOTO 0
+#endif
+
+// Checks that `verifyScriptFunction(...)` proves for all bytecode that has been verified, such as
+// slot bounds and operand types. `SYNC_INTERPRETER_UNCHECKED` skips them even when other
+// assertions are enabled, so must only be used if every executed script function is verified,
+// which `Compiler::compile(...)` does for all modules, and `ProgramImage::load(...)` for all
+// images.
+#ifdef SYNC_INTERPRETER_UNCHECKED
+#define sy_verified_assert(expression, message) ((void)0)
+#else
+#define sy_verified_assert(expression, message) sy_assert(expression, message)
+#endif
 
 using namespace sy;
 
-enum class OkExecStatus { Continue, FunctionCall, Return };
+enum class OkExecStatus { FunctionCall, Return, Suspend, Yield };
+
+/// Budget of executions that aren't preemptible. Preemption points would need to be passed at a
+/// rate no script can reach for it to ever run out.
+static constexpr uint64_t UNLIMITED_BUDGET = UINT64_MAX;
 
-static Result<OkExecStatus, AnyError> interpreterExecuteContinuous(const Program* program);
-static Result<OkExecStatus, AnyError> interpreterExecuteOperation(const Program* program);
+/// Set while a `PreemptibleExecution` is running on this thread, and cleared for nested executions
+/// that run to completion. Native code of JIT compiled functions has no preemption points, so those
+/// functions are interpreted instead, and `Yield` only suspends execution when this is set.
+static thread_local bool runningPreemptible = false;
+
+static Result<OkExecStatus, AnyError>
+interpreterExecuteContinuous(Stack& activeStack, uint64_t& budget,
+                             const TaskCancelToken* cancelToken);
 static void unwindStackFrame(const int16_t* unwindSlots, const uint16_t len);
+static void enterScriptFunction(const RawFunction* scriptFunction, Stack& activeStack);
 
 static void setupFunctionStackFrame(const RawFunction* scriptFunction, void* outReturnValue) {
     sy_assert(scriptFunction->tag == FunctionType::Script,
@@ -29,62 +70,216 @@ static void setupFunctionStackFrame(const RawFunction* scriptFunction, void* out
 
     Stack& activeStack = Stack::getActiveStack();
     activeStack.pushFunctionFrame(scriptFunction, outReturnValue);
+    enterScriptFunction(scriptFunction, activeStack);
+}
 
+/// Starts executing `scriptFunction` within the current frame of `activeStack`.
+static void enterScriptFunction(const RawFunction* scriptFunction, Stack& activeStack) {
     const sy::InterpreterFunctionScriptInfo* scriptInfo =
         reinterpret_cast<const sy::InterpreterFunctionScriptInfo*>(scriptFunction->fptr);
+    if (scriptInfo->image != nullptr) {
+        scriptInfo->image->ensureRelocated();
+    }
     activeStack.setInstructionPointer(scriptInfo->bytecode);
-}
+#if SY_INTERPRETER_PROFILER
+    profiler::enterFunction(scriptInfo);
+#endif
 
-Result<void, AnyError> sy::interpreterExecuteScriptFunction(const RawFunction* scriptFunction,
-                                                                void* outReturnValue) {
-    // Just setup the initial function call stack
-    setupFunctionStackFrame(scriptFunction, outReturnValue);
+    // Native code has no preemption or cancellation points, so isn't used by preemptible
+    // executions, nor by tasks, which may be cancelled.
+    if (scriptInfo->jit != nullptr && !runningPreemptible && runningTaskCancelToken() == nullptr) {
+        // Native code runs the function as far as it can, then the interpreter continues from
+        // wherever it stopped.
+        if (const JitEntryFn entry = scriptInfo->jit->onCall(scriptInfo); entry != nullptr) {
+            activeStack.setInstructionPointer(
+                entry(activeStack.frameValuesBase(), activeStack.frameTypesBase(),
+                      scriptInfo->bytecode));
+        }
+    }
+}
 
-    size_t depth = 1;
-    while (depth > 0) {
-        Stack& activeStack = Stack::getActiveStack();
+/// Unwinds and pops the `count` innermost frames of `activeStack`.
+static void unwindFunctionFrames(Stack& activeStack, size_t count) {
+    for (; count > 0; count--) {
         const sy::RawFunction* currentFunction = activeStack.getCurrentFunction().value();
         const sy::InterpreterFunctionScriptInfo* currentScriptInfo =
             reinterpret_cast<const sy::InterpreterFunctionScriptInfo*>(currentFunction->fptr);
+        unwindStackFrame(currentScriptInfo->unwindSlots, currentScriptInfo->unwindLen);
+#if SY_INTERPRETER_PROFILER
+        profiler::leaveFunction();
+#endif
+        activeStack.popFrame();
+    }
+}
 
-        auto res = interpreterExecuteContinuous(currentScriptInfo->program);
+/// Executes the `depth` innermost frames of `activeStack` until all of them have returned, or
+/// `budget` runs out. Calls consume budget as preemption points, along with backward jumps within
+/// `interpreterExecuteContinuous(...)`. Preemption points also fail execution if the task running
+/// on this thread has been cancelled. If an error occurs, all `depth` frames are unwound.
+static Result<ExecutionStatus, AnyError> interpreterRun(Stack& activeStack, size_t& depth,
+                                                        uint64_t& budget) {
+    // Tasks run inline by C functions this execution calls restore the running task as they
+    // return, so it only has to be read once.
+    const TaskCancelToken* cancelToken = runningTaskCancelToken();
+    while (depth > 0) {
+        auto res = interpreterExecuteContinuous(activeStack, budget, cancelToken);
         if (res.hasErr()) {
-            while (depth > 0) {
-                currentFunction = activeStack.getCurrentFunction().value();
-                currentScriptInfo = reinterpret_cast<const sy::InterpreterFunctionScriptInfo*>(
-                    currentFunction->fptr);
-                unwindStackFrame(currentScriptInfo->unwindSlots, currentScriptInfo->unwindLen);
-                activeStack.popFrame();
-                depth -= 1;
-            }
+            unwindFunctionFrames(activeStack, depth);
+            depth = 0;
             return Error(res.takeErr());
         }
 
-        sy_assert(res.value() != OkExecStatus::Continue,
-                  "Continue should not have escaped to here");
-
-        if (res.value() == OkExecStatus::Return) {
-            unwindStackFrame(currentScriptInfo->unwindSlots, currentScriptInfo->unwindLen);
-            activeStack.popFrame();
+        switch (res.value()) {
+        case OkExecStatus::Return:
+            unwindFunctionFrames(activeStack, 1);
             depth -= 1;
-        }
-
-        if (res.value() == OkExecStatus::FunctionCall) {
+            break;
+        case OkExecStatus::FunctionCall:
             depth += 1;
+            if (cancelToken != nullptr && cancelToken->isCancelled()) {
+                unwindFunctionFrames(activeStack, depth);
+                depth = 0;
+                return Error(AnyError(Exceptional::Cancelled));
+            }
+            budget -= 1;
+            if (budget == 0) {
+                return ExecutionStatus::Suspended;
+            }
+            break;
+        case OkExecStatus::Suspend:
+            return ExecutionStatus::Suspended;
+        case OkExecStatus::Yield:
+            return ExecutionStatus::Yielded;
         }
     }
 
+    return ExecutionStatus::Finished;
+}
+
+Result<void, AnyError> sy::interpreterExecuteScriptFunction(const RawFunction* scriptFunction,
+                                                            void* outReturnValue) {
+    // Scripts called by C functions within a preemptible execution can't be suspended, as the C
+    // functions would have to be suspended too.
+    const bool wasPreemptible = runningPreemptible;
+    runningPreemptible = false;
+
+    // Just setup the initial function call stack
+    setupFunctionStackFrame(scriptFunction, outReturnValue);
+
+    size_t depth = 1;
+    uint64_t budget = UNLIMITED_BUDGET;
+    auto res = interpreterRun(Stack::getActiveStack(), depth, budget);
+    runningPreemptible = wasPreemptible;
+    if (res.hasErr()) {
+        return Error(res.takeErr());
+    }
+    sy_assert(res.value() == ExecutionStatus::Finished, "Unlimited execution cannot be suspended");
     return {};
 }
 
-static Result<OkExecStatus, AnyError> interpreterExecuteContinuous(const Program* program) {
-    while (true) {
-        auto execResult = interpreterExecuteOperation(program);
-        if (execResult.hasValue() && execResult.value() == OkExecStatus::Continue) {
-            // just keep executing bytecode
-        } else {
-            return execResult;
+PreemptibleExecution::~PreemptibleExecution() noexcept { this->destroy(); }
+
+PreemptibleExecution::PreemptibleExecution(PreemptibleExecution&& other) noexcept
+    : stack_(other.stack_), depth_(other.depth_) {
+    sy_assert(!other.running_, "Cannot move a running execution");
+    other.stack_ = nullptr;
+    other.depth_ = 0;
+}
+
+PreemptibleExecution& PreemptibleExecution::operator=(PreemptibleExecution&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    sy_assert(!other.running_, "Cannot move a running execution");
+    this->destroy();
+    this->stack_ = other.stack_;
+    this->depth_ = other.depth_;
+    other.stack_ = nullptr;
+    other.depth_ = 0;
+    return *this;
+}
+
+Result<PreemptibleExecution, AnyError>
+PreemptibleExecution::start(const RawFunction* scriptFunction, void* const* args,
+                            void* outReturnValue) noexcept {
+    sy_assert(scriptFunction->tag == FunctionType::Script,
+              "Preemptible executions can only run script functions");
+
+    // Pushing copies the arguments onto the stack, which doesn't destroy them when freed, so
+    // arguments that were already pushed are destroyed through `args` along with the rest.
+    auto destroyArgs = [scriptFunction, args]() {
+        for (uint16_t i = 0; i < scriptFunction->argsLen; i++) {
+            scriptFunction->argsTypes[i]->destroyObject(args[i]);
+        }
+    };
+
+    Allocator alloc{};
+    auto stackRes = alloc.allocObject<Stack>();
+    if (stackRes.hasErr()) {
+        destroyArgs();
+        return Error(AnyError(Exceptional::OOM));
+    }
+
+    PreemptibleExecution execution;
+    execution.stack_ = new (stackRes.value()) Stack();
+
+    Stack* previousStack = Stack::setActiveStack(execution.stack_);
+    {
+        RawFunction::CallArgs callArgs = scriptFunction->startCall();
+        for (uint16_t i = 0; i < scriptFunction->argsLen; i++) {
+            if (callArgs.push(args[i], scriptFunction->argsTypes[i]) == false) {
+                (void)Stack::setActiveStack(previousStack);
+                destroyArgs();
+                return Error(AnyError(Exceptional::Capacity));
+            }
         }
+        const bool wasPreemptible = runningPreemptible;
+        runningPreemptible = true;
+        setupFunctionStackFrame(scriptFunction, outReturnValue);
+        runningPreemptible = wasPreemptible;
+    }
+    (void)Stack::setActiveStack(previousStack);
+
+    execution.depth_ = 1;
+    return execution;
+}
+
+Result<ExecutionStatus, AnyError> PreemptibleExecution::resume(uint64_t budget) noexcept {
+    sy_assert(this->isSuspended(), "Execution has already finished");
+    sy_assert(!this->running_, "Execution is already running");
+    sy_assert(budget > 0, "Execution requires budget to make progress");
+
+    Stack* previousStack = Stack::setActiveStack(this->stack_);
+    const bool wasPreemptible = runningPreemptible;
+    runningPreemptible = true;
+    this->running_ = true;
+    auto res = interpreterRun(*this->stack_, this->depth_, budget);
+    this->running_ = false;
+    runningPreemptible = wasPreemptible;
+    (void)Stack::setActiveStack(previousStack);
+    return res;
+}
+
+void PreemptibleExecution::cancel() noexcept {
+    if (!this->isSuspended()) {
+        return;
+    }
+    sy_assert(!this->running_, "Cannot cancel a running execution");
+
+    Stack* previousStack = Stack::setActiveStack(this->stack_);
+    unwindFunctionFrames(*this->stack_, this->depth_);
+    (void)Stack::setActiveStack(previousStack);
+    this->depth_ = 0;
+}
+
+void PreemptibleExecution::destroy() noexcept {
+    // The frames live on the stack, so must be unwound first.
+    this->cancel();
+    if (this->stack_ != nullptr) {
+        Allocator alloc{};
+        this->stack_->~Stack();
+        alloc.freeObject(this->stack_);
+        this->stack_ = nullptr;
     }
 }
 
@@ -102,356 +297,2051 @@ static void unwindStackFrame(const int16_t* unwindSlots, const uint16_t len) {
     }
 }
 
-static void executeReturn(const Bytecode b);
-static void executeReturnValue(const Bytecode b);
-static Result<void, AnyError> executeCallImmediateNoReturn(ptrdiff_t& ipChange,
-                                                               const Bytecode* bytecodes);
-static Result<void, AnyError> executeCallSrcNoReturn(ptrdiff_t& ipChange,
-                                                         const Bytecode* bytecodes);
-static Result<void, AnyError> executeCallImmediateWithReturn(ptrdiff_t& ipChange,
-                                                                 const Bytecode* bytecodes);
-static Result<void, AnyError> executeCallSrcWithReturn(ptrdiff_t& ipChange,
-                                                           const Bytecode* bytecodes);
-static void executeLoadDefault(ptrdiff_t& ipChange, const Bytecode* bytecodes);
-static void executeLoadImmediateScalar(ptrdiff_t& ipChange, const Bytecode* bytecodes);
-static void executeMemsetUninitialized(const Bytecode bytecode);
-static void executeSetType(ptrdiff_t& ipChange, const Bytecode* bytecodes);
-static void executeSetNullType(const Bytecode bytecode);
-static void executeJump(ptrdiff_t& ipChange, const Bytecode bytecode);
-static void executeJumpIfFalse(ptrdiff_t& ipChange, const Bytecode bytecode);
-static void executeDestruct(const Bytecode bytecode);
-
-static Result<OkExecStatus, AnyError> interpreterExecuteOperation(const Program* program) {
-    (void)program;
-
-    ptrdiff_t ipChange = 1;
-    const Bytecode* instructionPointer = Stack::getActiveStack().getInstructionPointer();
-    const OpCode opcode = instructionPointer->getOpcode();
-
-    auto result = [opcode, instructionPointer, &ipChange]() -> Result<OkExecStatus, AnyError> {
-        switch (opcode) {
-        case OpCode::Noop:
-            break;
-        case OpCode::Return: {
-            executeReturn(*instructionPointer);
-            return OkExecStatus::Return;
-        } break;
-        case OpCode::ReturnValue: {
-            executeReturnValue(*instructionPointer);
-            return OkExecStatus::Return;
-        } break;
-        case OpCode::CallImmediateNoReturn: {
-            if (auto callRes = executeCallImmediateNoReturn(ipChange, instructionPointer);
-                callRes.hasErr()) {
-                return Error(callRes.takeErr());
-            }
-            return OkExecStatus::FunctionCall;
-        } break;
-        case OpCode::CallSrcNoReturn: {
-            if (auto callRes = executeCallSrcNoReturn(ipChange, instructionPointer);
-                callRes.hasErr()) {
-                return Error(callRes.takeErr());
-            }
-            return OkExecStatus::FunctionCall;
-        } break;
-        case OpCode::CallImmediateWithReturn: {
-            if (auto callRes = executeCallImmediateWithReturn(ipChange, instructionPointer);
-                callRes.hasErr()) {
-                return Error(callRes.takeErr());
-            }
-            return OkExecStatus::FunctionCall;
-        } break;
-        case OpCode::CallSrcWithReturn: {
-            if (auto callRes = executeCallSrcWithReturn(ipChange, instructionPointer);
-                callRes.hasErr()) {
-                return Error(callRes.takeErr());
-            }
-            return OkExecStatus::FunctionCall;
-        } break;
-        case OpCode::LoadDefault: {
-            executeLoadDefault(ipChange, instructionPointer);
-        } break;
-        case OpCode::LoadImmediateScalar: {
-            executeLoadImmediateScalar(ipChange, instructionPointer);
-        } break;
-        case OpCode::MemsetUninitialized: {
-            executeMemsetUninitialized(*instructionPointer);
-        } break;
-        case OpCode::SetType: {
-            executeSetType(ipChange, instructionPointer);
-        } break;
-        case OpCode::SetNullType: {
-            executeSetNullType(*instructionPointer);
-        } break;
-        case OpCode::Jump: {
-            executeJump(ipChange, *instructionPointer);
-        } break;
-        case OpCode::JumpIfFalse: {
-            executeJumpIfFalse(ipChange, *instructionPointer);
-        } break;
-        case OpCode::Destruct: {
-            executeDestruct(*instructionPointer);
-        } break;
-
-        default: {
-            sy_assert(static_cast<uint8_t>(opcode) && false, "Unimplemented opcode");
+namespace {
+/// Direct addressing of the current frame's slots. The dispatch loop keeps these in locals for
+/// the duration of a continuous run of bytecode within a single frame, and only synchronizes the
+/// instruction pointer with the active `Stack` when it exits through a call, return, or error.
+struct FrameSlots {
+    uint64_t* values;
+    Node::TypeOfValue* types;
+    uint16_t frameLength;
+    /// Inline caches of the current function's indirect call sites. See `CallSiteCache`.
+    CallSiteCache* callSiteCaches;
+    uint32_t callSiteCachesLen;
+
+    template <typename T> T* valueAt(const uint64_t offset) const {
+        sy_verified_assert(offset < this->frameLength, "Index out of bounds for stack frame");
+        return reinterpret_cast<T*>(&this->values[offset]);
+    }
+
+    const Type* typeAt(const uint64_t offset) const {
+        sy_verified_assert(offset < this->frameLength, "Index out of bounds for stack frame");
+        return this->types[offset].get();
+    }
+
+    /// Same as `Node::setTypeAt(...)`.
+    void setTypeAt(const Type* type, const uint64_t offset) const {
+        sy_verified_assert(offset < this->frameLength, "Index out of bounds for stack frame");
+        if (type == nullptr) {
+            this->types[offset] = nullptr;
+            return;
         }
+
+        const uint64_t slotsOccupied = static_cast<uint64_t>((type->sizeType - 1) / 8) + 1;
+        sy_verified_assert((offset + slotsOccupied) <= this->frameLength,
+                           "Cannot set type information past the frame length");
+        this->types[offset] = Node::TypeOfValue(type, true);
+        for (uint64_t i = 1; i < slotsOccupied; i++) {
+            this->types[offset + i] = nullptr;
         }
-        return OkExecStatus::Continue;
-    }();
+    }
+};
+} // namespace
+
+static FrameSlots currentFrameSlots(Stack& activeStack) {
+    FrameSlots slots;
+    slots.values = activeStack.frameValuesBase();
+    slots.types = activeStack.frameTypesBase();
+    slots.frameLength = activeStack.getCurrentFrame().value().frameLength;
+    const sy::InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<const sy::InterpreterFunctionScriptInfo*>(
+            activeStack.getCurrentFunction().value()->fptr);
+    slots.callSiteCaches = scriptInfo->callSiteCaches;
+    slots.callSiteCachesLen = scriptInfo->callSiteCachesLen;
+    return slots;
+}
+
+// Every operation handler takes the instruction pointer at its own bytecode, and returns the
+// instruction pointer of the next operation to execute.
+
+static void executeReturnValue(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack);
+static Result<const Bytecode*, AnyError>
+executeCallImmediateNoReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack);
+static Result<const Bytecode*, AnyError>
+executeCallSrcNoReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack);
+static Result<const Bytecode*, AnyError>
+executeCallImmediateWithReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack);
+static Result<const Bytecode*, AnyError>
+executeCallSrcWithReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack);
+static Result<const Bytecode*, AnyError>
+executeTailCallImmediate(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack);
+static Result<const Bytecode*, AnyError> executeTailCallSrc(const Bytecode* ip,
+                                                            const FrameSlots& frame,
+                                                            Stack& activeStack);
+static inline const Bytecode* executeLoadDefault(const Bytecode* ip, const FrameSlots& frame);
+static inline const Bytecode* executeLoadImmediateScalar(const Bytecode* ip,
+                                                         const FrameSlots& frame);
+static inline const Bytecode* executeMemsetUninitialized(const Bytecode* ip,
+                                                         const FrameSlots& frame);
+static inline const Bytecode* executeSetType(const Bytecode* ip, const FrameSlots& frame);
+static inline const Bytecode* executeSetNullType(const Bytecode* ip, const FrameSlots& frame);
+static inline const Bytecode* executeJump(const Bytecode* ip);
+static inline const Bytecode* executeJumpIfFalse(const Bytecode* ip, const FrameSlots& frame);
+static inline const Bytecode* executeDestruct(const Bytecode* ip, const FrameSlots& frame);
+static inline const Bytecode* executeMove(const Bytecode* ip, const FrameSlots& frame);
+static inline Result<const Bytecode*, AnyError> executeClone(const Bytecode* ip,
+                                                             const FrameSlots& frame);
+static inline Result<const Bytecode*, AnyError> executeGetMember(const Bytecode* ip,
+                                                                 const FrameSlots& frame);
+static inline Result<const Bytecode*, AnyError> executeSetMember(const Bytecode* ip,
+                                                                 const FrameSlots& frame);
+template <typename OperandsT, typename Cmp>
+static inline Result<const Bytecode*, AnyError> executeCompare(const Bytecode* ip,
+                                                               const FrameSlots& frame);
+static inline const Bytecode* executeAdd(const Bytecode* ip, const FrameSlots& frame);
+static inline const Bytecode* executeCompareJumpIfFalse(const Bytecode* ip,
+                                                        const FrameSlots& frame);
+static inline const Bytecode* executeLoadImmediateScalarSetType(const Bytecode* ip,
+                                                                const FrameSlots& frame);
+static inline const Bytecode* executeLoadDefaultSetType(const Bytecode* ip,
+                                                        const FrameSlots& frame);
+static inline const Bytecode* executeDestructMany(const Bytecode* ip, const FrameSlots& frame);
+
+// Profiling counts every operation into the loop's `opcodeCounts`, which are added to the current
+// function before it calls another, and whenever the loop exits.
+#if SY_INTERPRETER_PROFILER
+#define SY_PROFILE_OP(name) opcodeCounts.counts[static_cast<size_t>(OpCode::name)] += 1;
+#define SY_PROFILE_FLUSH() profiler::flushInstructions(opcodeCounts)
+#define SY_PROFILE_CALL()                                                                          \
+    profiler::flushInstructions(opcodeCounts);                                                     \
+    profiler::recordCallSite(ip)
+#else
+#define SY_PROFILE_OP(name)
+#define SY_PROFILE_FLUSH() ((void)0)
+#define SY_PROFILE_CALL() ((void)0)
+#endif
 
-    if (result.hasValue() && result.value() == OkExecStatus::Continue) {
-        Stack::getActiveStack().setInstructionPointer(instructionPointer + ipChange);
+#if SY_INTERPRETER_COMPUTED_GOTO
+#define SY_OP(name) op_##name: SY_PROFILE_OP(name)
+#define SY_OP_UNIMPLEMENTED op_Unimplemented:
+#define SY_DISPATCH() goto* DISPATCH_TABLE[static_cast<uint8_t>(ip->getOpcode())]
+#else
+#define SY_OP(name) case OpCode::name: SY_PROFILE_OP(name)
+#define SY_OP_UNIMPLEMENTED default:
+#define SY_DISPATCH() continue
+#endif
+
+// Leaving the loop for a nested script call, in which case the call handlers have already stored
+// the instruction pointer to return to, and pushed the callee's frame. C functions have already
+// run to completion, so execution continues within the current frame.
+#define SY_CALL(handler)                                                                           \
+    {                                                                                              \
+        SY_PROFILE_CALL();                                                                         \
+        auto callRes = handler(ip, frame, activeStack);                                            \
+        if (callRes.hasErr()) {                                                                    \
+            return Error(callRes.takeErr());                                                       \
+        }                                                                                          \
+        if (callRes.value() == nullptr) {                                                          \
+            return OkExecStatus::FunctionCall;                                                     \
+        }                                                                                          \
+        ip = callRes.value();                                                                      \
+        SY_DISPATCH();                                                                             \
     }
 
-    return result;
-}
+// Same as `SY_CALL`, except that a tail call replaces the current frame rather than returning to
+// it, so the frame is reloaded from the active `Stack` to carry on executing the callee. Tail calls
+// never leave the loop, so are preemption points in place of the calls counted by
+// `interpreterRun(...)`.
+#define SY_TAIL_CALL(handler)                                                                      \
+    {                                                                                              \
+        SY_PROFILE_CALL();                                                                         \
+        auto callRes = handler(ip, frame, activeStack);                                            \
+        if (callRes.hasErr()) {                                                                    \
+            return Error(callRes.takeErr());                                                       \
+        }                                                                                          \
+        if (callRes.value() == nullptr) {                                                          \
+            return OkExecStatus::FunctionCall;                                                     \
+        }                                                                                          \
+        frame = currentFrameSlots(activeStack);                                                    \
+        ip = callRes.value();                                                                      \
+        SY_PREEMPT(ip)                                                                             \
+        SY_DISPATCH();                                                                             \
+    }
 
-static void executeReturn(const Bytecode b) {
-// No meaningful work needs to be done. Compiler should optimize this call away.
-#ifndef NDEBUG
-    const operators::Return operands = b.toOperands<operators::Return>();
-    (void)operands;
+// Preemption point, consuming one unit of budget, and leaving the loop to suspend execution once
+// it runs out. Execution resumes from `resumeIp`. Cancelled tasks fail here instead.
+#define SY_PREEMPT(resumeIp)                                                                       \
+    if (cancelToken != nullptr && cancelToken->isCancelled()) {                                    \
+        SY_PROFILE_FLUSH();                                                                        \
+        return Error(AnyError(Exceptional::Cancelled));                                            \
+    }                                                                                              \
+    if (--budget == 0) {                                                                           \
+        activeStack.setInstructionPointer(resumeIp);                                               \
+        SY_PROFILE_FLUSH();                                                                        \
+        return OkExecStatus::Suspend;                                                              \
+    }
+
+// Jumping to wherever `handlerCall` returns. Backward jumps are the only way for bytecode within a
+// frame to run again, so are preemption points.
+#define SY_JUMP(handlerCall)                                                                       \
+    {                                                                                              \
+        const Bytecode* target = handlerCall;                                                      \
+        if (target <= ip) {                                                                        \
+            SY_PREEMPT(target)                                                                     \
+        }                                                                                          \
+        ip = target;                                                                               \
+        SY_DISPATCH();                                                                             \
+    }
+
+// Leaving the loop only if the operation failed.
+#define SY_FALLIBLE(expr)                                                                          \
+    {                                                                                              \
+        auto opRes = expr;                                                                         \
+        if (opRes.hasErr()) {                                                                      \
+            SY_PROFILE_FLUSH();                                                                    \
+            return Error(opRes.takeErr());                                                         \
+        }                                                                                          \
+        ip = opRes.value();                                                                        \
+        SY_DISPATCH();                                                                             \
+    }
+
+#if SY_INTERPRETER_COMPUTED_GOTO && defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+/// Executes bytecode of the current frame until a call, return, error, or `budget` runs out.
+/// `cancelToken` is that of the task running on this thread, if any.
+static Result<OkExecStatus, AnyError>
+interpreterExecuteContinuous(Stack& activeStack, uint64_t& budget,
+                             const TaskCancelToken* cancelToken) {
+    const Bytecode* ip = activeStack.getInstructionPointer();
+    // Only changes when a tail call replaces the current frame.
+    FrameSlots frame = currentFrameSlots(activeStack);
+#if SY_INTERPRETER_PROFILER
+    OpcodeCounts opcodeCounts;
+#endif
+
+#if SY_INTERPRETER_COMPUTED_GOTO
+    // Must match the declaration order of `OpCode`.
+    static const void* const DISPATCH_TABLE[] = {
+        &&op_Noop,                       // Noop
+        &&op_Return,                     // Return
+        &&op_ReturnValue,                // ReturnValue
+        &&op_CallImmediateNoReturn,      // CallImmediateNoReturn
+        &&op_CallSrcNoReturn,            // CallSrcNoReturn
+        &&op_CallImmediateWithReturn,    // CallImmediateWithReturn
+        &&op_CallSrcWithReturn,          // CallSrcWithReturn
+        &&op_LoadDefault,                // LoadDefault
+        &&op_LoadImmediateScalar,        // LoadImmediateScalar
+        &&op_MemsetUninitialized,        // MemsetUninitialized
+        &&op_SetType,                    // SetType
+        &&op_SetNullType,                // SetNullType
+        &&op_Jump,                       // Jump
+        &&op_JumpIfFalse,                // JumpIfFalse
+        &&op_Destruct,                   // Destruct
+        &&op_Unimplemented,              // Sync
+        &&op_Unimplemented,              // Unsync
+        &&op_Move,                       // Move
+        &&op_Clone,                      // Clone
+        &&op_Unimplemented,              // Dereference
+        &&op_Unimplemented,              // SetReference
+        &&op_Unimplemented,              // MakeReference
+        &&op_GetMember,                  // GetMember
+        &&op_SetMember,                  // SetMember
+        &&op_Equal,                      // Equal
+        &&op_NotEqual,                   // NotEqual
+        &&op_Less,                       // Less
+        &&op_LessEqual,                  // LessEqual
+        &&op_Greater,                    // Greater
+        &&op_GreaterEqual,               // GreaterEqual
+        &&op_Add,                        // Add
+        &&op_TailCallImmediate,          // TailCallImmediate
+        &&op_TailCallSrc,                // TailCallSrc
+        &&op_Yield,                      // Yield
+        &&op_CompareJumpIfFalse,         // CompareJumpIfFalse
+        &&op_LoadImmediateScalarSetType, // LoadImmediateScalarSetType
+        &&op_LoadDefaultSetType,         // LoadDefaultSetType
+        &&op_DestructMany,               // DestructMany
+    };
+    static_assert(sizeof(DISPATCH_TABLE) / sizeof(DISPATCH_TABLE[0]) == OPCODE_COUNT,
+                  "Every opcode requires a dispatch table entry");
+
+    SY_DISPATCH();
 #else
-    (void)b;
-#endif // NDEBUG
+    while (true) {
+        switch (ip->getOpcode()) {
+#endif
 
-    // Frame is automatically unwinded
+    SY_OP(Noop) {
+        ip += 1;
+        SY_DISPATCH();
+    }
+    SY_OP(Return) {
+        // Frame is automatically unwinded
+        SY_PROFILE_FLUSH();
+        return OkExecStatus::Return;
+    }
+    SY_OP(ReturnValue) {
+        executeReturnValue(ip, frame, activeStack);
+        SY_PROFILE_FLUSH();
+        return OkExecStatus::Return;
+    }
+    SY_OP(CallImmediateNoReturn) SY_CALL(executeCallImmediateNoReturn);
+    SY_OP(CallSrcNoReturn) SY_CALL(executeCallSrcNoReturn);
+    SY_OP(CallImmediateWithReturn) SY_CALL(executeCallImmediateWithReturn);
+    SY_OP(CallSrcWithReturn) SY_CALL(executeCallSrcWithReturn);
+    SY_OP(LoadDefault) {
+        ip = executeLoadDefault(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(LoadImmediateScalar) {
+        ip = executeLoadImmediateScalar(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(MemsetUninitialized) {
+        ip = executeMemsetUninitialized(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(SetType) {
+        ip = executeSetType(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(SetNullType) {
+        ip = executeSetNullType(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(Jump) SY_JUMP(executeJump(ip));
+    SY_OP(JumpIfFalse) SY_JUMP(executeJumpIfFalse(ip, frame));
+    SY_OP(Destruct) {
+        ip = executeDestruct(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(Move) {
+        ip = executeMove(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(Clone) SY_FALLIBLE(executeClone(ip, frame));
+    SY_OP(GetMember) SY_FALLIBLE(executeGetMember(ip, frame));
+    SY_OP(SetMember) SY_FALLIBLE(executeSetMember(ip, frame));
+    SY_OP(Equal) SY_FALLIBLE((executeCompare<operators::Equal, std::equal_to<>>(ip, frame)));
+    SY_OP(NotEqual)
+    SY_FALLIBLE((executeCompare<operators::NotEqual, std::not_equal_to<>>(ip, frame)));
+    SY_OP(Less) SY_FALLIBLE((executeCompare<operators::Less, std::less<>>(ip, frame)));
+    SY_OP(LessEqual)
+    SY_FALLIBLE((executeCompare<operators::LessEqual, std::less_equal<>>(ip, frame)));
+    SY_OP(Greater) SY_FALLIBLE((executeCompare<operators::Greater, std::greater<>>(ip, frame)));
+    SY_OP(GreaterEqual)
+    SY_FALLIBLE((executeCompare<operators::GreaterEqual, std::greater_equal<>>(ip, frame)));
+    SY_OP(Add) {
+        ip = executeAdd(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(TailCallImmediate) SY_TAIL_CALL(executeTailCallImmediate);
+    SY_OP(TailCallSrc) SY_TAIL_CALL(executeTailCallSrc);
+    SY_OP(Yield) {
+        ip += 1;
+        if (runningPreemptible) {
+            activeStack.setInstructionPointer(ip);
+            SY_PROFILE_FLUSH();
+            return OkExecStatus::Yield;
+        }
+        SY_DISPATCH();
+    }
+    SY_OP(CompareJumpIfFalse) SY_JUMP(executeCompareJumpIfFalse(ip, frame));
+    SY_OP(LoadImmediateScalarSetType) {
+        ip = executeLoadImmediateScalarSetType(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(LoadDefaultSetType) {
+        ip = executeLoadDefaultSetType(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP(DestructMany) {
+        ip = executeDestructMany(ip, frame);
+        SY_DISPATCH();
+    }
+    SY_OP_UNIMPLEMENTED {
+        sy_assert(static_cast<uint8_t>(ip->getOpcode()) && false, "Unimplemented opcode");
+        ip += 1;
+        SY_DISPATCH();
+    }
+
+#if !SY_INTERPRETER_COMPUTED_GOTO
+        }
+    }
+#endif
 }
 
-static void executeReturnValue(const Bytecode b) {
-    const operators::ReturnValue operands = b.toOperands<operators::ReturnValue>();
+#if SY_INTERPRETER_COMPUTED_GOTO && defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
 
-    Stack& activeStack = Stack::getActiveStack();
+#undef SY_FALLIBLE
+#undef SY_JUMP
+#undef SY_PREEMPT
+#undef SY_TAIL_CALL
+#undef SY_CALL
+#undef SY_DISPATCH
+#undef SY_OP_UNIMPLEMENTED
+#undef SY_OP
+#undef SY_PROFILE_CALL
+#undef SY_PROFILE_FLUSH
+#undef SY_PROFILE_OP
+
+static void executeReturnValue(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack) {
+    const operators::ReturnValue operands = ip->toOperands<operators::ReturnValue>();
 
     void* retDst = activeStack.returnDst();
     sy_assert(retDst != nullptr, "Cannot assign return value to null memory");
 
-    const Type* retValType = activeStack.typeAt(operands.src);
-    sy_assert(retValType != nullptr, "Cannot return null type");
+    const Type* retValType = frame.typeAt(operands.src);
+    sy_verified_assert(retValType != nullptr, "Cannot return null type");
 
-    std::memcpy(retDst, activeStack.frameValueAt<void>(operands.src), retValType->sizeType);
+    std::memcpy(retDst, frame.valueAt<void>(operands.src), retValType->sizeType);
 
     // Frame is automatically unwinded
 }
 
 static bool pushScriptFunctionArgs(const RawFunction* function, const uint16_t argsCount,
-                                   const uint16_t* argsSrc) {
-    sy_assert(function->argsLen == argsCount, "Mismatched number of arguments passed to function");
+                                   const uint16_t* argsSrc, const FrameSlots& frame) {
+    sy_verified_assert(function->argsLen == argsCount,
+                       "Mismatched number of arguments passed to function");
     sy_assert(function->tag == FunctionType::Script,
               "Cannot push script function arguments to non scirpt function");
 
     RawFunction::CallArgs callArgs = function->startCall();
-    Stack& activeStack = Stack::getActiveStack();
 
     for (uint16_t i = 0; i < argsCount; i++) {
         const uint16_t argSrc = argsSrc[i];
-        const Type* type = activeStack.typeAt(argSrc);
-        sy_assert(type != nullptr, "Cannot push null type to function");
-        if (callArgs.push(activeStack.frameValueAt<void>(argSrc), type) == false) {
+        const Type* type = frame.typeAt(argSrc);
+        sy_verified_assert(type != nullptr, "Cannot push null type to function");
+        if (callArgs.push(frame.valueAt<void>(argSrc), type) == false) {
             return false;
         }
     }
     return true;
 }
 
-static Result<void, AnyError> setupInterpreterNestedCall(const RawFunction* function,
-                                                             void* retDst, const uint16_t argsCount,
-                                                             const uint16_t* argsSrc) {
+/// C function calls with up to this many arguments reference them in place within the caller's
+/// frame. Calls with more go through `RawFunction::CallArgs`.
+static constexpr uint16_t MAX_BORROWED_C_ARGS = 16;
+
+/// Runs a C function to completion, without pushing a script frame.
+static Result<void, AnyError> callCFunction(const RawFunction* function, void* retDst,
+                                            const uint16_t argsCount, const uint16_t* argsSrc,
+                                            const FrameSlots& frame) {
+    sy_verified_assert(function->argsLen == argsCount,
+                       "Mismatched number of arguments passed to function");
+
+    BorrowedArg args[MAX_BORROWED_C_ARGS];
+    bool borrowable = argsCount <= MAX_BORROWED_C_ARGS;
+    for (uint16_t i = 0; borrowable && i < argsCount; i++) {
+        const uint16_t argSrc = argsSrc[i];
+        const Type* type = frame.typeAt(argSrc);
+        sy_verified_assert(type != nullptr, "Cannot push null type to function");
+        // Frame slots are only guaranteed to be aligned to 8 bytes.
+        borrowable = type->alignType <= alignof(uint64_t);
+        args[i] = BorrowedArg{frame.valueAt<void>(argSrc), type};
+    }
+    if (borrowable) {
+        return callCFunctionBorrowedArgs(function, args, argsCount, retDst);
+    }
+
+    RawFunction::CallArgs callArgs = function->startCall();
+    for (uint16_t i = 0; i < argsCount; i++) {
+        (void)callArgs.push(frame.valueAt<void>(argsSrc[i]), frame.typeAt(argsSrc[i]));
+    }
+    return callArgs.call(retDst);
+}
+
+/// Stores `returnIp` as where the current frame resumes. Script functions get their frame pushed,
+/// returning null, whereas C functions are called immediately, returning `returnIp`.
+static Result<const Bytecode*, AnyError>
+setupInterpreterNestedCall(const RawFunction* function, void* retDst, const uint16_t argsCount,
+                           const uint16_t* argsSrc, const Bytecode* returnIp,
+                           const FrameSlots& frame, Stack& activeStack) {
+    activeStack.setInstructionPointer(returnIp);
+
     if (function->tag == FunctionType::Script) {
-        (void)pushScriptFunctionArgs(function, argsCount, argsSrc);
+        (void)pushScriptFunctionArgs(function, argsCount, argsSrc, frame);
         setupFunctionStackFrame(function, retDst);
-    } else {
-        sy_assert(false, "Cannot handle C function calling currently");
+        return static_cast<const Bytecode*>(nullptr);
+    }
+
+    auto callRes = callCFunction(function, retDst, argsCount, argsSrc, frame);
+    if (callRes.hasErr()) {
+        return Error(callRes.takeErr());
+    }
+    return returnIp;
+}
+
+/// Resolves how to call `function` from an indirect call site, through the site's inline cache if
+/// it has one. Either way, `function` is compiled by the time this returns.
+static ResolvedCall resolveIndirectCall(const RawFunction* function, const uint64_t cacheIndex,
+                                        const FrameSlots& frame) {
+    if (cacheIndex == NO_CALL_SITE_CACHE) {
+        ensureFunctionCompiled(function);
+        return CallSiteCache::resolve(function);
     }
 
+    sy_verified_assert(cacheIndex < frame.callSiteCachesLen, "Call site cache index out of bounds");
+    CallSiteCache& cache = frame.callSiteCaches[cacheIndex];
+    ResolvedCall resolved{};
+    if (cache.lookup(function, resolved)) {
+        return resolved;
+    }
+    // Only compiled functions are cached, so hits can skip this.
+    ensureFunctionCompiled(function);
+    return cache.update(function);
+}
+
+/// The verifier only knows the type of the value being called indirectly, not which function it
+/// holds, so the call is checked against the callee's signature here, in every build mode.
+static Result<void, AnyError> checkIndirectCallArgs(const RawFunction* function,
+                                                    const uint16_t argsCount,
+                                                    const uint16_t* argsSrc,
+                                                    const FrameSlots& frame) {
+    if (function->argsLen != argsCount) {
+        return Error(AnyError(Exceptional::Signature));
+    }
+    for (uint16_t i = 0; i < argsCount; i++) {
+        const Type* type = frame.typeAt(argsSrc[i]);
+        if (type == nullptr || type != function->argsTypes[i]) {
+            return Error(AnyError(Exceptional::Signature));
+        }
+    }
     return {};
 }
 
-static Result<void, AnyError> executeCallImmediateNoReturn(ptrdiff_t& ipChange,
-                                                               const Bytecode* bytecodes) {
-    const operators::CallImmediateNoReturn operands =
-        bytecodes[0].toOperands<operators::CallImmediateNoReturn>();
+/// Same as `checkIndirectCallArgs(...)`, also checking that the return value of `function`, if any,
+/// fits within the frame at `retDst`.
+static Result<void, AnyError> checkIndirectCall(const RawFunction* function, const void* retDst,
+                                                const uint16_t argsCount, const uint16_t* argsSrc,
+                                                const FrameSlots& frame) {
+    if ((retDst != nullptr) != (function->returnType != nullptr)) {
+        return Error(AnyError(Exceptional::Signature));
+    }
+    if (retDst != nullptr) {
+        const uint8_t* frameEnd =
+            reinterpret_cast<const uint8_t*>(frame.values + frame.frameLength);
+        const uint8_t* retEnd =
+            reinterpret_cast<const uint8_t*>(retDst) + function->returnType->sizeType;
+        if (retEnd > frameEnd) {
+            return Error(AnyError(Exceptional::Signature));
+        }
+    }
+    return checkIndirectCallArgs(function, argsCount, argsSrc, frame);
+}
 
-    Stack& activeStack = Stack::getActiveStack();
+/// Same as `setupInterpreterNestedCall(...)`, but for an indirect call. Script functions have their
+/// arguments and frame pushed directly onto `activeStack` using their resolved script info.
+static Result<const Bytecode*, AnyError>
+setupInterpreterIndirectCall(const RawFunction* function, void* retDst, const uint16_t argsCount,
+                             const uint16_t* argsSrc, const uint64_t cacheIndex,
+                             const Bytecode* returnIp, const FrameSlots& frame,
+                             Stack& activeStack) {
+    if (auto checkRes = checkIndirectCall(function, retDst, argsCount, argsSrc, frame);
+        checkRes.hasErr()) {
+        return Error(checkRes.takeErr());
+    }
 
-    const RawFunction* function = *reinterpret_cast<const RawFunction* const*>(&bytecodes[1]);
-    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&bytecodes[2]);
+    const ResolvedCall resolved = resolveIndirectCall(function, cacheIndex, frame);
+    if (!resolved.isScript) {
+        return setupInterpreterNestedCall(function, retDst, argsCount, argsSrc, returnIp, frame,
+                                          activeStack);
+    }
 
-    ipChange =
-        static_cast<ptrdiff_t>(operators::CallImmediateNoReturn::bytecodeUsed(operands.argCount));
+    activeStack.setInstructionPointer(returnIp);
 
-    activeStack.setInstructionPointer(activeStack.getInstructionPointer() + ipChange);
+    // Same layout as `RawFunction::CallArgs::push(...)`.
+    uint16_t offset = 0;
+    for (uint16_t i = 0; i < argsCount; i++) {
+        const uint16_t argSrc = argsSrc[i];
+        const Type* type = frame.typeAt(argSrc);
+        sy_verified_assert(type != nullptr, "Cannot push null type to function");
+        (void)activeStack.pushScriptFunctionArg(frame.valueAt<void>(argSrc), type, offset,
+                                                resolved.frameLength, resolved.frameAlign);
+        offset += static_cast<uint16_t>((type->sizeType + 7) / 8);
+    }
 
-    return setupInterpreterNestedCall(function, nullptr, operands.argCount, argsSrcs);
+    activeStack.pushFunctionFrame(function, retDst);
+    enterScriptFunction(function, activeStack);
+    return static_cast<const Bytecode*>(nullptr);
 }
 
-static Result<void, AnyError> executeCallSrcNoReturn(ptrdiff_t& ipChange,
-                                                         const Bytecode* bytecodes) {
-    const operators::CallSrcNoReturn operands =
-        bytecodes[0].toOperands<operators::CallSrcNoReturn>();
+static Result<const Bytecode*, AnyError>
+executeCallImmediateNoReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack) {
+    const operators::CallImmediateNoReturn operands =
+        ip->toOperands<operators::CallImmediateNoReturn>();
 
-    Stack& activeStack = Stack::getActiveStack();
+    const RawFunction* function = *reinterpret_cast<const RawFunction* const*>(&ip[1]);
+    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&ip[2]);
+    const Bytecode* returnIp =
+        ip + operators::CallImmediateNoReturn::bytecodeUsed(operands.argCount);
 
-    sy_assert(activeStack.typeAt(operands.src).get()->tag == Type::Tag::Function,
-              "Expected function to call");
-    const RawFunction* function = activeStack.frameValueAt<const RawFunction>(operands.src);
-    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&bytecodes[1]);
+    return setupInterpreterNestedCall(function, nullptr, operands.argCount, argsSrcs, returnIp,
+                                      frame, activeStack);
+}
 
-    ipChange = static_cast<ptrdiff_t>(operators::CallSrcNoReturn::bytecodeUsed(operands.argCount));
+static Result<const Bytecode*, AnyError>
+executeCallSrcNoReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack) {
+    const operators::CallSrcNoReturn operands = ip->toOperands<operators::CallSrcNoReturn>();
 
-    activeStack.setInstructionPointer(activeStack.getInstructionPointer() + ipChange);
+    sy_verified_assert(frame.typeAt(operands.src)->tag == Type::Tag::Function,
+                       "Expected function to call");
+    const RawFunction* function = frame.valueAt<const RawFunction>(operands.src);
+    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&ip[2]);
+    const Bytecode* returnIp = ip + operators::CallSrcNoReturn::bytecodeUsed(operands.argCount);
 
-    return setupInterpreterNestedCall(function, nullptr, operands.argCount, argsSrcs);
+    return setupInterpreterIndirectCall(function, nullptr, operands.argCount, argsSrcs,
+                                        ip[1].value, returnIp, frame, activeStack);
 }
 
-static Result<void, AnyError> executeCallImmediateWithReturn(ptrdiff_t& ipChange,
-                                                                 const Bytecode* bytecodes) {
+static Result<const Bytecode*, AnyError>
+executeCallImmediateWithReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack) {
     const operators::CallImmediateWithReturn operands =
-        bytecodes[0].toOperands<operators::CallImmediateWithReturn>();
+        ip->toOperands<operators::CallImmediateWithReturn>();
 
-    const RawFunction* function = *reinterpret_cast<const RawFunction* const*>(&bytecodes[1]);
-    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&bytecodes[2]);
+    const RawFunction* function = *reinterpret_cast<const RawFunction* const*>(&ip[1]);
+    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&ip[2]);
+    const Bytecode* returnIp =
+        ip + operators::CallImmediateWithReturn::bytecodeUsed(operands.argCount);
+    void* returnDst = frame.valueAt<void>(operands.retDst);
 
-    ipChange =
-        static_cast<ptrdiff_t>(operators::CallImmediateWithReturn::bytecodeUsed(operands.argCount));
+    return setupInterpreterNestedCall(function, returnDst, operands.argCount, argsSrcs, returnIp,
+                                      frame, activeStack);
+}
 
-    Stack& activeStack = Stack::getActiveStack();
-    void* returnDst = activeStack.frameValueAt<void>(operands.retDst);
+static Result<const Bytecode*, AnyError>
+executeCallSrcWithReturn(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack) {
+    const operators::CallSrcWithReturn operands = ip->toOperands<operators::CallSrcWithReturn>();
 
-    activeStack.setInstructionPointer(activeStack.getInstructionPointer() + ipChange);
+    sy_verified_assert(frame.typeAt(operands.src)->tag == Type::Tag::Function,
+                       "Expected function to call");
+    const RawFunction* function = frame.valueAt<const RawFunction>(operands.src);
+    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&ip[2]);
+    const Bytecode* returnIp = ip + operators::CallSrcWithReturn::bytecodeUsed(operands.argCount);
+    void* returnDst = frame.valueAt<void>(operands.retDst);
 
-    return setupInterpreterNestedCall(function, returnDst, operands.argCount, argsSrcs);
+    return setupInterpreterIndirectCall(function, returnDst, operands.argCount, argsSrcs,
+                                        ip[1].value, returnIp, frame, activeStack);
 }
 
-static Result<void, AnyError> executeCallSrcWithReturn(ptrdiff_t& ipChange,
-                                                           const Bytecode* bytecodes) {
-    const operators::CallSrcWithReturn operands =
-        bytecodes[0].toOperands<operators::CallSrcWithReturn>();
+/// Executed once a tail call has finished, for when the callee could not take over the caller's
+/// frame, so the caller returns after the callee instead.
+static const Bytecode TAIL_CALL_RETURN =
+    Bytecode(operators::Return{static_cast<uint64_t>(operators::Return::OPCODE)});
+
+/// Tail calls with arguments fitting within this many slots, including a slot per argument for
+/// its type, move them through the C++ stack. Calls with more allocate.
+static constexpr size_t MAX_STACK_TAIL_CALL_ARG_SLOTS = 32;
+
+/// Slot offset of the next argument within a script function's frame. Arguments are packed one
+/// after the other, regardless of their alignment, the same as the offsets of
+/// `RawFunction::CallArgs::push(...)` and the entry state of the bytecode verifier. Advances
+/// `offset` past the argument.
+static size_t nextScriptArgOffset(size_t& offset, const Type* type) {
+    const size_t argOffset = offset;
+    offset += (type->sizeType + 7) / 8;
+    return argOffset;
+}
 
-    Stack& activeStack = Stack::getActiveStack();
+/// Moves the arguments out of the current frame, unwinds it, and replaces it with the frame of
+/// `function`, with the arguments moved into it. Returns the instruction pointer to carry on
+/// executing `function` from.
+static Result<const Bytecode*, AnyError>
+replaceWithTailCallFrame(const RawFunction* function, const uint16_t argsCount,
+                         const uint16_t* argsSrc, const FrameSlots& frame, Stack& activeStack) {
+    sy_verified_assert(function->argsLen == argsCount,
+                       "Mismatched number of arguments passed to function");
+
+    size_t argSlots = 0;
+    for (uint16_t i = 0; i < argsCount; i++) {
+        const Type* type = frame.typeAt(argsSrc[i]);
+        sy_verified_assert(type != nullptr, "Cannot push null type to function");
+        (void)nextScriptArgOffset(argSlots, type);
+    }
+
+    // The argument values laid out as they will be in the callee's frame, followed by their types.
+    Allocator alloc{};
+    const size_t scratchLen = argSlots + argsCount;
+    uint64_t stackScratch[MAX_STACK_TAIL_CALL_ARG_SLOTS];
+    uint64_t* scratch = stackScratch;
+    if (scratchLen > MAX_STACK_TAIL_CALL_ARG_SLOTS) {
+        auto allocRes = alloc.allocArray<uint64_t>(scratchLen);
+        if (allocRes.hasErr()) {
+            return Error(AnyError(Exceptional::OOM));
+        }
+        scratch = allocRes.value();
+    }
+    const Type** scratchTypes = reinterpret_cast<const Type**>(&scratch[argSlots]);
+
+    // Take ownership of the arguments before unwinding, so they aren't destroyed along with
+    // everything else in the frame. Every argument is copied before any slot is released, as the
+    // same slot may be passed more than once.
+    size_t offset = 0;
+    for (uint16_t i = 0; i < argsCount; i++) {
+        const Type* type = frame.typeAt(argsSrc[i]);
+        memcpy(&scratch[nextScriptArgOffset(offset, type)], frame.valueAt<void>(argsSrc[i]),
+               type->sizeType);
+        scratchTypes[i] = type;
+    }
+    for (uint16_t i = 0; i < argsCount; i++) {
+        frame.setTypeAt(nullptr, argsSrc[i]);
+    }
+
+    {
+        const sy::RawFunction* currentFunction = activeStack.getCurrentFunction().value();
+        const sy::InterpreterFunctionScriptInfo* currentScriptInfo =
+            reinterpret_cast<const sy::InterpreterFunctionScriptInfo*>(currentFunction->fptr);
+        unwindStackFrame(currentScriptInfo->unwindSlots, currentScriptInfo->unwindLen);
+    }
+
+#if SY_INTERPRETER_PROFILER
+    profiler::leaveFunction();
+#endif
+    // Frames aren't cleared when pushed, but the callee must not see the caller's stale types.
+    activeStack.replaceFunctionFrame(function);
+    const FrameSlots calleeFrame = currentFrameSlots(activeStack);
+    for (uint16_t i = 0; i < calleeFrame.frameLength; i++) {
+        calleeFrame.types[i] = nullptr;
+    }
 
-    sy_assert(activeStack.typeAt(operands.src).get()->tag == Type::Tag::Function,
-              "Expected function to call");
-    const RawFunction* function = activeStack.frameValueAt<const RawFunction>(operands.src);
-    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&bytecodes[1]);
+    offset = 0;
+    for (uint16_t i = 0; i < argsCount; i++) {
+        const Type* type = scratchTypes[i];
+        const size_t argOffset = nextScriptArgOffset(offset, type);
+        memcpy(calleeFrame.valueAt<void>(argOffset), &scratch[argOffset], type->sizeType);
+        calleeFrame.setTypeAt(type, argOffset);
+    }
 
-    ipChange =
-        static_cast<ptrdiff_t>(operators::CallSrcWithReturn::bytecodeUsed(operands.argCount));
+    if (scratch != stackScratch) {
+        alloc.freeArray(scratch, scratchLen);
+    }
 
-    void* returnDst = activeStack.frameValueAt<void>(operands.retDst);
+    enterScriptFunction(function, activeStack);
+    return activeStack.getInstructionPointer();
+}
 
-    activeStack.setInstructionPointer(activeStack.getInstructionPointer() + ipChange);
+/// The callee returns directly into the current function's return value destination. Script
+/// functions reuse the current frame, whereas C functions, and script functions whose object
+/// lives within the current frame, are called as usual before the current function returns.
+static Result<const Bytecode*, AnyError>
+setupInterpreterTailCall(const RawFunction* function, const bool isScript,
+                         const uint16_t argsCount, const uint16_t* argsSrc,
+                         const FrameSlots& frame, Stack& activeStack) {
+    const uint8_t* functionMem = reinterpret_cast<const uint8_t*>(function);
+    const uint8_t* frameMem = reinterpret_cast<const uint8_t*>(frame.values);
+    const bool livesInFrame = functionMem >= frameMem &&
+                              functionMem < (frameMem + (frame.frameLength * sizeof(uint64_t)));
+
+    if (isScript && !livesInFrame) {
+        ensureFunctionCompiled(function);
+        return replaceWithTailCallFrame(function, argsCount, argsSrc, frame, activeStack);
+    }
 
-    return setupInterpreterNestedCall(function, returnDst, operands.argCount, argsSrcs);
+    return setupInterpreterNestedCall(function, activeStack.returnDst(), argsCount, argsSrc,
+                                      &TAIL_CALL_RETURN, frame, activeStack);
 }
 
-void executeLoadDefault(ptrdiff_t& ipChange, const Bytecode* bytecodes) {
-    const operators::LoadDefault operands = bytecodes[0].toOperands<operators::LoadDefault>();
+static Result<const Bytecode*, AnyError>
+executeTailCallImmediate(const Bytecode* ip, const FrameSlots& frame, Stack& activeStack) {
+    const operators::TailCallImmediate operands = ip->toOperands<operators::TailCallImmediate>();
 
-    Stack& activeStack = Stack::getActiveStack();
-    void* destination = activeStack.frameValueAt<void>(operands.dst);
+    const RawFunction* function = *reinterpret_cast<const RawFunction* const*>(&ip[1]);
+    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&ip[2]);
+
+    return setupInterpreterTailCall(function, function->tag == FunctionType::Script,
+                                    operands.argCount, argsSrcs, frame, activeStack);
+}
+
+static Result<const Bytecode*, AnyError> executeTailCallSrc(const Bytecode* ip,
+                                                            const FrameSlots& frame,
+                                                            Stack& activeStack) {
+    const operators::TailCallSrc operands = ip->toOperands<operators::TailCallSrc>();
+
+    sy_verified_assert(frame.typeAt(operands.src)->tag == Type::Tag::Function,
+                       "Expected function to call");
+    const RawFunction* function = frame.valueAt<const RawFunction>(operands.src);
+    const uint16_t* argsSrcs = reinterpret_cast<const uint16_t*>(&ip[2]);
+    if (function->returnType != activeStack.getCurrentFunction().value()->returnType) {
+        return Error(AnyError(Exceptional::Signature));
+    }
+    if (auto checkRes = checkIndirectCallArgs(function, operands.argCount, argsSrcs, frame);
+        checkRes.hasErr()) {
+        return Error(checkRes.takeErr());
+    }
+    const bool isScript = resolveIndirectCall(function, ip[1].value, frame).isScript;
+
+    return setupInterpreterTailCall(function, isScript, operands.argCount, argsSrcs, frame,
+                                    activeStack);
+}
+
+static inline const Bytecode* executeLoadDefault(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::LoadDefault operands = ip->toOperands<operators::LoadDefault>();
+
+    void* destination = frame.valueAt<void>(operands.dst);
 
     if (operands.isScalar) {
         const Type* scalarType = scalarTypeFromTag(static_cast<ScalarTag>(operands.scalarTag));
         memset(destination, 0, scalarType->sizeType);
     } else {
-        (void)ipChange;
         // TODO call default constructors or default initializer
         sy_assert(false, "Cannot load default for non-scalar types currently");
     }
+    return ip + 1;
 }
 
-void executeLoadImmediateScalar(ptrdiff_t& ipChange, const Bytecode* bytecodes) {
-    const operators::LoadImmediateScalar operands =
-        bytecodes[0].toOperands<operators::LoadImmediateScalar>();
+/// Shared by `LoadImmediateScalar` and `LoadImmediateScalarSetType`, which have the same layout.
+template <typename OperandsT>
+static inline const Bytecode* loadImmediateScalarImpl(const Bytecode* ip, const FrameSlots& frame,
+                                                      const OperandsT operands) {
     const ScalarTag scalarTag = static_cast<ScalarTag>(operands.scalarTag);
 
-    Stack& activeStack = Stack::getActiveStack();
-    void* destination = activeStack.frameValueAt<void>(operands.dst);
+    void* destination = frame.valueAt<void>(operands.dst);
     const Type* type = scalarTypeFromTag(scalarTag);
     if (type->sizeType <= 4) { // 32 bits
         uint32_t rawValue = static_cast<uint32_t>(operands.immediate);
         *reinterpret_cast<uint32_t*>(destination) = rawValue;
+        return ip + 1;
     } else {
         // All scalar types have alignment less than or equal to alignof(Bytecode), so this is fine.
         sy_assert(type->alignType <= alignof(Bytecode),
                   "Scalar types must have less than or equal alignment to Bytecode");
-        const void* valueMemory = reinterpret_cast<const void*>(&bytecodes[1]);
+        const void* valueMemory = reinterpret_cast<const void*>(&ip[1]);
         memcpy(destination, valueMemory, type->sizeType);
 
-        ipChange = operators::LoadImmediateScalar::bytecodeUsed(scalarTag);
-
         // TODO how to load immediate string objects? not string slices
+        return ip + OperandsT::bytecodeUsed(scalarTag);
     }
 }
 
-void executeMemsetUninitialized(const Bytecode bytecode) {
+static inline const Bytecode* executeLoadImmediateScalar(const Bytecode* ip,
+                                                         const FrameSlots& frame) {
+    return loadImmediateScalarImpl(ip, frame, ip->toOperands<operators::LoadImmediateScalar>());
+}
+
+static inline const Bytecode* executeMemsetUninitialized(const Bytecode* ip,
+                                                         const FrameSlots& frame) {
     const operators::MemsetUninitialized operands =
-        bytecode.toOperands<operators::MemsetUninitialized>();
+        ip->toOperands<operators::MemsetUninitialized>();
 
-    Stack& activeStack = Stack::getActiveStack();
-    void* destination = activeStack.frameValueAt<void>(operands.dst);
-#ifndef NDEBUG
-    const uint32_t frameLength = activeStack.getCurrentFrame().value().frameLength;
-    sy_assert(frameLength >=
-                  (static_cast<uint64_t>(operands.dst) + static_cast<uint64_t>(operands.slots)),
-              "Trying to uninitialize memory outside of stack frame");
-#endif
+    void* destination = frame.valueAt<void>(operands.dst);
+    sy_verified_assert(frame.frameLength >= (static_cast<uint64_t>(operands.dst) +
+                                             static_cast<uint64_t>(operands.slots)),
+                       "Trying to uninitialize memory outside of stack frame");
     const size_t bytesToSet = sizeof(void*) * static_cast<size_t>(operands.slots);
     memset(destination, 0xAA, bytesToSet);
+    return ip + 1;
 }
 
-void executeSetType(ptrdiff_t& ipChange, const Bytecode* bytecodes) {
-    const operators::SetType operands = bytecodes[0].toOperands<operators::SetType>();
+static inline const Bytecode* executeSetType(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::SetType operands = ip->toOperands<operators::SetType>();
 
-    Stack& activeStack = Stack::getActiveStack();
-    const Type* type = nullptr;
     if (operands.isScalar) {
-        type = scalarTypeFromTag(static_cast<ScalarTag>(operands.scalarTag));
+        frame.setTypeAt(scalarTypeFromTag(static_cast<ScalarTag>(operands.scalarTag)),
+                        operands.dst);
+        return ip + 1;
     } else {
-        const Bytecode next = bytecodes[1];
-        memcpy(&type, &next, sizeof(const Type*));
-        ipChange = 2;
+        const Type* type = nullptr;
+        memcpy(&type, &ip[1], sizeof(const Type*));
+        frame.setTypeAt(type, operands.dst);
+        return ip + 2;
     }
-    activeStack.setTypeAt(Node::TypeOfValue(type, true), operands.dst);
 }
 
-void executeSetNullType(const Bytecode bytecode) {
-    const operators::SetNullType operands = bytecode.toOperands<operators::SetNullType>();
-    Stack& activeStack = Stack::getActiveStack();
-    activeStack.setTypeAt(nullptr, operands.dst);
+static inline const Bytecode* executeSetNullType(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::SetNullType operands = ip->toOperands<operators::SetNullType>();
+    frame.setTypeAt(nullptr, operands.dst);
+    return ip + 1;
 }
 
-static void executeJump(ptrdiff_t& ipChange, const Bytecode bytecode) {
-    const operators::Jump operands = bytecode.toOperands<operators::Jump>();
-    int32_t jumpAmount = static_cast<int32_t>(operands.amount);
-    ipChange = jumpAmount;
+static inline const Bytecode* executeJump(const Bytecode* ip) {
+    const operators::Jump operands = ip->toOperands<operators::Jump>();
+    return ip + static_cast<int32_t>(operands.amount);
 }
 
-static void executeJumpIfFalse(ptrdiff_t& ipChange, const Bytecode bytecode) {
-    const operators::JumpIfFalse operands = bytecode.toOperands<operators::JumpIfFalse>();
+static inline const Bytecode* executeJumpIfFalse(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::JumpIfFalse operands = ip->toOperands<operators::JumpIfFalse>();
 
-    Stack& activeStack = Stack::getActiveStack();
-    const Type* srcType = activeStack.typeAt(operands.src);
-    sy_assert(srcType == Reflect<bool>::get(), "Can only conditionally jump on boolean types");
-    (void)srcType;
+    sy_verified_assert(frame.typeAt(operands.src) == Reflect<bool>::get(),
+                       "Can only conditionally jump on boolean types");
 
-    if (*activeStack.frameValueAt<bool>(operands.src) == false) {
-        int32_t jumpAmount = static_cast<int32_t>(operands.amount);
-        ipChange = jumpAmount;
+    if (*frame.valueAt<bool>(operands.src) == false) {
+        return ip + static_cast<int32_t>(operands.amount);
     }
+    return ip + 1;
 }
 
-static void executeDestruct(const Bytecode bytecode) {
-    const operators::Destruct operands = bytecode.toOperands<operators::Destruct>();
+static inline const Bytecode* executeDestruct(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::Destruct operands = ip->toOperands<operators::Destruct>();
 
-    Stack& activeStack = Stack::getActiveStack();
+    const Type* srcType = frame.typeAt(operands.src);
+    sy_verified_assert(srcType != nullptr, "Cannot destruct null typed object");
+
+    srcType->destroyObject(frame.valueAt<void>(operands.src));
+    frame.setTypeAt(nullptr, operands.src);
+    return ip + 1;
+}
+
+/// Calls `kernel` with a value initialized object of the C++ type matching `tag`. The kernel is
+/// expected to be a generic lambda, using the type of its argument to select the typed operation.
+template <typename F> static inline decltype(auto) visitScalar(const ScalarTag tag, F&& kernel) {
+    switch (tag) {
+    case ScalarTag::Bool:
+        return kernel(bool{});
+    case ScalarTag::I8:
+        return kernel(int8_t{});
+    case ScalarTag::I16:
+        return kernel(int16_t{});
+    case ScalarTag::I32:
+        return kernel(int32_t{});
+    case ScalarTag::I64:
+        return kernel(int64_t{});
+    case ScalarTag::U8:
+        return kernel(uint8_t{});
+    case ScalarTag::U16:
+        return kernel(uint16_t{});
+    case ScalarTag::U32:
+        return kernel(uint32_t{});
+    case ScalarTag::U64:
+        return kernel(uint64_t{});
+    case ScalarTag::USize:
+        return kernel(size_t{});
+    case ScalarTag::F32:
+        return kernel(float{});
+    case ScalarTag::F64:
+        return kernel(double{});
+    }
+    sync_unreachable();
+}
+
+static inline const Bytecode* executeMove(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::Move operands = ip->toOperands<operators::Move>();
+
+    if (operands.isScalar) {
+        *frame.valueAt<uint64_t>(operands.dst) = *frame.valueAt<uint64_t>(operands.src);
+        return ip + 1;
+    }
+
+    if (operands.dst == operands.src) {
+        return ip + 1;
+    }
+
+    const Type* srcType = frame.typeAt(operands.src);
+    sy_verified_assert(srcType != nullptr, "Cannot move null typed object");
+
+    memmove(frame.valueAt<void>(operands.dst), frame.valueAt<void>(operands.src),
+            srcType->sizeType);
+    frame.setTypeAt(nullptr, operands.src);
+    frame.setTypeAt(srcType, operands.dst);
+    return ip + 1;
+}
+
+static inline Result<const Bytecode*, AnyError> executeClone(const Bytecode* ip,
+                                                             const FrameSlots& frame) {
+    const operators::Clone operands = ip->toOperands<operators::Clone>();
+
+    if (operands.isScalar) {
+        *frame.valueAt<uint64_t>(operands.dst) = *frame.valueAt<uint64_t>(operands.src);
+        return ip + 1;
+    }
+
+    const Type* srcType = frame.typeAt(operands.src);
+    sy_verified_assert(srcType != nullptr, "Cannot clone null typed object");
+
+    if (auto cloneRes =
+            srcType->cloneObj(frame.valueAt<void>(operands.dst), frame.valueAt<void>(operands.src));
+        cloneRes.hasErr()) {
+        return Error(cloneRes.takeErr());
+    }
+    frame.setTypeAt(srcType, operands.dst);
+    return ip + 1;
+}
+
+static inline Result<const Bytecode*, AnyError> executeGetMember(const Bytecode* ip,
+                                                                 const FrameSlots& frame) {
+    const operators::GetMember operands = ip->toOperands<operators::GetMember>();
+
+    const uint8_t* member =
+        frame.valueAt<const uint8_t>(operands.src) + static_cast<size_t>(operands.memberOffset);
+    void* destination = frame.valueAt<void>(operands.dst);
+
+    if (operands.isScalar) {
+        visitScalar(static_cast<ScalarTag>(operands.scalarTag),
+                    [&](auto zero) { memcpy(destination, member, sizeof(zero)); });
+        return ip + 1;
+    }
+
+    const Type* memberType = nullptr;
+    memcpy(&memberType, &ip[1], sizeof(const Type*));
+    sy_verified_assert(memberType != nullptr, "Cannot get null typed member");
+
+    if (auto cloneRes = memberType->cloneObj(destination, reinterpret_cast<const void*>(member));
+        cloneRes.hasErr()) {
+        return Error(cloneRes.takeErr());
+    }
+    frame.setTypeAt(memberType, operands.dst);
+    return ip + 2;
+}
+
+static inline Result<const Bytecode*, AnyError> executeSetMember(const Bytecode* ip,
+                                                                 const FrameSlots& frame) {
+    const operators::SetMember operands = ip->toOperands<operators::SetMember>();
+
+    uint8_t* member =
+        frame.valueAt<uint8_t>(operands.dst) + static_cast<size_t>(operands.memberOffset);
+    const void* source = frame.valueAt<void>(operands.src);
+
+    if (operands.isScalar) {
+        visitScalar(static_cast<ScalarTag>(operands.scalarTag),
+                    [&](auto zero) { memcpy(member, source, sizeof(zero)); });
+        return ip + 1;
+    }
+
+    const Type* memberType = nullptr;
+    memcpy(&memberType, &ip[1], sizeof(const Type*));
+    sy_verified_assert(memberType != nullptr, "Cannot set null typed member");
+    sy_verified_assert(frame.typeAt(operands.src) == memberType,
+                       "Mismatched member and source types");
+
+    if (auto destroyRes = memberType->destroyObject(reinterpret_cast<void*>(member));
+        destroyRes.hasErr()) {
+        return Error(destroyRes.takeErr());
+    }
+    memcpy(member, source, memberType->sizeType);
+    frame.setTypeAt(nullptr, operands.src);
+    return ip + 2;
+}
+
+/// `Cmp` is one of the `std` transparent comparison function objects, such as `std::less<>`.
+/// Non scalar types compare through their `BuiltInCoherentTraits`, by comparing the resulting
+/// `Ordering` against `Ordering::Equal`.
+template <typename OperandsT, typename Cmp>
+static inline Result<const Bytecode*, AnyError> executeCompare(const Bytecode* ip,
+                                                               const FrameSlots& frame) {
+    const OperandsT operands = ip->toOperands<OperandsT>();
+
+    if (operands.isScalar) {
+        *frame.valueAt<bool>(operands.dst) =
+            visitScalar(static_cast<ScalarTag>(operands.scalarTag), [&](auto zero) -> bool {
+                using T = decltype(zero);
+                return Cmp{}(*frame.valueAt<T>(operands.lhs), *frame.valueAt<T>(operands.rhs));
+            });
+        return ip + 1;
+    }
+
+    const Type* type = frame.typeAt(operands.lhs);
+    sy_verified_assert(type != nullptr, "Cannot compare null typed objects");
+    sy_verified_assert(type == frame.typeAt(operands.rhs),
+                       "Cannot compare objects of different types");
+
+    const void* lhs = frame.valueAt<void>(operands.lhs);
+    const void* rhs = frame.valueAt<void>(operands.rhs);
+    int32_t ordering = 0;
+    if constexpr (std::is_same_v<Cmp, std::equal_to<>> ||
+                  std::is_same_v<Cmp, std::not_equal_to<>>) {
+        auto eqRes = type->equalObj(lhs, rhs);
+        if (eqRes.hasErr()) {
+            return Error(eqRes.takeErr());
+        }
+        ordering = eqRes.value() ? 0 : 1;
+    } else {
+        auto cmpRes = type->compareObj(lhs, rhs);
+        if (cmpRes.hasErr()) {
+            return Error(cmpRes.takeErr());
+        }
+        ordering = static_cast<int32_t>(cmpRes.value());
+    }
+
+    *frame.valueAt<bool>(operands.dst) = Cmp{}(ordering, 0);
+    frame.setTypeAt(Reflect<bool>::get(), operands.dst);
+    return ip + 1;
+}
+
+static inline const Bytecode* executeAdd(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::Add operands = ip->toOperands<operators::Add>();
+    sy_assert(operands.isScalar, "Addition of non scalar types is unsupported");
+
+    visitScalar(static_cast<ScalarTag>(operands.scalarTag), [&](auto zero) {
+        using T = decltype(zero);
+        const T lhs = *frame.valueAt<T>(operands.lhs);
+        const T rhs = *frame.valueAt<T>(operands.rhs);
+        T* dst = frame.valueAt<T>(operands.dst);
+        if constexpr (std::is_same_v<T, bool>) {
+            (void)lhs;
+            (void)rhs;
+            (void)dst;
+            sy_assert(false, "Cannot add booleans");
+        } else if constexpr (std::is_integral_v<T>) {
+            // Unsigned arithmetic wraps rather than being undefined on signed overflow.
+            using U = std::make_unsigned_t<T>;
+            *dst = static_cast<T>(static_cast<U>(lhs) + static_cast<U>(rhs));
+        } else {
+            *dst = lhs + rhs;
+        }
+    });
+    return ip + 1;
+}
+
+static inline const Bytecode* executeCompareJumpIfFalse(const Bytecode* ip,
+                                                        const FrameSlots& frame) {
+    const operators::CompareJumpIfFalse operands = ip->toOperands<operators::CompareJumpIfFalse>();
+    const ScalarTag scalarTag = static_cast<ScalarTag>(operands.scalarTag);
+
+    bool result = false;
+    visitScalar(scalarTag, [&](auto zero) {
+        using T = decltype(zero);
+        const T lhs = *frame.valueAt<T>(operands.lhs);
+        const T rhs = *frame.valueAt<T>(operands.rhs);
+        switch (static_cast<OpCode>(static_cast<uint8_t>(OpCode::Equal) + operands.compareOp)) {
+        case OpCode::Equal:
+            result = lhs == rhs;
+            break;
+        case OpCode::NotEqual:
+            result = lhs != rhs;
+            break;
+        case OpCode::Less:
+            result = lhs < rhs;
+            break;
+        case OpCode::LessEqual:
+            result = lhs <= rhs;
+            break;
+        case OpCode::Greater:
+            result = lhs > rhs;
+            break;
+        case OpCode::GreaterEqual:
+            result = lhs >= rhs;
+            break;
+        default:
+            sy_assert(false, "Invalid fused comparison");
+        }
+    });
+    *frame.valueAt<bool>(operands.dst) = result;
+
+    if (result == false) {
+        return ip + static_cast<int64_t>(ip[1].value);
+    }
+    return ip + 2;
+}
+
+static inline const Bytecode* executeLoadImmediateScalarSetType(const Bytecode* ip,
+                                                                const FrameSlots& frame) {
+    const operators::LoadImmediateScalarSetType operands =
+        ip->toOperands<operators::LoadImmediateScalarSetType>();
+    frame.setTypeAt(scalarTypeFromTag(static_cast<ScalarTag>(operands.scalarTag)), operands.dst);
+    return loadImmediateScalarImpl(ip, frame, operands);
+}
+
+static inline const Bytecode* executeLoadDefaultSetType(const Bytecode* ip,
+                                                        const FrameSlots& frame) {
+    const operators::LoadDefaultSetType operands = ip->toOperands<operators::LoadDefaultSetType>();
+
+    const Type* scalarType = scalarTypeFromTag(static_cast<ScalarTag>(operands.scalarTag));
+    memset(frame.valueAt<void>(operands.dst), 0, scalarType->sizeType);
+    frame.setTypeAt(scalarType, operands.dst);
+    return ip + 1;
+}
+
+static inline const Bytecode* executeDestructMany(const Bytecode* ip, const FrameSlots& frame) {
+    const operators::DestructMany operands = ip->toOperands<operators::DestructMany>();
+    sy_assert(operands.count >= 2, "DestructMany expects at least 2 sources");
+
+    const uint16_t srcs[3] = {static_cast<uint16_t>(operands.src0),
+                              static_cast<uint16_t>(operands.src1),
+                              static_cast<uint16_t>(operands.src2)};
+    for (uint64_t i = 0; i < operands.count; i++) {
+        const Type* srcType = frame.typeAt(srcs[i]);
+        sy_verified_assert(srcType != nullptr, "Cannot destruct null typed object");
+
+        srcType->destroyObject(frame.valueAt<void>(srcs[i]));
+        frame.setTypeAt(nullptr, srcs[i]);
+    }
+    return ip + 1;
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include "../testing/script_function.hpp"
+#include "function_builder.hpp"
+
+using namespace sy::testing;
+
+TEST_CASE("[interpreter] return immediate") {
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 42),
+                                 setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    TestScriptFunction fn(bytecode, 3, 2, Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 42);
+}
+
+TEST_CASE("[interpreter] jump if false") {
+    operators::JumpIfFalse jumpIfFalse{};
+    jumpIfFalse.reserveOpcode = static_cast<uint64_t>(operators::JumpIfFalse::OPCODE);
+    jumpIfFalse.src = 0;
+    jumpIfFalse.amount = 3;
+
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = 2;
+
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::Bool, 0, 0),
+                                 setScalarType(ScalarTag::Bool, 0),
+                                 Bytecode(jumpIfFalse),
+                                 loadImmediate(ScalarTag::I32, 1, 1),
+                                 Bytecode(jump),
+                                 loadImmediate(ScalarTag::I32, 1, 2),
+                                 setScalarType(ScalarTag::I32, 1),
+                                 returnValue(1)};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                          Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 2);
+}
+
+TEST_CASE("[interpreter] nested script call with return") {
+    const Bytecode calleeBytecode[] = {loadImmediate(ScalarTag::I32, 0, 7),
+                                       setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    TestScriptFunction callee(calleeBytecode, 3, 2, Reflect<int32_t>::get());
+
+    operators::CallImmediateWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+    call.argCount = 0;
+    call.retDst = 1;
+    Bytecode calleePtr;
+    calleePtr.value = reinterpret_cast<uint64_t>(&callee.function);
+
+    const Bytecode callerBytecode[] = {Bytecode(call), calleePtr, setScalarType(ScalarTag::I32, 1),
+                                       returnValue(1)};
+    TestScriptFunction caller(callerBytecode, 4, 2, Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&caller.function, &result));
+    CHECK_EQ(result, 7);
+}
+
+TEST_CASE("[interpreter] nested script call with arguments") {
+    // Each argument takes the next slot of the callee's frame.
+    const Bytecode calleeBytecode[] = {binaryScalarOp<operators::Add>(ScalarTag::I32, 3, 0, 1),
+                                       binaryScalarOp<operators::Add>(ScalarTag::I32, 3, 3, 2),
+                                       setScalarType(ScalarTag::I32, 3), returnValue(3)};
+    TestScriptFunction callee(calleeBytecode, 4, 4, Reflect<int32_t>::get());
+    const Type* argsTypes[3] = {Reflect<int32_t>::get(), Reflect<int32_t>::get(),
+                                Reflect<int32_t>::get()};
+    callee.function.argsTypes = argsTypes;
+    callee.function.argsLen = 3;
+
+    operators::CallImmediateWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+    call.argCount = 3;
+    call.retDst = 3;
+    Bytecode calleePtr;
+    calleePtr.value = reinterpret_cast<uint64_t>(&callee.function);
+    Bytecode argsSrcs;
+    argsSrcs.value = 0 | (1 << 16) | (uint64_t{2} << 32);
+
+    const Bytecode callerBytecode[] = {loadImmediate(ScalarTag::I32, 0, 1),
+                                       setScalarType(ScalarTag::I32, 0),
+                                       loadImmediate(ScalarTag::I32, 1, 20),
+                                       setScalarType(ScalarTag::I32, 1),
+                                       loadImmediate(ScalarTag::I32, 2, 300),
+                                       setScalarType(ScalarTag::I32, 2),
+                                       Bytecode(call),
+                                       calleePtr,
+                                       argsSrcs,
+                                       setScalarType(ScalarTag::I32, 3),
+                                       returnValue(3)};
+    TestScriptFunction caller(callerBytecode, sizeof(callerBytecode) / sizeof(Bytecode), 4,
+                              Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&caller.function, &result));
+    CHECK_EQ(result, 321);
+}
+
+static int32_t hostSubtract(int32_t lhs, int32_t rhs) { return lhs - rhs; }
+
+static Result<void, AnyError> hostFail() { return Error(AnyError(Exceptional::Capacity)); }
+
+TEST_CASE("[interpreter] C function call stays within the caller's frame") {
+    const Function<int32_t(int32_t, int32_t)> subtract(hostSubtract);
+
+    operators::CallImmediateWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+    call.argCount = 2;
+    call.retDst = 2;
+    Bytecode subtractPtr;
+    subtractPtr.value = reinterpret_cast<uint64_t>(&subtract);
+    Bytecode argsSrcs;
+    argsSrcs.value = 1 | (0 << 16);
+
+    // Calls the host function twice, feeding the first result into the second call.
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 10),
+                                 setScalarType(ScalarTag::I32, 0),
+                                 loadImmediate(ScalarTag::I32, 1, 50),
+                                 setScalarType(ScalarTag::I32, 1),
+                                 Bytecode(call),
+                                 subtractPtr,
+                                 argsSrcs,
+                                 setScalarType(ScalarTag::I32, 2),
+                                 Bytecode(call),
+                                 subtractPtr,
+                                 argsSrcs,
+                                 returnValue(2)};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 4,
+                          Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 40);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+}
+
+TEST_CASE("[interpreter] C function error unwinds") {
+    const Function<void()> fail(hostFail);
+
+    operators::CallImmediateNoReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateNoReturn::OPCODE);
+    call.argCount = 0;
+    Bytecode failPtr;
+    failPtr.value = reinterpret_cast<uint64_t>(&fail);
 
-    const Type* srcType = activeStack.typeAt(operands.src);
-    sy_assert(srcType != nullptr, "Cannot destruct null typed object");
+    const Bytecode bytecode[] = {Bytecode(call), failPtr, loadImmediate(ScalarTag::I32, 0, 1),
+                                 setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                          Reflect<int32_t>::get());
 
-    void* src = activeStack.frameValueAt<void>(operands.src);
-    srcType->destroyObject(src);
-    activeStack.setTypeAt(nullptr, operands.src);
+    int32_t result = 0;
+    CHECK_FALSE(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 0);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
 }
+
+static int32_t hostCallstackDepth() {
+    return static_cast<int32_t>(Stack::getActiveStack().callStack().len());
+}
+
+TEST_CASE("[interpreter] tail call recursion runs in constant stack") {
+    const Function<int32_t()> callstackDepth(hostCallstackDepth);
+
+    operators::JumpIfFalse jumpIfFalse{};
+    jumpIfFalse.reserveOpcode = static_cast<uint64_t>(operators::JumpIfFalse::OPCODE);
+    jumpIfFalse.src = 2;
+    jumpIfFalse.amount = 5;
+
+    operators::CallImmediateWithReturn depthCall{};
+    depthCall.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+    depthCall.argCount = 0;
+    depthCall.retDst = 4;
+    Bytecode depthPtr;
+    depthPtr.value = reinterpret_cast<uint64_t>(&callstackDepth);
+
+    operators::TailCallImmediate tailCall{};
+    tailCall.reserveOpcode = static_cast<uint64_t>(operators::TailCallImmediate::OPCODE);
+    tailCall.argCount = 1;
+    Bytecode argsSrcs;
+    argsSrcs.value = 0;
+
+    // countdown(n) { if (n == 0) return callstackDepth(); return countdown(n + -1); }
+    Bytecode countdownBytecode[] = {loadImmediate(ScalarTag::I32, 1, static_cast<uint32_t>(-1)),
+                                    setScalarType(ScalarTag::I32, 1),
+                                    loadImmediate(ScalarTag::I32, 3, 0),
+                                    setScalarType(ScalarTag::I32, 3),
+                                    setScalarType(ScalarTag::Bool, 2),
+                                    binaryScalarOp<operators::NotEqual>(ScalarTag::I32, 2, 0, 3),
+                                    Bytecode(jumpIfFalse),
+                                    binaryScalarOp<operators::Add>(ScalarTag::I32, 0, 0, 1),
+                                    Bytecode(tailCall),
+                                    Bytecode(),
+                                    argsSrcs,
+                                    Bytecode(depthCall),
+                                    depthPtr,
+                                    setScalarType(ScalarTag::I32, 4),
+                                    returnValue(4)};
+    TestScriptFunction countdown(countdownBytecode, sizeof(countdownBytecode) / sizeof(Bytecode), 6,
+                                 Reflect<int32_t>::get());
+    const Type* argsTypes[1] = {Reflect<int32_t>::get()};
+    countdown.function.argsTypes = argsTypes;
+    countdown.function.argsLen = 1;
+    countdownBytecode[9].value = reinterpret_cast<uint64_t>(&countdown.function);
+
+    auto depthAfterCountdown = [&countdown](uint32_t n) -> int32_t {
+        operators::CallImmediateWithReturn call{};
+        call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+        call.argCount = 1;
+        call.retDst = 1;
+        Bytecode countdownPtr;
+        countdownPtr.value = reinterpret_cast<uint64_t>(&countdown.function);
+        Bytecode callArgsSrcs;
+        callArgsSrcs.value = 0;
+
+        const Bytecode callerBytecode[] = {loadImmediate(ScalarTag::I32, 0, n),
+                                           setScalarType(ScalarTag::I32, 0),
+                                           Bytecode(call),
+                                           countdownPtr,
+                                           callArgsSrcs,
+                                           setScalarType(ScalarTag::I32, 1),
+                                           returnValue(1)};
+        TestScriptFunction caller(callerBytecode, sizeof(callerBytecode) / sizeof(Bytecode), 2,
+                                  Reflect<int32_t>::get());
+
+        int32_t result = 0;
+        CHECK(interpreterExecuteScriptFunction(&caller.function, &result));
+        CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+        return result;
+    };
+
+    const int32_t shallowDepth = depthAfterCountdown(0);
+    CHECK_GT(shallowDepth, 0);
+    CHECK_EQ(depthAfterCountdown(1), shallowDepth);
+    CHECK_EQ(depthAfterCountdown(100000), shallowDepth);
+}
+
+TEST_CASE("[interpreter] tail call into larger frame and C function") {
+    const Function<int32_t(int32_t, int32_t)> subtract(hostSubtract);
+
+    operators::TailCallImmediate tailCall{};
+    tailCall.reserveOpcode = static_cast<uint64_t>(operators::TailCallImmediate::OPCODE);
+    tailCall.argCount = 2;
+    Bytecode subtractPtr;
+    subtractPtr.value = reinterpret_cast<uint64_t>(&subtract);
+
+    // Large enough to not fit in the node of the frame it replaces.
+    constexpr uint16_t largeFrameLength = 20000;
+    Bytecode argsSrcs;
+    argsSrcs.value = (largeFrameLength - 2) | (0 << 16);
+    const Bytecode largeBytecode[] = {loadImmediate(ScalarTag::I32, largeFrameLength - 2, 50),
+                                      setScalarType(ScalarTag::I32, largeFrameLength - 2),
+                                      Bytecode(tailCall),
+                                      subtractPtr,
+                                      argsSrcs};
+    TestScriptFunction large(largeBytecode, sizeof(largeBytecode) / sizeof(Bytecode),
+                             largeFrameLength, Reflect<int32_t>::get());
+    const Type* argsTypes[1] = {Reflect<int32_t>::get()};
+    large.function.argsTypes = argsTypes;
+    large.function.argsLen = 1;
+
+    operators::TailCallImmediate callLarge{};
+    callLarge.reserveOpcode = static_cast<uint64_t>(operators::TailCallImmediate::OPCODE);
+    callLarge.argCount = 1;
+    Bytecode largePtr;
+    largePtr.value = reinterpret_cast<uint64_t>(&large.function);
+    Bytecode callLargeArgsSrcs;
+    callLargeArgsSrcs.value = 0;
+
+    // return large(10) -> return subtract(50, 10)
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 10),
+                                 setScalarType(ScalarTag::I32, 0), Bytecode(callLarge), largePtr,
+                                 callLargeArgsSrcs};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                          Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 40);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+}
+
+struct alignas(16) TestAligned16 {
+    uint64_t v[2];
+};
+
+TEST_CASE("[interpreter] tail call packs over-aligned arguments") {
+    const Type alignedType = {
+        .sizeType = sizeof(TestAligned16),
+        .alignType = static_cast<uint16_t>(alignof(TestAligned16)),
+        .name = StringSlice("aligned"),
+        .tag = Type::Tag::OpaquePointer,
+        .extra = Type::ExtraInfo(),
+        .destructor = nullptr,
+        .builtinTraits = nullptr,
+        .constRef = nullptr,
+        .mutRef = nullptr,
+    };
+    const Type* argsTypes[2] = {Reflect<int32_t>::get(), &alignedType};
+
+    // Packed after the first argument, the aligned argument starts at slot 1.
+    const Bytecode calleeBytecode[] = {returnValue(1)};
+    TestScriptFunction callee(calleeBytecode, 1, 4, &alignedType);
+    callee.function.argsTypes = argsTypes;
+    callee.function.argsLen = 2;
+
+    operators::TailCallImmediate tailCall{};
+    tailCall.reserveOpcode = static_cast<uint64_t>(operators::TailCallImmediate::OPCODE);
+    tailCall.argCount = 2;
+    Bytecode calleePtr;
+    calleePtr.value = reinterpret_cast<uint64_t>(&callee.function);
+    Bytecode argsSrcs;
+    argsSrcs.value = 0 | (1 << 16);
+
+    // caller(n, aligned) { return callee(n, aligned); }
+    const Bytecode callerBytecode[] = {Bytecode(tailCall), calleePtr, argsSrcs};
+    TestScriptFunction caller(callerBytecode, sizeof(callerBytecode) / sizeof(Bytecode), 4,
+                              &alignedType);
+    caller.function.argsTypes = argsTypes;
+    caller.function.argsLen = 2;
+
+    int32_t n = 1;
+    TestAligned16 aligned = {{2, 3}};
+    RawFunction::CallArgs args = caller.function.startCall();
+    CHECK(args.push(&n, Reflect<int32_t>::get()));
+    CHECK(args.push(&aligned, &alignedType));
+    TestAligned16 result = {{0, 0}};
+    CHECK(args.call(&result));
+    CHECK_EQ(result.v[0], 2);
+    CHECK_EQ(result.v[1], 3);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+}
+
+TEST_CASE("[interpreter] tail call passing the same slot twice") {
+    const Bytecode sumBytecode[] = {setScalarType(ScalarTag::I32, 2), addI32(2, 0, 1),
+                                    returnValue(2)};
+    TestScriptFunction sum(sumBytecode, sizeof(sumBytecode) / sizeof(Bytecode), 4,
+                           Reflect<int32_t>::get());
+    const Type* argsTypes[2] = {Reflect<int32_t>::get(), Reflect<int32_t>::get()};
+    sum.function.argsTypes = argsTypes;
+    sum.function.argsLen = 2;
+
+    operators::TailCallImmediate tailCall{};
+    tailCall.reserveOpcode = static_cast<uint64_t>(operators::TailCallImmediate::OPCODE);
+    tailCall.argCount = 2;
+    Bytecode sumPtr;
+    sumPtr.value = reinterpret_cast<uint64_t>(&sum.function);
+    Bytecode argsSrcs;
+    argsSrcs.value = 0 | (0 << 16);
+
+    // x = 21; return sum(x, x);
+    const Bytecode bytecode[] = {loadI32(0, 21), Bytecode(tailCall), sumPtr, argsSrcs};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                          Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 42);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+}
+
+static int32_t hostNegate(int32_t value) { return -value; }
+
+TEST_CASE("[interpreter] indirect calls go through the call site cache") {
+    // Functions called indirectly are copied into the frame.
+    const Type functionType = {
+        .sizeType = sizeof(RawFunction),
+        .alignType = static_cast<uint16_t>(alignof(RawFunction)),
+        .name = StringSlice("fn"),
+        .tag = Type::Tag::Function,
+        .extra = Type::ExtraInfo(),
+        .destructor = nullptr,
+        .builtinTraits = nullptr,
+        .constRef = nullptr,
+        .mutRef = nullptr,
+    };
+    constexpr uint16_t functionSlots = static_cast<uint16_t>((sizeof(RawFunction) + 7) / 8);
+
+    const Bytecode incrementBytecode[] = {
+        loadImmediate(ScalarTag::I32, 1, 1), setScalarType(ScalarTag::I32, 1),
+        setScalarType(ScalarTag::I32, 2), binaryScalarOp<operators::Add>(ScalarTag::I32, 2, 0, 1),
+        returnValue(2)};
+    TestScriptFunction increment(incrementBytecode, sizeof(incrementBytecode) / sizeof(Bytecode), 4,
+                                 Reflect<int32_t>::get());
+    const Type* incrementArgsTypes[1] = {Reflect<int32_t>::get()};
+    increment.function.argsTypes = incrementArgsTypes;
+    increment.function.argsLen = 1;
+
+    const Function<int32_t(int32_t)> negate(hostNegate);
+
+    operators::CallSrcWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallSrcWithReturn::OPCODE);
+    call.src = 0;
+    call.argCount = 1;
+    call.retDst = functionSlots + 1;
+    Bytecode cacheIndex;
+    cacheIndex.value = 0;
+    Bytecode argsSrcs;
+    argsSrcs.value = functionSlots;
+
+    // caller(fn) { return fn(41); }
+    const Bytecode callerBytecode[] = {loadImmediate(ScalarTag::I32, functionSlots, 41),
+                                       setScalarType(ScalarTag::I32, functionSlots),
+                                       Bytecode(call),
+                                       cacheIndex,
+                                       argsSrcs,
+                                       setScalarType(ScalarTag::I32, functionSlots + 1),
+                                       returnValue(functionSlots + 1)};
+    TestScriptFunction caller(callerBytecode, sizeof(callerBytecode) / sizeof(Bytecode),
+                              functionSlots + 2, Reflect<int32_t>::get());
+    const Type* callerArgsTypes[1] = {&functionType};
+    caller.function.argsTypes = callerArgsTypes;
+    caller.function.argsLen = 1;
+    CallSiteCache caches[1];
+    caller.info.callSiteCaches = caches;
+    caller.info.callSiteCachesLen = 1;
+
+    auto callWith = [&caller, &functionType](const RawFunction* function) -> int32_t {
+        RawFunction::CallArgs args = caller.function.startCall();
+        CHECK(args.push(const_cast<RawFunction*>(function), &functionType));
+        int32_t result = 0;
+        CHECK(args.call(&result));
+        return result;
+    };
+
+    ResolvedCall resolved{};
+    CHECK_FALSE(caches[0].lookup(&increment.function, resolved));
+    CHECK_EQ(callWith(&increment.function), 42);
+    REQUIRE(caches[0].lookup(&increment.function, resolved));
+    CHECK(resolved.isScript);
+    CHECK_EQ(resolved.frameLength, increment.info.stackSpaceRequired);
+    CHECK_EQ(resolved.frameAlign, increment.function.alignment);
+    CHECK_EQ(callWith(&increment.function), 42);
+
+    CHECK_EQ(callWith(reinterpret_cast<const RawFunction*>(&negate)), -41);
+    CHECK_FALSE(caches[0].lookup(&increment.function, resolved));
+    REQUIRE(caches[0].lookup(reinterpret_cast<const RawFunction*>(&negate), resolved));
+    CHECK_FALSE(resolved.isScript);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+}
+
+TEST_CASE("[interpreter] indirect calls with mismatched arguments fail") {
+    const Type functionType = {
+        .sizeType = sizeof(RawFunction),
+        .alignType = static_cast<uint16_t>(alignof(RawFunction)),
+        .name = StringSlice("fn"),
+        .tag = Type::Tag::Function,
+        .extra = Type::ExtraInfo(),
+        .destructor = nullptr,
+        .builtinTraits = nullptr,
+        .constRef = nullptr,
+        .mutRef = nullptr,
+    };
+    constexpr uint16_t functionSlots = static_cast<uint16_t>((sizeof(RawFunction) + 7) / 8);
+
+    const Bytecode identityBytecode[] = {returnValue(0)};
+    TestScriptFunction identity(identityBytecode, 1, 2, Reflect<int32_t>::get());
+    const Type* identityArgsTypes[1] = {Reflect<int32_t>::get()};
+    identity.function.argsTypes = identityArgsTypes;
+    identity.function.argsLen = 1;
+
+    const Function<int32_t(int32_t)> negate(hostNegate);
+
+    Bytecode noCache;
+    noCache.value = NO_CALL_SITE_CACHE;
+    Bytecode argsSrcs;
+    argsSrcs.value = functionSlots | (functionSlots << 16);
+
+    // caller(fn) { return fn(41, 41); }
+    operators::CallSrcWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallSrcWithReturn::OPCODE);
+    call.src = 0;
+    call.argCount = 2;
+    call.retDst = functionSlots + 1;
+    const Bytecode callBytecode[] = {loadI32(functionSlots, 41),
+                                     Bytecode(call),
+                                     noCache,
+                                     argsSrcs,
+                                     setScalarType(ScalarTag::I32, functionSlots + 1),
+                                     returnValue(functionSlots + 1)};
+    TestScriptFunction caller(callBytecode, sizeof(callBytecode) / sizeof(Bytecode),
+                              functionSlots + 2, Reflect<int32_t>::get());
+
+    // ignoringCaller(fn) { fn(41); return 0; }
+    operators::CallSrcNoReturn ignoringCall{};
+    ignoringCall.reserveOpcode = static_cast<uint64_t>(operators::CallSrcNoReturn::OPCODE);
+    ignoringCall.src = 0;
+    ignoringCall.argCount = 1;
+    const Bytecode ignoringBytecode[] = {loadI32(functionSlots, 41), Bytecode(ignoringCall),
+                                         noCache, argsSrcs, returnValue(functionSlots)};
+    TestScriptFunction ignoringCaller(ignoringBytecode,
+                                      sizeof(ignoringBytecode) / sizeof(Bytecode),
+                                      functionSlots + 2, Reflect<int32_t>::get());
+
+    // tailCaller(fn) { return fn(); }
+    operators::TailCallSrc tailCall{};
+    tailCall.reserveOpcode = static_cast<uint64_t>(operators::TailCallSrc::OPCODE);
+    tailCall.src = 0;
+    tailCall.argCount = 0;
+    const Bytecode tailCallBytecode[] = {Bytecode(tailCall), noCache};
+    TestScriptFunction tailCaller(tailCallBytecode, sizeof(tailCallBytecode) / sizeof(Bytecode),
+                                  functionSlots + 2, Reflect<int32_t>::get());
+
+    const Type* callerArgsTypes[1] = {&functionType};
+    for (TestScriptFunction* fn : {&caller, &ignoringCaller, &tailCaller}) {
+        fn->function.argsTypes = callerArgsTypes;
+        fn->function.argsLen = 1;
+    }
+
+    auto callWith = [&functionType](const TestScriptFunction& fn, const RawFunction* function) {
+        RawFunction::CallArgs args = fn.function.startCall();
+        CHECK(args.push(const_cast<RawFunction*>(function), &functionType));
+        int32_t result = 0;
+        auto res = args.call(&result);
+        REQUIRE(res.hasErr());
+        CHECK_EQ(res.takeErr().exceptional().value(), Exceptional::Signature);
+        CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+    };
+
+    callWith(caller, &identity.function);
+    callWith(caller, reinterpret_cast<const RawFunction*>(&negate));
+    callWith(ignoringCaller, &identity.function);
+    callWith(ignoringCaller, reinterpret_cast<const RawFunction*>(&negate));
+    callWith(tailCaller, &identity.function);
+    callWith(tailCaller, reinterpret_cast<const RawFunction*>(&negate));
+}
+
+TEST_CASE("[interpreter] scalar add") {
+    SUBCASE("i32") {
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 40),
+                                     loadImmediate(ScalarTag::I32, 1, 2),
+                                     setScalarType(ScalarTag::I32, 2),
+                                     binaryScalarOp<operators::Add>(ScalarTag::I32, 2, 0, 1),
+                                     returnValue(2)};
+        TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 4,
+                              Reflect<int32_t>::get());
+
+        int32_t result = 0;
+        CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+        CHECK_EQ(result, 42);
+    }
+    SUBCASE("i8 wraps") {
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::I8, 0, 127),
+                                     loadImmediate(ScalarTag::I8, 1, 1),
+                                     setScalarType(ScalarTag::I8, 0),
+                                     binaryScalarOp<operators::Add>(ScalarTag::I8, 0, 0, 1),
+                                     returnValue(0)};
+        TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                              Reflect<int8_t>::get());
+
+        int8_t result = 0;
+        CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+        CHECK_EQ(result, -128);
+    }
+    SUBCASE("f32") {
+        const float lhs = 1.5f;
+        const float rhs = 2.25f;
+        uint32_t lhsBits = 0;
+        uint32_t rhsBits = 0;
+        memcpy(&lhsBits, &lhs, sizeof(float));
+        memcpy(&rhsBits, &rhs, sizeof(float));
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::F32, 0, lhsBits),
+                                     loadImmediate(ScalarTag::F32, 1, rhsBits),
+                                     setScalarType(ScalarTag::F32, 1),
+                                     binaryScalarOp<operators::Add>(ScalarTag::F32, 1, 0, 1),
+                                     returnValue(1)};
+        TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                              Reflect<float>::get());
+
+        float result = 0;
+        CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+        CHECK_EQ(result, 3.75f);
+    }
+}
+
+TEST_CASE("[interpreter] scalar compare") {
+    auto compare = [](Bytecode op, uint32_t lhs, uint32_t rhs) -> bool {
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::U32, 0, lhs),
+                                     loadImmediate(ScalarTag::U32, 1, rhs),
+                                     setScalarType(ScalarTag::Bool, 2), op, returnValue(2)};
+        TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 4,
+                              Reflect<bool>::get());
+
+        bool result = false;
+        CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+        return result;
+    };
+
+    CHECK(compare(binaryScalarOp<operators::Equal>(ScalarTag::U32, 2, 0, 1), 5, 5));
+    CHECK_FALSE(compare(binaryScalarOp<operators::Equal>(ScalarTag::U32, 2, 0, 1), 5, 6));
+    CHECK(compare(binaryScalarOp<operators::NotEqual>(ScalarTag::U32, 2, 0, 1), 5, 6));
+    CHECK(compare(binaryScalarOp<operators::Less>(ScalarTag::U32, 2, 0, 1), 5, 6));
+    CHECK_FALSE(compare(binaryScalarOp<operators::Less>(ScalarTag::U32, 2, 0, 1), 6, 6));
+    CHECK(compare(binaryScalarOp<operators::LessEqual>(ScalarTag::U32, 2, 0, 1), 6, 6));
+    CHECK(compare(binaryScalarOp<operators::Greater>(ScalarTag::U32, 2, 0, 1), 7, 6));
+    CHECK_FALSE(compare(binaryScalarOp<operators::GreaterEqual>(ScalarTag::U32, 2, 0, 1), 5, 6));
+}
+
+TEST_CASE("[interpreter] scalar get and set member") {
+    operators::SetMember setMember{};
+    setMember.reserveOpcode = static_cast<uint64_t>(operators::SetMember::OPCODE);
+    setMember.isScalar = true;
+    setMember.scalarTag = static_cast<uint64_t>(ScalarTag::U16);
+    setMember.dst = 0;
+    setMember.src = 1;
+    setMember.memberOffset = 2;
+
+    operators::GetMember getMember{};
+    getMember.reserveOpcode = static_cast<uint64_t>(operators::GetMember::OPCODE);
+    getMember.isScalar = true;
+    getMember.scalarTag = static_cast<uint64_t>(ScalarTag::U16);
+    getMember.dst = 1;
+    getMember.src = 0;
+    getMember.memberOffset = 2;
+
+    operators::Move move{};
+    move.reserveOpcode = static_cast<uint64_t>(operators::Move::OPCODE);
+    move.isScalar = true;
+    move.dst = 2;
+    move.src = 1;
+
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::U32, 0, 0),
+                                 loadImmediate(ScalarTag::U16, 1, 513),
+                                 Bytecode(setMember),
+                                 loadImmediate(ScalarTag::U16, 1, 0),
+                                 Bytecode(getMember),
+                                 Bytecode(move),
+                                 setScalarType(ScalarTag::U16, 2),
+                                 returnValue(2)};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 4,
+                          Reflect<uint16_t>::get());
+
+    uint16_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 513);
+}
+
+TEST_CASE("[interpreter] fused loop matches unfused") {
+    operators::LoadDefault loadDefault{};
+    loadDefault.reserveOpcode = static_cast<uint64_t>(operators::LoadDefault::OPCODE);
+    loadDefault.isScalar = true;
+    loadDefault.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+    loadDefault.dst = 4;
+
+    operators::JumpIfFalse jumpIfFalse{};
+    jumpIfFalse.reserveOpcode = static_cast<uint64_t>(operators::JumpIfFalse::OPCODE);
+    jumpIfFalse.src = 2;
+    jumpIfFalse.amount = 4;
+
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = -4;
+
+    // sum = 0; for (i = 0; i < 10; i += 1) { sum += i; } return sum;
+    const Bytecode bytecode[] = {
+        loadImmediate(ScalarTag::I32, 0, 0),
+        setScalarType(ScalarTag::I32, 0),
+        loadImmediate(ScalarTag::I32, 1, 10),
+        setScalarType(ScalarTag::I32, 1),
+        loadImmediate(ScalarTag::I32, 3, 1),
+        setScalarType(ScalarTag::I32, 3),
+        Bytecode(loadDefault),
+        setScalarType(ScalarTag::I32, 4),
+        setScalarType(ScalarTag::Bool, 2),
+        binaryScalarOp<operators::Less>(ScalarTag::I32, 2, 0, 1), // loop header
+        Bytecode(jumpIfFalse),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 4, 4, 0),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 0, 0, 3),
+        Bytecode(jump),
+        returnValue(4),
+    };
+    constexpr size_t bytecodeCount = sizeof(bytecode) / sizeof(Bytecode);
+
+    FunctionBuilder builder(Allocator{});
+    CHECK(builder.pushBytecode(bytecode, bytecodeCount));
+    CHECK(builder.fuseSuperinstructions());
+    CHECK_LT(builder.bytecode.len(), bytecodeCount);
+
+    TestScriptFunction unfused(bytecode, bytecodeCount, 6, Reflect<int32_t>::get());
+    TestScriptFunction fused(builder.bytecode.data(), builder.bytecode.len(), 6,
+                             Reflect<int32_t>::get());
+
+    int32_t unfusedResult = 0;
+    int32_t fusedResult = 0;
+    CHECK(interpreterExecuteScriptFunction(&unfused.function, &unfusedResult));
+    CHECK(interpreterExecuteScriptFunction(&fused.function, &fusedResult));
+    CHECK_EQ(unfusedResult, 45);
+    CHECK_EQ(fusedResult, 45);
+}
+
+TEST_CASE("[interpreter] preemptible execution suspends on back edges and calls") {
+    operators::JumpIfFalse jumpIfFalse{};
+    jumpIfFalse.reserveOpcode = static_cast<uint64_t>(operators::JumpIfFalse::OPCODE);
+    jumpIfFalse.src = 2;
+    jumpIfFalse.amount = 4;
+
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = -4;
+
+    // sum = 0; for (i = 0; i < 10; i += 1) { sum += i; } return sum;
+    const Bytecode loopBytecode[] = {
+        loadImmediate(ScalarTag::I32, 0, 0),
+        setScalarType(ScalarTag::I32, 0),
+        loadImmediate(ScalarTag::I32, 1, 10),
+        setScalarType(ScalarTag::I32, 1),
+        loadImmediate(ScalarTag::I32, 3, 1),
+        setScalarType(ScalarTag::I32, 3),
+        loadImmediate(ScalarTag::I32, 4, 0),
+        setScalarType(ScalarTag::I32, 4),
+        setScalarType(ScalarTag::Bool, 2),
+        binaryScalarOp<operators::Less>(ScalarTag::I32, 2, 0, 1), // loop header
+        Bytecode(jumpIfFalse),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 4, 4, 0),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 0, 0, 3),
+        Bytecode(jump),
+        returnValue(4),
+    };
+    TestScriptFunction loop(loopBytecode, sizeof(loopBytecode) / sizeof(Bytecode), 6,
+                            Reflect<int32_t>::get());
+
+    SUBCASE("back edges") {
+        int32_t result = 0;
+        PreemptibleExecution execution =
+            PreemptibleExecution::start(&loop.function, nullptr, &result).takeValue();
+        CHECK(execution.isSuspended());
+
+        // 10 back edges with a budget of 3 each
+        size_t suspensions = 0;
+        while (true) {
+            auto res = execution.resume(3);
+            REQUIRE(res);
+            if (res.value() == ExecutionStatus::Finished) {
+                break;
+            }
+            suspensions += 1;
+            CHECK_EQ(execution.depth(), 1);
+        }
+        CHECK_EQ(suspensions, 3);
+        CHECK_FALSE(execution.isSuspended());
+        CHECK_EQ(result, 45);
+        CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+    }
+    SUBCASE("calls") {
+        operators::CallImmediateWithReturn call{};
+        call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+        call.argCount = 0;
+        call.retDst = 1;
+        Bytecode loopPtr;
+        loopPtr.value = reinterpret_cast<uint64_t>(&loop.function);
+
+        const Bytecode callerBytecode[] = {Bytecode(call), loopPtr,
+                                           setScalarType(ScalarTag::I32, 1), returnValue(1)};
+        TestScriptFunction caller(callerBytecode, 4, 2, Reflect<int32_t>::get());
+
+        int32_t result = 0;
+        PreemptibleExecution execution =
+            PreemptibleExecution::start(&caller.function, nullptr, &result).takeValue();
+        auto res = execution.resume(1);
+        REQUIRE(res);
+        CHECK_EQ(res.value(), ExecutionStatus::Suspended);
+        CHECK_EQ(execution.depth(), 2);
+
+        // Unrelated calls can be made while suspended.
+        int32_t unrelated = 0;
+        CHECK(interpreterExecuteScriptFunction(&loop.function, &unrelated));
+        CHECK_EQ(unrelated, 45);
+
+        res = execution.resume(UINT64_MAX);
+        REQUIRE(res);
+        CHECK_EQ(res.value(), ExecutionStatus::Finished);
+        CHECK_EQ(result, 45);
+    }
+}
+
+TEST_CASE("[interpreter] preemptible executions interleave on their own stacks") {
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = 0;
+
+    // while (true) {}
+    const Bytecode spinBytecode[] = {Bytecode(jump), returnValue(0)};
+    TestScriptFunction spin(spinBytecode, 2, 2, Reflect<int32_t>::get());
+    const Bytecode sevenBytecode[] = {loadI32(0, 7), returnValue(0)};
+    TestScriptFunction seven(sevenBytecode, 2, 2, Reflect<int32_t>::get());
+
+    int32_t spinResult = 0;
+    int32_t sevenResult = 0;
+    PreemptibleExecution first =
+        PreemptibleExecution::start(&spin.function, nullptr, &spinResult).takeValue();
+    CHECK_EQ(first.resume(1).value(), ExecutionStatus::Suspended);
+
+    // Started after, but finished before the first execution, which is still suspended.
+    PreemptibleExecution second =
+        PreemptibleExecution::start(&seven.function, nullptr, &sevenResult).takeValue();
+    CHECK_EQ(first.resume(1).value(), ExecutionStatus::Suspended);
+    CHECK_EQ(second.resume(1).value(), ExecutionStatus::Finished);
+    CHECK_EQ(sevenResult, 7);
+
+    CHECK_EQ(first.resume(1).value(), ExecutionStatus::Suspended);
+    CHECK_EQ(first.depth(), 1);
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+}
+
+TEST_CASE("[interpreter] cancelled preemptible execution unwinds its frames") {
+    operators::Jump jump{};
+    jump.reserveOpcode = static_cast<uint64_t>(operators::Jump::OPCODE);
+    jump.amount = 0;
+
+    // while (true) {}
+    const Bytecode bytecode[] = {Bytecode(jump), returnValue(0)};
+    TestScriptFunction spin(bytecode, 2, 2, Reflect<int32_t>::get());
+
+    int32_t result = 0;
+    {
+        PreemptibleExecution execution =
+            PreemptibleExecution::start(&spin.function, nullptr, &result).takeValue();
+        for (int i = 0; i < 3; i++) {
+            auto res = execution.resume(1000);
+            REQUIRE(res);
+            CHECK_EQ(res.value(), ExecutionStatus::Suspended);
+        }
+        CHECK_EQ(execution.depth(), 1);
+        execution.cancel();
+        CHECK_FALSE(execution.isSuspended());
+        CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+    }
+    {
+        // Dropping a suspended execution cancels it.
+        PreemptibleExecution execution =
+            PreemptibleExecution::start(&spin.function, nullptr, &result).takeValue();
+        CHECK_EQ(execution.resume(1).value(), ExecutionStatus::Suspended);
+    }
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+}
+
+#if SY_INTERPRETER_PROFILER
+TEST_CASE("[interpreter] profiles nested calls") {
+    ProgramProfile program;
+    program.enabled.store(true);
+
+    const Bytecode calleeBytecode[] = {loadImmediate(ScalarTag::I32, 0, 7),
+                                       setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    TestScriptFunction callee(calleeBytecode, 3, 2, Reflect<int32_t>::get());
+    FunctionProfile calleeProfile;
+    REQUIRE(calleeProfile.init(Allocator{}, &program, &callee.info));
+    callee.info.profile = &calleeProfile;
+
+    operators::CallImmediateWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+    call.argCount = 0;
+    call.retDst = 1;
+    Bytecode calleePtr;
+    calleePtr.value = reinterpret_cast<uint64_t>(&callee.function);
+
+    const Bytecode callerBytecode[] = {Bytecode(call), calleePtr, setScalarType(ScalarTag::I32, 1),
+                                       returnValue(1)};
+    TestScriptFunction caller(callerBytecode, 4, 2, Reflect<int32_t>::get());
+    FunctionProfile callerProfile;
+    REQUIRE(callerProfile.init(Allocator{}, &program, &caller.info));
+    caller.info.profile = &callerProfile;
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&caller.function, &result));
+    CHECK(interpreterExecuteScriptFunction(&caller.function, &result));
+    CHECK_EQ(result, 7);
+
+    const ProfiledFunction callerStats = callerProfile.snapshot();
+    CHECK_EQ(callerStats.calls, 2);
+    CHECK_EQ(callerStats.exclusiveInstructions, 6);
+    CHECK_EQ(callerStats.inclusiveInstructions, 12);
+
+    const ProfiledFunction calleeStats = calleeProfile.snapshot();
+    CHECK_EQ(calleeStats.calls, 2);
+    CHECK_EQ(calleeStats.exclusiveInstructions, 6);
+    CHECK_EQ(calleeStats.inclusiveInstructions, 6);
+
+    ProfiledCallSite site;
+    REQUIRE_EQ(callerProfile.callSites(&site, 1), 1);
+    CHECK_EQ(site.bytecodeOffset, 0);
+    CHECK_EQ(site.calls, 2);
+
+    CHECK_EQ(program.opcodeCounts[static_cast<size_t>(OpCode::CallImmediateWithReturn)].load(), 2);
+    CHECK_EQ(program.opcodeCounts[static_cast<size_t>(OpCode::SetType)].load(), 4);
+    CHECK_EQ(program.opcodeCounts[static_cast<size_t>(OpCode::ReturnValue)].load(), 4);
+}
+#endif // SY_INTERPRETER_PROFILER
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -7,10 +7,77 @@
 
 namespace sy {
 class RawFunction;
+class Stack;
 
 /// Begins execution of a function. Does not handle pushing the arguments of the function.
 /// The return of the call will be stored in `outReturnValue`, provided the function does return a value.
 Result<void, AnyError> interpreterExecuteScriptFunction(const RawFunction* scriptFunction, void* outReturnValue);
+
+enum class ExecutionStatus {
+    /// The function has returned.
+    Finished,
+    /// The budget ran out before the function returned.
+    Suspended,
+    /// The function executed a `Yield` operation.
+    Yielded,
+};
+
+/// Execution of a script function that runs for a limited budget at a time, so hosts can time slice
+/// long running scripts without stopping the thread. The budget counts preemption points, being
+/// backward jumps and calls to script functions, which are the only ways for bytecode to run again,
+/// so any budget bounds how long a single `resume(...)` can take. Scripts can also suspend
+/// execution themselves with the `Yield` operation.
+///
+/// Each execution runs on a `Stack` of its own, which is only active while it's resumed, so any
+/// number of executions can be suspended at once, and other functions may be called in the
+/// meantime. Script functions run by the execution are always interpreted, rather
+/// than running as native code, but scripts called by C functions run to completion.
+class PreemptibleExecution final {
+  public:
+    PreemptibleExecution() = default;
+
+    /// Cancels the execution if it's suspended, and frees its stack.
+    ~PreemptibleExecution() noexcept;
+
+    PreemptibleExecution(PreemptibleExecution&& other) noexcept;
+
+    PreemptibleExecution& operator=(PreemptibleExecution&& other) noexcept;
+
+    PreemptibleExecution(const PreemptibleExecution& other) = delete;
+
+    PreemptibleExecution& operator=(const PreemptibleExecution& other) = delete;
+
+    /// Creates an execution with a new stack, starting a call of `scriptFunction` on it without
+    /// executing any of it. The arguments are moved from `args`, which must have the types of the
+    /// function's arguments, in order, and are destroyed if the execution fails to start. The
+    /// return value is stored in `outReturnValue` once the execution finishes, so must remain
+    /// valid until then. Same return value requirements as `interpreterExecuteScriptFunction(...)`.
+    [[nodiscard]] static Result<PreemptibleExecution, AnyError>
+    start(const RawFunction* scriptFunction, void* const* args, void* outReturnValue) noexcept;
+
+    /// Continues execution until the function returns or yields, or `budget` preemption points have
+    /// passed. The execution's stack is active for the duration. If an error occurs, all of the
+    /// execution's frames are unwound, finishing it.
+    /// # Debug Asserts
+    /// The execution must be suspended and not already running, and `budget` must be non-zero.
+    Result<ExecutionStatus, AnyError> resume(uint64_t budget) noexcept;
+
+    /// Unwinds all of the execution's frames without finishing the function, if it's suspended.
+    void cancel() noexcept;
+
+    [[nodiscard]] bool isSuspended() const noexcept { return this->depth_ > 0; }
+
+    /// @return The amount of script frames the execution currently has on its stack.
+    [[nodiscard]] size_t depth() const noexcept { return this->depth_; }
+
+  private:
+    void destroy() noexcept;
+
+    /// Owned by the execution.
+    Stack* stack_ = nullptr;
+    size_t depth_ = 0;
+    bool running_ = false;
+};
 } // namespace sy
 
-#endif // SY_INTERPRETER_INTERPRETER_HPP_
\ No newline at end of file
+#endif // SY_INTERPRETER_INTERPRETER_HPP_
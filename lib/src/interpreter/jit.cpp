@@ -0,0 +1,740 @@
+#include "jit.hpp"
+#include "../core/core_internal.h"
+#include "../program/program_internal.hpp"
+#include "../types/array/dynamic_array.hpp"
+#include "../types/type_info.hpp"
+#include "bytecode.hpp"
+#include <cstring>
+
+using namespace sy;
+
+#if SY_JIT_SUPPORTED
+
+namespace {
+constexpr uint8_t REX_W = 0x48;
+constexpr uint8_t REG_RAX = 0;
+/// Used as an opcode extension within ModRM for `cmp r/m8, imm8`.
+constexpr uint8_t REG_CMP_EXT = 7;
+
+/// Condition codes, as the low nibble of `jcc` and `setcc` opcodes. Inverting a condition is
+/// flipping the lowest bit.
+enum Cond : uint8_t {
+    CondB = 0x2,
+    CondAE = 0x3,
+    CondE = 0x4,
+    CondNE = 0x5,
+    CondBE = 0x6,
+    CondA = 0x7,
+    CondL = 0xC,
+    CondGE = 0xD,
+    CondLE = 0xE,
+    CondG = 0xF,
+};
+
+struct JumpFixup {
+    /// Position of the rel32 displacement within the native code.
+    size_t rel32Pos;
+    /// Bytecode position that is jumped to.
+    size_t target;
+};
+
+/// Appends machine code. Under the System V ABI, the generated entry receives the frame values in
+/// `rdi`, and the frame types in `rsi`. The bytecode in `rdx` is unused, as exits embed the
+/// absolute instruction pointer. All operands are addressed as `[rdi + disp32]` or
+/// `[rsi + disp32]`, and `rax` / `xmm0` are the only scratch registers used.
+class Emitter {
+  public:
+    DynArray<uint8_t> code;
+    DynArray<JumpFixup> fixups;
+    bool outOfMemory = false;
+
+    Emitter(Allocator alloc) : code(alloc), fixups(alloc) {}
+
+    size_t len() const { return this->code.len(); }
+
+    void u8(uint8_t b) {
+        if (this->code.push(b).hasErr()) {
+            this->outOfMemory = true;
+        }
+    }
+
+    void u16(uint16_t v) {
+        for (int i = 0; i < 2; i++) {
+            this->u8(static_cast<uint8_t>(v >> (i * 8)));
+        }
+    }
+
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            this->u8(static_cast<uint8_t>(v >> (i * 8)));
+        }
+    }
+
+    void u64(uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            this->u8(static_cast<uint8_t>(v >> (i * 8)));
+        }
+    }
+
+    /// ModRM + disp32 for `[rdi + disp]`.
+    void valuesOperand(uint8_t reg, uint32_t disp) {
+        this->u8(static_cast<uint8_t>(0x80 | (reg << 3) | 0x7));
+        this->u32(disp);
+    }
+
+    /// ModRM + disp32 for `[rsi + disp]`.
+    void typesOperand(uint8_t reg, uint32_t disp) {
+        this->u8(static_cast<uint8_t>(0x80 | (reg << 3) | 0x6));
+        this->u32(disp);
+    }
+
+    /// `mov` of `size` bytes between `[rdi + disp]` and `rax`.
+    void movRaxValues(uint32_t disp, size_t size, bool store) {
+        if (size == 2) {
+            this->u8(0x66);
+        } else if (size == 8) {
+            this->u8(REX_W);
+        }
+        if (size == 1) {
+            this->u8(store ? 0x88 : 0x8A);
+        } else {
+            this->u8(store ? 0x89 : 0x8B);
+        }
+        this->valuesOperand(REG_RAX, disp);
+    }
+
+    /// `mov` of an immediate of `size` bytes to `[rdi + disp]`. For 8 bytes, `imm` is sign
+    /// extended.
+    void movImmValues(uint32_t disp, size_t size, uint32_t imm) {
+        switch (size) {
+        case 1:
+            this->u8(0xC6);
+            this->valuesOperand(0, disp);
+            this->u8(static_cast<uint8_t>(imm));
+            break;
+        case 2:
+            this->u8(0x66);
+            this->u8(0xC7);
+            this->valuesOperand(0, disp);
+            this->u16(static_cast<uint16_t>(imm));
+            break;
+        case 4:
+            this->u8(0xC7);
+            this->valuesOperand(0, disp);
+            this->u32(imm);
+            break;
+        default:
+            this->u8(REX_W);
+            this->u8(0xC7);
+            this->valuesOperand(0, disp);
+            this->u32(imm);
+            break;
+        }
+    }
+
+    /// `mov rax, imm64`
+    void movRaxImm64(uint64_t imm) {
+        this->u8(REX_W);
+        this->u8(0xB8);
+        this->u64(imm);
+    }
+
+    /// Writes the raw type info `mask` to `[rsi + disp]`.
+    void storeType(uint32_t disp, uint64_t mask) {
+        if (mask == 0) {
+            this->u8(REX_W);
+            this->u8(0xC7);
+            this->typesOperand(0, disp);
+            this->u32(0);
+            return;
+        }
+        this->movRaxImm64(mask);
+        this->u8(REX_W);
+        this->u8(0x89);
+        this->typesOperand(REG_RAX, disp);
+    }
+
+    /// Returns `ip` to the interpreter.
+    void exit(const Bytecode* ip) {
+        this->movRaxImm64(reinterpret_cast<uint64_t>(ip));
+        this->u8(0xC3); // ret
+    }
+
+    void jmp(size_t target) {
+        this->u8(0xE9);
+        this->rel32(target);
+    }
+
+    void jcc(Cond cond, size_t target) {
+        this->u8(0x0F);
+        this->u8(static_cast<uint8_t>(0x80 | cond));
+        this->rel32(target);
+    }
+
+    void setcc(Cond cond, uint32_t disp) {
+        this->u8(0x0F);
+        this->u8(static_cast<uint8_t>(0x90 | cond));
+        this->valuesOperand(0, disp);
+    }
+
+  private:
+    void rel32(size_t target) {
+        if (this->fixups.push(JumpFixup{this->len(), target}).hasErr()) {
+            this->outOfMemory = true;
+        }
+        this->u32(0);
+    }
+};
+
+/// Integer scalars with compare and add templates, which occupy 4 or 8 bytes.
+bool integerInfo(ScalarTag tag, bool& outWide, bool& outSigned) {
+    switch (tag) {
+    case ScalarTag::I32:
+        outWide = false;
+        outSigned = true;
+        return true;
+    case ScalarTag::U32:
+        outWide = false;
+        outSigned = false;
+        return true;
+    case ScalarTag::I64:
+        outWide = true;
+        outSigned = true;
+        return true;
+    case ScalarTag::U64:
+    case ScalarTag::USize:
+        outWide = true;
+        outSigned = false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// `compareOp` is the offset of the comparison `OpCode` from `OpCode::Equal`.
+Cond compareCond(uint8_t compareOp, bool isSigned) {
+    switch (static_cast<OpCode>(static_cast<uint8_t>(OpCode::Equal) + compareOp)) {
+    case OpCode::Equal:
+        return CondE;
+    case OpCode::NotEqual:
+        return CondNE;
+    case OpCode::Less:
+        return isSigned ? CondL : CondB;
+    case OpCode::LessEqual:
+        return isSigned ? CondLE : CondBE;
+    case OpCode::Greater:
+        return isSigned ? CondG : CondA;
+    default:
+        return isSigned ? CondGE : CondAE;
+    }
+}
+
+uint64_t scalarTypeMask(ScalarTag tag) {
+    const Node::TypeOfValue typeOfValue(scalarTypeFromTag(tag), true);
+    uint64_t mask = 0;
+    static_assert(sizeof(Node::TypeOfValue) == sizeof(uint64_t));
+    memcpy(&mask, &typeOfValue, sizeof(uint64_t));
+    return mask;
+}
+
+/// Translates a single operation. Each template checks it can handle the operands before emitting
+/// anything, returning `false` if it cannot, in which case the caller emits an exit instead.
+class Translator {
+  public:
+    Translator(Emitter& e, const Bytecode* bytecode, size_t bytecodeCount, uint16_t frameLength)
+        : e_(e), bytecode_(bytecode), bytecodeCount_(bytecodeCount), frameLength_(frameLength) {}
+
+    bool translate(size_t pos) {
+        const Bytecode* ip = &this->bytecode_[pos];
+        switch (ip->getOpcode()) {
+        case OpCode::Noop:
+            return true;
+        case OpCode::LoadDefault: {
+            const auto operands = ip->toOperands<operators::LoadDefault>();
+            if (!operands.isScalar || !this->inFrame(operands.dst)) {
+                return false;
+            }
+            const ScalarTag tag = static_cast<ScalarTag>(operands.scalarTag);
+            this->e_.movImmValues(slot(operands.dst), scalarTypeFromTag(tag)->sizeType, 0);
+            return true;
+        }
+        case OpCode::LoadImmediateScalar: {
+            const auto operands = ip->toOperands<operators::LoadImmediateScalar>();
+            return this->loadImmediate(ip, static_cast<ScalarTag>(operands.scalarTag),
+                                       operands.dst, static_cast<uint32_t>(operands.immediate));
+        }
+        case OpCode::SetType: {
+            const auto operands = ip->toOperands<operators::SetType>();
+            if (!operands.isScalar || !this->inFrame(operands.dst)) {
+                return false;
+            }
+            this->e_.storeType(slot(operands.dst),
+                               scalarTypeMask(static_cast<ScalarTag>(operands.scalarTag)));
+            return true;
+        }
+        case OpCode::SetNullType: {
+            const auto operands = ip->toOperands<operators::SetNullType>();
+            if (!this->inFrame(operands.dst)) {
+                return false;
+            }
+            this->e_.storeType(slot(operands.dst), 0);
+            return true;
+        }
+        case OpCode::Jump: {
+            const auto operands = ip->toOperands<operators::Jump>();
+            size_t target = 0;
+            if (!this->jumpTarget(pos, operands.amount, target)) {
+                return false;
+            }
+            this->e_.jmp(target);
+            return true;
+        }
+        case OpCode::JumpIfFalse: {
+            const auto operands = ip->toOperands<operators::JumpIfFalse>();
+            size_t target = 0;
+            if (!this->inFrame(operands.src) || !this->jumpTarget(pos, operands.amount, target)) {
+                return false;
+            }
+            // cmp byte [src], 0
+            this->e_.u8(0x80);
+            this->e_.valuesOperand(REG_CMP_EXT, slot(operands.src));
+            this->e_.u8(0);
+            this->e_.jcc(CondE, target);
+            return true;
+        }
+        case OpCode::Move: {
+            const auto operands = ip->toOperands<operators::Move>();
+            return operands.isScalar && this->copySlot(operands.dst, operands.src);
+        }
+        case OpCode::Clone: {
+            const auto operands = ip->toOperands<operators::Clone>();
+            return operands.isScalar && this->copySlot(operands.dst, operands.src);
+        }
+        case OpCode::GetMember: {
+            const auto operands = ip->toOperands<operators::GetMember>();
+            if (!operands.isScalar) {
+                return false;
+            }
+            const size_t size =
+                scalarTypeFromTag(static_cast<ScalarTag>(operands.scalarTag))->sizeType;
+            const uint32_t memberDisp = slot(operands.src) + operands.memberOffset;
+            if (!this->inFrame(operands.dst) || !this->inFrameBytes(memberDisp, size)) {
+                return false;
+            }
+            this->e_.movRaxValues(memberDisp, size, false);
+            this->e_.movRaxValues(slot(operands.dst), size, true);
+            return true;
+        }
+        case OpCode::SetMember: {
+            const auto operands = ip->toOperands<operators::SetMember>();
+            if (!operands.isScalar) {
+                return false;
+            }
+            const size_t size =
+                scalarTypeFromTag(static_cast<ScalarTag>(operands.scalarTag))->sizeType;
+            const uint32_t memberDisp = slot(operands.dst) + operands.memberOffset;
+            if (!this->inFrame(operands.src) || !this->inFrameBytes(memberDisp, size)) {
+                return false;
+            }
+            this->e_.movRaxValues(slot(operands.src), size, false);
+            this->e_.movRaxValues(memberDisp, size, true);
+            return true;
+        }
+        case OpCode::Equal:
+            return this->compare<operators::Equal>(ip);
+        case OpCode::NotEqual:
+            return this->compare<operators::NotEqual>(ip);
+        case OpCode::Less:
+            return this->compare<operators::Less>(ip);
+        case OpCode::LessEqual:
+            return this->compare<operators::LessEqual>(ip);
+        case OpCode::Greater:
+            return this->compare<operators::Greater>(ip);
+        case OpCode::GreaterEqual:
+            return this->compare<operators::GreaterEqual>(ip);
+        case OpCode::Add:
+            return this->add(ip->toOperands<operators::Add>());
+        case OpCode::CompareJumpIfFalse: {
+            const auto operands = ip->toOperands<operators::CompareJumpIfFalse>();
+            size_t target = 0;
+            if (!this->jumpTarget(pos, static_cast<int64_t>(ip[1].value), target)) {
+                return false;
+            }
+            Cond cond;
+            if (!this->compareToDst(static_cast<ScalarTag>(operands.scalarTag),
+                                    static_cast<uint8_t>(operands.compareOp), operands.dst,
+                                    operands.lhs, operands.rhs, cond)) {
+                return false;
+            }
+            this->e_.jcc(static_cast<Cond>(cond ^ 1), target);
+            return true;
+        }
+        case OpCode::LoadImmediateScalarSetType: {
+            const auto operands = ip->toOperands<operators::LoadImmediateScalarSetType>();
+            const ScalarTag tag = static_cast<ScalarTag>(operands.scalarTag);
+            if (!this->loadImmediate(ip, tag, operands.dst,
+                                     static_cast<uint32_t>(operands.immediate))) {
+                return false;
+            }
+            this->e_.storeType(slot(operands.dst), scalarTypeMask(tag));
+            return true;
+        }
+        case OpCode::LoadDefaultSetType: {
+            const auto operands = ip->toOperands<operators::LoadDefaultSetType>();
+            if (!this->inFrame(operands.dst)) {
+                return false;
+            }
+            const ScalarTag tag = static_cast<ScalarTag>(operands.scalarTag);
+            this->e_.movImmValues(slot(operands.dst), scalarTypeFromTag(tag)->sizeType, 0);
+            this->e_.storeType(slot(operands.dst), scalarTypeMask(tag));
+            return true;
+        }
+        default:
+            // Calls, returns, destructors, and non scalar operations go through the interpreter.
+            return false;
+        }
+    }
+
+  private:
+    Emitter& e_;
+    const Bytecode* bytecode_;
+    size_t bytecodeCount_;
+    uint16_t frameLength_;
+
+    static uint32_t slot(uint64_t s) { return static_cast<uint32_t>(s * sizeof(uint64_t)); }
+
+    bool inFrame(uint64_t s) const { return s < this->frameLength_; }
+
+    bool inFrameBytes(uint64_t disp, size_t size) const {
+        return (disp + size) <= (static_cast<uint64_t>(this->frameLength_) * sizeof(uint64_t));
+    }
+
+    bool jumpTarget(size_t pos, int64_t amount, size_t& outTarget) const {
+        const int64_t target = static_cast<int64_t>(pos) + amount;
+        if (target < 0 || static_cast<size_t>(target) >= this->bytecodeCount_) {
+            return false;
+        }
+        outTarget = static_cast<size_t>(target);
+        return true;
+    }
+
+    bool copySlot(uint64_t dst, uint64_t src) {
+        if (!this->inFrame(dst) || !this->inFrame(src)) {
+            return false;
+        }
+        this->e_.movRaxValues(slot(src), 8, false);
+        this->e_.movRaxValues(slot(dst), 8, true);
+        return true;
+    }
+
+    bool loadImmediate(const Bytecode* ip, ScalarTag tag, uint64_t dst, uint32_t immediate) {
+        if (!this->inFrame(dst)) {
+            return false;
+        }
+        const size_t size = scalarTypeFromTag(tag)->sizeType;
+        if (size <= 4) {
+            // Same as the interpreter, which always writes the full 32 bit immediate.
+            this->e_.movImmValues(slot(dst), 4, immediate);
+        } else {
+            this->e_.movRaxImm64(ip[1].value);
+            this->e_.movRaxValues(slot(dst), 8, true);
+        }
+        return true;
+    }
+
+    /// Emits `cmp lhs, rhs` and a `setcc` into `dst`, leaving the flags for a following `jcc`.
+    bool compareToDst(ScalarTag tag, uint8_t compareOp, uint64_t dst, uint64_t lhs, uint64_t rhs,
+                      Cond& outCond) {
+        bool wide = false;
+        bool isSigned = false;
+        if (!integerInfo(tag, wide, isSigned) || !this->inFrame(dst) || !this->inFrame(lhs) ||
+            !this->inFrame(rhs)) {
+            return false;
+        }
+        outCond = compareCond(compareOp, isSigned);
+        this->e_.movRaxValues(slot(lhs), wide ? 8 : 4, false);
+        if (wide) {
+            this->e_.u8(REX_W);
+        }
+        this->e_.u8(0x3B); // cmp rax, [rhs]
+        this->e_.valuesOperand(REG_RAX, slot(rhs));
+        this->e_.setcc(outCond, slot(dst));
+        return true;
+    }
+
+    template <typename OperandsT> bool compare(const Bytecode* ip) {
+        const OperandsT operands = ip->toOperands<OperandsT>();
+        if (!operands.isScalar) {
+            return false;
+        }
+        Cond cond;
+        return this->compareToDst(
+            static_cast<ScalarTag>(operands.scalarTag),
+            static_cast<uint8_t>(static_cast<uint8_t>(OperandsT::OPCODE) -
+                                 static_cast<uint8_t>(OpCode::Equal)),
+            operands.dst, operands.lhs, operands.rhs, cond);
+    }
+
+    bool add(const operators::Add operands) {
+        if (!operands.isScalar || !this->inFrame(operands.dst) || !this->inFrame(operands.lhs) ||
+            !this->inFrame(operands.rhs)) {
+            return false;
+        }
+        const ScalarTag tag = static_cast<ScalarTag>(operands.scalarTag);
+        if (tag == ScalarTag::F32 || tag == ScalarTag::F64) {
+            const uint8_t prefix = tag == ScalarTag::F64 ? 0xF2 : 0xF3;
+            const uint8_t ops[3] = {0x10, 0x58, 0x11}; // movs, adds, movs store
+            const uint64_t slots[3] = {operands.lhs, operands.rhs, operands.dst};
+            for (int i = 0; i < 3; i++) {
+                this->e_.u8(prefix);
+                this->e_.u8(0x0F);
+                this->e_.u8(ops[i]);
+                this->e_.valuesOperand(0, slot(slots[i]));
+            }
+            return true;
+        }
+
+        bool wide = false;
+        bool isSigned = false;
+        if (!integerInfo(tag, wide, isSigned)) {
+            return false;
+        }
+        // Native addition wraps, same as the interpreter.
+        this->e_.movRaxValues(slot(operands.lhs), wide ? 8 : 4, false);
+        if (wide) {
+            this->e_.u8(REX_W);
+        }
+        this->e_.u8(0x03); // add rax, [rhs]
+        this->e_.valuesOperand(REG_RAX, slot(operands.rhs));
+        this->e_.movRaxValues(slot(operands.dst), wide ? 8 : 4, true);
+        return true;
+    }
+};
+
+/// Generates native code for the whole function into executable pages.
+bool translateFunction(const InterpreterFunctionScriptInfo* scriptInfo, void*& outCode,
+                       size_t& outCodeLen) {
+    const Bytecode* bytecode = scriptInfo->bytecode;
+    const size_t bytecodeCount = scriptInfo->bytecodeCount;
+
+    Emitter e{Allocator{}};
+    DynArray<size_t> nativeOffsets{Allocator{}};
+    if (nativeOffsets.reserve(bytecodeCount).hasErr()) {
+        return false;
+    }
+    for (size_t i = 0; i < bytecodeCount; i++) {
+        (void)nativeOffsets.push(0);
+    }
+
+    Translator translator(e, bytecode, bytecodeCount, scriptInfo->stackSpaceRequired);
+    size_t pos = 0;
+    while (pos < bytecodeCount) {
+        nativeOffsets[pos] = e.len();
+        if (!translator.translate(pos)) {
+            e.exit(&bytecode[pos]);
+        }
+        pos += bytecode[pos].bytecodeUsed();
+    }
+    // Malformed bytecode running off the end is handed back to the interpreter.
+    e.exit(&bytecode[bytecodeCount]);
+
+    if (e.outOfMemory) {
+        return false;
+    }
+
+    for (size_t i = 0; i < e.fixups.len(); i++) {
+        const JumpFixup& fixup = e.fixups[i];
+        const int64_t rel = static_cast<int64_t>(nativeOffsets[fixup.target]) -
+                            static_cast<int64_t>(fixup.rel32Pos + sizeof(uint32_t));
+        const uint32_t rel32 = static_cast<uint32_t>(static_cast<int32_t>(rel));
+        for (size_t b = 0; b < sizeof(uint32_t); b++) {
+            e.code[fixup.rel32Pos + b] = static_cast<uint8_t>(rel32 >> (b * 8));
+        }
+    }
+
+    const size_t pageSize = sy_page_size();
+    const size_t codeLen = ((e.len() + pageSize - 1) / pageSize) * pageSize;
+    void* code = sy_page_malloc(codeLen);
+    if (code == nullptr) {
+        return false;
+    }
+    memcpy(code, e.code.data(), e.len());
+    sy_make_pages_executable(code, codeLen);
+
+    outCode = code;
+    outCodeLen = codeLen;
+    return true;
+}
+} // namespace
+
+#endif // SY_JIT_SUPPORTED
+
+sy::JitFunctionState::~JitFunctionState() noexcept {
+#if SY_JIT_SUPPORTED
+    if (this->code_ != nullptr) {
+        sy_page_free(this->code_, this->codeLen_);
+    }
+#endif
+}
+
+JitEntryFn sy::JitFunctionState::onCall(const InterpreterFunctionScriptInfo* scriptInfo) noexcept {
+    if (JitEntryFn entry = this->entry(); entry != nullptr) {
+        return entry;
+    }
+#if SY_JIT_SUPPORTED
+    if (this->status_.load(std::memory_order_relaxed) != Status::NotCompiled) {
+        return nullptr;
+    }
+
+    const uint32_t calls = this->callCount_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (calls < SYNC_JIT_CALL_THRESHOLD) {
+        return nullptr;
+    }
+    (void)this->compile(scriptInfo);
+    return this->entry();
+#else
+    (void)scriptInfo;
+    return nullptr;
+#endif
+}
+
+bool sy::JitFunctionState::compile(const InterpreterFunctionScriptInfo* scriptInfo) noexcept {
+#if SY_JIT_SUPPORTED
+    Status expected = Status::NotCompiled;
+    if (!this->status_.compare_exchange_strong(expected, Status::Compiling,
+                                               std::memory_order_acq_rel)) {
+        return expected == Status::Compiled;
+    }
+
+    void* code = nullptr;
+    size_t codeLen = 0;
+    if (!translateFunction(scriptInfo, code, codeLen)) {
+        this->status_.store(Status::Failed, std::memory_order_release);
+        return false;
+    }
+
+    this->code_ = code;
+    this->codeLen_ = codeLen;
+    JitEntryFn entry = nullptr;
+    static_assert(sizeof(JitEntryFn) == sizeof(void*));
+    memcpy(&entry, &code, sizeof(void*));
+    this->entry_.store(entry, std::memory_order_release);
+    this->status_.store(Status::Compiled, std::memory_order_release);
+    return true;
+#else
+    (void)scriptInfo;
+    return false;
+#endif
+}
+
+bool sy::JitFunctionState::usePrecompiled(JitEntryFn entry) noexcept {
+    sy_assert(entry != nullptr, "Expected non-null native entry");
+    Status expected = Status::NotCompiled;
+    if (!this->status_.compare_exchange_strong(expected, Status::Compiling,
+                                               std::memory_order_acq_rel)) {
+        return false;
+    }
+    // `code_` stays null, as the code belongs to the host binary.
+    this->entry_.store(entry, std::memory_order_release);
+    this->status_.store(Status::Compiled, std::memory_order_release);
+    return true;
+}
+
+#if SYNC_LIB_WITH_TESTS && SY_JIT_SUPPORTED
+
+#include "../doctest.h"
+#include "../testing/script_function.hpp"
+#include "interpreter.hpp"
+
+using namespace sy::testing;
+
+TEST_CASE("[JitFunctionState] loop runs natively") {
+    auto jumpIfFalse = makeOperands<operators::JumpIfFalse>();
+    jumpIfFalse.src = 2;
+    jumpIfFalse.amount = 4;
+    auto jump = makeOperands<operators::Jump>();
+    jump.amount = -4;
+
+    // sum = 0; for (i = -5; i < 10; i += 1) { sum += i; } return sum;
+    const Bytecode bytecode[] = {
+        loadImmediate(ScalarTag::I32, 0, static_cast<uint32_t>(-5)),
+        loadImmediate(ScalarTag::I32, 1, 10),
+        loadImmediate(ScalarTag::I32, 3, 1),
+        loadImmediate(ScalarTag::I32, 4, 0),
+        setScalarType(ScalarTag::I32, 4),
+        setScalarType(ScalarTag::Bool, 2),
+        binaryScalarOp<operators::Less>(ScalarTag::I32, 2, 0, 1),
+        Bytecode(jumpIfFalse),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 4, 4, 0),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 0, 0, 3),
+        Bytecode(jump),
+        returnValue(4),
+    };
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 6,
+                          Reflect<int32_t>::get());
+    JitFunctionState jit{};
+    fn.info.jit = &jit;
+
+    REQUIRE(jit.compile(&fn.info));
+    CHECK_NE(jit.entry(), nullptr);
+
+    int32_t result = 0;
+    CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+    CHECK_EQ(result, 30);
+}
+
+TEST_CASE("[JitFunctionState] fused compare jump signedness") {
+    // return (0xFFFFFFFF > 1) ? 1 : 2, where 0xFFFFFFFF is -1 if signed.
+    auto run = [](ScalarTag tag) -> int32_t {
+        auto compareJump = makeOperands<operators::CompareJumpIfFalse>();
+        compareJump.compareOp =
+            static_cast<uint64_t>(OpCode::Greater) - static_cast<uint64_t>(OpCode::Equal);
+        compareJump.scalarTag = static_cast<uint64_t>(tag);
+        compareJump.dst = 2;
+        compareJump.lhs = 0;
+        compareJump.rhs = 1;
+        Bytecode amount;
+        amount.value = static_cast<uint64_t>(int64_t{4});
+
+        const Bytecode bytecode[] = {
+            loadImmediate(tag, 0, 0xFFFFFFFF),
+            loadImmediate(tag, 1, 1),
+            setScalarType(ScalarTag::I32, 3),
+            Bytecode(compareJump),
+            amount,
+            loadImmediate(ScalarTag::I32, 3, 1),
+            returnValue(3),
+            loadImmediate(ScalarTag::I32, 3, 2), // jump target
+            returnValue(3),
+        };
+        TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 4,
+                              Reflect<int32_t>::get());
+        JitFunctionState jit{};
+        fn.info.jit = &jit;
+        REQUIRE(jit.compile(&fn.info));
+
+        int32_t result = 0;
+        CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+        return result;
+    };
+
+    CHECK_EQ(run(ScalarTag::U32), 1);
+    CHECK_EQ(run(ScalarTag::I32), 2);
+}
+
+TEST_CASE("[JitFunctionState] call threshold") {
+    const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 9),
+                                 setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    TestScriptFunction fn(bytecode, 3, 2, Reflect<int32_t>::get());
+    JitFunctionState jit{};
+    fn.info.jit = &jit;
+
+    for (int i = 0; i < SYNC_JIT_CALL_THRESHOLD + 1; i++) {
+        int32_t result = 0;
+        CHECK(interpreterExecuteScriptFunction(&fn.function, &result));
+        CHECK_EQ(result, 9);
+    }
+    CHECK_NE(jit.entry(), nullptr);
+}
+
+#endif // SYNC_LIB_WITH_TESTS && SY_JIT_SUPPORTED
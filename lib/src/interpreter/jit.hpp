@@ -0,0 +1,85 @@
+#pragma once
+#ifndef SY_INTERPRETER_JIT_HPP_
+#define SY_INTERPRETER_JIT_HPP_
+
+#include "../core/core.h"
+#include "stack/node.hpp"
+#include <atomic>
+
+// The baseline JIT only targets x86-64 Linux (System V ABI). It can be disabled by defining
+// `SYNC_NO_JIT`. It requires page memory in order to make generated code executable.
+#if defined(__x86_64__) && defined(__linux__) && !defined(SYNC_NO_JIT) && !defined(SYNC_NO_PAGES)
+#define SY_JIT_SUPPORTED 1
+#else
+#define SY_JIT_SUPPORTED 0
+#endif
+
+#ifndef SYNC_JIT_CALL_THRESHOLD
+/// Amount of calls to a script function before it is compiled to native code. `0` or `1` compiles
+/// on the first call.
+#define SYNC_JIT_CALL_THRESHOLD 100
+#endif
+
+namespace sy {
+struct Bytecode;
+struct InterpreterFunctionScriptInfo;
+
+/// Native code of a script function. Executes from the start of the function's bytecode, operating
+/// directly on the current frame, until reaching an operation it does not handle. Returns the
+/// instruction pointer of that operation, which the interpreter continues executing from.
+/// `bytecode` is the start of the function's bytecode, which code generated at runtime already
+/// knows, but code compiled ahead of time does not.
+using JitEntryFn = const Bytecode* (*)(uint64_t* frameValues, Node::TypeOfValue* frameTypes,
+                                       const Bytecode* bytecode);
+
+/// Mutable JIT state of a single script function, referenced by
+/// `InterpreterFunctionScriptInfo::jit`.
+///
+/// Compilation stitches together a machine code template per operation, patching in the frame
+/// offsets, immediates, and jump displacements. Operations without a template, such as calls and
+/// returns, become exits back to the interpreter. The generated code does not validate types, so
+/// it expects bytecode that would pass the interpreter's debug assertions.
+class JitFunctionState final {
+  public:
+    JitFunctionState() = default;
+
+    ~JitFunctionState() noexcept;
+
+    JitFunctionState(const JitFunctionState& other) = delete;
+
+    JitFunctionState& operator=(const JitFunctionState& other) = delete;
+
+    /// Counts a call to the function, compiling it once `SYNC_JIT_CALL_THRESHOLD` calls have been
+    /// made. Only one thread compiles, while other threads keep interpreting until it's done.
+    /// @return The native entry of the function, or null if it should be interpreted.
+    [[nodiscard]] JitEntryFn onCall(const InterpreterFunctionScriptInfo* scriptInfo) noexcept;
+
+    /// Compiles the function immediately, if it hasn't been compiled already.
+    /// @return `true` if native code is available, otherwise `false` if the JIT is unsupported, or
+    /// compilation failed.
+    bool compile(const InterpreterFunctionScriptInfo* scriptInfo) noexcept;
+
+    /// Uses native code compiled ahead of time, such as from `emitModuleC(...)`, rather than
+    /// generating it. `entry` is not owned, so it must outlive this state. Works even if the JIT
+    /// is unsupported.
+    /// @return `true` if `entry` is now in use, otherwise `false` if the function has already
+    /// been compiled, or is being compiled.
+    bool usePrecompiled(JitEntryFn entry) noexcept;
+
+    /// @return The native entry of the function, or null if it has not been compiled.
+    [[nodiscard]] JitEntryFn entry() const noexcept {
+        return this->entry_.load(std::memory_order_acquire);
+    }
+
+  private:
+    enum class Status : uint8_t { NotCompiled, Compiling, Compiled, Failed };
+
+    std::atomic<uint32_t> callCount_{0};
+    std::atomic<Status> status_{Status::NotCompiled};
+    std::atomic<JitEntryFn> entry_{nullptr};
+    void* code_ = nullptr;
+    size_t codeLen_ = 0;
+};
+} // namespace sy
+
+#endif // SY_INTERPRETER_JIT_HPP_
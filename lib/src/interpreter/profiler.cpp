@@ -0,0 +1,336 @@
+#include "profiler.hpp"
+#include "../core/core_internal.h"
+#include "../program/program.hpp"
+#include "../program/program_internal.hpp"
+#include "../types/array/dynamic_array.hpp"
+#include <chrono>
+
+using namespace sy;
+
+void sy::ProgramProfile::reset() noexcept {
+    for (size_t i = 0; i < OPCODE_COUNT; i++) {
+        this->opcodeCounts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+sy::FunctionProfile::~FunctionProfile() noexcept {
+    if (this->sites_ != nullptr) {
+        this->alloc_.freeArray(this->sites_, this->sitesLen_);
+        this->sites_ = nullptr;
+    }
+}
+
+static bool isCallOperation(const OpCode opcode) {
+    switch (opcode) {
+    case OpCode::CallImmediateNoReturn:
+    case OpCode::CallSrcNoReturn:
+    case OpCode::CallImmediateWithReturn:
+    case OpCode::CallSrcWithReturn:
+    case OpCode::TailCallImmediate:
+    case OpCode::TailCallSrc:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Result<void, AllocErr>
+sy::FunctionProfile::init(Allocator alloc, ProgramProfile* program,
+                          const InterpreterFunctionScriptInfo* scriptInfo) noexcept {
+    sy_assert(this->sites_ == nullptr, "Function profile already initialized");
+
+    const Bytecode* bytecode = scriptInfo->bytecode;
+    uint32_t sitesLen = 0;
+    for (size_t pos = 0; pos < scriptInfo->bytecodeCount; pos += bytecode[pos].bytecodeUsed()) {
+        if (isCallOperation(bytecode[pos].getOpcode())) {
+            sitesLen += 1;
+        }
+    }
+
+    if (sitesLen > 0) {
+        auto allocRes = alloc.allocArray<CallSiteProfile>(sitesLen);
+        if (allocRes.hasErr()) {
+            return Error(AllocErr::OutOfMemory);
+        }
+        this->sites_ = allocRes.value();
+
+        uint32_t site = 0;
+        for (size_t pos = 0; pos < scriptInfo->bytecodeCount; pos += bytecode[pos].bytecodeUsed()) {
+            if (isCallOperation(bytecode[pos].getOpcode())) {
+                new (&this->sites_[site]) CallSiteProfile{static_cast<uint32_t>(pos), {0}};
+                site += 1;
+            }
+        }
+    }
+
+    this->program_ = program;
+    this->sitesLen_ = sitesLen;
+    this->alloc_ = alloc;
+    return {};
+}
+
+void sy::FunctionProfile::recordCallSite(size_t bytecodeOffset) noexcept {
+    uint32_t low = 0;
+    uint32_t high = this->sitesLen_;
+    while (low < high) {
+        const uint32_t mid = low + ((high - low) / 2);
+        if (this->sites_[mid].bytecodeOffset < bytecodeOffset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < this->sitesLen_ && this->sites_[low].bytecodeOffset == bytecodeOffset) {
+        this->sites_[low].calls.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void sy::FunctionProfile::recordCall(uint64_t inclusiveInstructions, uint64_t exclusiveInstructions,
+                                     uint64_t inclusiveNanos, uint64_t exclusiveNanos) noexcept {
+    this->calls_.fetch_add(1, std::memory_order_relaxed);
+    this->inclusiveInstructions_.fetch_add(inclusiveInstructions, std::memory_order_relaxed);
+    this->exclusiveInstructions_.fetch_add(exclusiveInstructions, std::memory_order_relaxed);
+    this->inclusiveNanos_.fetch_add(inclusiveNanos, std::memory_order_relaxed);
+    this->exclusiveNanos_.fetch_add(exclusiveNanos, std::memory_order_relaxed);
+}
+
+ProfiledFunction sy::FunctionProfile::snapshot() const noexcept {
+    ProfiledFunction out;
+    out.calls = this->calls_.load(std::memory_order_relaxed);
+    out.inclusiveInstructions = this->inclusiveInstructions_.load(std::memory_order_relaxed);
+    out.exclusiveInstructions = this->exclusiveInstructions_.load(std::memory_order_relaxed);
+    out.inclusiveNanos = this->inclusiveNanos_.load(std::memory_order_relaxed);
+    out.exclusiveNanos = this->exclusiveNanos_.load(std::memory_order_relaxed);
+    return out;
+}
+
+size_t sy::FunctionProfile::callSites(ProfiledCallSite* outSites, size_t outLen) const noexcept {
+    for (size_t i = 0; i < outLen && i < this->sitesLen_; i++) {
+        outSites[i].bytecodeOffset = this->sites_[i].bytecodeOffset;
+        outSites[i].calls = this->sites_[i].calls.load(std::memory_order_relaxed);
+    }
+    return this->sitesLen_;
+}
+
+void sy::FunctionProfile::reset() noexcept {
+    this->calls_.store(0, std::memory_order_relaxed);
+    this->inclusiveInstructions_.store(0, std::memory_order_relaxed);
+    this->exclusiveInstructions_.store(0, std::memory_order_relaxed);
+    this->inclusiveNanos_.store(0, std::memory_order_relaxed);
+    this->exclusiveNanos_.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < this->sitesLen_; i++) {
+        this->sites_[i].calls.store(0, std::memory_order_relaxed);
+    }
+}
+
+namespace {
+/// A script function executing on the current thread.
+struct ProfileFrame {
+    /// Null if the function isn't being profiled, in which case nothing is recorded for it.
+    FunctionProfile* profile;
+    const Bytecode* bytecode;
+    uint64_t startNanos;
+    uint64_t instructions;
+    /// Inclusive counts of every call made by the function.
+    uint64_t childInstructions;
+    uint64_t childNanos;
+};
+
+/// Every thread keeps the functions it is executing, matching the frames of its active `Stack`.
+struct ProfileFrameStack {
+    DynArray<ProfileFrame> frames;
+    /// Frames that couldn't be pushed due to running out of memory. They are popped before any
+    /// in `frames`, so that enters and leaves stay balanced.
+    size_t dropped = 0;
+};
+
+thread_local ProfileFrameStack profileFrames{};
+} // namespace
+
+static uint64_t nowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+void sy::profiler::enterFunction(const InterpreterFunctionScriptInfo* scriptInfo) noexcept {
+    FunctionProfile* profile = scriptInfo->profile;
+    if (profile != nullptr && !profile->program()->enabled.load(std::memory_order_relaxed)) {
+        profile = nullptr;
+    }
+
+    ProfileFrame frame{profile, scriptInfo->bytecode, 0, 0, 0, 0};
+    if (profile != nullptr) {
+        frame.startNanos = nowNanos();
+    }
+    if (profileFrames.dropped > 0 || profileFrames.frames.push(frame).hasErr()) {
+        profileFrames.dropped += 1;
+    }
+}
+
+void sy::profiler::leaveFunction() noexcept {
+    if (profileFrames.dropped > 0) {
+        profileFrames.dropped -= 1;
+        return;
+    }
+
+    const size_t len = profileFrames.frames.len();
+    sy_assert(len > 0, "Left more profiled functions than were entered");
+    const ProfileFrame frame = profileFrames.frames[len - 1];
+    profileFrames.frames.removeAt(len - 1);
+
+    const uint64_t inclusiveInstructions = frame.instructions + frame.childInstructions;
+    uint64_t inclusiveNanos = 0;
+    if (frame.profile != nullptr) {
+        inclusiveNanos = nowNanos() - frame.startNanos;
+        const uint64_t exclusiveNanos =
+            inclusiveNanos > frame.childNanos ? inclusiveNanos - frame.childNanos : 0;
+        frame.profile->recordCall(inclusiveInstructions, frame.instructions, inclusiveNanos,
+                                  exclusiveNanos);
+    }
+
+    if (len > 1) {
+        ProfileFrame& caller = profileFrames.frames[len - 2];
+        caller.childInstructions += inclusiveInstructions;
+        caller.childNanos += inclusiveNanos;
+    }
+}
+
+void sy::profiler::flushInstructions(OpcodeCounts& counts) noexcept {
+    const size_t len = profileFrames.frames.len();
+    ProfileFrame* frame =
+        (profileFrames.dropped == 0 && len > 0) ? &profileFrames.frames[len - 1] : nullptr;
+    ProgramProfile* program =
+        (frame != nullptr && frame->profile != nullptr) ? frame->profile->program() : nullptr;
+
+    for (size_t i = 0; i < OPCODE_COUNT; i++) {
+        const uint64_t count = counts.counts[i];
+        if (count == 0) {
+            continue;
+        }
+        counts.counts[i] = 0;
+        if (frame != nullptr) {
+            frame->instructions += count;
+        }
+        if (program != nullptr) {
+            program->opcodeCounts[i].fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+}
+
+void sy::profiler::recordCallSite(const Bytecode* ip) noexcept {
+    const size_t len = profileFrames.frames.len();
+    if (profileFrames.dropped > 0 || len == 0) {
+        return;
+    }
+    const ProfileFrame& frame = profileFrames.frames[len - 1];
+    if (frame.profile != nullptr) {
+        frame.profile->recordCallSite(static_cast<size_t>(ip - frame.bytecode));
+    }
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include "../testing/script_function.hpp"
+
+using namespace sy::testing;
+
+namespace {
+/// Calls a function in between two no-ops, then returns.
+struct ProfiledTestFunction {
+    Bytecode bytecode[4];
+    TestScriptFunction script;
+    FunctionProfile profile;
+
+    ProfiledTestFunction(ProgramProfile* program) : script(this->bytecode, 4, 2, nullptr) {
+        auto call = makeOperands<operators::CallImmediateNoReturn>();
+        call.argCount = 0;
+
+        this->bytecode[0] = Bytecode();
+        this->bytecode[1] = Bytecode(call);
+        this->bytecode[2] = Bytecode();
+        this->bytecode[3] = Bytecode(makeOperands<operators::Return>());
+        this->script.info.profile = &this->profile;
+        (void)this->profile.init(Allocator{}, program, &this->script.info);
+    }
+};
+} // namespace
+
+TEST_CASE("[profiler] call sites are found and counted") {
+    ProgramProfile program;
+    ProfiledTestFunction fn(&program);
+
+    ProfiledCallSite sites[2];
+    REQUIRE_EQ(fn.profile.callSites(sites, 2), 1);
+    CHECK_EQ(sites[0].bytecodeOffset, 1);
+    CHECK_EQ(sites[0].calls, 0);
+
+    fn.profile.recordCallSite(1);
+    fn.profile.recordCallSite(1);
+    // Not a call operation.
+    fn.profile.recordCallSite(3);
+    (void)fn.profile.callSites(sites, 2);
+    CHECK_EQ(sites[0].calls, 2);
+
+    fn.profile.reset();
+    (void)fn.profile.callSites(sites, 2);
+    CHECK_EQ(sites[0].calls, 0);
+}
+
+TEST_CASE("[profiler] inclusive and exclusive instructions") {
+    ProgramProfile program;
+    ProfiledTestFunction caller(&program);
+    ProfiledTestFunction callee(&program);
+    OpcodeCounts counts;
+
+    SUBCASE("enabled") {
+        program.enabled.store(true);
+
+        profiler::enterFunction(&caller.script.info);
+        counts.counts[static_cast<size_t>(OpCode::Noop)] = 2;
+        counts.counts[static_cast<size_t>(OpCode::CallImmediateNoReturn)] = 1;
+        profiler::flushInstructions(counts);
+        profiler::recordCallSite(&caller.bytecode[1]);
+
+        profiler::enterFunction(&callee.script.info);
+        counts.counts[static_cast<size_t>(OpCode::Noop)] = 3;
+        profiler::flushInstructions(counts);
+        profiler::leaveFunction();
+
+        counts.counts[static_cast<size_t>(OpCode::Return)] = 1;
+        profiler::flushInstructions(counts);
+        profiler::leaveFunction();
+
+        const ProfiledFunction callerProfile = caller.profile.snapshot();
+        CHECK_EQ(callerProfile.calls, 1);
+        CHECK_EQ(callerProfile.exclusiveInstructions, 4);
+        CHECK_EQ(callerProfile.inclusiveInstructions, 7);
+        CHECK_GE(callerProfile.inclusiveNanos, callerProfile.exclusiveNanos);
+
+        const ProfiledFunction calleeProfile = callee.profile.snapshot();
+        CHECK_EQ(calleeProfile.calls, 1);
+        CHECK_EQ(calleeProfile.exclusiveInstructions, 3);
+        CHECK_EQ(calleeProfile.inclusiveInstructions, 3);
+
+        ProfiledCallSite site;
+        (void)caller.profile.callSites(&site, 1);
+        CHECK_EQ(site.calls, 1);
+
+        CHECK_EQ(program.opcodeCounts[static_cast<size_t>(OpCode::Noop)].load(), 5);
+        CHECK_EQ(program.opcodeCounts[static_cast<size_t>(OpCode::Return)].load(), 1);
+    }
+    SUBCASE("disabled") {
+        profiler::enterFunction(&caller.script.info);
+        counts.counts[static_cast<size_t>(OpCode::Noop)] = 2;
+        profiler::flushInstructions(counts);
+        profiler::recordCallSite(&caller.bytecode[1]);
+        profiler::leaveFunction();
+
+        CHECK_EQ(counts.counts[static_cast<size_t>(OpCode::Noop)], 0);
+        CHECK_EQ(caller.profile.snapshot().calls, 0);
+        CHECK_EQ(program.opcodeCounts[static_cast<size_t>(OpCode::Noop)].load(), 0);
+    }
+}
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -0,0 +1,129 @@
+#pragma once
+#ifndef SY_INTERPRETER_PROFILER_HPP_
+#define SY_INTERPRETER_PROFILER_HPP_
+
+#include "../core/core.h"
+#include "../mem/allocator.hpp"
+#include "../types/result/result.hpp"
+#include "bytecode.hpp"
+#include <atomic>
+
+// Counting every dispatched operation isn't free, so the interpreter only records profiles when
+// built with `SYNC_INTERPRETER_PROFILER`. Recording is then toggled at runtime per program, with
+// `Program::setProfiling(...)`.
+#ifdef SYNC_INTERPRETER_PROFILER
+#define SY_INTERPRETER_PROFILER 1
+#else
+#define SY_INTERPRETER_PROFILER 0
+#endif
+
+namespace sy {
+struct InterpreterFunctionScriptInfo;
+struct ProfiledFunction;
+struct ProfiledCallSite;
+
+/// Mutable profile state of a whole program, referenced by `ProgramInternal::profile`, and by every
+/// `FunctionProfile` of the program.
+class ProgramProfile final {
+  public:
+    ProgramProfile() = default;
+
+    ProgramProfile(const ProgramProfile& other) = delete;
+
+    ProgramProfile& operator=(const ProgramProfile& other) = delete;
+
+    /// Functions only record their profile while this is set.
+    std::atomic<bool> enabled{false};
+
+    /// Amount of times each operation has been interpreted, indexed by `OpCode`.
+    std::atomic<uint64_t> opcodeCounts[OPCODE_COUNT] = {};
+
+    void reset() noexcept;
+};
+
+/// Call count of a single call operation within a script function.
+struct CallSiteProfile {
+    /// Bytecode index of the call operation within its function.
+    uint32_t bytecodeOffset;
+    std::atomic<uint64_t> calls;
+};
+
+/// Mutable profile of a single script function, referenced by
+/// `InterpreterFunctionScriptInfo::profile`. Script info lives in protected memory, so this lives
+/// outside of it, the same as `JitFunctionState`.
+///
+/// Inclusive counts cover the function and everything it calls, whereas exclusive counts only
+/// cover the function itself. Recursive calls count towards the inclusive counts of every active
+/// call. Instructions are operations interpreted within the function, so parts of the function
+/// running as native code, and C functions, only count towards time.
+class FunctionProfile final {
+  public:
+    FunctionProfile() = default;
+
+    ~FunctionProfile() noexcept;
+
+    FunctionProfile(const FunctionProfile& other) = delete;
+
+    FunctionProfile& operator=(const FunctionProfile& other) = delete;
+
+    /// Finds all call sites of `scriptInfo`'s bytecode, and associates the profile with `program`.
+    [[nodiscard]] Result<void, AllocErr>
+    init(Allocator alloc, ProgramProfile* program,
+         const InterpreterFunctionScriptInfo* scriptInfo) noexcept;
+
+    [[nodiscard]] ProgramProfile* program() const noexcept { return this->program_; }
+
+    /// Counts a call made by the call operation at `bytecodeOffset`.
+    void recordCallSite(size_t bytecodeOffset) noexcept;
+
+    /// Adds a finished call of the function.
+    void recordCall(uint64_t inclusiveInstructions, uint64_t exclusiveInstructions,
+                    uint64_t inclusiveNanos, uint64_t exclusiveNanos) noexcept;
+
+    [[nodiscard]] ProfiledFunction snapshot() const noexcept;
+
+    /// Copies up to `outLen` call sites into `outSites`, in bytecode order.
+    /// @return The amount of call sites within the function.
+    size_t callSites(ProfiledCallSite* outSites, size_t outLen) const noexcept;
+
+    void reset() noexcept;
+
+  private:
+    ProgramProfile* program_ = nullptr;
+    std::atomic<uint64_t> calls_{0};
+    std::atomic<uint64_t> inclusiveInstructions_{0};
+    std::atomic<uint64_t> exclusiveInstructions_{0};
+    std::atomic<uint64_t> inclusiveNanos_{0};
+    std::atomic<uint64_t> exclusiveNanos_{0};
+    /// Sorted by `CallSiteProfile::bytecodeOffset`.
+    CallSiteProfile* sites_ = nullptr;
+    uint32_t sitesLen_ = 0;
+    Allocator alloc_{};
+};
+
+/// Operations interpreted during a single continuous run of the dispatch loop, indexed by
+/// `OpCode`. Kept local to the loop, and added to the current function with
+/// `profiler::flushInstructions(...)`.
+struct OpcodeCounts {
+    uint64_t counts[OPCODE_COUNT] = {};
+};
+
+/// Tracks the script functions executing on the current thread, in order to attribute time and
+/// instructions to them. Every `enterFunction(...)` must be paired with a `leaveFunction()`.
+namespace profiler {
+/// The function's frame has been pushed, and it's about to start executing.
+void enterFunction(const InterpreterFunctionScriptInfo* scriptInfo) noexcept;
+
+/// The most recently entered function's frame is being popped, or replaced by a tail call.
+void leaveFunction() noexcept;
+
+/// Adds `counts` to the most recently entered function and its program, zeroing them.
+void flushInstructions(OpcodeCounts& counts) noexcept;
+
+/// Counts a call made by the most recently entered function, from the call operation at `ip`.
+void recordCallSite(const Bytecode* ip) noexcept;
+} // namespace profiler
+
+} // namespace sy
+
+#endif // SY_INTERPRETER_PROFILER_HPP_
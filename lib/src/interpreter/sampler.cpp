@@ -0,0 +1,393 @@
+#include "sampler.hpp"
+#include "../core/core_internal.h"
+#include "../types/function/function.hpp"
+#include "../types/string/string.hpp"
+#include "stack/stack.hpp"
+#include <new>
+
+#if SY_SAMPLER_TIMER_SUPPORTED
+#include <cerrno>
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+using namespace sy;
+
+/// If the timer samples this thread when it fires. Trivially constructed and destroyed, so it can
+/// be read from within a signal handler.
+static thread_local bool threadAttached = false;
+
+sy::StackSampler::~StackSampler() noexcept {
+    this->stopTimer();
+    if (this->samples_ != nullptr) {
+        this->alloc_.freeArray(this->samples_, this->capacity_);
+        this->samples_ = nullptr;
+    }
+}
+
+Result<void, AllocErr> sy::StackSampler::init(Allocator alloc, size_t capacity) noexcept {
+    sy_assert(this->samples_ == nullptr, "Sampler already initialized");
+    sy_assert(capacity > 0, "Sampler requires space for at least 1 sample");
+
+    auto allocRes = alloc.allocArray<Sample>(capacity);
+    if (allocRes.hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    this->samples_ = allocRes.value();
+    for (size_t i = 0; i < capacity; i++) {
+        new (&this->samples_[i].state) std::atomic<uint32_t>(Sample::Empty);
+    }
+    this->capacity_ = capacity;
+    this->alloc_ = alloc;
+    this->stacks_ = DynArray<FoldedStack>(alloc);
+    this->stackFunctions_ = DynArray<const RawFunction*>(alloc);
+    return {};
+}
+
+void sy::StackSampler::sample(const Stack& stack) noexcept {
+    const size_t index =
+        this->nextSample_.fetch_add(1, std::memory_order_relaxed) % this->capacity_;
+    Sample& sample = this->samples_[index];
+
+    uint32_t expected = Sample::Empty;
+    if (!sample.state.compare_exchange_strong(expected, Sample::Writing, std::memory_order_acquire,
+                                              std::memory_order_relaxed)) {
+        this->dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    sample.totalDepth = stack.sampleCallStack(sample.functions, MAX_SAMPLE_DEPTH);
+    sample.depth = static_cast<uint32_t>(
+        sample.totalDepth < MAX_SAMPLE_DEPTH ? sample.totalDepth : MAX_SAMPLE_DEPTH);
+    sample.state.store(Sample::Written, std::memory_order_release);
+}
+
+void sy::StackSampler::sampleCurrentThread() noexcept { this->sample(Stack::getActiveStack()); }
+
+void sy::StackSampler::attachThread() noexcept {
+    // Publishes the thread's current stack to `Stack::getActiveStackSignalSafe()`.
+    (void)Stack::setActiveStack(&Stack::getActiveStack());
+    threadAttached = true;
+}
+
+void sy::StackSampler::detachThread() noexcept { threadAttached = false; }
+
+#if SY_SAMPLER_TIMER_SUPPORTED
+
+static std::atomic<StackSampler*> timerSampler{nullptr};
+/// Signal handlers currently sampling, which `stopTimer()` waits on.
+static std::atomic<uint32_t> activeTimerSamples{0};
+static struct sigaction previousProfAction;
+
+static void onProfSignal(int) {
+    const int savedErrno = errno;
+    activeTimerSamples.fetch_add(1, std::memory_order_acquire);
+    StackSampler* sampler = timerSampler.load(std::memory_order_acquire);
+    const Stack* stack = threadAttached ? Stack::getActiveStackSignalSafe() : nullptr;
+    if (sampler != nullptr && stack != nullptr) {
+        sampler->sample(*stack);
+    }
+    activeTimerSamples.fetch_sub(1, std::memory_order_release);
+    errno = savedErrno;
+}
+
+bool sy::StackSampler::startTimer(uint32_t intervalMicros) noexcept {
+    sy_assert(this->samples_ != nullptr, "Sampler must be initialized before sampling");
+    sy_assert(intervalMicros > 0, "Timer interval must be non-zero");
+
+    StackSampler* expected = nullptr;
+    if (!timerSampler.compare_exchange_strong(expected, this, std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = onProfSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &previousProfAction) != 0) {
+        timerSampler.store(nullptr, std::memory_order_release);
+        return false;
+    }
+
+    struct itimerval timer = {};
+    timer.it_interval.tv_sec = static_cast<time_t>(intervalMicros / 1000000);
+    timer.it_interval.tv_usec = static_cast<suseconds_t>(intervalMicros % 1000000);
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        (void)sigaction(SIGPROF, &previousProfAction, nullptr);
+        timerSampler.store(nullptr, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+void sy::StackSampler::stopTimer() noexcept {
+    if (timerSampler.load(std::memory_order_acquire) != this) {
+        return;
+    }
+
+    struct itimerval timer = {};
+    (void)setitimer(ITIMER_PROF, &timer, nullptr);
+    timerSampler.store(nullptr, std::memory_order_release);
+    // A signal may have been delivered to another thread just before the timer stopped.
+    while (activeTimerSamples.load(std::memory_order_acquire) != 0) {
+    }
+    (void)sigaction(SIGPROF, &previousProfAction, nullptr);
+}
+
+#else
+
+bool sy::StackSampler::startTimer(uint32_t intervalMicros) noexcept {
+    (void)intervalMicros;
+    return false;
+}
+
+void sy::StackSampler::stopTimer() noexcept {}
+
+#endif // SY_SAMPLER_TIMER_SUPPORTED
+
+static size_t hashStack(const RawFunction* const* functions, uint32_t depth, bool truncated) {
+    // FNV-1a over the function addresses.
+    size_t hash = truncated ? 1469598103934665603ULL ^ 1 : 1469598103934665603ULL;
+    for (uint32_t i = 0; i < depth; i++) {
+        hash ^= reinterpret_cast<uintptr_t>(functions[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+Result<void, AllocErr> sy::StackSampler::collect() noexcept {
+    for (size_t i = 0; i < this->capacity_; i++) {
+        Sample& sample = this->samples_[i];
+        if (sample.state.load(std::memory_order_acquire) != Sample::Written) {
+            continue;
+        }
+
+        const bool truncated = sample.totalDepth > sample.depth;
+        const size_t hash = hashStack(sample.functions, sample.depth, truncated);
+        bool found = false;
+        for (size_t j = 0; j < this->stacks_.len(); j++) {
+            FoldedStack& folded = this->stacks_[j];
+            if (folded.hash != hash || folded.depth != sample.depth ||
+                folded.truncated != truncated) {
+                continue;
+            }
+            bool same = true;
+            for (uint32_t k = 0; k < sample.depth && same; k++) {
+                same = this->stackFunctions_[folded.start + k] == sample.functions[k];
+            }
+            if (same) {
+                folded.count += 1;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            const size_t start = this->stackFunctions_.len();
+            if (this->stackFunctions_.reserve(start + sample.depth).hasErr()) {
+                return Error(AllocErr::OutOfMemory);
+            }
+            for (uint32_t k = 0; k < sample.depth; k++) {
+                (void)this->stackFunctions_.push(sample.functions[k]);
+            }
+            if (this->stacks_.push(FoldedStack{hash, start, sample.depth, truncated, 1}).hasErr()) {
+                return Error(AllocErr::OutOfMemory);
+            }
+        }
+
+        sample.state.store(Sample::Empty, std::memory_order_release);
+    }
+    return {};
+}
+
+static Result<void, AllocErr> writeCount(StringBuilder& out, uint64_t count) {
+    char digits[20];
+    size_t len = 0;
+    do {
+        digits[sizeof(digits) - 1 - len] = static_cast<char>('0' + (count % 10));
+        count /= 10;
+        len += 1;
+    } while (count != 0);
+    return out.write(StringSlice(&digits[sizeof(digits) - len], len));
+}
+
+Result<void, AllocErr> sy::StackSampler::writeFolded(StringBuilder& out) noexcept {
+    if (auto res = this->collect(); res.hasErr()) {
+        return res;
+    }
+
+    for (size_t i = 0; i < this->stacks_.len(); i++) {
+        const FoldedStack& folded = this->stacks_[i];
+        if (folded.truncated) {
+            if (auto res = out.write("[truncated];"); res.hasErr()) {
+                return res;
+            }
+        }
+        for (uint32_t k = 0; k < folded.depth; k++) {
+            if (k != 0) {
+                if (auto res = out.write(";"); res.hasErr()) {
+                    return res;
+                }
+            }
+            const StringSlice name = this->stackFunctions_[folded.start + k]->qualifiedName;
+            if (auto res = out.write(name); res.hasErr()) {
+                return res;
+            }
+        }
+        if (auto res = out.write(" "); res.hasErr()) {
+            return res;
+        }
+        if (auto res = writeCount(out, folded.count); res.hasErr()) {
+            return res;
+        }
+        if (auto res = out.write("\n"); res.hasErr()) {
+            return res;
+        }
+    }
+    return {};
+}
+
+void sy::StackSampler::clear() noexcept {
+    while (this->stacks_.len() > 0) {
+        this->stacks_.removeAt(this->stacks_.len() - 1);
+    }
+    while (this->stackFunctions_.len() > 0) {
+        this->stackFunctions_.removeAt(this->stackFunctions_.len() - 1);
+    }
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include "../testing/script_function.hpp"
+
+using namespace sy::testing;
+
+namespace {
+/// Body of every sampled function. Samples are only taken of frames, so it never runs.
+const Bytecode sampledBytecode[1] = {};
+
+/// Pushes the frame of `fn` as if the interpreter had started executing it.
+void enter(Stack& stack, const TestScriptFunction& fn) {
+    stack.pushFunctionFrame(&fn.function, nullptr);
+    stack.setInstructionPointer(fn.info.bytecode);
+}
+
+String foldedOf(StackSampler& sampler) {
+    StringBuilder builder = StringBuilder::init().takeValue();
+    REQUIRE(sampler.writeFolded(builder));
+    return builder.build().takeValue();
+}
+} // namespace
+
+TEST_CASE("[sampler] folds identical call stacks") {
+    TestScriptFunction outer(sampledBytecode, 1, 4, nullptr, "test.outer");
+    TestScriptFunction inner(sampledBytecode, 1, 4, nullptr, "test.inner");
+
+    StackSampler sampler;
+    REQUIRE(sampler.init(Allocator{}, 8));
+
+    Stack stack;
+    enter(stack, outer);
+    enter(stack, inner);
+    sampler.sample(stack);
+    sampler.sample(stack);
+    stack.popFrame();
+    sampler.sample(stack);
+    stack.popFrame();
+
+    CHECK_EQ(foldedOf(sampler), StringSlice("test.outer;test.inner 2\ntest.outer 1\n"));
+    CHECK_EQ(sampler.droppedSamples(), 0);
+
+    // Counts keep accumulating until cleared.
+    enter(stack, outer);
+    sampler.sample(stack);
+    stack.popFrame();
+    CHECK_EQ(foldedOf(sampler), StringSlice("test.outer;test.inner 2\ntest.outer 2\n"));
+
+    sampler.clear();
+    CHECK_EQ(foldedOf(sampler), StringSlice(""));
+}
+
+TEST_CASE("[sampler] full buffer drops samples") {
+    TestScriptFunction fn(sampledBytecode, 1, 4, nullptr, "test.fn");
+    StackSampler sampler;
+    REQUIRE(sampler.init(Allocator{}, 2));
+
+    Stack stack;
+    enter(stack, fn);
+    for (int i = 0; i < 5; i++) {
+        sampler.sample(stack);
+    }
+    stack.popFrame();
+
+    CHECK_EQ(sampler.droppedSamples(), 3);
+    CHECK_EQ(foldedOf(sampler), StringSlice("test.fn 2\n"));
+}
+
+TEST_CASE("[sampler] deep call stacks are truncated") {
+    TestScriptFunction outer(sampledBytecode, 1, 4, nullptr, "test.outer");
+    TestScriptFunction recursive(sampledBytecode, 1, 4, nullptr, "test.recursive");
+    StackSampler sampler;
+    REQUIRE(sampler.init(Allocator{}, 1));
+
+    Stack stack;
+    enter(stack, outer);
+    for (size_t i = 0; i < StackSampler::MAX_SAMPLE_DEPTH; i++) {
+        enter(stack, recursive);
+    }
+    sampler.sample(stack);
+    for (size_t i = 0; i <= StackSampler::MAX_SAMPLE_DEPTH; i++) {
+        stack.popFrame();
+    }
+
+    StringBuilder expected = StringBuilder::init().takeValue();
+    CHECK(expected.write("[truncated];test.recursive"));
+    for (size_t i = 1; i < StackSampler::MAX_SAMPLE_DEPTH; i++) {
+        CHECK(expected.write(";test.recursive"));
+    }
+    CHECK(expected.write(" 1\n"));
+    CHECK_EQ(foldedOf(sampler), expected.build().takeValue());
+}
+
+#if SY_SAMPLER_TIMER_SUPPORTED && !defined(__SANITIZE_THREAD__)
+TEST_CASE("[sampler] timer samples attached thread") {
+    TestScriptFunction fn(sampledBytecode, 1, 4, nullptr, "test.busy");
+    StackSampler sampler;
+    REQUIRE(sampler.init(Allocator{}, 64));
+
+    // Attached before switching stacks, so the timer has to follow the switch.
+    StackSampler::attachThread();
+    Stack stack;
+    enter(stack, fn);
+    Stack* previousStack = Stack::setActiveStack(&stack);
+    const bool started = sampler.startTimer(1000);
+
+    StackSampler other;
+    REQUIRE(other.init(Allocator{}, 1));
+    CHECK_FALSE(other.startTimer(1000));
+
+    // Burn CPU time until the timer has fired, giving up after a long while.
+    volatile uint64_t spin = 0;
+    bool sampled = false;
+    for (uint64_t i = 0; started && i < 4000000000ULL && !sampled; i++) {
+        spin = spin + 1;
+        if ((i % 1000000) == 0) {
+            sampled = foldedOf(sampler).len() > 0;
+        }
+    }
+    sampler.stopTimer();
+    (void)Stack::setActiveStack(previousStack);
+    StackSampler::detachThread();
+    stack.popFrame();
+
+    REQUIRE(started);
+    REQUIRE(sampled);
+    const String folded = foldedOf(sampler);
+    REQUIRE_GE(folded.len(), 10);
+    CHECK_EQ(StringSlice(folded.cstr(), 10), StringSlice("test.busy "));
+}
+#endif
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -0,0 +1,121 @@
+#pragma once
+#ifndef SY_INTERPRETER_SAMPLER_HPP_
+#define SY_INTERPRETER_SAMPLER_HPP_
+
+#include "../core/core.h"
+#include "../mem/allocator.hpp"
+#include "../types/array/dynamic_array.hpp"
+#include "../types/result/result.hpp"
+#include <atomic>
+
+// Timer driven sampling uses `setitimer(ITIMER_PROF)` and `SIGPROF`, which only POSIX targets have.
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define SY_SAMPLER_TIMER_SUPPORTED 1
+#else
+#define SY_SAMPLER_TIMER_SUPPORTED 0
+#endif
+
+namespace sy {
+class RawFunction;
+class Stack;
+class StringBuilder;
+
+/// Statistical profiler of script call stacks. Samples copy the functions of a `Stack`'s call
+/// stack, without stopping the thread using it, or any other thread. Collected samples are
+/// aggregated into collapsed stacks, which `writeFolded(...)` writes in the format flame graph
+/// tools expect, keyed by `RawFunction::qualifiedName`.
+///
+/// Samples are taken either by the host calling `sampleCurrentThread()` on its own tick, or by a
+/// `SIGPROF` timer with `startTimer(...)`, which samples whichever attached thread is running when
+/// the timer fires. Taking a sample does not allocate or lock, so is safe within signal handlers.
+/// Samples are written to a fixed size buffer, and are dropped if it fills up before `collect()`
+/// drains it.
+///
+/// Sampled functions must outlive the sampler, or at least the last call to `collect()`.
+class StackSampler final {
+  public:
+    /// Call stacks deeper than this keep their innermost frames.
+    static constexpr size_t MAX_SAMPLE_DEPTH = 64;
+
+    StackSampler() = default;
+
+    ~StackSampler() noexcept;
+
+    StackSampler(const StackSampler& other) = delete;
+
+    StackSampler& operator=(const StackSampler& other) = delete;
+
+    /// Allocates space for `capacity` samples between calls to `collect()`.
+    [[nodiscard]] Result<void, AllocErr> init(Allocator alloc, size_t capacity) noexcept;
+
+    /// Samples the call stack of `stack`. Must be called from the thread using `stack`, or while
+    /// that thread isn't using it. Async signal safe.
+    void sample(const Stack& stack) noexcept;
+
+    /// Samples the active stack of the calling thread.
+    void sampleCurrentThread() noexcept;
+
+    /// Allows the timer to sample the active stack of the calling thread whenever it fires on it,
+    /// following `Stack::setActiveStack(...)` as tasks and coroutines switch stacks.
+    static void attachThread() noexcept;
+
+    /// Stops the timer from sampling the calling thread.
+    static void detachThread() noexcept;
+
+    /// Samples the attached thread that's running every `intervalMicros` of process CPU time. Only
+    /// one sampler can use the timer at a time.
+    /// @return `true` if the timer started, otherwise `false` if timers are unsupported, or
+    /// another sampler is using it.
+    bool startTimer(uint32_t intervalMicros) noexcept;
+
+    /// Stops the timer if this sampler is using it, waiting for any samples it's taking to finish.
+    void stopTimer() noexcept;
+
+    /// Drains taken samples into the aggregated stacks. Must not be called concurrently with
+    /// itself, or `writeFolded(...)`.
+    [[nodiscard]] Result<void, AllocErr> collect() noexcept;
+
+    /// Collects, then writes one line per unique call stack, being the qualified names of the
+    /// functions from outermost to innermost separated by `;`, followed by a space and the amount
+    /// of samples of it. Stacks that were cut short start with `[truncated]`.
+    [[nodiscard]] Result<void, AllocErr> writeFolded(StringBuilder& out) noexcept;
+
+    /// @return The amount of samples dropped due to the buffer being full.
+    [[nodiscard]] uint64_t droppedSamples() const noexcept {
+        return this->dropped_.load(std::memory_order_relaxed);
+    }
+
+    /// Forgets all collected stacks.
+    void clear() noexcept;
+
+  private:
+    struct Sample {
+        enum State : uint32_t { Empty, Writing, Written };
+
+        std::atomic<uint32_t> state;
+        uint32_t depth;
+        /// Depth of the whole call stack, which is more than `depth` if truncated.
+        size_t totalDepth;
+        const RawFunction* functions[MAX_SAMPLE_DEPTH];
+    };
+
+    struct FoldedStack {
+        size_t hash;
+        /// Start of the stack's functions within `stackFunctions_`.
+        size_t start;
+        uint32_t depth;
+        bool truncated;
+        uint64_t count;
+    };
+
+    Sample* samples_ = nullptr;
+    size_t capacity_ = 0;
+    std::atomic<size_t> nextSample_{0};
+    std::atomic<uint64_t> dropped_{0};
+    Allocator alloc_{};
+    DynArray<FoldedStack> stacks_{};
+    DynArray<const RawFunction*> stackFunctions_{};
+};
+} // namespace sy
+
+#endif // SY_INTERPRETER_SAMPLER_HPP_
@@ -375,6 +375,24 @@ std::optional<std::tuple<Frame, const Bytecode*>> sy::Node::popFrame() {
     }
 }
 
+bool sy::Node::reuseFrame(const uint16_t frameLength, const uint16_t byteAlign) {
+    sy_assert(this->isInUse(), "Expected this node to be in use");
+
+    Frame& frame = this->currentFrame.value();
+    if (requiredBaseOffsetForByteAlignment(frame.basePointerOffset, byteAlign) !=
+        frame.basePointerOffset) {
+        return false;
+    }
+    if ((frame.basePointerOffset + static_cast<uint32_t>(frameLength)) > this->slots) {
+        return false;
+    }
+
+    frame.frameLength = frameLength;
+    this->nextBaseOffset =
+        frame.basePointerOffset + frameLength + Frame::OLD_FRAME_INFO_RESERVED_SLOTS;
+    return true;
+}
+
 std::optional<uint16_t> sy::Node::pushScriptFunctionArg(const void* argMem, const sy::Type* type,
                                                         uint16_t offset, const uint16_t frameLength,
                                                         const uint16_t frameByteAlign) {
@@ -422,16 +440,9 @@ std::optional<uint16_t> sy::Node::pushScriptFunctionArg(const void* argMem, cons
         }
     }
 
-    const uint32_t actualOffset = [this, offset, type]() -> uint32_t {
-        const uint32_t normalizedTypeAlign = ((type->alignType - 1) / 8) + 1;
-        const uint32_t initialOffset = this->nextBaseOffset + static_cast<uint32_t>(offset);
-        const uint32_t remainder = initialOffset % normalizedTypeAlign;
-        if (remainder == 0) {
-            return initialOffset;
-        }
-
-        return initialOffset + (this->nextBaseOffset - remainder);
-    }();
+    // Arguments are packed one after the other, as frame slots are only guaranteed to be aligned to
+    // 8 bytes anyway.
+    const uint32_t actualOffset = this->nextBaseOffset + static_cast<uint32_t>(offset);
 
     { // ensure fits within frame
         const uint32_t extraTypeSlots = static_cast<uint32_t>((type->sizeType - 1) / 8);
@@ -440,7 +451,7 @@ std::optional<uint16_t> sy::Node::pushScriptFunctionArg(const void* argMem, cons
         }
     }
 
-    // guaranteed that all arguments will fit even with their alignment requirements
+    // guaranteed that all arguments will fit
 
     uint64_t* valueMem = &this->values[actualOffset];
     TypeOfValue* typesMem = &this->types[actualOffset];
@@ -504,7 +515,7 @@ std::optional<uint32_t> sy::Node::shouldReallocate(uint16_t frameLength, uint16_
 
 Node::TypeOfValue sy::Node::typeAt(const uint16_t offset) const {
     this->ensureOffsetWithinFrameBounds(offset);
-    return this->types[offset + this->nextBaseOffset];
+    return this->types[offset + this->currentFrame.value().basePointerOffset];
 }
 
 void sy::Node::setTypeAt(const TypeOfValue type, const uint16_t offset) {
@@ -515,12 +526,12 @@ void sy::Node::setTypeAt(const TypeOfValue type, const uint16_t offset) {
     const sy::Type* typeInfo = type.get();
     if (typeInfo != nullptr) {
         const uint32_t slotsOccupied = static_cast<uint32_t>((typeInfo->sizeType - 1) / 8) + 1;
-        sy_assert((static_cast<uint32_t>(offset) + slotsOccupied) < frame.frameLength,
+        sy_assert((static_cast<uint32_t>(offset) + slotsOccupied) <= frame.frameLength,
                   "Cannot set type information past the frame length");
 
         this->types[actualOffset] = type;
         for (size_t i = 1; i < slotsOccupied; i++) {
-            this->types[actualOffset + 1] = nullptr;
+            this->types[actualOffset + i] = nullptr;
         }
     } else {
         this->types[actualOffset] = nullptr;
@@ -532,6 +543,16 @@ void sy::Node::setFrameFunction(const uint16_t functionIndex) {
     this->currentFrame.value().functionIndex = functionIndex;
 }
 
+uint64_t* sy::Node::frameValuesBase() {
+    sy_assert(this->isInUse(), "Expected node to have a frame");
+    return &this->values[this->currentFrame.value().basePointerOffset];
+}
+
+Node::TypeOfValue* sy::Node::frameTypesBase() {
+    sy_assert(this->isInUse(), "Expected node to have a frame");
+    return &this->types[this->currentFrame.value().basePointerOffset];
+}
+
 void sy::Node::ensureOffsetWithinFrameBounds(const uint16_t offset) const {
     sy_assert(this->currentFrame.has_value(), "No frame");
     sy_assert(offset < this->currentFrame.value().frameLength,
@@ -1101,6 +1122,41 @@ TEST_CASE("push 2 pop 2 no more frames") {
     CHECK_EQ(node.nextBaseOffset, Frame::OLD_FRAME_INFO_RESERVED_SLOTS);
 }
 
+TEST_CASE("reuse frame keeps previous frame") {
+    auto node = Node(1);
+    int retDst = 0;
+    node.pushFrameAllowReallocate(4, 1, nullptr, std::nullopt, nullptr);
+    Bytecode bytecode;
+    CHECK(node.pushFrameNoReallocate(2, 1, &retDst, &bytecode));
+    const Frame before = node.currentFrame.value();
+
+    CHECK(node.reuseFrame(8, 1));
+    CHECK_EQ(node.frameDepth, 2);
+    CHECK_EQ(node.currentFrame.value().basePointerOffset, before.basePointerOffset);
+    CHECK_EQ(node.currentFrame.value().frameLength, 8);
+    CHECK_EQ(node.currentFrame.value().retValueDst, &retDst);
+    CHECK_EQ(node.nextBaseOffset,
+             before.basePointerOffset + 8 + Frame::OLD_FRAME_INFO_RESERVED_SLOTS);
+
+    auto result = node.popFrame();
+    CHECK(result.has_value());
+    CHECK_EQ(std::get<1>(result.value()), &bytecode);
+    CHECK_EQ(node.frameDepth, 1);
+}
+
+TEST_CASE("reuse frame not successful") {
+    auto node = Node(1);
+    node.pushFrameAllowReallocate(4, 1, nullptr, std::nullopt, nullptr);
+    const Frame before = node.currentFrame.value();
+    const uint32_t nextBaseOffset = node.nextBaseOffset;
+
+    SUBCASE("too long") { CHECK_FALSE(node.reuseFrame(static_cast<uint16_t>(node.slots), 1)); }
+    SUBCASE("misaligned base") { CHECK_FALSE(node.reuseFrame(4, 64)); }
+
+    CHECK_EQ(node.currentFrame.value().frameLength, before.frameLength);
+    CHECK_EQ(node.nextBaseOffset, nextBaseOffset);
+}
+
 TEST_CASE("push frame from previous node") {
     auto node1 = Node(1);
     auto node2 = Node(1);
@@ -106,10 +106,19 @@ class Node final {
     /// it or not, along with the instruction pointer.
     [[nodiscard]] std::optional<std::tuple<Frame, const Bytecode*>> popFrame();
 
+    /// @brief Resizes the current frame in place for a different function, keeping it's base
+    /// offset, return value destination, and previous frame information. Used for tail calls.
+    /// The values and types within the frame are left untouched.
+    /// @param frameLength The length of the new frame
+    /// @param byteAlign The alignment in bytes of the new frame
+    /// @return `true` if the current frame's base offset satisfies `byteAlign`, and the new frame
+    /// fits within this node. Otherwise the frame is unchanged.
+    [[nodiscard]] bool reuseFrame(const uint16_t frameLength, const uint16_t byteAlign);
+
     /// @brief Attempts to push a script function argument onto this node.
     /// @param argMem Non-null pointer to the arguments memory to be byte-copied from.
     /// @param type Non-null pointer to the type of the argument.
-    /// @param offset Memory offset to place the argument. If not properly aligned, will be shifted.
+    /// @param offset Slot offset to place the argument at, directly after the previous argument.
     /// @param frameLength Slot length of the frame for the future function call.
     /// @param frameByteAlign Byte alignment of the frame for the future function call.
     /// @return std::nullopt if cannot fit the argument and it's frame into this node. Otherwise
@@ -142,6 +151,14 @@ class Node final {
 
     void setFrameFunction(const uint16_t functionIndex);
 
+    /// @return non-null pointer to the first value slot of the current stack frame. Only valid
+    /// until a frame is pushed or popped on this node.
+    [[nodiscard]] uint64_t* frameValuesBase();
+
+    /// @return non-null pointer to the first type slot of the current stack frame. Only valid
+    /// until a frame is pushed or popped on this node.
+    [[nodiscard]] TypeOfValue* frameTypesBase();
+
     /// By default, values use 1KB.
     /// On targets with 64 bit pointers, the types minimum allocation is 1KB. On targets with 32 bit pointers,
     /// such as wasm32, the types minimum allocation is 512B.
@@ -159,12 +176,13 @@ class Node final {
 
 template <typename T> inline T* Node::frameValueAt(const uint16_t offset) {
     ensureOffsetWithinFrameBounds(offset);
-    return reinterpret_cast<T*>(&this->values[offset + this->nextBaseOffset]);
+    return reinterpret_cast<T*>(&this->values[offset + this->currentFrame->basePointerOffset]);
 }
 
 template <typename T> inline const T* Node::frameValueAt(const uint16_t offset) const {
     ensureOffsetWithinFrameBounds(offset);
-    return reinterpret_cast<const T*>(&this->values[offset + this->nextBaseOffset]);
+    return reinterpret_cast<const T*>(
+        &this->values[offset + this->currentFrame->basePointerOffset]);
 }
 
 } // namespace sy
@@ -8,6 +8,7 @@
 #include "../../types/function/function.hpp"
 #include "../../types/type_info.hpp"
 #include "../bytecode.hpp"
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <new>
@@ -22,6 +23,10 @@ namespace detail {
 static thread_local Stack defaultThreadStack{};
 /// For now, this value will never change, however it'll be supported anyways for when coroutines become a thing.
 static thread_local Stack* activeStack = &defaultThreadStack;
+/// Same as `activeStack`, but constant initialized and trivially destroyed, so reading it never
+/// initializes thread locals, which isn't async signal safe. Null until `setActiveStack(...)` is
+/// first called on this thread.
+static thread_local std::atomic<const Stack*> signalSafeActiveStack{nullptr};
 } // namespace detail
 } // namespace sy
 
@@ -51,9 +56,14 @@ Stack& sy::Stack::getActiveStack() {
 Stack* sy::Stack::setActiveStack(Stack* newStack) {
     Stack* previous = detail::activeStack;
     detail::activeStack = newStack;
+    detail::signalSafeActiveStack.store(newStack, std::memory_order_release);
     return previous;
 }
 
+const Stack* sy::Stack::getActiveStackSignalSafe() noexcept {
+    return detail::signalSafeActiveStack.load(std::memory_order_acquire);
+}
+
 static constexpr size_t minNodeCapacityForCacheAlign() {
     size_t bytes = sizeof(Node);
     while ((bytes % ALLOC_CACHE_ALIGN) != 0) {
@@ -70,32 +80,34 @@ static constexpr size_t minCallstackFunctionCapacityForCacheAlign() {
     return bytes / sizeof(const sy::RawFunction*);
 }
 
+void sy::Stack::initialAllocations(const uint16_t frameLength) {
+    sy::Allocator alloc{};
+
+    if (this->nodes == nullptr) {
+        constexpr size_t capacity = minNodeCapacityForCacheAlign();
+        this->nodes = alloc.allocAlignedArray<Node>(capacity, ALLOC_CACHE_ALIGN).value();
+        this->nodesCapacity = capacity;
+
+        Node* _ = new (&this->nodes[0]) Node(frameLength * 4); // TODO evaluate this default
+        (void)_;
+        this->nodesLen = 1;
+    }
+
+    if (this->callstackFunctions == nullptr) {
+        constexpr size_t capacity = minCallstackFunctionCapacityForCacheAlign();
+        this->callstackFunctions =
+            alloc.allocAlignedArray<const sy::RawFunction*>(capacity, ALLOC_CACHE_ALIGN).value();
+        this->callstackCapacity = capacity;
+    }
+}
+
 void sy::Stack::pushFrame(uint16_t frameLength, uint16_t alignment, void* retValDst) {
     sy_assert(frameLength > 0, "Frame length of 0 is useless");
     sy_assert(frameLength <= MAX_FRAME_LEN, "Frame length too big");
     // TODO validate alignment power of 2
     sy_assert((page_size() % alignment) == 0, "Alignment greater than system page size makes no sense");
 
-    { // perform initial allocations if necessary
-        sy::Allocator alloc{};
-
-        if (this->nodes == nullptr) {
-            constexpr size_t capacity = minNodeCapacityForCacheAlign();
-            this->nodes = alloc.allocAlignedArray<Node>(capacity, ALLOC_CACHE_ALIGN).value();
-            this->nodesCapacity = capacity;
-
-            Node* _ = new (&this->nodes[0]) Node(frameLength * 4); // TODO evaluate this default
-            (void)_;
-            this->nodesLen = 1;
-        }
-
-        if (this->callstackFunctions == nullptr) {
-            constexpr size_t capacity = minCallstackFunctionCapacityForCacheAlign();
-            this->callstackFunctions =
-                alloc.allocAlignedArray<const sy::RawFunction*>(capacity, ALLOC_CACHE_ALIGN).value();
-            this->callstackCapacity = capacity;
-        }
-    }
+    this->initialAllocations(frameLength);
 
     const uint16_t actualAlignment = alignment < 16 ? 16 : alignment;
 
@@ -139,19 +151,56 @@ void sy::Stack::pushFunctionFrame(const sy::RawFunction* function, void* retValD
                 newFunctions[i] = this->callstackFunctions[i];
             }
 
-            alloc.freeAlignedArray(this->callstackFunctions, this->callstackCapacity, ALLOC_CACHE_ALIGN);
+            // Publish the new functions before freeing the old ones, as `sampleCallStack(...)` may interrupt at any
+            // point.
+            const sy::RawFunction** oldFunctions = this->callstackFunctions;
             this->callstackFunctions = newFunctions;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            alloc.freeAlignedArray(oldFunctions, this->callstackCapacity, ALLOC_CACHE_ALIGN);
             this->callstackCapacity = newCapacity;
         }
     }
 
     this->callstackFunctions[this->callstackLen] = function;
     this->nodes[this->currentNode].setFrameFunction(this->callstackLen);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
     this->callstackLen += 1;
 }
 
+void sy::Stack::replaceFunctionFrame(const sy::RawFunction* function) {
+    sy_assert(function->tag == sy::FunctionType::Script, "Can only push frames for script functions");
+    const sy::InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<const sy::InterpreterFunctionScriptInfo*>(function->fptr);
+    const uint16_t actualAlignment = function->alignment < 16 ? 16 : function->alignment;
+
+    Node& currNode = this->nodes[this->currentNode];
+    if (currNode.reuseFrame(scriptInfo->stackSpaceRequired, actualAlignment)) {
+        this->callstackFunctions[currNode.currentFrame.value().functionIndex] = function;
+        return;
+    }
+
+    // Popping restores the instruction pointer of the previous frame, which the new frame then stores as where to
+    // return to.
+    void* retValDst = this->returnDst();
+    this->popFrame();
+    this->pushFunctionFrame(function, retValDst);
+}
+
 sy::CallStack sy::Stack::callStack() const { return sy::CallStack(this->callstackFunctions, this->callstackLen); }
 
+size_t sy::Stack::sampleCallStack(const sy::RawFunction** outFunctions, size_t outLen) const noexcept {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    const size_t len = this->callstackLen;
+    const sy::RawFunction* const* functions = this->callstackFunctions;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    const size_t copied = len < outLen ? len : outLen;
+    for (size_t i = 0; i < copied; i++) {
+        outFunctions[i] = functions[len - copied + i];
+    }
+    return len;
+}
+
 const Bytecode* sy::Stack::getInstructionPointer() {
     sy_assert(this->instructionPointer != nullptr, "Cannot get invalid instruction pointer");
     return this->instructionPointer;
@@ -172,8 +221,16 @@ void sy::Stack::setTypeAt(const Node::TypeOfValue type, const uint16_t offset) {
 
 void* sy::Stack::returnDst() { return this->nodes[currentNode].currentFrame.value().retValueDst; }
 
+uint64_t* sy::Stack::frameValuesBase() { return this->nodes[this->currentNode].frameValuesBase(); }
+
+Node::TypeOfValue* sy::Stack::frameTypesBase() {
+    return this->nodes[this->currentNode].frameTypesBase();
+}
+
 uint16_t sy::Stack::pushScriptFunctionArg(const void* argMem, const sy::Type* type, uint16_t offset,
                                           const uint16_t frameLength, const uint16_t frameAlign) {
+    // Arguments can be pushed before the first frame.
+    this->initialAllocations(frameLength);
     std::optional<uint16_t> result =
         this->nodes[this->currentNode].pushScriptFunctionArg(argMem, type, offset, frameLength, frameAlign);
     if (result.has_value()) {
@@ -187,7 +244,35 @@ uint16_t sy::Stack::pushScriptFunctionArg(const void* argMem, const sy::Type* ty
     return actualResult;
 }
 
-std::optional<Frame> sy::Stack::getCurrentFrame() const noexcept { return this->nodes[this->currentNode].currentFrame; }
+void sy::Stack::takeScriptFunctionArgs(const sy::RawFunction* function, void* const* outArgs) {
+    if (function->argsLen == 0) {
+        return;
+    }
+
+    // The arguments are where the function's frame would start, so the frame is pushed to read them, then popped
+    // without ever being executed.
+    this->pushFunctionFrame(function, nullptr);
+    uint16_t offset = 0;
+    for (uint16_t i = 0; i < function->argsLen; i++) {
+        const sy::Type* type = function->argsTypes[i];
+        // Same packed placement as `Node::pushScriptFunctionArg(...)`, given the offsets of
+        // `RawFunction::CallArgs`.
+        sy_assert(this->typeAt(offset) == type, "Script function argument was not pushed");
+
+        memcpy(outArgs[i], this->frameValueAt<uint8_t>(offset), type->sizeType);
+        // Moved out, so must not be destroyed along with the frame.
+        this->setTypeAt(nullptr, offset);
+        offset = static_cast<uint16_t>(offset + ((type->sizeType + 7) / 8));
+    }
+    this->popFrame();
+}
+
+std::optional<Frame> sy::Stack::getCurrentFrame() const noexcept {
+    if (this->nodes == nullptr) {
+        return std::optional<Frame>();
+    }
+    return this->nodes[this->currentNode].currentFrame;
+}
 
 std::optional<const sy::RawFunction*> sy::Stack::getCurrentFunction() const noexcept {
     auto frame = this->getCurrentFrame();
@@ -203,6 +288,7 @@ void sy::Stack::popFrame() {
     if (!popResult.has_value()) {
         sy_assert(this->currentNode == 0, "Node incorrectly reported having no previous frame");
         this->instructionPointer = nullptr;
+        this->callstackLen = 0;
         return;
     }
 
@@ -33,6 +33,11 @@ class Stack final {
 
     static Stack* setActiveStack(Stack* newStack);
 
+    /// Same as `getActiveStack()`, but async signal safe, so a signal handler can find the stack of the thread it
+    /// interrupted.
+    /// @return The active stack of the calling thread, or null if `setActiveStack(...)` was never called on it.
+    static const Stack* getActiveStackSignalSafe() noexcept;
+
     /// Pushes a new frame onto the stack, given a length in slots, as well as return value and type destinations.
     /// Can stack overflow. Since functions track their return types, only the return value destination is required.
     /// @param frameLength The amount of slots the frame requires. Internally, some more will be added
@@ -44,8 +49,20 @@ class Stack final {
 
     void pushFunctionFrame(const sy::RawFunction* function, void* retValDst);
 
+    /// Replaces the current frame with a frame for `function`, keeping the return value destination and the
+    /// instruction pointer to return to. The frame is reused in place if it fits, otherwise it is popped and a new
+    /// one is pushed, so the depth of the stack doesn't change either way. Used for tail calls.
+    /// Does not unwind the stack, nor clear the types of the frame.
+    void replaceFunctionFrame(const sy::RawFunction* function);
+
     [[nodiscard]] sy::CallStack callStack() const;
 
+    /// Copies the functions of the innermost `outLen` frames into `outFunctions`, ordered from the outermost frame to
+    /// the innermost. Safe to call from a signal handler that interrupted the thread using this stack, as the call
+    /// stack is always consistent between operations on it.
+    /// @return The depth of the call stack, which may be more than `outLen`.
+    size_t sampleCallStack(const sy::RawFunction** outFunctions, size_t outLen) const noexcept;
+
     [[nodiscard]] const Bytecode* getInstructionPointer();
 
     void setInstructionPointer(const Bytecode* bytecode);
@@ -65,6 +82,14 @@ class Stack final {
 
     [[nodiscard]] void* returnDst();
 
+    /// @return non-null pointer to the first value slot of the current stack frame. Used by the
+    /// interpreter to address frame slots directly. Invalidated by pushing or popping frames.
+    [[nodiscard]] uint64_t* frameValuesBase();
+
+    /// @return non-null pointer to the first type slot of the current stack frame. Used by the
+    /// interpreter to address frame slots directly. Invalidated by pushing or popping frames.
+    [[nodiscard]] Node::TypeOfValue* frameTypesBase();
+
     /// @brief Pushes the argument onto the script stack. Potentially adds another stack node if the frame
     /// and arguments wouldn't fit within the current node.
     /// @param argMem Memory to copy the argument data from.
@@ -74,6 +99,12 @@ class Stack final {
     uint16_t pushScriptFunctionArg(const void* argMem, const sy::Type* type, uint16_t offset,
                                    const uint16_t frameLength, const uint16_t frameAlign);
 
+    /// @brief Moves the arguments pushed with `pushScriptFunctionArg(...)` for a call of `function` out of the
+    /// stack, without making the call, so that it can be made elsewhere, such as on another thread.
+    /// @param outArgs Where to move each argument to, with `outArgs[i]` being sized and aligned for
+    /// `function->argsTypes[i]`.
+    void takeScriptFunctionArgs(const sy::RawFunction* function, void* const* outArgs);
+
     [[nodiscard]] std::optional<Frame> getCurrentFrame() const noexcept;
 
     [[nodiscard]] std::optional<const sy::RawFunction*> getCurrentFunction() const noexcept;
@@ -85,6 +116,9 @@ class Stack final {
     void popFrame();
 
   private:
+    /// Allocates the first node and the call stack, if they haven't been already.
+    void initialAllocations(const uint16_t frameLength);
+
     void addOneNode(const uint16_t requiredFrameLength);
 
     friend class FrameGuard;
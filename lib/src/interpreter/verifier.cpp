@@ -0,0 +1,1023 @@
+#include "verifier.hpp"
+#include "../core/core_internal.h"
+#include "../program/program_internal.hpp"
+#include "../types/array/dynamic_array.hpp"
+#include "../types/function/function.hpp"
+#include "../types/type_info.hpp"
+#include "bytecode.hpp"
+#include "call_site_cache.hpp"
+#include <cstring>
+
+using namespace sy;
+
+namespace {
+/// What is statically known about the type of a frame slot.
+struct SlotType {
+    /// Only meaningful if `known`, in which case null means the slot has no type.
+    const Type* type = nullptr;
+    bool known = false;
+
+    static SlotType of(const Type* inType) { return SlotType{inType, true}; }
+
+    bool isNonNull() const { return this->known && this->type != nullptr; }
+
+    bool is(const Type* expected) const { return this->known && this->type == expected; }
+};
+
+constexpr size_t NOT_A_LEADER = SIZE_MAX;
+
+/// Same as the slots occupied in `Node::setTypeAt(...)`.
+uint64_t slotsOccupied(const Type* type) {
+    if (type->sizeType == 0) {
+        return 1;
+    }
+    return static_cast<uint64_t>((type->sizeType - 1) / 8) + 1;
+}
+
+bool isValidScalarTag(uint64_t scalarTag) {
+    return scalarTag <= static_cast<uint64_t>(ScalarTag::F64);
+}
+
+const Type* scalarType(uint64_t scalarTag) {
+    return scalarTypeFromTag(static_cast<ScalarTag>(scalarTag));
+}
+
+/// Reads the `const Type*` or `const RawFunction*` immediate stored in the bytecode after `ip`.
+template <typename T> const T* immediatePtr(const Bytecode* ip) {
+    const T* ptr = nullptr;
+    memcpy(&ptr, &ip[1], sizeof(const T*));
+    return ptr;
+}
+
+template <typename OperandsT> bool compareOperandsValid(const Bytecode& op) {
+    const OperandsT operands = op.toOperands<OperandsT>();
+    return !operands.isScalar || isValidScalarTag(operands.scalarTag);
+}
+
+} // namespace
+
+bool sy::operandsValid(const Bytecode& op) noexcept {
+    if (static_cast<size_t>(op.getOpcode()) >= OPCODE_COUNT) {
+        return false;
+    }
+
+    switch (op.getOpcode()) {
+    case OpCode::Sync:
+    case OpCode::Unsync:
+    case OpCode::Dereference:
+    case OpCode::SetReference:
+    case OpCode::MakeReference:
+        return false;
+    case OpCode::LoadDefault: {
+        const operators::LoadDefault operands = op.toOperands<operators::LoadDefault>();
+        return operands.isScalar && isValidScalarTag(operands.scalarTag);
+    }
+    case OpCode::LoadImmediateScalar:
+        return isValidScalarTag(op.toOperands<operators::LoadImmediateScalar>().scalarTag);
+    case OpCode::SetType: {
+        const operators::SetType operands = op.toOperands<operators::SetType>();
+        return !operands.isScalar || isValidScalarTag(operands.scalarTag);
+    }
+    case OpCode::GetMember: {
+        const operators::GetMember operands = op.toOperands<operators::GetMember>();
+        return !operands.isScalar || isValidScalarTag(operands.scalarTag);
+    }
+    case OpCode::SetMember: {
+        const operators::SetMember operands = op.toOperands<operators::SetMember>();
+        return !operands.isScalar || isValidScalarTag(operands.scalarTag);
+    }
+    case OpCode::Equal:
+        return compareOperandsValid<operators::Equal>(op);
+    case OpCode::NotEqual:
+        return compareOperandsValid<operators::NotEqual>(op);
+    case OpCode::Less:
+        return compareOperandsValid<operators::Less>(op);
+    case OpCode::LessEqual:
+        return compareOperandsValid<operators::LessEqual>(op);
+    case OpCode::Greater:
+        return compareOperandsValid<operators::Greater>(op);
+    case OpCode::GreaterEqual:
+        return compareOperandsValid<operators::GreaterEqual>(op);
+    case OpCode::Add: {
+        const operators::Add operands = op.toOperands<operators::Add>();
+        return operands.isScalar && isValidScalarTag(operands.scalarTag) &&
+               operands.scalarTag != static_cast<uint64_t>(ScalarTag::Bool);
+    }
+    case OpCode::CompareJumpIfFalse: {
+        const operators::CompareJumpIfFalse operands =
+            op.toOperands<operators::CompareJumpIfFalse>();
+        return isValidScalarTag(operands.scalarTag) &&
+               operands.compareOp <=
+                   (static_cast<uint64_t>(OpCode::GreaterEqual) -
+                    static_cast<uint64_t>(OpCode::Equal));
+    }
+    case OpCode::LoadImmediateScalarSetType:
+        return isValidScalarTag(op.toOperands<operators::LoadImmediateScalarSetType>().scalarTag);
+    case OpCode::LoadDefaultSetType:
+        return isValidScalarTag(op.toOperands<operators::LoadDefaultSetType>().scalarTag);
+    case OpCode::DestructMany:
+        return op.toOperands<operators::DestructMany>().count >= 2;
+    default:
+        return true;
+    }
+}
+
+namespace {
+template <typename T> bool fill(DynArray<T>& arr, size_t len, const T& value) {
+    if (arr.reserve(len).hasErr()) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        (void)arr.push(value);
+    }
+    return true;
+}
+
+/// Forward dataflow over the slot types of a single function. States are only stored at the
+/// start of basic blocks, which are the function entry and every jump target.
+class Verifier {
+  public:
+    Verifier(const RawFunction* function, const InterpreterFunctionScriptInfo* scriptInfo)
+        : function_(function), bytecode_(scriptInfo->bytecode),
+          bytecodeCount_(scriptInfo->bytecodeCount),
+          frameLength_(scriptInfo->stackSpaceRequired), scriptInfo_(scriptInfo) {}
+
+    Result<void, BytecodeVerifyError> run() noexcept;
+
+  private:
+    Error<BytecodeVerifyError> fail(BytecodeVerifyErrorKind kind) const {
+        return Error(BytecodeVerifyError{kind, this->pos_});
+    }
+
+    bool inFrame(uint64_t slot, uint64_t slots = 1) const {
+        return slot < this->frameLength_ && slots <= (this->frameLength_ - slot);
+    }
+
+    /// `memberOffset` bytes into the object at `slot`, for a member of `memberType`.
+    bool memberInFrame(uint64_t slot, uint64_t memberOffset, const Type* memberType) const {
+        const uint64_t frameBytes = static_cast<uint64_t>(this->frameLength_) * 8;
+        return this->inFrame(slot) &&
+               (slot * 8 + memberOffset + memberType->sizeType) <= frameBytes;
+    }
+
+    SlotType& at(uint64_t slot) { return this->current_[slot]; }
+
+    /// Same as `FrameSlots::setTypeAt(...)` within the interpreter.
+    bool setType(uint64_t slot, const Type* type);
+
+    Result<void, BytecodeVerifyError> decode() noexcept;
+
+    bool jumpTargetOf(size_t pos, size_t& outTarget) const;
+
+    Result<void, BytecodeVerifyError> setEntryState() noexcept;
+
+    Result<void, BytecodeVerifyError> walkBlock(size_t leader) noexcept;
+
+    Result<void, BytecodeVerifyError> mergeInto(size_t target) noexcept;
+
+    Result<void, BytecodeVerifyError> step(size_t pos) noexcept;
+
+    Result<void, BytecodeVerifyError> verifyCallArgs(const RawFunction* callee, uint16_t argCount,
+                                                     const uint16_t* argsSrcs) noexcept;
+
+    Result<void, BytecodeVerifyError> verifyCall(const RawFunction* callee, uint16_t argCount,
+                                                 const uint16_t* argsSrcs, bool withReturn,
+                                                 uint64_t retDst) noexcept;
+
+    /// Checks the call site cache index of `CallSrcNoReturn`, `CallSrcWithReturn`, or
+    /// `TailCallSrc`.
+    bool validCallSiteCache(const Bytecode* ip) const noexcept;
+
+    Result<void, BytecodeVerifyError> verifyTailCall(const RawFunction* callee, uint16_t argCount,
+                                                     const uint16_t* argsSrcs) noexcept;
+
+    template <typename OperandsT>
+    Result<void, BytecodeVerifyError> verifyCompare(const Bytecode* ip) noexcept;
+
+    const RawFunction* function_;
+    const Bytecode* bytecode_;
+    size_t bytecodeCount_;
+    uint64_t frameLength_;
+    const InterpreterFunctionScriptInfo* scriptInfo_;
+    /// Operation currently being verified, for error reporting.
+    size_t pos_ = 0;
+
+    DynArray<bool> isOpStart_{};
+    /// Index into `hasState_`, or `NOT_A_LEADER`, for every bytecode.
+    DynArray<size_t> leaderIndex_{};
+    size_t leaderCount_ = 0;
+    DynArray<bool> hasState_{};
+    /// `frameLength_` slot types per leader.
+    DynArray<SlotType> leaderStates_{};
+    DynArray<SlotType> current_{};
+    DynArray<size_t> worklist_{};
+};
+
+bool Verifier::setType(uint64_t slot, const Type* type) {
+    if (!this->inFrame(slot)) {
+        return false;
+    }
+    if (type == nullptr) {
+        this->at(slot) = SlotType::of(nullptr);
+        return true;
+    }
+
+    const uint64_t slots = slotsOccupied(type);
+    if (!this->inFrame(slot, slots)) {
+        return false;
+    }
+    this->at(slot) = SlotType::of(type);
+    for (uint64_t i = 1; i < slots; i++) {
+        this->at(slot + i) = SlotType::of(nullptr);
+    }
+    return true;
+}
+
+bool Verifier::jumpTargetOf(size_t pos, size_t& outTarget) const {
+    const Bytecode& op = this->bytecode_[pos];
+    // Wrapping arithmetic, as out of range targets are rejected regardless.
+    switch (op.getOpcode()) {
+    case OpCode::Jump:
+        outTarget = pos + static_cast<size_t>(
+                              static_cast<int64_t>(op.toOperands<operators::Jump>().amount));
+        return true;
+    case OpCode::JumpIfFalse:
+        outTarget = pos + static_cast<size_t>(static_cast<int64_t>(
+                              op.toOperands<operators::JumpIfFalse>().amount));
+        return true;
+    case OpCode::CompareJumpIfFalse:
+        outTarget = pos + static_cast<size_t>(this->bytecode_[pos + 1].value);
+        return true;
+    default:
+        return false;
+    }
+}
+
+Result<void, BytecodeVerifyError> Verifier::decode() noexcept {
+    if (!fill(this->isOpStart_, this->bytecodeCount_, false) ||
+        !fill(this->leaderIndex_, this->bytecodeCount_, NOT_A_LEADER)) {
+        return this->fail(BytecodeVerifyErrorKind::OutOfMemory);
+    }
+
+    for (size_t pos = 0; pos < this->bytecodeCount_;) {
+        this->pos_ = pos;
+        const Bytecode& op = this->bytecode_[pos];
+        if (!operandsValid(op)) {
+            return this->fail(BytecodeVerifyErrorKind::InvalidOperation);
+        }
+        const size_t width = op.bytecodeUsed();
+        if (width > (this->bytecodeCount_ - pos)) {
+            return this->fail(BytecodeVerifyErrorKind::Truncated);
+        }
+        this->isOpStart_[pos] = true;
+        pos += width;
+    }
+
+    this->leaderIndex_[0] = 0;
+    this->leaderCount_ = 1;
+    for (size_t pos = 0; pos < this->bytecodeCount_; pos += this->bytecode_[pos].bytecodeUsed()) {
+        this->pos_ = pos;
+        size_t target = 0;
+        if (!this->jumpTargetOf(pos, target)) {
+            continue;
+        }
+        if (target >= this->bytecodeCount_ || !this->isOpStart_[target]) {
+            return this->fail(BytecodeVerifyErrorKind::InvalidJumpTarget);
+        }
+        if (this->leaderIndex_[target] == NOT_A_LEADER) {
+            this->leaderIndex_[target] = this->leaderCount_;
+            this->leaderCount_ += 1;
+        }
+    }
+
+    if (!fill(this->hasState_, this->leaderCount_, false) ||
+        !fill(this->leaderStates_, this->leaderCount_ * this->frameLength_, SlotType{}) ||
+        !fill(this->current_, this->frameLength_, SlotType{})) {
+        return this->fail(BytecodeVerifyErrorKind::OutOfMemory);
+    }
+    return {};
+}
+
+Result<void, BytecodeVerifyError> Verifier::setEntryState() noexcept {
+    this->pos_ = 0;
+    // Without argument types, the layout of the arguments is unknown, so nothing is assumed.
+    if (this->function_->argsTypes == nullptr) {
+        return {};
+    }
+
+    uint64_t offset = 0;
+    for (uint16_t i = 0; i < this->function_->argsLen; i++) {
+        const Type* argType = this->function_->argsTypes[i];
+        if (argType == nullptr) {
+            return this->fail(BytecodeVerifyErrorKind::InvalidCall);
+        }
+        if (!this->setType(offset, argType)) {
+            return this->fail(BytecodeVerifyErrorKind::SlotOutOfBounds);
+        }
+        offset += slotsOccupied(argType);
+    }
+    return {};
+}
+
+Result<void, BytecodeVerifyError> Verifier::mergeInto(size_t target) noexcept {
+    const size_t index = this->leaderIndex_[target];
+    SlotType* state = this->leaderStates_.data() + (index * this->frameLength_);
+    const SlotType* incoming = this->current_.data();
+
+    bool changed = false;
+    if (!this->hasState_[index]) {
+        for (uint64_t i = 0; i < this->frameLength_; i++) {
+            state[i] = incoming[i];
+        }
+        this->hasState_[index] = true;
+        changed = true;
+    } else {
+        for (uint64_t i = 0; i < this->frameLength_; i++) {
+            if (state[i].known && !incoming[i].is(state[i].type)) {
+                state[i] = SlotType{};
+                changed = true;
+            }
+        }
+    }
+
+    if (changed && this->worklist_.push(target).hasErr()) {
+        return this->fail(BytecodeVerifyErrorKind::OutOfMemory);
+    }
+    return {};
+}
+
+Result<void, BytecodeVerifyError> Verifier::walkBlock(size_t leader) noexcept {
+    const SlotType* state =
+        this->leaderStates_.data() + (this->leaderIndex_[leader] * this->frameLength_);
+    for (uint64_t i = 0; i < this->frameLength_; i++) {
+        this->current_[i] = state[i];
+    }
+
+    size_t pos = leader;
+    while (true) {
+        if (auto res = this->step(pos); res.hasErr()) {
+            return res;
+        }
+
+        const OpCode opcode = this->bytecode_[pos].getOpcode();
+        if (opcode == OpCode::Return || opcode == OpCode::ReturnValue ||
+            opcode == OpCode::TailCallImmediate || opcode == OpCode::TailCallSrc) {
+            return {};
+        }
+
+        size_t target = 0;
+        if (this->jumpTargetOf(pos, target)) {
+            if (auto res = this->mergeInto(target); res.hasErr()) {
+                return res;
+            }
+            if (opcode == OpCode::Jump) {
+                return {};
+            }
+        }
+
+        const size_t next = pos + this->bytecode_[pos].bytecodeUsed();
+        if (next >= this->bytecodeCount_) {
+            return this->fail(BytecodeVerifyErrorKind::FallsOffEnd);
+        }
+        if (this->leaderIndex_[next] != NOT_A_LEADER) {
+            return this->mergeInto(next);
+        }
+        pos = next;
+    }
+}
+
+Result<void, BytecodeVerifyError> Verifier::verifyCallArgs(const RawFunction* callee,
+                                                           uint16_t argCount,
+                                                           const uint16_t* argsSrcs) noexcept {
+    for (uint16_t i = 0; i < argCount; i++) {
+        if (!this->inFrame(argsSrcs[i])) {
+            return this->fail(BytecodeVerifyErrorKind::SlotOutOfBounds);
+        }
+        if (!this->at(argsSrcs[i]).isNonNull()) {
+            return this->fail(BytecodeVerifyErrorKind::TypeMismatch);
+        }
+    }
+
+    if (callee != nullptr) {
+        if (callee->argsLen != argCount) {
+            return this->fail(BytecodeVerifyErrorKind::InvalidCall);
+        }
+        if (callee->argsTypes != nullptr) {
+            for (uint16_t i = 0; i < argCount; i++) {
+                if (this->at(argsSrcs[i]).type != callee->argsTypes[i]) {
+                    return this->fail(BytecodeVerifyErrorKind::InvalidCall);
+                }
+            }
+        }
+    }
+    return {};
+}
+
+Result<void, BytecodeVerifyError> Verifier::verifyCall(const RawFunction* callee,
+                                                       uint16_t argCount, const uint16_t* argsSrcs,
+                                                       bool withReturn, uint64_t retDst) noexcept {
+    if (auto res = this->verifyCallArgs(callee, argCount, argsSrcs); res.hasErr()) {
+        return res;
+    }
+
+    uint64_t retSlots = 1;
+    if (callee != nullptr) {
+        if (withReturn != (callee->returnType != nullptr)) {
+            return this->fail(BytecodeVerifyErrorKind::InvalidCall);
+        }
+        if (withReturn) {
+            retSlots = slotsOccupied(callee->returnType);
+        }
+    }
+
+    if (withReturn && !this->inFrame(retDst, retSlots)) {
+        return this->fail(BytecodeVerifyErrorKind::SlotOutOfBounds);
+    }
+    return {};
+}
+
+bool Verifier::validCallSiteCache(const Bytecode* ip) const noexcept {
+    const uint64_t cacheIndex = ip[1].value;
+    return cacheIndex == NO_CALL_SITE_CACHE || cacheIndex < this->scriptInfo_->callSiteCachesLen;
+}
+
+/// The callee of a tail call returns directly into this function's return value destination.
+Result<void, BytecodeVerifyError> Verifier::verifyTailCall(const RawFunction* callee,
+                                                           uint16_t argCount,
+                                                           const uint16_t* argsSrcs) noexcept {
+    if (callee != nullptr && callee->returnType != this->function_->returnType) {
+        return this->fail(BytecodeVerifyErrorKind::InvalidCall);
+    }
+    // The same slot may be passed more than once, as every argument is copied out of the frame
+    // before any of their slots are released.
+    return this->verifyCallArgs(callee, argCount, argsSrcs);
+}
+
+template <typename OperandsT>
+Result<void, BytecodeVerifyError> Verifier::verifyCompare(const Bytecode* ip) noexcept {
+    const OperandsT operands = ip->toOperands<OperandsT>();
+    if (!this->inFrame(operands.dst) || !this->inFrame(operands.lhs) ||
+        !this->inFrame(operands.rhs)) {
+        return this->fail(BytecodeVerifyErrorKind::SlotOutOfBounds);
+    }
+    if (operands.isScalar) {
+        return {};
+    }
+
+    const SlotType lhs = this->at(operands.lhs);
+    if (!lhs.isNonNull() || !this->at(operands.rhs).is(lhs.type)) {
+        return this->fail(BytecodeVerifyErrorKind::TypeMismatch);
+    }
+    if (!this->setType(operands.dst, Reflect<bool>::get())) {
+        return this->fail(BytecodeVerifyErrorKind::SlotOutOfBounds);
+    }
+    return {};
+}
+
+Result<void, BytecodeVerifyError> Verifier::step(size_t pos) noexcept {
+    using Kind = BytecodeVerifyErrorKind;
+
+    this->pos_ = pos;
+    const Bytecode* ip = &this->bytecode_[pos];
+
+    switch (ip->getOpcode()) {
+    case OpCode::Noop:
+    case OpCode::Jump:
+    case OpCode::Yield:
+        return {};
+    case OpCode::Return: {
+        if (this->function_->returnType != nullptr) {
+            return this->fail(Kind::InvalidCall);
+        }
+        return {};
+    }
+    case OpCode::ReturnValue: {
+        const operators::ReturnValue operands = ip->toOperands<operators::ReturnValue>();
+        const Type* returnType = this->function_->returnType;
+        if (returnType == nullptr) {
+            return this->fail(Kind::InvalidCall);
+        }
+        if (!this->inFrame(operands.src)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (!this->at(operands.src).is(returnType)) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        return {};
+    }
+    case OpCode::CallImmediateNoReturn: {
+        const operators::CallImmediateNoReturn operands =
+            ip->toOperands<operators::CallImmediateNoReturn>();
+        const RawFunction* callee = immediatePtr<RawFunction>(ip);
+        if (callee == nullptr) {
+            return this->fail(Kind::InvalidCall);
+        }
+        return this->verifyCall(callee, static_cast<uint16_t>(operands.argCount),
+                                reinterpret_cast<const uint16_t*>(&ip[2]), false, 0);
+    }
+    case OpCode::CallImmediateWithReturn: {
+        const operators::CallImmediateWithReturn operands =
+            ip->toOperands<operators::CallImmediateWithReturn>();
+        const RawFunction* callee = immediatePtr<RawFunction>(ip);
+        if (callee == nullptr) {
+            return this->fail(Kind::InvalidCall);
+        }
+        return this->verifyCall(callee, static_cast<uint16_t>(operands.argCount),
+                                reinterpret_cast<const uint16_t*>(&ip[2]), true,
+                                operands.retDst);
+    }
+    case OpCode::CallSrcNoReturn: {
+        const operators::CallSrcNoReturn operands = ip->toOperands<operators::CallSrcNoReturn>();
+        if (!this->inFrame(operands.src)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (!this->validCallSiteCache(ip)) {
+            return this->fail(Kind::InvalidOperation);
+        }
+        const SlotType src = this->at(operands.src);
+        if (!src.isNonNull() || src.type->tag != Type::Tag::Function) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        return this->verifyCall(nullptr, static_cast<uint16_t>(operands.argCount),
+                                reinterpret_cast<const uint16_t*>(&ip[2]), false, 0);
+    }
+    case OpCode::CallSrcWithReturn: {
+        const operators::CallSrcWithReturn operands =
+            ip->toOperands<operators::CallSrcWithReturn>();
+        if (!this->inFrame(operands.src)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (!this->validCallSiteCache(ip)) {
+            return this->fail(Kind::InvalidOperation);
+        }
+        const SlotType src = this->at(operands.src);
+        if (!src.isNonNull() || src.type->tag != Type::Tag::Function) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        return this->verifyCall(nullptr, static_cast<uint16_t>(operands.argCount),
+                                reinterpret_cast<const uint16_t*>(&ip[2]), true,
+                                operands.retDst);
+    }
+    case OpCode::TailCallImmediate: {
+        const operators::TailCallImmediate operands =
+            ip->toOperands<operators::TailCallImmediate>();
+        const RawFunction* callee = immediatePtr<RawFunction>(ip);
+        if (callee == nullptr) {
+            return this->fail(Kind::InvalidCall);
+        }
+        return this->verifyTailCall(callee, static_cast<uint16_t>(operands.argCount),
+                                    reinterpret_cast<const uint16_t*>(&ip[2]));
+    }
+    case OpCode::TailCallSrc: {
+        const operators::TailCallSrc operands = ip->toOperands<operators::TailCallSrc>();
+        if (!this->inFrame(operands.src)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (!this->validCallSiteCache(ip)) {
+            return this->fail(Kind::InvalidOperation);
+        }
+        const SlotType src = this->at(operands.src);
+        if (!src.isNonNull() || src.type->tag != Type::Tag::Function) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        return this->verifyTailCall(nullptr, static_cast<uint16_t>(operands.argCount),
+                                    reinterpret_cast<const uint16_t*>(&ip[2]));
+    }
+    case OpCode::LoadDefault: {
+        if (!this->inFrame(ip->toOperands<operators::LoadDefault>().dst)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::LoadImmediateScalar: {
+        if (!this->inFrame(ip->toOperands<operators::LoadImmediateScalar>().dst)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::MemsetUninitialized: {
+        const operators::MemsetUninitialized operands =
+            ip->toOperands<operators::MemsetUninitialized>();
+        if (!this->inFrame(operands.dst) || !this->inFrame(operands.dst, operands.slots)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::SetType: {
+        const operators::SetType operands = ip->toOperands<operators::SetType>();
+        const Type* type =
+            operands.isScalar ? scalarType(operands.scalarTag) : immediatePtr<Type>(ip);
+        if (!this->setType(operands.dst, type)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::SetNullType: {
+        if (!this->setType(ip->toOperands<operators::SetNullType>().dst, nullptr)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::JumpIfFalse: {
+        const operators::JumpIfFalse operands = ip->toOperands<operators::JumpIfFalse>();
+        if (!this->inFrame(operands.src)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (!this->at(operands.src).is(Reflect<bool>::get())) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        return {};
+    }
+    case OpCode::Destruct: {
+        const operators::Destruct operands = ip->toOperands<operators::Destruct>();
+        if (!this->inFrame(operands.src)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (!this->at(operands.src).isNonNull()) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        this->at(operands.src) = SlotType::of(nullptr);
+        return {};
+    }
+    case OpCode::Move:
+    case OpCode::Clone: {
+        // Same layout
+        static_assert(sizeof(operators::Move) == sizeof(operators::Clone));
+        const bool isMove = ip->getOpcode() == OpCode::Move;
+        uint64_t dst = 0;
+        uint64_t src = 0;
+        bool isScalar = false;
+        if (isMove) {
+            const operators::Move operands = ip->toOperands<operators::Move>();
+            dst = operands.dst;
+            src = operands.src;
+            isScalar = operands.isScalar;
+        } else {
+            const operators::Clone operands = ip->toOperands<operators::Clone>();
+            dst = operands.dst;
+            src = operands.src;
+            isScalar = operands.isScalar;
+        }
+
+        if (!this->inFrame(dst) || !this->inFrame(src)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        // Moving into itself does nothing.
+        if (isScalar || (isMove && dst == src)) {
+            return {};
+        }
+
+        const SlotType srcType = this->at(src);
+        if (!srcType.isNonNull()) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        if (isMove) {
+            this->at(src) = SlotType::of(nullptr);
+        }
+        if (!this->setType(dst, srcType.type)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::GetMember: {
+        const operators::GetMember operands = ip->toOperands<operators::GetMember>();
+        const Type* memberType =
+            operands.isScalar ? scalarType(operands.scalarTag) : immediatePtr<Type>(ip);
+        if (memberType == nullptr) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        if (!this->inFrame(operands.dst) ||
+            !this->memberInFrame(operands.src, operands.memberOffset, memberType)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (!operands.isScalar && !this->setType(operands.dst, memberType)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::SetMember: {
+        const operators::SetMember operands = ip->toOperands<operators::SetMember>();
+        const Type* memberType =
+            operands.isScalar ? scalarType(operands.scalarTag) : immediatePtr<Type>(ip);
+        if (memberType == nullptr) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        if (!this->inFrame(operands.src) ||
+            !this->memberInFrame(operands.dst, operands.memberOffset, memberType)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        if (operands.isScalar) {
+            return {};
+        }
+        if (!this->at(operands.src).is(memberType)) {
+            return this->fail(Kind::TypeMismatch);
+        }
+        this->at(operands.src) = SlotType::of(nullptr);
+        return {};
+    }
+    case OpCode::Equal:
+        return this->verifyCompare<operators::Equal>(ip);
+    case OpCode::NotEqual:
+        return this->verifyCompare<operators::NotEqual>(ip);
+    case OpCode::Less:
+        return this->verifyCompare<operators::Less>(ip);
+    case OpCode::LessEqual:
+        return this->verifyCompare<operators::LessEqual>(ip);
+    case OpCode::Greater:
+        return this->verifyCompare<operators::Greater>(ip);
+    case OpCode::GreaterEqual:
+        return this->verifyCompare<operators::GreaterEqual>(ip);
+    case OpCode::Add: {
+        const operators::Add operands = ip->toOperands<operators::Add>();
+        if (!this->inFrame(operands.dst) || !this->inFrame(operands.lhs) ||
+            !this->inFrame(operands.rhs)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::CompareJumpIfFalse: {
+        const operators::CompareJumpIfFalse operands =
+            ip->toOperands<operators::CompareJumpIfFalse>();
+        if (!this->inFrame(operands.dst) || !this->inFrame(operands.lhs) ||
+            !this->inFrame(operands.rhs)) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::LoadImmediateScalarSetType: {
+        const operators::LoadImmediateScalarSetType operands =
+            ip->toOperands<operators::LoadImmediateScalarSetType>();
+        if (!this->setType(operands.dst, scalarType(operands.scalarTag))) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::LoadDefaultSetType: {
+        const operators::LoadDefaultSetType operands =
+            ip->toOperands<operators::LoadDefaultSetType>();
+        if (!this->setType(operands.dst, scalarType(operands.scalarTag))) {
+            return this->fail(Kind::SlotOutOfBounds);
+        }
+        return {};
+    }
+    case OpCode::DestructMany: {
+        const operators::DestructMany operands = ip->toOperands<operators::DestructMany>();
+        const uint64_t srcs[3] = {operands.src0, operands.src1, operands.src2};
+        for (uint64_t i = 0; i < operands.count; i++) {
+            if (!this->inFrame(srcs[i])) {
+                return this->fail(Kind::SlotOutOfBounds);
+            }
+            if (!this->at(srcs[i]).isNonNull()) {
+                return this->fail(Kind::TypeMismatch);
+            }
+            this->at(srcs[i]) = SlotType::of(nullptr);
+        }
+        return {};
+    }
+    default:
+        return this->fail(Kind::InvalidOperation);
+    }
+}
+
+Result<void, BytecodeVerifyError> Verifier::run() noexcept {
+    if (this->bytecode_ == nullptr || this->bytecodeCount_ == 0) {
+        return this->fail(BytecodeVerifyErrorKind::FallsOffEnd);
+    }
+
+    for (uint16_t i = 0; i < this->scriptInfo_->unwindLen; i++) {
+        const int16_t slot = this->scriptInfo_->unwindSlots[i];
+        if (slot < 0 || !this->inFrame(static_cast<uint64_t>(slot))) {
+            this->pos_ = this->bytecodeCount_;
+            return this->fail(BytecodeVerifyErrorKind::SlotOutOfBounds);
+        }
+    }
+
+    if (auto res = this->decode(); res.hasErr()) {
+        return res;
+    }
+    if (auto res = this->setEntryState(); res.hasErr()) {
+        return res;
+    }
+    if (auto res = this->mergeInto(0); res.hasErr()) {
+        return res;
+    }
+
+    while (this->worklist_.len() > 0) {
+        const size_t leader = this->worklist_[this->worklist_.len() - 1];
+        this->worklist_.removeAt(this->worklist_.len() - 1);
+        if (auto res = this->walkBlock(leader); res.hasErr()) {
+            return res;
+        }
+    }
+    return {};
+}
+} // namespace
+
+Result<void, BytecodeVerifyError> sy::verifyScriptFunction(const RawFunction* function) noexcept {
+    sy_assert(function->tag == FunctionType::Script, "Can only verify script functions");
+    const InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<const InterpreterFunctionScriptInfo*>(function->fptr);
+    sy_assert(scriptInfo != nullptr, "Script function has no script info");
+
+    Verifier verifier(function, scriptInfo);
+    return verifier.run();
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include "../testing/script_function.hpp"
+#include "function_builder.hpp"
+
+using namespace sy::testing;
+
+namespace {
+BytecodeVerifyError expectError(const TestScriptFunction& fn) {
+    auto res = verifyScriptFunction(&fn.function);
+    REQUIRE(res.hasErr());
+    return res.takeErr();
+}
+} // namespace
+
+TEST_CASE("[verifyScriptFunction] accepts loop, before and after fusion") {
+    auto loadDefault = makeOperands<operators::LoadDefault>();
+    loadDefault.isScalar = true;
+    loadDefault.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+    loadDefault.dst = 4;
+
+    // sum = 0; for (i = 0; i < 10; i += 1) { sum += i; } return sum;
+    const Bytecode bytecode[] = {
+        loadImmediate(ScalarTag::I32, 0, 0),
+        setScalarType(ScalarTag::I32, 0),
+        loadImmediate(ScalarTag::I32, 1, 10),
+        setScalarType(ScalarTag::I32, 1),
+        loadImmediate(ScalarTag::I32, 3, 1),
+        setScalarType(ScalarTag::I32, 3),
+        Bytecode(loadDefault),
+        setScalarType(ScalarTag::I32, 4),
+        setScalarType(ScalarTag::Bool, 2),
+        binaryScalarOp<operators::Less>(ScalarTag::I32, 2, 0, 1), // loop header
+        jumpIfFalse(2, 4),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 4, 4, 0),
+        binaryScalarOp<operators::Add>(ScalarTag::I32, 0, 0, 3),
+        jump(-4),
+        returnValue(4),
+    };
+    constexpr size_t bytecodeCount = sizeof(bytecode) / sizeof(Bytecode);
+
+    FunctionBuilder builder(Allocator{});
+    CHECK(builder.pushBytecode(bytecode, bytecodeCount));
+    CHECK(builder.fuseSuperinstructions());
+
+    TestScriptFunction unfused(bytecode, bytecodeCount, 6, Reflect<int32_t>::get());
+    TestScriptFunction fused(builder.bytecode.data(), builder.bytecode.len(), 6,
+                             Reflect<int32_t>::get());
+    CHECK(verifyScriptFunction(&unfused.function));
+    CHECK(verifyScriptFunction(&fused.function));
+}
+
+TEST_CASE("[verifyScriptFunction] rejects slots outside of the frame") {
+    SUBCASE("operand") {
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 2, 1),
+                                     setScalarType(ScalarTag::I32, 0), returnValue(0)};
+        TestScriptFunction fn(bytecode, 3, 2, Reflect<int32_t>::get());
+        const BytecodeVerifyError err = expectError(fn);
+        CHECK_EQ(err.kind, BytecodeVerifyErrorKind::SlotOutOfBounds);
+        CHECK_EQ(err.position, 0);
+    }
+    SUBCASE("member") {
+        auto getMember = makeOperands<operators::GetMember>();
+        getMember.isScalar = true;
+        getMember.scalarTag = static_cast<uint64_t>(ScalarTag::U32);
+        getMember.dst = 0;
+        getMember.src = 1;
+        getMember.memberOffset = 6;
+
+        const Bytecode bytecode[] = {Bytecode(getMember), setScalarType(ScalarTag::U32, 0),
+                                     returnValue(0)};
+        TestScriptFunction fn(bytecode, 3, 2, Reflect<uint32_t>::get());
+        CHECK_EQ(expectError(fn).kind, BytecodeVerifyErrorKind::SlotOutOfBounds);
+    }
+}
+
+TEST_CASE("[verifyScriptFunction] rejects invalid jump targets") {
+    SUBCASE("past the end") {
+        const Bytecode bytecode[] = {jump(2), Bytecode(makeOperands<operators::Return>())};
+        TestScriptFunction fn(bytecode, 2, 2, nullptr);
+        CHECK_EQ(expectError(fn).kind, BytecodeVerifyErrorKind::InvalidJumpTarget);
+    }
+    SUBCASE("within an operation") {
+        // 64 bit immediates are 3 wide
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::I64, 0, 0), Bytecode(), Bytecode(),
+                                    jump(-2)};
+        TestScriptFunction fn(bytecode, 4, 2, nullptr);
+        const BytecodeVerifyError err = expectError(fn);
+        CHECK_EQ(err.kind, BytecodeVerifyErrorKind::InvalidJumpTarget);
+        CHECK_EQ(err.position, 3);
+    }
+}
+
+TEST_CASE("[verifyScriptFunction] types must match on every path") {
+    const Type* argsTypes[1] = {Reflect<bool>::get()};
+
+    // if (arg) { slot1: bool } else { slot1: ? }; if (slot1) {}
+    Bytecode bytecode[] = {jumpIfFalse(0, 3),
+                           setScalarType(ScalarTag::Bool, 1),
+                           jump(2),
+                           setScalarType(ScalarTag::I32, 1),
+                           jumpIfFalse(1, 1),
+                           Bytecode(makeOperands<operators::Return>())};
+    TestScriptFunction fn(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2, nullptr);
+    fn.function.argsTypes = argsTypes;
+    fn.function.argsLen = 1;
+
+    const BytecodeVerifyError err = expectError(fn);
+    CHECK_EQ(err.kind, BytecodeVerifyErrorKind::TypeMismatch);
+    CHECK_EQ(err.position, 4);
+
+    bytecode[3] = setScalarType(ScalarTag::Bool, 1);
+    CHECK(verifyScriptFunction(&fn.function));
+
+    // Without the argument, it's type is unknown.
+    fn.function.argsTypes = nullptr;
+    fn.function.argsLen = 0;
+    CHECK_EQ(expectError(fn).position, 0);
+}
+
+TEST_CASE("[verifyScriptFunction] rejects mismatched returns") {
+    SUBCASE("falls off the end") {
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 1),
+                                     setScalarType(ScalarTag::I32, 0)};
+        TestScriptFunction fn(bytecode, 2, 2, Reflect<int32_t>::get());
+        const BytecodeVerifyError err = expectError(fn);
+        CHECK_EQ(err.kind, BytecodeVerifyErrorKind::FallsOffEnd);
+        CHECK_EQ(err.position, 1);
+    }
+    SUBCASE("wrong type") {
+        const Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 1),
+                                     setScalarType(ScalarTag::I32, 0), returnValue(0)};
+        TestScriptFunction fn(bytecode, 3, 2, Reflect<bool>::get());
+        CHECK_EQ(expectError(fn).kind, BytecodeVerifyErrorKind::TypeMismatch);
+    }
+    SUBCASE("missing value") {
+        const Bytecode bytecode[] = {Bytecode(makeOperands<operators::Return>())};
+        TestScriptFunction fn(bytecode, 1, 2, Reflect<int32_t>::get());
+        CHECK_EQ(expectError(fn).kind, BytecodeVerifyErrorKind::InvalidCall);
+    }
+}
+
+TEST_CASE("[verifyScriptFunction] checks call signatures") {
+    const Bytecode calleeBytecode[] = {loadImmediate(ScalarTag::I32, 0, 7),
+                                       setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    TestScriptFunction callee(calleeBytecode, 3, 2, Reflect<int32_t>::get());
+    const Type* argsTypes[1] = {Reflect<int32_t>::get()};
+    callee.function.argsTypes = argsTypes;
+    callee.function.argsLen = 1;
+
+    auto call = makeOperands<operators::CallImmediateWithReturn>();
+    call.argCount = 1;
+    call.retDst = 1;
+    Bytecode calleePtr;
+    calleePtr.value = reinterpret_cast<uint64_t>(&callee.function);
+    Bytecode argsSrcs;
+    argsSrcs.value = 0;
+
+    Bytecode bytecode[] = {loadImmediate(ScalarTag::I32, 0, 1),
+                           setScalarType(ScalarTag::I32, 0),
+                           Bytecode(call),
+                           calleePtr,
+                           argsSrcs,
+                           setScalarType(ScalarTag::I32, 1),
+                           returnValue(1)};
+    TestScriptFunction caller(bytecode, sizeof(bytecode) / sizeof(Bytecode), 2,
+                              Reflect<int32_t>::get());
+    CHECK(verifyScriptFunction(&caller.function));
+
+    bytecode[1] = setScalarType(ScalarTag::U32, 0);
+    const BytecodeVerifyError err = expectError(caller);
+    CHECK_EQ(err.kind, BytecodeVerifyErrorKind::InvalidCall);
+    CHECK_EQ(err.position, 2);
+}
+
+TEST_CASE("[verifyScriptFunction] tail calls must return the caller's type") {
+    const Bytecode calleeBytecode[] = {loadImmediate(ScalarTag::I32, 0, 7),
+                                       setScalarType(ScalarTag::I32, 0), returnValue(0)};
+    TestScriptFunction callee(calleeBytecode, 3, 2, Reflect<int32_t>::get());
+
+    auto tailCall = makeOperands<operators::TailCallImmediate>();
+    tailCall.argCount = 0;
+    Bytecode calleePtr;
+    calleePtr.value = reinterpret_cast<uint64_t>(&callee.function);
+
+    // The tail call ends the block, so nothing needs to follow it.
+    const Bytecode bytecode[] = {Bytecode(tailCall), calleePtr};
+    TestScriptFunction caller(bytecode, 2, 2, Reflect<int32_t>::get());
+    CHECK(verifyScriptFunction(&caller.function));
+
+    TestScriptFunction mismatchedCaller(bytecode, 2, 2, Reflect<uint32_t>::get());
+    const BytecodeVerifyError err = expectError(mismatchedCaller);
+    CHECK_EQ(err.kind, BytecodeVerifyErrorKind::InvalidCall);
+    CHECK_EQ(err.position, 0);
+}
+
+#endif // SYNC_LIB_WITH_TESTS
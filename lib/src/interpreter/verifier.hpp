@@ -0,0 +1,56 @@
+#pragma once
+#ifndef SY_INTERPRETER_VERIFIER_HPP_
+#define SY_INTERPRETER_VERIFIER_HPP_
+
+#include "../core/core.h"
+#include "../types/result/result.hpp"
+
+namespace sy {
+struct RawFunction;
+struct Bytecode;
+
+enum class BytecodeVerifyErrorKind : int {
+    OutOfMemory,
+    /// Unknown opcode, an opcode the interpreter does not implement, or invalid operands such as an
+    /// out of range scalar tag.
+    InvalidOperation,
+    /// An operation extends past the end of the bytecode.
+    Truncated,
+    /// An operation accesses memory outside of the function's frame.
+    SlotOutOfBounds,
+    /// Jumps outside of the bytecode, or into the middle of an operation.
+    InvalidJumpTarget,
+    /// Execution can continue past the last operation without returning.
+    FallsOffEnd,
+    /// The type of a slot cannot be proven to be what the operation requires, on every path.
+    TypeMismatch,
+    /// A call or return does not match the signature of the function.
+    InvalidCall,
+};
+
+struct BytecodeVerifyError {
+    BytecodeVerifyErrorKind kind;
+    /// Bytecode index of the offending operation.
+    size_t position;
+};
+
+/// Checks everything about a single operation that doesn't depend on the frame, so that its
+/// width and operands can be safely decoded.
+[[nodiscard]] bool operandsValid(const Bytecode& op) noexcept;
+
+/// Proves that executing the bytecode of `function` cannot fail any of the interpreter's per
+/// operation checks. This covers frame slot bounds, jump targets, call signatures, and the types
+/// operations require, such as `JumpIfFalse` needing a `bool`.
+///
+/// Types are tracked per slot through every path of the bytecode. Argument slots start with the
+/// function's argument types, and all other slots start with an unknown type, as frames are not
+/// cleared when pushed. Scalar operations don't touch type info, so only their slot bounds are
+/// checked.
+///
+/// Operations the interpreter does not implement fail verification.
+/// @param function Must be a script function.
+[[nodiscard]] Result<void, BytecodeVerifyError>
+verifyScriptFunction(const RawFunction* function) noexcept;
+} // namespace sy
+
+#endif // SY_INTERPRETER_VERIFIER_HPP_
@@ -81,7 +81,7 @@ struct MemoryProtectedNode {
             if (remainder == 0) {
                 allocSize = minSize;
             } else {
-                allocSize = minSize + (minSize - remainder);
+                allocSize = minSize + (pageSize - remainder);
             }
         }
 
@@ -93,6 +93,8 @@ struct MemoryProtectedNode {
         MemoryProtectedNode self{};
         self.baseMem = newMem;
         self.size = allocSize;
+        // The node itself lives at the start of its memory.
+        self.offset = sizeof(MemoryProtectedNode);
         return self;
     }
 
@@ -103,7 +105,7 @@ struct MemoryProtectedNode {
             actualOffset += align - remainder;
         }
 
-        if ((size - offset) < len) {
+        if (actualOffset > size || (size - actualOffset) < len) {
             return Error(AllocErr::OutOfMemory);
         }
 
@@ -159,7 +161,7 @@ void* ProtectedAllocator::alloc(size_t len, size_t align) noexcept {
     std::scoped_lock _lock(mutex_);
 
     if (this->tail_ == nullptr) {
-        auto res = MemoryProtectedNode::init(len + sizeof(MemoryProtectedNode));
+        auto res = MemoryProtectedNode::init(len + align + sizeof(MemoryProtectedNode));
         if (res.hasErr()) {
             return nullptr;
         }
@@ -176,8 +178,8 @@ void* ProtectedAllocator::alloc(size_t len, size_t align) noexcept {
             return tryAllocRes.value();
         }
 
-        const size_t minSize = (tail->size * 2) < (len + sizeof(MemoryProtectedNode))
-                                   ? (len + sizeof(MemoryProtectedNode))
+        const size_t minSize = (tail->size * 2) < (len + align + sizeof(MemoryProtectedNode))
+                                   ? (len + align + sizeof(MemoryProtectedNode))
                                    : (tail->size * 2);
         auto newNodeRes = MemoryProtectedNode::init(minSize);
         if (newNodeRes.hasErr()) {
@@ -188,6 +190,7 @@ void* ProtectedAllocator::alloc(size_t len, size_t align) noexcept {
         newNode.prev = tail;
         MemoryProtectedNode* baseMem = reinterpret_cast<MemoryProtectedNode*>(newNode.baseMem);
         *baseMem = newNode;
+        this->tail_ = reinterpret_cast<void*>(baseMem);
         auto newAllocRes = baseMem->tryAlloc(len, align);
         sy_assert(newAllocRes.hasValue(), "This should not have failed");
         return newAllocRes.value();
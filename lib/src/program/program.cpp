@@ -1,16 +1,24 @@
 #include "program.h"
+#include "../compiler/lazy_function.hpp"
 #include "../core/core_internal.h"
+#include "../interpreter/profiler.hpp"
 #include "../types/function/function.hpp"
+#include "../types/type_info.hpp"
 #include "program.hpp"
 #include "program_error.h"
 #include "program_error.hpp"
 #include "program_internal.hpp"
+#include <algorithm>
+#include <string_view>
 
 using namespace sy;
 
 static_assert(sizeof(Program) == sizeof(SyProgram));
 static_assert(sizeof(SyProgramRuntimeErrorKind) == sizeof(int));
 static_assert(sizeof(CallStack) == sizeof(SyCallStack));
+static_assert(sizeof(ProfiledFunction) == sizeof(SyProfiledFunction));
+static_assert(sizeof(ProfiledCallSite) == sizeof(SyProfiledCallSite));
+static_assert(sizeof(ProfiledOpcode) == sizeof(SyProfiledOpcode));
 
 static_assert(SY_COMPILE_ERROR_NONE == 0);
 static_assert(static_cast<int>(CompileError::Unknown) == SY_COMPILE_ERROR_UNKNOWN);
@@ -52,6 +60,8 @@ static_assert(static_cast<int>(CompileError::CompileUnknownType) ==
               SY_COMPILE_ERROR_COMPILE_UNKNOWN_TYPE);
 static_assert(static_cast<int>(CompileError::BufferTooSmall) == SY_COMPILE_ERROR_BUFFER_TOO_SMALL);
 static_assert(static_cast<int>(CompileError::GenRefStale) == SY_COMPILE_ERROR_GEN_REF_STALE);
+static_assert(static_cast<int>(CompileError::BytecodeVerification) ==
+              SY_COMPILE_ERROR_BYTECODE_VERIFICATION);
 
 sy::CallStack::CallStack(const RawFunction* const* inFunctions, size_t inLen)
     : _functions(inFunctions), _len(inLen) {
@@ -79,6 +89,27 @@ sy::ProgramModule::getFunctionByQualifiedName(StringSlice qualifiedName) const n
     return self->getFunctionByQualifiedName(qualifiedName);
 }
 
+Slice<const RawFunction*>
+sy::ProgramModule::getFunctionsByUnqualifiedName(StringSlice unqualifiedName) const noexcept {
+    const ProgramModuleInternal* self =
+        reinterpret_cast<const ProgramModuleInternal*>(this->inner_);
+    return self->getFunctionsByUnqualifiedName(unqualifiedName);
+}
+
+Option<const Type*>
+sy::ProgramModule::getTypeByQualifiedName(StringSlice qualifiedName) const noexcept {
+    const ProgramModuleInternal* self =
+        reinterpret_cast<const ProgramModuleInternal*>(this->inner_);
+    return self->getTypeByQualifiedName(qualifiedName);
+}
+
+Slice<const Type*>
+sy::ProgramModule::getTypesByUnqualifiedName(StringSlice unqualifiedName) const noexcept {
+    const ProgramModuleInternal* self =
+        reinterpret_cast<const ProgramModuleInternal*>(this->inner_);
+    return self->getTypesByUnqualifiedName(unqualifiedName);
+}
+
 Option<const ProgramModule&> sy::Program::getModule(StringSlice name,
                                                     Option<SemVer> version) const noexcept {
     const ProgramInternal* self = reinterpret_cast<const ProgramInternal*>(this->inner_);
@@ -102,6 +133,123 @@ Option<const ProgramModule&> sy::Program::getModule(StringSlice name,
     }
 }
 
+bool sy::Program::setProfiling(bool enabled) noexcept {
+    ProgramInternal* self = reinterpret_cast<ProgramInternal*>(this->inner_);
+    if (self->profile == nullptr) {
+        return false;
+    }
+    self->profile->enabled.store(enabled, std::memory_order_release);
+    return true;
+}
+
+bool sy::Program::isProfiling() const noexcept {
+    const ProgramInternal* self = reinterpret_cast<const ProgramInternal*>(this->inner_);
+    return self->profile != nullptr && self->profile->enabled.load(std::memory_order_acquire);
+}
+
+void sy::Program::resetProfile() noexcept {
+    ProgramInternal* self = reinterpret_cast<ProgramInternal*>(this->inner_);
+    if (self->profile == nullptr) {
+        return;
+    }
+    self->profile->reset();
+    for (size_t i = 0; i < self->allModulesLen; i++) {
+        const ProgramModuleInternal* module =
+            *reinterpret_cast<const ProgramModuleInternal* const*>(&self->allModules[i]);
+        for (size_t j = 0; j < module->allFunctionsLen; j++) {
+            if (module->allFunctions[j].tag != FunctionType::Script) {
+                continue;
+            }
+            FunctionProfile* profile = module->allFunctionScriptInfo[j].profile;
+            if (profile != nullptr) {
+                profile->reset();
+            }
+        }
+    }
+}
+
+size_t sy::Program::profiledOpcodes(ProfiledOpcode* outOpcodes, size_t outLen) const noexcept {
+    const ProgramInternal* self = reinterpret_cast<const ProgramInternal*>(this->inner_);
+    if (self->profile == nullptr) {
+        return 0;
+    }
+    for (size_t i = 0; i < outLen && i < OPCODE_COUNT; i++) {
+        outOpcodes[i].name = opcodeName(static_cast<OpCode>(i));
+        outOpcodes[i].count = self->profile->opcodeCounts[i].load(std::memory_order_relaxed);
+    }
+    return OPCODE_COUNT;
+}
+
+/// @return The profile of `function` if it's a script function profiled by `self`, or null.
+static const FunctionProfile* profileOf(const ProgramInternal* self, const RawFunction* function) {
+    if (self->profile == nullptr || function->tag != FunctionType::Script) {
+        return nullptr;
+    }
+    const InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<const InterpreterFunctionScriptInfo*>(function->fptr);
+    if (scriptInfo->profile == nullptr || scriptInfo->profile->program() != self->profile) {
+        return nullptr;
+    }
+    return scriptInfo->profile;
+}
+
+Option<ProfiledFunction> sy::Program::profiledFunction(const RawFunction* function) const noexcept {
+    const ProgramInternal* self = reinterpret_cast<const ProgramInternal*>(this->inner_);
+    const FunctionProfile* profile = profileOf(self, function);
+    if (profile == nullptr) {
+        return {};
+    }
+    return profile->snapshot();
+}
+
+size_t sy::Program::profiledCallSites(const RawFunction* function, ProfiledCallSite* outSites,
+                                      size_t outLen) const noexcept {
+    const ProgramInternal* self = reinterpret_cast<const ProgramInternal*>(this->inner_);
+    const FunctionProfile* profile = profileOf(self, function);
+    if (profile == nullptr) {
+        return 0;
+    }
+    return profile->callSites(outSites, outLen);
+}
+
+extern "C" {
+SY_API bool sy_program_set_profiling(SyProgram* self, bool enabled) {
+    return reinterpret_cast<Program*>(self)->setProfiling(enabled);
+}
+
+SY_API bool sy_program_is_profiling(const SyProgram* self) {
+    return reinterpret_cast<const Program*>(self)->isProfiling();
+}
+
+SY_API void sy_program_reset_profile(SyProgram* self) {
+    reinterpret_cast<Program*>(self)->resetProfile();
+}
+
+SY_API size_t sy_program_profiled_opcodes(const SyProgram* self, SyProfiledOpcode* outOpcodes,
+                                          size_t outLen) {
+    return reinterpret_cast<const Program*>(self)->profiledOpcodes(
+        reinterpret_cast<ProfiledOpcode*>(outOpcodes), outLen);
+}
+
+SY_API bool sy_program_profiled_function(const SyProgram* self, const SyFunction* function,
+                                         SyProfiledFunction* outProfile) {
+    Option<ProfiledFunction> profile = reinterpret_cast<const Program*>(self)->profiledFunction(
+        reinterpret_cast<const RawFunction*>(function));
+    if (!profile.hasValue()) {
+        return false;
+    }
+    *reinterpret_cast<ProfiledFunction*>(outProfile) = profile.value();
+    return true;
+}
+
+SY_API size_t sy_program_profiled_call_sites(const SyProgram* self, const SyFunction* function,
+                                             SyProfiledCallSite* outSites, size_t outLen) {
+    return reinterpret_cast<const Program*>(self)->profiledCallSites(
+        reinterpret_cast<const RawFunction*>(function),
+        reinterpret_cast<ProfiledCallSite*>(outSites), outLen);
+}
+} // extern "C"
+
 Result<ProgramModuleInternal*, AllocErr>
 sy::ProgramModuleInternal::init(Allocator protAlloc, StringSlice name, SemVer version,
                                 size_t functionCount, size_t structCount) {
@@ -165,13 +313,228 @@ sy::ProgramModuleInternal::init(Allocator protAlloc, StringSlice name, SemVer ve
     return self;
 }
 
-Option<const RawFunction*>
-sy::ProgramModuleInternal::getFunctionByQualifiedName(StringSlice qualifiedName) const noexcept {
-    // TODO optimize this to use a map or something
-    for (size_t i = 0; i < this->allFunctionsLen; i++) {
-        if (this->allFunctionQualifiedNames[i].asSlice() == qualifiedName) {
-            return Option<const RawFunction*>(&this->allFunctions[i]);
+static std::string_view asView(StringSlice slice) { return {slice.data(), slice.len()}; }
+
+template <typename T>
+Result<void, AllocErr> sy::NameIndex<T>::build(Allocator protAlloc, const T* elements,
+                                               const String* qualifiedNames, const String* names,
+                                               size_t len) noexcept {
+    sy_assert(!this->built_, "Name index is already built");
+    sy_assert(len < UINT32_MAX, "Too many elements to index");
+    this->elements_ = elements;
+    this->qualifiedNames_ = qualifiedNames;
+    this->names_ = names;
+    this->len_ = len;
+    if (len == 0) {
+        this->built_ = true;
+        return {};
+    }
+
+    size_t slotsLen = 1;
+    while (slotsLen < len * 2) {
+        slotsLen *= 2;
+    }
+    auto slotsRes = protAlloc.allocArray<uint32_t>(slotsLen);
+    if (slotsRes.hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    uint32_t* slots = slotsRes.value();
+    for (size_t i = 0; i < slotsLen; i++) {
+        slots[i] = 0;
+    }
+    const size_t mask = slotsLen - 1;
+    for (size_t i = 0; i < len; i++) {
+        size_t slot = qualifiedNames[i].asSlice().hash() & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
         }
+        slots[slot] = static_cast<uint32_t>(i + 1);
     }
+
+    auto byNameRes = protAlloc.allocArray<const T*>(len);
+    if (byNameRes.hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    const T** byName = byNameRes.value();
+    for (size_t i = 0; i < len; i++) {
+        byName[i] = &elements[i];
+    }
+    std::sort(byName, byName + len, [elements, names](const T* lhs, const T* rhs) {
+        return asView(names[lhs - elements].asSlice()) < asView(names[rhs - elements].asSlice());
+    });
+
+    this->slots_ = slots;
+    this->slotsMask_ = mask;
+    this->byName_ = byName;
+    this->built_ = true;
     return {};
 }
+
+template <typename T>
+Option<const T*> sy::NameIndex<T>::findQualified(StringSlice qualifiedName) const noexcept {
+    sy_assert(this->built_, "Name index must be built before lookups");
+    if (this->len_ == 0) {
+        return {};
+    }
+    size_t slot = qualifiedName.hash() & this->slotsMask_;
+    for (uint32_t entry = this->slots_[slot]; entry != 0; entry = this->slots_[slot]) {
+        if (this->qualifiedNames_[entry - 1].asSlice() == qualifiedName) {
+            return Option<const T*>(&this->elements_[entry - 1]);
+        }
+        slot = (slot + 1) & this->slotsMask_;
+    }
+    return {};
+}
+
+template <typename T>
+Slice<const T*> sy::NameIndex<T>::findUnqualified(StringSlice name) const noexcept {
+    sy_assert(this->built_, "Name index must be built before lookups");
+    const T* const* begin = this->byName_;
+    const T* const* end = this->byName_ + this->len_;
+    const std::string_view view = asView(name);
+    auto nameOf = [this](const T* element) {
+        return asView(this->names_[element - this->elements_].asSlice());
+    };
+    const T* const* first = std::lower_bound(
+        begin, end, view, [&nameOf](const T* element, std::string_view value) {
+            return nameOf(element) < value;
+        });
+    const T* const* last = std::upper_bound(
+        first, end, view, [&nameOf](std::string_view value, const T* element) {
+            return value < nameOf(element);
+        });
+    return Slice<const T*>(first, static_cast<size_t>(last - first));
+}
+
+template class sy::NameIndex<RawFunction>;
+template class sy::NameIndex<Type>;
+
+Result<void, AllocErr> sy::ProgramModuleInternal::buildLookupIndex(Allocator protAlloc) noexcept {
+    if (auto res = this->functionIndex.build(protAlloc, this->allFunctions,
+                                             this->allFunctionQualifiedNames,
+                                             this->allFunctionNames, this->allFunctionsLen);
+        res.hasErr()) {
+        return res;
+    }
+    return this->typeIndex.build(protAlloc, this->allTypes, this->allTypeQualifiedNames,
+                                 this->allTypeNames, this->allTypesLen);
+}
+
+Option<const RawFunction*>
+sy::ProgramModuleInternal::getFunctionByQualifiedName(StringSlice qualifiedName) const noexcept {
+    auto found = this->functionIndex.findQualified(qualifiedName);
+    if (found.hasValue()) {
+        ensureFunctionCompiled(found.value());
+    }
+    return found;
+}
+
+Slice<const RawFunction*>
+sy::ProgramModuleInternal::getFunctionsByUnqualifiedName(StringSlice name) const noexcept {
+    const Slice<const RawFunction*> found = this->functionIndex.findUnqualified(name);
+    for (const RawFunction* function : found) {
+        ensureFunctionCompiled(function);
+    }
+    return found;
+}
+
+Option<const Type*>
+sy::ProgramModuleInternal::getTypeByQualifiedName(StringSlice qualifiedName) const noexcept {
+    return this->typeIndex.findQualified(qualifiedName);
+}
+
+Slice<const Type*>
+sy::ProgramModuleInternal::getTypesByUnqualifiedName(StringSlice name) const noexcept {
+    return this->typeIndex.findUnqualified(name);
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include <string>
+
+namespace {
+void setNames(String* qualifiedNames, String* names, size_t index, StringSlice qualifiedName,
+              StringSlice name, Allocator protAlloc) {
+    new (&qualifiedNames[index]) String(String::init(qualifiedName, protAlloc).takeValue());
+    new (&names[index]) String(String::init(name, protAlloc).takeValue());
+}
+} // namespace
+
+TEST_CASE("[ProgramModuleInternal] finds functions by qualified name") {
+    ProgramInternal program{};
+    Allocator protAlloc = program.protAlloc.asAllocator();
+    constexpr size_t FUNCTIONS = 100;
+    ProgramModuleInternal* module =
+        ProgramModuleInternal::init(protAlloc, "math", SemVer{}, FUNCTIONS, 0).value();
+    for (size_t i = 0; i < FUNCTIONS; i++) {
+        const std::string name = "func" + std::to_string(i);
+        const std::string qualifiedName = "math." + name;
+        setNames(module->allFunctionQualifiedNames, module->allFunctionNames, i,
+                 StringSlice(qualifiedName.data(), qualifiedName.size()),
+                 StringSlice(name.data(), name.size()), protAlloc);
+        new (&module->allFunctions[i]) RawFunction();
+        module->allFunctions[i].tag = FunctionType::C;
+    }
+    REQUIRE(module->buildLookupIndex(protAlloc));
+
+    for (size_t i = 0; i < FUNCTIONS; i++) {
+        const std::string qualifiedName = "math.func" + std::to_string(i);
+        auto found = module->getFunctionByQualifiedName(
+            StringSlice(qualifiedName.data(), qualifiedName.size()));
+        REQUIRE(found.hasValue());
+        CHECK_EQ(found.value(), &module->allFunctions[i]);
+    }
+    CHECK_FALSE(module->getFunctionByQualifiedName("math.func100").hasValue());
+    CHECK_FALSE(module->getFunctionByQualifiedName("func0").hasValue());
+    CHECK_FALSE(module->getFunctionByQualifiedName("").hasValue());
+}
+
+TEST_CASE("[ProgramModuleInternal] finds all functions and types sharing an unqualified name") {
+    ProgramInternal program{};
+    Allocator protAlloc = program.protAlloc.asAllocator();
+    ProgramModuleInternal* module =
+        ProgramModuleInternal::init(protAlloc, "shapes", SemVer{}, 4, 3).value();
+    setNames(module->allFunctionQualifiedNames, module->allFunctionNames, 0, "shapes.circle.area",
+             "area", protAlloc);
+    setNames(module->allFunctionQualifiedNames, module->allFunctionNames, 1, "shapes.perimeter",
+             "perimeter", protAlloc);
+    setNames(module->allFunctionQualifiedNames, module->allFunctionNames, 2, "shapes.square.area",
+             "area", protAlloc);
+    setNames(module->allFunctionQualifiedNames, module->allFunctionNames, 3, "shapes.area", "area",
+             protAlloc);
+    for (size_t i = 0; i < 4; i++) {
+        new (&module->allFunctions[i]) RawFunction();
+        module->allFunctions[i].tag = FunctionType::C;
+    }
+    setNames(module->allTypeQualifiedNames, module->allTypeNames, 0, "shapes.circle.Point",
+             "Point", protAlloc);
+    setNames(module->allTypeQualifiedNames, module->allTypeNames, 1, "shapes.Circle", "Circle",
+             protAlloc);
+    setNames(module->allTypeQualifiedNames, module->allTypeNames, 2, "shapes.Point", "Point",
+             protAlloc);
+    REQUIRE(module->buildLookupIndex(protAlloc));
+
+    Slice<const RawFunction*> areas = module->getFunctionsByUnqualifiedName("area");
+    REQUIRE_EQ(areas.len(), 3);
+    bool foundArea[4] = {false, false, false, false};
+    for (const RawFunction* function : areas) {
+        foundArea[function - module->allFunctions] = true;
+    }
+    CHECK(foundArea[0]);
+    CHECK_FALSE(foundArea[1]);
+    CHECK(foundArea[2]);
+    CHECK(foundArea[3]);
+    CHECK_EQ(module->getFunctionsByUnqualifiedName("perimeter").len(), 1);
+    CHECK_EQ(module->getFunctionsByUnqualifiedName("volume").len(), 0);
+
+    auto circle = module->getTypeByQualifiedName("shapes.Circle");
+    REQUIRE(circle.hasValue());
+    CHECK_EQ(circle.value(), &module->allTypes[1]);
+    CHECK_FALSE(module->getTypeByQualifiedName("Circle").hasValue());
+    CHECK_EQ(module->getTypesByUnqualifiedName("Point").len(), 2);
+    CHECK_EQ(module->getTypesByUnqualifiedName("Circle").len(), 1);
+    CHECK_EQ(module->getTypesByUnqualifiedName("Square").len(), 0);
+}
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -28,4 +28,62 @@ typedef struct SyCallStack {
     size_t len;
 } SyCallStack;
 
+/// Profile of a script function. See `sy_program_set_profiling`.
+typedef struct SyProfiledFunction {
+    uint64_t calls;
+    /// Operations interpreted within the function, and everything it called.
+    uint64_t inclusiveInstructions;
+    /// Operations interpreted within the function itself.
+    uint64_t exclusiveInstructions;
+    uint64_t inclusiveNanos;
+    uint64_t exclusiveNanos;
+} SyProfiledFunction;
+
+/// Call count of a call operation within a script function.
+typedef struct SyProfiledCallSite {
+    /// Bytecode index of the call operation within its function.
+    uint32_t bytecodeOffset;
+    uint64_t calls;
+} SyProfiledCallSite;
+
+/// Amount of times an operation has been interpreted.
+typedef struct SyProfiledOpcode {
+    const char* name;
+    uint64_t count;
+} SyProfiledOpcode;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Starts or stops recording the profile of `self`. Profiles are only recorded if the library is
+/// built with `SYNC_INTERPRETER_PROFILER`.
+/// @return `true` if profiling is supported, otherwise `false`.
+SY_API bool sy_program_set_profiling(SyProgram* self, bool enabled);
+
+SY_API bool sy_program_is_profiling(const SyProgram* self);
+
+/// Zeroes all recorded opcode, function, and call site counts of `self`.
+SY_API void sy_program_reset_profile(SyProgram* self);
+
+/// Copies up to `outLen` opcode counts into `outOpcodes`.
+/// @return The amount of opcodes, or 0 if profiling is not supported.
+SY_API size_t sy_program_profiled_opcodes(const SyProgram* self, SyProfiledOpcode* outOpcodes,
+                                          size_t outLen);
+
+/// @return `true` if `function` is a profiled script function of `self`, writing its profile to
+/// `outProfile`, otherwise `false`.
+SY_API bool sy_program_profiled_function(const SyProgram* self, const struct SyFunction* function,
+                                         SyProfiledFunction* outProfile);
+
+/// Copies up to `outLen` call sites of `function` into `outSites`, in bytecode order.
+/// @return The amount of call sites within `function`, or 0 if it's not profiled.
+SY_API size_t sy_program_profiled_call_sites(const SyProgram* self,
+                                             const struct SyFunction* function,
+                                             SyProfiledCallSite* outSites, size_t outLen);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
 #endif // _SY_PROGRAM_PROGRAM_H_
\ No newline at end of file
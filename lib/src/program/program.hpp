@@ -11,6 +11,7 @@
 
 namespace sy {
 class RawFunction;
+class Type;
 
 class CallStack {
   public:
@@ -23,20 +24,51 @@ class CallStack {
     size_t _len;
 };
 
+/// Profile of a script function. See `Program::setProfiling(...)`.
+struct ProfiledFunction {
+    uint64_t calls = 0;
+    /// Operations interpreted within the function, and everything it called.
+    uint64_t inclusiveInstructions = 0;
+    /// Operations interpreted within the function itself.
+    uint64_t exclusiveInstructions = 0;
+    uint64_t inclusiveNanos = 0;
+    uint64_t exclusiveNanos = 0;
+};
+
+/// Call count of a call operation within a script function.
+struct ProfiledCallSite {
+    /// Bytecode index of the call operation within its function.
+    uint32_t bytecodeOffset = 0;
+    uint64_t calls = 0;
+};
+
+/// Amount of times an operation has been interpreted.
+struct ProfiledOpcode {
+    const char* name = nullptr;
+    uint64_t count = 0;
+};
+
 class SY_API ProgramModule final {
   public:
     // module name and version
     ModuleVersion moduleInfo() const noexcept;
 
-    // get function(s) by unqualified name
-    // Option<Slice<const Function*>> getFunctionsByUnqualifiedName(StringSlice unqualifiedName) const noexcept;
+    /// @brief Gets all functions named `unqualifiedName`, within any namespace of the module.
+    /// @return The functions in no particular order, or an empty slice if there are none. Valid for
+    /// as long as the program.
+    Slice<const RawFunction*>
+    getFunctionsByUnqualifiedName(StringSlice unqualifiedName) const noexcept;
 
-    // get function (singular) by fully qualified name
+    /// @brief Gets a function by its fully qualified name, such as `example.func`.
     Option<const RawFunction*> getFunctionByQualifiedName(StringSlice qualifiedName) const noexcept;
 
-    // get type(s) by unqualified name
+    /// @brief Gets all types named `unqualifiedName`, within any namespace of the module.
+    /// @return The types in no particular order, or an empty slice if there are none. Valid for as
+    /// long as the program.
+    Slice<const Type*> getTypesByUnqualifiedName(StringSlice unqualifiedName) const noexcept;
 
-    // get type (singular) by fully qualified name
+    /// @brief Gets a type by its fully qualified name.
+    Option<const Type*> getTypeByQualifiedName(StringSlice qualifiedName) const noexcept;
 
     // globals too?
 
@@ -55,6 +87,30 @@ class SY_API Program final {
     /// @return The found module, or none.
     Option<const ProgramModule&> getModule(StringSlice name, Option<SemVer> version) const noexcept;
 
+    /// @brief Starts or stops recording how many operations are interpreted, and how many
+    /// instructions, calls, and how much time each script function takes. Profiles are only
+    /// recorded if the library is built with `SYNC_INTERPRETER_PROFILER`.
+    /// @return `true` if profiling is supported, otherwise `false`.
+    bool setProfiling(bool enabled) noexcept;
+
+    bool isProfiling() const noexcept;
+
+    /// @brief Zeroes all recorded opcode, function, and call site counts.
+    void resetProfile() noexcept;
+
+    /// @brief Copies up to `outLen` opcode counts into `outOpcodes`.
+    /// @return The amount of opcodes, or 0 if profiling is not supported.
+    size_t profiledOpcodes(ProfiledOpcode* outOpcodes, size_t outLen) const noexcept;
+
+    /// @return The profile of `function`, or none if it is not a profiled script function of this
+    /// program.
+    Option<ProfiledFunction> profiledFunction(const RawFunction* function) const noexcept;
+
+    /// @brief Copies up to `outLen` call sites of `function` into `outSites`, in bytecode order.
+    /// @return The amount of call sites within `function`, or 0 if it's not profiled.
+    size_t profiledCallSites(const RawFunction* function, ProfiledCallSite* outSites,
+                             size_t outLen) const noexcept;
+
   private:
     void* inner_;
 };
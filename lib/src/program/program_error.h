@@ -28,6 +28,17 @@ enum SyCompileError {
     SY_COMPILE_ERROR_COMPILE_UNKNOWN_TYPE = 20,
     SY_COMPILE_ERROR_BUFFER_TOO_SMALL = 21,
     SY_COMPILE_ERROR_GEN_REF_STALE = 22,
+    SY_COMPILE_ERROR_BYTECODE_VERIFICATION = 23,
+};
+
+enum SyProgramImageError {
+    /// This NONE variant means no error happened.
+    SY_PROGRAM_IMAGE_ERROR_NONE = 0,
+    SY_PROGRAM_IMAGE_ERROR_OUT_OF_MEMORY = 1,
+    SY_PROGRAM_IMAGE_ERROR_IO = 2,
+    SY_PROGRAM_IMAGE_ERROR_INVALID_IMAGE = 3,
+    SY_PROGRAM_IMAGE_ERROR_UNSUPPORTED_VERSION = 4,
+    SY_PROGRAM_IMAGE_ERROR_UNSERIALIZABLE = 5,
 };
 
 #endif // SY_PROGRAM_PROGRAM_ERROR_H_
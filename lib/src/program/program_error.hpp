@@ -51,6 +51,20 @@ enum class CompileError : int {
     CompileUnknownType = 20,
     BufferTooSmall = 21,
     GenRefStale = 22,
+    BytecodeVerification = 23,
+};
+
+/// Errors of writing and loading a `ProgramImage`.
+enum class ProgramImageError : int {
+    OutOfMemory = 1,
+    /// The file couldn't be opened, read, written, or mapped.
+    Io = 2,
+    /// The file isn't a program image, or is truncated or malformed.
+    InvalidImage = 3,
+    /// The image was written by a different version of the format, or for a different platform.
+    UnsupportedVersion = 4,
+    /// The program references something that can't be written to an image, such as C functions.
+    Unserializable = 5,
 };
 
 using CompileErrorReporter = void (*)(CompileError errKind, const SourceFileLocation& where,
@@ -0,0 +1,1452 @@
+#include "program_image.hpp"
+#include "../compiler/lazy_function.hpp"
+#include "../core/core_internal.h"
+#include "../interpreter/bytecode.hpp"
+#include "../interpreter/call_site_cache.hpp"
+#include "../interpreter/jit.hpp"
+#include "../interpreter/stack/stack.hpp"
+#include "../interpreter/verifier.hpp"
+#include "../types/function/function.hpp"
+#include "program_image.h"
+#include "program_image_internal.hpp"
+#include "program_internal.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <thread>
+
+#if defined(__EMSCRIPTEN__) || defined(SYNC_NO_PAGES)
+// Without pages to map, images are read into memory instead.
+#define SY_PROGRAM_IMAGE_MMAP 0
+#elif defined(_MSC_VER) || defined(_WIN32)
+#define SY_PROGRAM_IMAGE_MMAP 1
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+// clang-format off
+#include <windows.h>
+// clang-format on
+#elif defined(__APPLE__) || defined(__GNUC__)
+#define SY_PROGRAM_IMAGE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace sy;
+
+static_assert(sizeof(ProgramImage) == sizeof(SyProgramImage));
+
+static_assert(static_cast<int>(ProgramImageError::OutOfMemory) ==
+              SY_PROGRAM_IMAGE_ERROR_OUT_OF_MEMORY);
+static_assert(static_cast<int>(ProgramImageError::Io) == SY_PROGRAM_IMAGE_ERROR_IO);
+static_assert(static_cast<int>(ProgramImageError::InvalidImage) ==
+              SY_PROGRAM_IMAGE_ERROR_INVALID_IMAGE);
+static_assert(static_cast<int>(ProgramImageError::UnsupportedVersion) ==
+              SY_PROGRAM_IMAGE_ERROR_UNSUPPORTED_VERSION);
+static_assert(static_cast<int>(ProgramImageError::Unserializable) ==
+              SY_PROGRAM_IMAGE_ERROR_UNSERIALIZABLE);
+
+// Image layout. Every section starts at an offset aligned to `IMAGE_SECTION_ALIGN`, so once the
+// file is mapped, each section can be used in place.
+//
+// | header | modules | functions | argument types | relocations | bytecode | unwind | strings |
+//
+// Pointers are stored as indices. Type references are 0 for no type, otherwise 1 + the index of a
+// built-in type within `IMAGE_BUILTIN_TYPES`.
+
+static constexpr char IMAGE_MAGIC[8] = {'S', 'Y', 'I', 'M', 'A', 'G', 'E', '\0'};
+/// Must be incremented whenever the layout, `IMAGE_BUILTIN_TYPES`, or the bytecode encoding
+/// changes.
+static constexpr uint32_t IMAGE_FORMAT_VERSION = 1;
+/// Written in native byte order, so a mismatch means the image was written on another platform.
+static constexpr uint32_t IMAGE_BYTE_ORDER_MARK = 0x01020304;
+static constexpr uint64_t IMAGE_SECTION_ALIGN = 8;
+static constexpr uint32_t IMAGE_NO_TYPE = 0;
+
+namespace {
+struct ImageSection {
+    uint64_t offset;
+    /// Amount of elements, not bytes.
+    uint64_t len;
+};
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t byteOrderMark;
+    uint32_t pointerSize;
+    uint32_t bytecodeSize;
+    uint64_t fileSize;
+    ImageSection modules;
+    ImageSection functions;
+    ImageSection argTypes;
+    ImageSection relocations;
+    ImageSection bytecode;
+    ImageSection unwindSlots;
+    ImageSection strings;
+};
+
+/// Range of bytes within the strings section.
+struct ImageString {
+    uint64_t offset;
+    uint64_t len;
+};
+
+struct ImageModuleEntry {
+    ImageString name;
+    uint32_t major;
+    uint32_t minor;
+    uint32_t patch;
+    uint32_t reserved;
+    uint64_t firstFunction;
+    uint64_t functionsLen;
+};
+
+struct ImageFunctionEntry {
+    ImageString name;
+    ImageString qualifiedName;
+    uint64_t firstArgType;
+    uint64_t bytecodeStart;
+    uint64_t bytecodeCount;
+    uint64_t unwindStart;
+    uint64_t firstRelocation;
+    uint64_t relocationsLen;
+    uint32_t returnType;
+    uint32_t callSiteCachesLen;
+    uint16_t argsLen;
+    uint16_t alignment;
+    uint16_t stackSpaceRequired;
+    uint16_t unwindLen;
+    uint8_t comptimeSafe;
+    uint8_t reserved[7];
+};
+
+static_assert(sizeof(ImageHeader) % IMAGE_SECTION_ALIGN == 0);
+static_assert(sizeof(ImageModuleEntry) % IMAGE_SECTION_ALIGN == 0);
+static_assert(sizeof(ImageFunctionEntry) % IMAGE_SECTION_ALIGN == 0);
+static_assert(sizeof(ImageRelocation) % IMAGE_SECTION_ALIGN == 0);
+
+struct ImageMapping {
+    uint8_t* base = nullptr;
+    size_t size = 0;
+};
+
+/// Everything owned by a loaded `ProgramImage`.
+struct ProgramImageInternal {
+    Program program{};
+    ProgramInternal* programInternal = nullptr;
+    ImageMapping mapping{};
+    ImageFunction* functions = nullptr;
+    size_t functionsLen = 0;
+    CallSiteCache* callSiteCaches = nullptr;
+    size_t callSiteCachesLen = 0;
+    /// Of each function, in the same order as `functions`.
+    JitFunctionState* jitStates = nullptr;
+    size_t jitStatesLen = 0;
+};
+} // namespace
+
+static const Type* const IMAGE_BUILTIN_TYPES[] = {
+    &internal::TYPE_BOOL, &internal::TYPE_BOOL_CONST_REF, &internal::TYPE_BOOL_MUT_REF,
+    &internal::TYPE_I8, &internal::TYPE_I8_CONST_REF, &internal::TYPE_I8_MUT_REF,
+    &internal::TYPE_I16, &internal::TYPE_I16_CONST_REF, &internal::TYPE_I16_MUT_REF,
+    &internal::TYPE_I32, &internal::TYPE_I32_CONST_REF, &internal::TYPE_I32_MUT_REF,
+    &internal::TYPE_I64, &internal::TYPE_I64_CONST_REF, &internal::TYPE_I64_MUT_REF,
+    &internal::TYPE_U8, &internal::TYPE_U8_CONST_REF, &internal::TYPE_U8_MUT_REF,
+    &internal::TYPE_U16, &internal::TYPE_U16_CONST_REF, &internal::TYPE_U16_MUT_REF,
+    &internal::TYPE_U32, &internal::TYPE_U32_CONST_REF, &internal::TYPE_U32_MUT_REF,
+    &internal::TYPE_U64, &internal::TYPE_U64_CONST_REF, &internal::TYPE_U64_MUT_REF,
+    &internal::TYPE_USIZE, &internal::TYPE_USIZE_CONST_REF, &internal::TYPE_USIZE_MUT_REF,
+    &internal::TYPE_F32, &internal::TYPE_F32_CONST_REF, &internal::TYPE_F32_MUT_REF,
+    &internal::TYPE_F64, &internal::TYPE_F64_CONST_REF, &internal::TYPE_F64_MUT_REF,
+    &internal::TYPE_ORDERING, &internal::TYPE_ORDERING_CONST_REF, &internal::TYPE_ORDERING_MUT_REF,
+    &internal::TYPE_STRING_SLICE,
+    &internal::TYPE_STRING_SLICE_CONST_REF,
+    &internal::TYPE_STRING_SLICE_MUT_REF,
+    &internal::TYPE_STRING, &internal::TYPE_STRING_CONST_REF, &internal::TYPE_STRING_MUT_REF,
+    &internal::TYPE_OPAQUE_PTR,
+};
+
+static constexpr uint32_t IMAGE_BUILTIN_TYPES_LEN =
+    static_cast<uint32_t>(sizeof(IMAGE_BUILTIN_TYPES) / sizeof(IMAGE_BUILTIN_TYPES[0]));
+
+/// @return The built-in type at `index` within `IMAGE_BUILTIN_TYPES`.
+static const Type* imageBuiltinType(uint32_t index) {
+    sy_assert(index < IMAGE_BUILTIN_TYPES_LEN, "Built-in type index out of bounds");
+    return IMAGE_BUILTIN_TYPES[index];
+}
+
+/// @return `true` if `type` is null or a built-in type, storing its reference in `outRef`.
+static bool imageTypeRef(const Type* type, uint32_t& outRef) {
+    if (type == nullptr) {
+        outRef = IMAGE_NO_TYPE;
+        return true;
+    }
+    for (uint32_t i = 0; i < IMAGE_BUILTIN_TYPES_LEN; i++) {
+        if (IMAGE_BUILTIN_TYPES[i] == type) {
+            outRef = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const Type* imageTypeOf(uint32_t ref) {
+    if (ref == IMAGE_NO_TYPE) {
+        return nullptr;
+    }
+    return imageBuiltinType(ref - 1);
+}
+
+static uint64_t alignToSection(uint64_t offset) {
+    return (offset + (IMAGE_SECTION_ALIGN - 1)) & ~(IMAGE_SECTION_ALIGN - 1);
+}
+
+static const ProgramModuleInternal* moduleAt(const ProgramInternal* program, size_t index) {
+    return *reinterpret_cast<const ProgramModuleInternal* const*>(&program->allModules[index]);
+}
+
+/// @return `true` if `op` is followed by a pointer operand, storing what it points to in
+/// `outKind`.
+static bool pointerOperandOf(const Bytecode& op, ImageRelocation::Kind& outKind) {
+    switch (op.getOpcode()) {
+    case OpCode::CallImmediateNoReturn:
+    case OpCode::CallImmediateWithReturn:
+    case OpCode::TailCallImmediate:
+        outKind = ImageRelocation::Function;
+        return true;
+    case OpCode::LoadDefault:
+        outKind = ImageRelocation::Type;
+        return !op.toOperands<operators::LoadDefault>().isScalar;
+    case OpCode::SetType:
+        outKind = ImageRelocation::Type;
+        return !op.toOperands<operators::SetType>().isScalar;
+    case OpCode::GetMember:
+        outKind = ImageRelocation::Type;
+        return !op.toOperands<operators::GetMember>().isScalar;
+    case OpCode::SetMember:
+        outKind = ImageRelocation::Type;
+        return !op.toOperands<operators::SetMember>().isScalar;
+    default:
+        return false;
+    }
+}
+
+void sy::ImageFunction::relocateInto(Bytecode* bytecode) const noexcept {
+    for (size_t i = 0; i < this->relocationsLen_; i++) {
+        const ImageRelocation& relocation = this->relocations_[i];
+        const void* target = nullptr;
+        if (relocation.kind == ImageRelocation::Function) {
+            target = &this->imageFunctions_[relocation.target];
+        } else {
+            target = imageBuiltinType(relocation.target);
+        }
+        bytecode[relocation.bytecodeIndex].value =
+            static_cast<uint64_t>(reinterpret_cast<uintptr_t>(target));
+    }
+}
+
+void sy::ImageFunction::relocate() noexcept {
+    uint32_t expected = PENDING;
+    if (this->state_.compare_exchange_strong(expected, RELOCATING, std::memory_order_acquire)) {
+        this->relocateInto(this->bytecode_);
+        this->state_.store(RELOCATED, std::memory_order_release);
+        return;
+    }
+
+    // Another thread is relocating. Relocation is short, and happens once per function.
+    while (this->state_.load(std::memory_order_acquire) != RELOCATED) {
+        std::this_thread::yield();
+    }
+}
+
+namespace {
+/// Flattens all modules of a program into the sections of an image.
+class ImageWriter final {
+  public:
+    explicit ImageWriter(const ProgramInternal* program) : program_(program) {}
+
+    Result<void, ProgramImageError> addModule(const ProgramModuleInternal* module) noexcept;
+
+    Result<void, ProgramImageError> writeTo(const std::filesystem::path& path) const;
+
+  private:
+    Result<ImageString, ProgramImageError> addString(StringSlice str) noexcept;
+
+    Result<void, ProgramImageError> addFunction(const RawFunction& function) noexcept;
+
+    Result<void, ProgramImageError> addBytecode(const InterpreterFunctionScriptInfo* scriptInfo,
+                                                ImageFunctionEntry& entry) noexcept;
+
+    Result<void, ProgramImageError> addRelocation(uint64_t bytecodeIndex,
+                                                  const Bytecode& operand,
+                                                  ImageRelocation::Kind kind) noexcept;
+
+    /// @return `true` if `function` belongs to the program, storing its index over all modules in
+    /// `outIndex`.
+    bool functionIndexOf(const RawFunction* function, uint32_t& outIndex) const noexcept;
+
+    const ProgramInternal* program_;
+    DynArray<ImageModuleEntry> modules_{};
+    DynArray<ImageFunctionEntry> functions_{};
+    DynArray<uint32_t> argTypes_{};
+    DynArray<ImageRelocation> relocations_{};
+    DynArray<Bytecode> bytecode_{};
+    DynArray<int16_t> unwindSlots_{};
+    DynArray<char> strings_{};
+};
+} // namespace
+
+Result<void, ProgramImageError>
+ImageWriter::addModule(const ProgramModuleInternal* module) noexcept {
+    // Struct types hold function pointers to their implementations, so can't be written.
+    if (module->allTypesLen > 0) {
+        return Error(ProgramImageError::Unserializable);
+    }
+
+    ImageModuleEntry entry{};
+    auto nameRes = this->addString(module->name.asSlice());
+    if (nameRes.hasErr()) {
+        return Error(nameRes.takeErr());
+    }
+    entry.name = nameRes.value();
+    entry.major = module->version.major;
+    entry.minor = module->version.minor;
+    entry.patch = module->version.patch;
+    entry.firstFunction = this->functions_.len();
+    entry.functionsLen = module->allFunctionsLen;
+
+    for (size_t i = 0; i < module->allFunctionsLen; i++) {
+        if (auto res = this->addFunction(module->allFunctions[i]); res.hasErr()) {
+            return res;
+        }
+    }
+
+    if (this->modules_.push(entry).hasErr()) {
+        return Error(ProgramImageError::OutOfMemory);
+    }
+    return {};
+}
+
+Result<ImageString, ProgramImageError> ImageWriter::addString(StringSlice str) noexcept {
+    const ImageString imageStr{this->strings_.len(), str.len()};
+    for (size_t i = 0; i < str.len(); i++) {
+        if (this->strings_.push(str.data()[i]).hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+    }
+    return imageStr;
+}
+
+Result<void, ProgramImageError> ImageWriter::addFunction(const RawFunction& function) noexcept {
+    if (function.tag != FunctionType::Script) {
+        return Error(ProgramImageError::Unserializable);
+    }
+
+    ImageFunctionEntry entry{};
+    auto nameRes = this->addString(function.name);
+    if (nameRes.hasErr()) {
+        return Error(nameRes.takeErr());
+    }
+    entry.name = nameRes.value();
+    auto qualifiedNameRes = this->addString(function.qualifiedName);
+    if (qualifiedNameRes.hasErr()) {
+        return Error(qualifiedNameRes.takeErr());
+    }
+    entry.qualifiedName = qualifiedNameRes.value();
+
+    if (!imageTypeRef(function.returnType, entry.returnType)) {
+        return Error(ProgramImageError::Unserializable);
+    }
+    entry.firstArgType = this->argTypes_.len();
+    entry.argsLen = function.argsLen;
+    for (uint16_t i = 0; i < function.argsLen; i++) {
+        uint32_t argType = IMAGE_NO_TYPE;
+        if (!imageTypeRef(function.argsTypes[i], argType) || argType == IMAGE_NO_TYPE) {
+            return Error(ProgramImageError::Unserializable);
+        }
+        if (this->argTypes_.push(argType).hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+    }
+    entry.alignment = function.alignment;
+    entry.comptimeSafe = function.comptimeSafe ? 1 : 0;
+
+    ensureFunctionCompiled(&function);
+    const InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<const InterpreterFunctionScriptInfo*>(function.fptr);
+    entry.stackSpaceRequired = scriptInfo->stackSpaceRequired;
+    entry.callSiteCachesLen = scriptInfo->callSiteCachesLen;
+    entry.unwindStart = this->unwindSlots_.len();
+    entry.unwindLen = scriptInfo->unwindLen;
+    for (uint16_t i = 0; i < scriptInfo->unwindLen; i++) {
+        if (this->unwindSlots_.push(scriptInfo->unwindSlots[i]).hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+    }
+
+    if (auto res = this->addBytecode(scriptInfo, entry); res.hasErr()) {
+        return res;
+    }
+
+    if (this->functions_.push(entry).hasErr()) {
+        return Error(ProgramImageError::OutOfMemory);
+    }
+    return {};
+}
+
+Result<void, ProgramImageError>
+ImageWriter::addBytecode(const InterpreterFunctionScriptInfo* scriptInfo,
+                         ImageFunctionEntry& entry) noexcept {
+    if (scriptInfo->image != nullptr) {
+        // Written from a loaded image, whose pointer operands must be resolved first.
+        scriptInfo->image->ensureRelocated();
+    }
+
+    entry.bytecodeStart = this->bytecode_.len();
+    entry.bytecodeCount = scriptInfo->bytecodeCount;
+    entry.firstRelocation = this->relocations_.len();
+
+    const Bytecode* bytecode = scriptInfo->bytecode;
+    for (size_t pos = 0; pos < scriptInfo->bytecodeCount;) {
+        const Bytecode& op = bytecode[pos];
+        const size_t width = op.bytecodeUsed();
+        if (width == 0 || width > (scriptInfo->bytecodeCount - pos)) {
+            return Error(ProgramImageError::Unserializable);
+        }
+        for (size_t i = 0; i < width; i++) {
+            if (this->bytecode_.push(bytecode[pos + i]).hasErr()) {
+                return Error(ProgramImageError::OutOfMemory);
+            }
+        }
+
+        ImageRelocation::Kind kind = ImageRelocation::Type;
+        if (pointerOperandOf(op, kind)) {
+            if (auto res = this->addRelocation(pos + 1, bytecode[pos + 1], kind); res.hasErr()) {
+                return res;
+            }
+            // Written by `ImageFunction::relocate()` once loaded, so images don't hold addresses
+            // of the process that wrote them.
+            this->bytecode_[entry.bytecodeStart + pos + 1].value = 0;
+        }
+        pos += width;
+    }
+
+    entry.relocationsLen = this->relocations_.len() - entry.firstRelocation;
+    return {};
+}
+
+Result<void, ProgramImageError> ImageWriter::addRelocation(uint64_t bytecodeIndex,
+                                                           const Bytecode& operand,
+                                                           ImageRelocation::Kind kind) noexcept {
+    ImageRelocation relocation{};
+    relocation.bytecodeIndex = bytecodeIndex;
+    relocation.kind = kind;
+    if (kind == ImageRelocation::Function) {
+        const RawFunction* function =
+            reinterpret_cast<const RawFunction*>(static_cast<uintptr_t>(operand.value));
+        if (!this->functionIndexOf(function, relocation.target)) {
+            return Error(ProgramImageError::Unserializable);
+        }
+    } else {
+        const Type* type = reinterpret_cast<const Type*>(static_cast<uintptr_t>(operand.value));
+        uint32_t typeRef = IMAGE_NO_TYPE;
+        if (!imageTypeRef(type, typeRef) || typeRef == IMAGE_NO_TYPE) {
+            return Error(ProgramImageError::Unserializable);
+        }
+        relocation.target = typeRef - 1;
+    }
+
+    if (this->relocations_.push(relocation).hasErr()) {
+        return Error(ProgramImageError::OutOfMemory);
+    }
+    return {};
+}
+
+bool ImageWriter::functionIndexOf(const RawFunction* function, uint32_t& outIndex) const noexcept {
+    if (function == nullptr) {
+        return false;
+    }
+    size_t first = 0;
+    for (size_t i = 0; i < this->program_->allModulesLen; i++) {
+        const ProgramModuleInternal* module = moduleAt(this->program_, i);
+        const RawFunction* begin = module->allFunctions;
+        if (module->allFunctionsLen > 0 && function >= begin &&
+            function < begin + module->allFunctionsLen) {
+            outIndex = static_cast<uint32_t>(first + static_cast<size_t>(function - begin));
+            return true;
+        }
+        first += module->allFunctionsLen;
+    }
+    return false;
+}
+
+/// Writes `bytes` of `data` at `offset`, padding with zeroes from `written`.
+static void writeAt(std::ofstream& file, uint64_t& written, uint64_t offset, const void* data,
+                    size_t bytes) {
+    static constexpr char ZEROES[IMAGE_SECTION_ALIGN] = {};
+    sy_assert(offset >= written && (offset - written) < IMAGE_SECTION_ALIGN,
+              "Image sections must be written in order");
+    file.write(ZEROES, static_cast<std::streamsize>(offset - written));
+    if (bytes > 0) {
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    }
+    written = offset + bytes;
+}
+
+Result<void, ProgramImageError> ImageWriter::writeTo(const std::filesystem::path& path) const {
+    ImageHeader header{};
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    header.formatVersion = IMAGE_FORMAT_VERSION;
+    header.byteOrderMark = IMAGE_BYTE_ORDER_MARK;
+    header.pointerSize = static_cast<uint32_t>(sizeof(void*));
+    header.bytecodeSize = static_cast<uint32_t>(sizeof(Bytecode));
+
+    uint64_t end = sizeof(ImageHeader);
+    auto place = [&end](ImageSection& section, size_t len, size_t elementSize) {
+        section.offset = alignToSection(end);
+        section.len = len;
+        end = section.offset + (len * elementSize);
+    };
+    place(header.modules, this->modules_.len(), sizeof(ImageModuleEntry));
+    place(header.functions, this->functions_.len(), sizeof(ImageFunctionEntry));
+    place(header.argTypes, this->argTypes_.len(), sizeof(uint32_t));
+    place(header.relocations, this->relocations_.len(), sizeof(ImageRelocation));
+    place(header.bytecode, this->bytecode_.len(), sizeof(Bytecode));
+    place(header.unwindSlots, this->unwindSlots_.len(), sizeof(int16_t));
+    place(header.strings, this->strings_.len(), sizeof(char));
+    header.fileSize = end;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return Error(ProgramImageError::Io);
+    }
+    uint64_t written = 0;
+    writeAt(file, written, 0, &header, sizeof(ImageHeader));
+    writeAt(file, written, header.modules.offset, this->modules_.data(),
+            this->modules_.len() * sizeof(ImageModuleEntry));
+    writeAt(file, written, header.functions.offset, this->functions_.data(),
+            this->functions_.len() * sizeof(ImageFunctionEntry));
+    writeAt(file, written, header.argTypes.offset, this->argTypes_.data(),
+            this->argTypes_.len() * sizeof(uint32_t));
+    writeAt(file, written, header.relocations.offset, this->relocations_.data(),
+            this->relocations_.len() * sizeof(ImageRelocation));
+    writeAt(file, written, header.bytecode.offset, this->bytecode_.data(),
+            this->bytecode_.len() * sizeof(Bytecode));
+    writeAt(file, written, header.unwindSlots.offset, this->unwindSlots_.data(),
+            this->unwindSlots_.len() * sizeof(int16_t));
+    writeAt(file, written, header.strings.offset, this->strings_.data(), this->strings_.len());
+    file.close();
+    if (file.fail()) {
+        return Error(ProgramImageError::Io);
+    }
+    return {};
+}
+
+Result<void, ProgramImageError> sy::ProgramImage::write(const Program& program,
+                                                        StringSlice path) noexcept {
+    const ProgramInternal* self = *reinterpret_cast<const ProgramInternal* const*>(&program);
+    try {
+        ImageWriter writer(self);
+        for (size_t i = 0; i < self->allModulesLen; i++) {
+            if (auto res = writer.addModule(moduleAt(self, i)); res.hasErr()) {
+                return res;
+            }
+        }
+        return writer.writeTo(std::filesystem::path(path.data(), path.data() + path.len()));
+    } catch (...) {
+        return Error(ProgramImageError::Io);
+    }
+}
+
+#if SY_PROGRAM_IMAGE_MMAP && (defined(_MSC_VER) || defined(_WIN32))
+
+static Result<ImageMapping, ProgramImageError> mapImageFile(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return Error(ProgramImageError::Io);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) ||
+        fileSize.QuadPart < static_cast<LONGLONG>(sizeof(ImageHeader))) {
+        CloseHandle(file);
+        return Error(ProgramImageError::InvalidImage);
+    }
+    // Copy-on-write, so relocating bytecode never writes to the file.
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return Error(ProgramImageError::Io);
+    }
+    void* base = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (base == nullptr) {
+        return Error(ProgramImageError::Io);
+    }
+    return ImageMapping{reinterpret_cast<uint8_t*>(base), static_cast<size_t>(fileSize.QuadPart)};
+}
+
+static void unmapImageFile(ImageMapping mapping) { UnmapViewOfFile(mapping.base); }
+
+#elif SY_PROGRAM_IMAGE_MMAP
+
+static Result<ImageMapping, ProgramImageError> mapImageFile(const std::filesystem::path& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return Error(ProgramImageError::Io);
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(ImageHeader))) {
+        close(fd);
+        return Error(ProgramImageError::InvalidImage);
+    }
+    const size_t size = static_cast<size_t>(fileStat.st_size);
+    // Private mappings are copy-on-write, so relocating bytecode never writes to the file, and
+    // pages of functions that are never called stay shared with other processes.
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return Error(ProgramImageError::Io);
+    }
+    return ImageMapping{reinterpret_cast<uint8_t*>(base), size};
+}
+
+static void unmapImageFile(ImageMapping mapping) { munmap(mapping.base, mapping.size); }
+
+#else
+
+static Result<ImageMapping, ProgramImageError> mapImageFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return Error(ProgramImageError::Io);
+    }
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileSize = file.tellg();
+    if (fileSize < static_cast<std::streamoff>(sizeof(ImageHeader))) {
+        return Error(ProgramImageError::InvalidImage);
+    }
+    const size_t size = static_cast<size_t>(fileSize);
+
+    // Allocated as words, so sections are as aligned as they would be when mapped.
+    Allocator alloc{};
+    auto bufRes = alloc.allocArray<uint64_t>((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    if (bufRes.hasErr()) {
+        return Error(ProgramImageError::OutOfMemory);
+    }
+    uint8_t* base = reinterpret_cast<uint8_t*>(bufRes.value());
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(base), fileSize);
+    if (file.fail()) {
+        alloc.freeArray(bufRes.value(), (size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        return Error(ProgramImageError::Io);
+    }
+    return ImageMapping{base, size};
+}
+
+static void unmapImageFile(ImageMapping mapping) {
+    Allocator alloc{};
+    alloc.freeArray(reinterpret_cast<uint64_t*>(mapping.base),
+                    (mapping.size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+}
+
+#endif
+
+/// @return `true` if `len` elements starting at `start` are within `[0, total)`.
+static bool rangeWithin(uint64_t start, uint64_t len, uint64_t total) {
+    return start <= total && len <= (total - start);
+}
+
+static bool sectionWithin(const ImageSection& section, size_t elementSize, uint64_t fileSize) {
+    if ((section.offset % IMAGE_SECTION_ALIGN) != 0 || section.offset > fileSize) {
+        return false;
+    }
+    return section.len <= ((fileSize - section.offset) / elementSize);
+}
+
+static bool typeRefValid(uint32_t ref) { return ref <= IMAGE_BUILTIN_TYPES_LEN; }
+
+/// Checks the header and every table of the image, without reading any bytecode. See
+/// `verifyImageFunctions(...)` for the bytecode.
+static Result<void, ProgramImageError> validateImage(const ImageMapping& mapping) {
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(mapping.base);
+    if (std::memcmp(header->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0) {
+        return Error(ProgramImageError::InvalidImage);
+    }
+    if (header->formatVersion != IMAGE_FORMAT_VERSION ||
+        header->byteOrderMark != IMAGE_BYTE_ORDER_MARK || header->pointerSize != sizeof(void*) ||
+        header->bytecodeSize != sizeof(Bytecode)) {
+        return Error(ProgramImageError::UnsupportedVersion);
+    }
+    const uint64_t fileSize = mapping.size;
+    if (header->fileSize != fileSize ||
+        !sectionWithin(header->modules, sizeof(ImageModuleEntry), fileSize) ||
+        !sectionWithin(header->functions, sizeof(ImageFunctionEntry), fileSize) ||
+        !sectionWithin(header->argTypes, sizeof(uint32_t), fileSize) ||
+        !sectionWithin(header->relocations, sizeof(ImageRelocation), fileSize) ||
+        !sectionWithin(header->bytecode, sizeof(Bytecode), fileSize) ||
+        !sectionWithin(header->unwindSlots, sizeof(int16_t), fileSize) ||
+        !sectionWithin(header->strings, sizeof(char), fileSize)) {
+        return Error(ProgramImageError::InvalidImage);
+    }
+
+    const auto* modules =
+        reinterpret_cast<const ImageModuleEntry*>(mapping.base + header->modules.offset);
+    for (uint64_t i = 0; i < header->modules.len; i++) {
+        const ImageModuleEntry& module = modules[i];
+        if (!rangeWithin(module.name.offset, module.name.len, header->strings.len) ||
+            !rangeWithin(module.firstFunction, module.functionsLen, header->functions.len)) {
+            return Error(ProgramImageError::InvalidImage);
+        }
+    }
+
+    const auto* functions =
+        reinterpret_cast<const ImageFunctionEntry*>(mapping.base + header->functions.offset);
+    const auto* argTypes =
+        reinterpret_cast<const uint32_t*>(mapping.base + header->argTypes.offset);
+    const auto* relocations =
+        reinterpret_cast<const ImageRelocation*>(mapping.base + header->relocations.offset);
+    // Functions don't share bytecode, as relocating one would change another after it was
+    // verified.
+    uint64_t bytecodeEnd = 0;
+    for (uint64_t i = 0; i < header->functions.len; i++) {
+        const ImageFunctionEntry& function = functions[i];
+        if (!rangeWithin(function.name.offset, function.name.len, header->strings.len) ||
+            !rangeWithin(function.qualifiedName.offset, function.qualifiedName.len,
+                         header->strings.len) ||
+            !rangeWithin(function.firstArgType, function.argsLen, header->argTypes.len) ||
+            !rangeWithin(function.bytecodeStart, function.bytecodeCount, header->bytecode.len) ||
+            !rangeWithin(function.unwindStart, function.unwindLen, header->unwindSlots.len) ||
+            !rangeWithin(function.firstRelocation, function.relocationsLen,
+                         header->relocations.len) ||
+            !typeRefValid(function.returnType) || function.bytecodeCount == 0 ||
+            function.bytecodeStart < bytecodeEnd ||
+            function.stackSpaceRequired > Stack::MAX_FRAME_LEN) {
+            return Error(ProgramImageError::InvalidImage);
+        }
+        bytecodeEnd = function.bytecodeStart + function.bytecodeCount;
+        for (uint16_t j = 0; j < function.argsLen; j++) {
+            const uint32_t argType = argTypes[function.firstArgType + j];
+            if (argType == IMAGE_NO_TYPE || !typeRefValid(argType)) {
+                return Error(ProgramImageError::InvalidImage);
+            }
+        }
+        for (uint64_t j = 0; j < function.relocationsLen; j++) {
+            const ImageRelocation& relocation = relocations[function.firstRelocation + j];
+            const bool targetValid =
+                relocation.kind == ImageRelocation::Function
+                    ? relocation.target < header->functions.len
+                    : (relocation.kind == ImageRelocation::Type &&
+                       relocation.target < IMAGE_BUILTIN_TYPES_LEN);
+            if (!targetValid || relocation.bytecodeIndex >= function.bytecodeCount) {
+                return Error(ProgramImageError::InvalidImage);
+            }
+        }
+    }
+    return {};
+}
+
+/// Frees everything `image` owns, including partially loaded state.
+static void destroyImageInternal(ProgramImageInternal* image) {
+    Allocator alloc{};
+    if (image->jitStates != nullptr) {
+        for (size_t i = 0; i < image->jitStatesLen; i++) {
+            image->jitStates[i].~JitFunctionState();
+        }
+        alloc.freeArray(image->jitStates, image->jitStatesLen);
+    }
+    if (image->callSiteCaches != nullptr) {
+        for (size_t i = 0; i < image->callSiteCachesLen; i++) {
+            image->callSiteCaches[i].~CallSiteCache();
+        }
+        alloc.freeArray(image->callSiteCaches, image->callSiteCachesLen);
+    }
+    if (image->functions != nullptr) {
+        for (size_t i = 0; i < image->functionsLen; i++) {
+            image->functions[i].~ImageFunction();
+        }
+        alloc.freeArray(image->functions, image->functionsLen);
+    }
+    if (ProgramInternal* programInternal = image->programInternal; programInternal != nullptr) {
+        Allocator programAlloc = programInternal->protAlloc.asAllocator();
+        for (auto entry : programInternal->moduleVersions) {
+            entry.value.destroy(programAlloc);
+        }
+        programInternal->moduleVersions.destroy(programAlloc);
+        // Everything else of the program, including `programInternal` itself, lives within the
+        // protected allocator's pages, which are freed all at once.
+        ProtectedAllocator protAlloc(std::move(programInternal->protAlloc));
+        programInternal->~ProgramInternal();
+    }
+    if (image->mapping.base != nullptr) {
+        unmapImageFile(image->mapping);
+    }
+    image->~ProgramImageInternal();
+    alloc.freeObject(image);
+}
+
+static Result<void, ProgramImageError> addModuleVersion(ProgramInternal* programInternal,
+                                                        ProgramModule* module) {
+    Allocator protAlloc = programInternal->protAlloc.asAllocator();
+    const ModuleVersion info = module->moduleInfo();
+    auto findVersions = programInternal->moduleVersions.find(info.name);
+    if (!findVersions.hasValue()) {
+        DynArrayUnmanaged<ProgramModule*> versions;
+        if (versions.push(module, protAlloc).hasErr() ||
+            programInternal->moduleVersions.insert(protAlloc, info.name, std::move(versions))
+                .hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        return {};
+    }
+
+    // Latest version first, as `Program::getModule(...)` expects.
+    DynArrayUnmanaged<ProgramModule*>& versions = findVersions.value();
+    size_t index = 0;
+    for (; index < versions.len(); index++) {
+        const SemVer other = versions[index]->moduleInfo().version;
+        if (other == info.version) {
+            return Error(ProgramImageError::InvalidImage);
+        }
+        if (other < info.version) {
+            break;
+        }
+    }
+    if (versions.insertAt(module, protAlloc, index).hasErr()) {
+        return Error(ProgramImageError::OutOfMemory);
+    }
+    return {};
+}
+
+/// Checks that the relocations of `bytecode`, a relocated copy of a function's bytecode, are
+/// exactly its pointer operands in order, as the verifier trusts pointer operands.
+static bool relocationsMatch(const Bytecode* bytecode, size_t bytecodeCount,
+                             const ImageRelocation* relocations, size_t relocationsLen) {
+    size_t nextRelocation = 0;
+    for (size_t pos = 0; pos < bytecodeCount;) {
+        const Bytecode& op = bytecode[pos];
+        if (!operandsValid(op)) {
+            return false;
+        }
+        const size_t width = op.bytecodeUsed();
+        if (width > (bytecodeCount - pos)) {
+            return false;
+        }
+        ImageRelocation::Kind kind = ImageRelocation::Type;
+        if (pointerOperandOf(op, kind)) {
+            if (nextRelocation == relocationsLen ||
+                relocations[nextRelocation].bytecodeIndex != (pos + 1) ||
+                relocations[nextRelocation].kind != kind) {
+                return false;
+            }
+            nextRelocation += 1;
+        }
+        pos += width;
+    }
+    return nextRelocation == relocationsLen;
+}
+
+/// Verifies the bytecode of every function of `image`, as the interpreter trusts verified
+/// bytecode, and images may be truncated, corrupted, or tampered with. Each function is relocated
+/// into a scratch copy, so the mapped bytecode is still only written to once called.
+static Result<void, ProgramImageError> verifyImageFunctions(const ProgramImageInternal* image,
+                                                            const ImageFunctionEntry* entries,
+                                                            const ImageRelocation* relocations,
+                                                            const RawFunction* functions) {
+    size_t scratchLen = 0;
+    for (size_t i = 0; i < image->functionsLen; i++) {
+        scratchLen = entries[i].bytecodeCount > scratchLen ? entries[i].bytecodeCount : scratchLen;
+    }
+    if (scratchLen == 0) {
+        return {};
+    }
+    Allocator alloc{};
+    auto scratchRes = alloc.allocArray<Bytecode>(scratchLen);
+    if (scratchRes.hasErr()) {
+        return Error(ProgramImageError::OutOfMemory);
+    }
+    Bytecode* scratch = scratchRes.value();
+
+    auto result = [&]() -> Result<void, ProgramImageError> {
+        for (size_t i = 0; i < image->functionsLen; i++) {
+            const ImageFunctionEntry& entry = entries[i];
+            const auto* scriptInfo =
+                reinterpret_cast<const InterpreterFunctionScriptInfo*>(functions[i].fptr);
+            memcpy(scratch, scriptInfo->bytecode, entry.bytecodeCount * sizeof(Bytecode));
+            image->functions[i].relocateInto(scratch);
+            if (!relocationsMatch(scratch, entry.bytecodeCount,
+                                  &relocations[entry.firstRelocation], entry.relocationsLen)) {
+                return Error(ProgramImageError::InvalidImage);
+            }
+
+            InterpreterFunctionScriptInfo scratchInfo = *scriptInfo;
+            scratchInfo.bytecode = scratch;
+            RawFunction scratchFunction = functions[i];
+            scratchFunction.fptr = reinterpret_cast<void*>(&scratchInfo);
+            if (auto res = verifyScriptFunction(&scratchFunction); res.hasErr()) {
+                if (res.err().kind == BytecodeVerifyErrorKind::OutOfMemory) {
+                    return Error(ProgramImageError::OutOfMemory);
+                }
+                return Error(ProgramImageError::InvalidImage);
+            }
+        }
+        return {};
+    }();
+    alloc.freeArray(scratch, scratchLen);
+    return result;
+}
+
+/// Sets up the program of `image` from its mapped tables.
+static Result<void, ProgramImageError> loadImageTables(ProgramImageInternal* image) {
+    const uint8_t* base = image->mapping.base;
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(base);
+    const auto* moduleEntries =
+        reinterpret_cast<const ImageModuleEntry*>(base + header->modules.offset);
+    const auto* functionEntries =
+        reinterpret_cast<const ImageFunctionEntry*>(base + header->functions.offset);
+    const auto* argTypeRefs = reinterpret_cast<const uint32_t*>(base + header->argTypes.offset);
+    const auto* relocations =
+        reinterpret_cast<const ImageRelocation*>(base + header->relocations.offset);
+    Bytecode* bytecode = reinterpret_cast<Bytecode*>(image->mapping.base + header->bytecode.offset);
+    const auto* unwindSlots = reinterpret_cast<const int16_t*>(base + header->unwindSlots.offset);
+    const char* strings = reinterpret_cast<const char*>(base + header->strings.offset);
+    auto stringAt = [strings](const ImageString& str) {
+        return StringSlice(strings + str.offset, str.len);
+    };
+
+    ProgramInternal* programInternal;
+    {
+        ProtectedAllocator protAlloc;
+        auto allocRes = protAlloc.asAllocator().allocObject<ProgramInternal>();
+        if (allocRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        programInternal = allocRes.value();
+        new (programInternal) ProgramInternal();
+        new (&programInternal->protAlloc) ProtectedAllocator(std::move(protAlloc));
+        image->programInternal = programInternal;
+        *reinterpret_cast<ProgramInternal**>(&image->program) = programInternal;
+    }
+    Allocator protAlloc = programInternal->protAlloc.asAllocator();
+    Allocator alloc{};
+
+    // Mutable state of the functions lives outside of protected memory, like the JIT state of
+    // compiled functions.
+    const size_t functionsLen = header->functions.len;
+    size_t callSiteCachesLen = 0;
+    for (size_t i = 0; i < functionsLen; i++) {
+        callSiteCachesLen += functionEntries[i].callSiteCachesLen;
+    }
+    if (functionsLen > 0) {
+        auto functionsRes = alloc.allocArray<ImageFunction>(functionsLen);
+        if (functionsRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        image->functions = functionsRes.value();
+
+        auto jitStatesRes = alloc.allocArray<JitFunctionState>(functionsLen);
+        if (jitStatesRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        image->jitStates = jitStatesRes.value();
+        for (size_t i = 0; i < functionsLen; i++) {
+            new (&image->jitStates[i]) JitFunctionState();
+        }
+        image->jitStatesLen = functionsLen;
+    }
+    if (callSiteCachesLen > 0) {
+        auto cachesRes = alloc.allocArray<CallSiteCache>(callSiteCachesLen);
+        if (cachesRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        image->callSiteCaches = cachesRes.value();
+        for (size_t i = 0; i < callSiteCachesLen; i++) {
+            new (&image->callSiteCaches[i]) CallSiteCache();
+        }
+        image->callSiteCachesLen = callSiteCachesLen;
+    }
+
+    RawFunction* functions = nullptr;
+    String* names = nullptr;
+    String* qualifiedNames = nullptr;
+    InterpreterFunctionScriptInfo* scriptInfos = nullptr;
+    const Type** argsTypes = nullptr;
+    if (functionsLen > 0) {
+        auto functionsRes = protAlloc.allocArray<RawFunction>(functionsLen);
+        auto namesRes = protAlloc.allocArray<String>(functionsLen);
+        auto qualifiedNamesRes = protAlloc.allocArray<String>(functionsLen);
+        auto scriptInfosRes = protAlloc.allocArray<InterpreterFunctionScriptInfo>(functionsLen);
+        if (functionsRes.hasErr() || namesRes.hasErr() || qualifiedNamesRes.hasErr() ||
+            scriptInfosRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        functions = functionsRes.value();
+        names = namesRes.value();
+        qualifiedNames = qualifiedNamesRes.value();
+        scriptInfos = scriptInfosRes.value();
+    }
+    if (header->argTypes.len > 0) {
+        auto argsTypesRes = protAlloc.allocArray<const Type*>(header->argTypes.len);
+        if (argsTypesRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        argsTypes = argsTypesRes.value();
+        for (size_t i = 0; i < header->argTypes.len; i++) {
+            argsTypes[i] = imageTypeOf(argTypeRefs[i]);
+        }
+    }
+
+    size_t nextCallSiteCache = 0;
+    for (size_t i = 0; i < functionsLen; i++) {
+        const ImageFunctionEntry& entry = functionEntries[i];
+        const StringSlice name = stringAt(entry.name);
+        const StringSlice qualifiedName = stringAt(entry.qualifiedName);
+        auto nameRes = String::init(name, protAlloc);
+        if (nameRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        new (&names[i]) String(nameRes.takeValue());
+        auto qualifiedNameRes = String::init(qualifiedName, protAlloc);
+        if (qualifiedNameRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        new (&qualifiedNames[i]) String(qualifiedNameRes.takeValue());
+
+        new (&image->functions[i])
+            ImageFunction(&bytecode[entry.bytecodeStart], &relocations[entry.firstRelocation],
+                          entry.relocationsLen, functions);
+        image->functionsLen = i + 1;
+
+        InterpreterFunctionScriptInfo& scriptInfo = scriptInfos[i];
+        scriptInfo.program = &image->program;
+        scriptInfo.stackSpaceRequired = entry.stackSpaceRequired;
+        scriptInfo.bytecodeCount = entry.bytecodeCount;
+        scriptInfo.bytecode = &bytecode[entry.bytecodeStart];
+        scriptInfo.unwindSlots = entry.unwindLen > 0 ? &unwindSlots[entry.unwindStart] : nullptr;
+        scriptInfo.unwindLen = entry.unwindLen;
+        scriptInfo.jit = &image->jitStates[i];
+        scriptInfo.callSiteCaches =
+            entry.callSiteCachesLen > 0 ? &image->callSiteCaches[nextCallSiteCache] : nullptr;
+        scriptInfo.callSiteCachesLen = entry.callSiteCachesLen;
+        // Profiles find their call sites by decoding the bytecode, which loading avoids.
+        scriptInfo.profile = nullptr;
+        scriptInfo.image = &image->functions[i];
+        scriptInfo.lazy = nullptr;
+        nextCallSiteCache += entry.callSiteCachesLen;
+
+        RawFunction& function = functions[i];
+        new (&function) RawFunction();
+        function.name = names[i].asSlice();
+        function.qualifiedName = qualifiedNames[i].asSlice();
+        function.returnType = imageTypeOf(entry.returnType);
+        function.argsTypes = entry.argsLen > 0 ? &argsTypes[entry.firstArgType] : nullptr;
+        function.argsLen = entry.argsLen;
+        function.alignment = entry.alignment;
+        function.comptimeSafe = entry.comptimeSafe != 0;
+        function.tag = FunctionType::Script;
+        function.fptr = reinterpret_cast<void*>(&scriptInfo);
+    }
+    if (auto res = verifyImageFunctions(image, functionEntries, relocations, functions);
+        res.hasErr()) {
+        return res;
+    }
+
+    const size_t modulesLen = header->modules.len;
+    if (modulesLen > 0) {
+        auto modulesRes = protAlloc.allocArray<ProgramModule>(modulesLen);
+        if (modulesRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        programInternal->allModules = modulesRes.value();
+    }
+    for (size_t i = 0; i < modulesLen; i++) {
+        const ImageModuleEntry& entry = moduleEntries[i];
+        SemVer version;
+        version.major = entry.major;
+        version.minor = entry.minor;
+        version.patch = entry.patch;
+        auto moduleRes =
+            ProgramModuleInternal::init(protAlloc, stringAt(entry.name), version, 0, 0);
+        if (moduleRes.hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+        ProgramModuleInternal* module = moduleRes.value();
+        if (entry.functionsLen > 0) {
+            module->allFunctions = &functions[entry.firstFunction];
+            module->allFunctionNames = &names[entry.firstFunction];
+            module->allFunctionQualifiedNames = &qualifiedNames[entry.firstFunction];
+            module->allFunctionScriptInfo = &scriptInfos[entry.firstFunction];
+            module->allFunctionsLen = entry.functionsLen;
+        }
+        if (module->buildLookupIndex(protAlloc).hasErr()) {
+            return Error(ProgramImageError::OutOfMemory);
+        }
+
+        *reinterpret_cast<ProgramModuleInternal**>(&programInternal->allModules[i]) = module;
+        programInternal->allModulesLen = i + 1;
+        if (auto res = addModuleVersion(programInternal, &programInternal->allModules[i]);
+            res.hasErr()) {
+            return res;
+        }
+    }
+    return {};
+}
+
+sy::ProgramImage::~ProgramImage() noexcept { this->destroy(); }
+
+sy::ProgramImage::ProgramImage(ProgramImage&& other) noexcept : inner_(other.inner_) {
+    other.inner_ = nullptr;
+}
+
+ProgramImage& sy::ProgramImage::operator=(ProgramImage&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    this->destroy();
+    this->inner_ = other.inner_;
+    other.inner_ = nullptr;
+    return *this;
+}
+
+Result<ProgramImage, ProgramImageError> sy::ProgramImage::load(StringSlice path) noexcept {
+    auto mapRes = [path]() -> Result<ImageMapping, ProgramImageError> {
+        try {
+            return mapImageFile(std::filesystem::path(path.data(), path.data() + path.len()));
+        } catch (...) {
+            return Error(ProgramImageError::Io);
+        }
+    }();
+    if (mapRes.hasErr()) {
+        return Error(mapRes.takeErr());
+    }
+    const ImageMapping mapping = mapRes.value();
+    if (auto res = validateImage(mapping); res.hasErr()) {
+        unmapImageFile(mapping);
+        return Error(res.takeErr());
+    }
+
+    Allocator alloc{};
+    auto imageRes = alloc.allocObject<ProgramImageInternal>();
+    if (imageRes.hasErr()) {
+        unmapImageFile(mapping);
+        return Error(ProgramImageError::OutOfMemory);
+    }
+    ProgramImageInternal* image = new (imageRes.value()) ProgramImageInternal();
+    image->mapping = mapping;
+    if (auto res = loadImageTables(image); res.hasErr()) {
+        destroyImageInternal(image);
+        return Error(res.takeErr());
+    }
+
+    ProgramImage loaded;
+    loaded.inner_ = image;
+    return loaded;
+}
+
+const Program& sy::ProgramImage::program() const noexcept {
+    sy_assert(this->inner_ != nullptr, "Program image is not loaded");
+    return reinterpret_cast<const ProgramImageInternal*>(this->inner_)->program;
+}
+
+void sy::ProgramImage::destroy() noexcept {
+    if (this->inner_ == nullptr) {
+        return;
+    }
+    destroyImageInternal(reinterpret_cast<ProgramImageInternal*>(this->inner_));
+    this->inner_ = nullptr;
+}
+
+extern "C" {
+SY_API SyProgramImageError sy_program_image_write(const SyProgram* program, const char* path,
+                                                  size_t pathLen) {
+    auto res = ProgramImage::write(*reinterpret_cast<const Program*>(program),
+                                   StringSlice(path, pathLen));
+    if (res.hasErr()) {
+        return static_cast<SyProgramImageError>(res.takeErr());
+    }
+    return SY_PROGRAM_IMAGE_ERROR_NONE;
+}
+
+SY_API SyProgramImageError sy_program_image_load(const char* path, size_t pathLen,
+                                                 SyProgramImage* outImage) {
+    auto res = ProgramImage::load(StringSlice(path, pathLen));
+    if (res.hasErr()) {
+        return static_cast<SyProgramImageError>(res.takeErr());
+    }
+    new (outImage) ProgramImage(res.takeValue());
+    return SY_PROGRAM_IMAGE_ERROR_NONE;
+}
+
+SY_API const SyProgram* sy_program_image_program(const SyProgramImage* self) {
+    return reinterpret_cast<const SyProgram*>(
+        &reinterpret_cast<const ProgramImage*>(self)->program());
+}
+
+SY_API void sy_program_image_destroy(SyProgramImage* self) {
+    reinterpret_cast<ProgramImage*>(self)->~ProgramImage();
+}
+} // extern "C"
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include "../interpreter/aot_c.hpp"
+#include "../testing/script_function.hpp"
+#include "../types/type_info.hpp"
+
+using namespace sy::testing;
+
+namespace {
+/// Program of a single module, whose functions are written by hand, as the compiler doesn't
+/// produce bytecode yet.
+struct TestProgram {
+    ProgramInternal internal{};
+    Program program{};
+    ProgramModuleInternal* module = nullptr;
+
+    TestProgram(size_t functionsLen) {
+        Allocator protAlloc = this->internal.protAlloc.asAllocator();
+        SemVer version;
+        version.major = 1;
+        version.minor = 2;
+        this->module = ProgramModuleInternal::init(protAlloc, "math", version, functionsLen, 0)
+                           .takeValue();
+        this->internal.allModules = protAlloc.allocArray<ProgramModule>(1).takeValue();
+        *reinterpret_cast<ProgramModuleInternal**>(&this->internal.allModules[0]) = this->module;
+        this->internal.allModulesLen = 1;
+        *reinterpret_cast<ProgramInternal**>(&this->program) = &this->internal;
+    }
+
+    RawFunction& addFunction(size_t index, StringSlice name, StringSlice qualifiedName,
+                             const Bytecode* bytecode, size_t bytecodeCount,
+                             uint16_t stackSpaceRequired, const Type* returnType) {
+        Allocator protAlloc = this->internal.protAlloc.asAllocator();
+        new (&this->module->allFunctionNames[index])
+            String(String::init(name, protAlloc).takeValue());
+        new (&this->module->allFunctionQualifiedNames[index])
+            String(String::init(qualifiedName, protAlloc).takeValue());
+
+        InterpreterFunctionScriptInfo& info = this->module->allFunctionScriptInfo[index];
+        new (&info) InterpreterFunctionScriptInfo{};
+        info.program = &this->program;
+        info.stackSpaceRequired = stackSpaceRequired;
+        info.bytecodeCount = bytecodeCount;
+        info.bytecode = bytecode;
+
+        RawFunction& function = this->module->allFunctions[index];
+        new (&function) RawFunction();
+        function.name = this->module->allFunctionNames[index].asSlice();
+        function.qualifiedName = this->module->allFunctionQualifiedNames[index].asSlice();
+        function.returnType = returnType;
+        function.argsTypes = nullptr;
+        function.argsLen = 0;
+        function.comptimeSafe = false;
+        function.tag = FunctionType::Script;
+        function.fptr = reinterpret_cast<void*>(&info);
+        return function;
+    }
+};
+
+std::filesystem::path testImagePath(const char* name) {
+    return std::filesystem::temp_directory_path() / name;
+}
+
+Result<void, ProgramImageError> writeTestImage(const Program& program,
+                                               const std::filesystem::path& path) {
+    const std::string pathStr = path.string();
+    return ProgramImage::write(program, StringSlice(pathStr.data(), pathStr.size()));
+}
+
+Result<ProgramImage, ProgramImageError> loadTestImage(const std::filesystem::path& path) {
+    const std::string pathStr = path.string();
+    return ProgramImage::load(StringSlice(pathStr.data(), pathStr.size()));
+}
+} // namespace
+
+TEST_CASE("[ProgramImage] loaded functions are relocated on their first call") {
+    const Bytecode sevenBytecode[] = {loadI32(0, 7), returnValue(0)};
+
+    // addSeven(x) { return x + seven(); }
+    operators::CallImmediateWithReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateWithReturn::OPCODE);
+    call.argCount = 0;
+    call.retDst = 1;
+    Bytecode calleePtr;
+    operators::SetType setI32{};
+    setI32.reserveOpcode = static_cast<uint64_t>(operators::SetType::OPCODE);
+    setI32.dst = 1;
+    setI32.isScalar = true;
+    setI32.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+    operators::SetType setString{};
+    setString.reserveOpcode = static_cast<uint64_t>(operators::SetType::OPCODE);
+    setString.dst = 2;
+    setString.isScalar = false;
+    Bytecode stringType;
+    stringType.value = reinterpret_cast<uint64_t>(Reflect<String>::get());
+    operators::SetNullType clearString{};
+    clearString.reserveOpcode = static_cast<uint64_t>(operators::SetNullType::OPCODE);
+    clearString.dst = 2;
+    Bytecode addSevenBytecode[] = {Bytecode(call),      calleePtr,  addI32(1, 0, 1),
+                                   Bytecode(setI32),    Bytecode(setString), stringType,
+                                   Bytecode(clearString), returnValue(1)};
+
+    const std::filesystem::path path = testImagePath("sync_program_image_relocate.syimg");
+    String emittedC;
+    {
+        TestProgram test(2);
+        RawFunction& seven = test.addFunction(0, "seven", "math.seven", sevenBytecode, 2, 1,
+                                              Reflect<int32_t>::get());
+        addSevenBytecode[1].value = reinterpret_cast<uint64_t>(&seven);
+        RawFunction& addSeven =
+            test.addFunction(1, "addSeven", "math.addSeven", addSevenBytecode,
+                             sizeof(addSevenBytecode) / sizeof(Bytecode), 6,
+                             Reflect<int32_t>::get());
+        const Type* argsTypes[1] = {Reflect<int32_t>::get()};
+        addSeven.argsTypes = argsTypes;
+        addSeven.argsLen = 1;
+
+        REQUIRE(writeTestImage(test.program, path));
+        emittedC = emitModuleC(test.module).takeValue();
+    }
+
+    auto loadRes = loadTestImage(path);
+    REQUIRE(loadRes);
+    ProgramImage image = loadRes.takeValue();
+
+    auto module = image.program().getModule("math", {});
+    REQUIRE(module.hasValue());
+    CHECK_EQ(module.value().moduleInfo().version.minor, 2);
+    auto seven = module.value().getFunctionByQualifiedName("math.seven");
+    auto addSeven = module.value().getFunctionByQualifiedName("math.addSeven");
+    REQUIRE(seven.hasValue());
+    REQUIRE(addSeven.hasValue());
+    CHECK_EQ(addSeven.value()->name, StringSlice("addSeven"));
+    CHECK_EQ(addSeven.value()->argsLen, 1);
+    CHECK_EQ(addSeven.value()->argsTypes[0], Reflect<int32_t>::get());
+    CHECK_EQ(addSeven.value()->returnType, Reflect<int32_t>::get());
+
+    const InterpreterFunctionScriptInfo* scriptInfo =
+        reinterpret_cast<const InterpreterFunctionScriptInfo*>(addSeven.value()->fptr);
+    CHECK_EQ(scriptInfo->bytecode[1].value, 0);
+    CHECK_EQ(scriptInfo->bytecode[5].value, 0);
+
+    // Code compiled ahead of time from the original program still matches, despite the called
+    // function and type operands being relocated.
+    CHECK_NE(scriptInfo->jit, nullptr);
+    const ProgramModuleInternal* moduleInternal =
+        *reinterpret_cast<const ProgramModuleInternal* const*>(&module.value());
+    CHECK_EQ(emitModuleC(moduleInternal).takeValue(), emittedC);
+
+    int32_t x = 35;
+    int32_t result = 0;
+    RawFunction::CallArgs args = addSeven.value()->startCall();
+    REQUIRE(args.push(&x, Reflect<int32_t>::get()));
+    REQUIRE(args.call(&result));
+    CHECK_EQ(result, 42);
+    CHECK_EQ(scriptInfo->bytecode[1].value, reinterpret_cast<uint64_t>(seven.value()));
+    CHECK_EQ(scriptInfo->bytecode[5].value, reinterpret_cast<uint64_t>(Reflect<String>::get()));
+
+    // Images can be written again from a loaded image.
+    const std::filesystem::path rewritten = testImagePath("sync_program_image_rewritten.syimg");
+    REQUIRE(writeTestImage(image.program(), rewritten));
+    auto reloadRes = loadTestImage(rewritten);
+    REQUIRE(reloadRes);
+    CHECK(reloadRes.value().program().getModule("math", {}).hasValue());
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(rewritten);
+}
+
+TEST_CASE("[ProgramImage] rejects unserializable programs and malformed images") {
+    const std::filesystem::path path = testImagePath("sync_program_image_invalid.syimg");
+
+    {
+        const Bytecode bytecode[] = {loadI32(0, 1), returnValue(0)};
+        TestProgram test(1);
+        RawFunction& function =
+            test.addFunction(0, "one", "math.one", bytecode, 2, 1, Reflect<int32_t>::get());
+        function.tag = FunctionType::C;
+        CHECK_EQ(writeTestImage(test.program, path).err(), ProgramImageError::Unserializable);
+        function.tag = FunctionType::Script;
+        REQUIRE(writeTestImage(test.program, path));
+    }
+
+    CHECK_EQ(loadTestImage(testImagePath("sync_program_image_missing.syimg")).err(),
+             ProgramImageError::Io);
+
+    const uintmax_t fileSize = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, fileSize - 1);
+    CHECK_EQ(loadTestImage(path).err(), ProgramImageError::InvalidImage);
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const char garbage[256] = "not a program image";
+        file.write(garbage, sizeof(garbage));
+    }
+    CHECK_EQ(loadTestImage(path).err(), ProgramImageError::InvalidImage);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("[ProgramImage] rejects images with tampered bytecode") {
+    const std::filesystem::path path = testImagePath("sync_program_image_tampered.syimg");
+    const Bytecode sevenBytecode[] = {loadI32(0, 7), returnValue(0)};
+    auto call = makeOperands<operators::CallImmediateWithReturn>();
+    call.argCount = 0;
+    call.retDst = 0;
+    Bytecode callSevenBytecode[] = {Bytecode(call), Bytecode(), setScalarType(ScalarTag::I32, 0),
+                                    returnValue(0)};
+    {
+        TestProgram test(2);
+        RawFunction& seven = test.addFunction(0, "seven", "math.seven", sevenBytecode, 2, 2,
+                                              Reflect<int32_t>::get());
+        callSevenBytecode[1].value = reinterpret_cast<uint64_t>(&seven);
+        (void)test.addFunction(1, "callSeven", "math.callSeven", callSevenBytecode, 4, 2,
+                               Reflect<int32_t>::get());
+        REQUIRE(writeTestImage(test.program, path));
+    }
+    REQUIRE(loadTestImage(path));
+
+    std::string written;
+    {
+        std::ifstream file(path, std::ios::binary);
+        written.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    ImageHeader header;
+    memcpy(&header, written.data(), sizeof(ImageHeader));
+    ImageFunctionEntry sevenEntry;
+    memcpy(&sevenEntry, written.data() + header.functions.offset, sizeof(ImageFunctionEntry));
+    auto loadTampered = [&](size_t offset, const void* bytes, size_t len) {
+        std::string tampered = written;
+        memcpy(tampered.data() + offset, bytes, len);
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(tampered.data(), static_cast<std::streamsize>(tampered.size()));
+        }
+        return loadTestImage(path);
+    };
+
+    // Loads to a slot outside of the frame.
+    const Bytecode outOfFrame = loadI32(1000, 7);
+    CHECK_EQ(loadTampered(header.bytecode.offset + (sevenEntry.bytecodeStart * sizeof(Bytecode)),
+                          &outOfFrame, sizeof(Bytecode))
+                 .err(),
+             ProgramImageError::InvalidImage);
+
+    // Relocates the called function as a type.
+    const ImageRelocation::Kind typeKind = ImageRelocation::Type;
+    CHECK_EQ(loadTampered(header.relocations.offset + offsetof(ImageRelocation, kind), &typeKind,
+                          sizeof(typeKind))
+                 .err(),
+             ProgramImageError::InvalidImage);
+
+    std::filesystem::remove(path);
+}
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -0,0 +1,37 @@
+//! API
+#pragma once
+#ifndef SY_PROGRAM_PROGRAM_IMAGE_H_
+#define SY_PROGRAM_PROGRAM_IMAGE_H_
+
+#include "../core/core.h"
+#include "program.h"
+#include "program_error.h"
+
+typedef struct SyProgramImage {
+    void* inner_;
+} SyProgramImage;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Writes all modules of `program` to the file at `path`, which is `pathLen` bytes long.
+SY_API enum SyProgramImageError sy_program_image_write(const SyProgram* program, const char* path,
+                                                       size_t pathLen);
+
+/// Maps the program image at `path`, which is `pathLen` bytes long, into `outImage`. On failure,
+/// `outImage` is left untouched.
+SY_API enum SyProgramImageError sy_program_image_load(const char* path, size_t pathLen,
+                                                      SyProgramImage* outImage);
+
+/// The program of a loaded image, valid until the image is destroyed.
+SY_API const SyProgram* sy_program_image_program(const SyProgramImage* self);
+
+/// Unmaps the image. All functions of its program must have returned by then.
+SY_API void sy_program_image_destroy(SyProgramImage* self);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // SY_PROGRAM_PROGRAM_IMAGE_H_
@@ -0,0 +1,59 @@
+//! API
+#pragma once
+#ifndef SY_PROGRAM_PROGRAM_IMAGE_HPP_
+#define SY_PROGRAM_PROGRAM_IMAGE_HPP_
+
+#include "../core/core.h"
+#include "../types/result/result.hpp"
+#include "../types/string/string_slice.hpp"
+#include "program.hpp"
+#include "program_error.hpp"
+
+namespace sy {
+
+/// Compiled program written to a file, which can be loaded by later processes without compiling
+/// any of its modules. Loading maps the file into memory rather than reading it, so the bytecode
+/// of every function is shared with other processes loading the same image, until a function is
+/// first called and its pointer operands are written.
+///
+/// Images can only be loaded by the same build of Sync for the same platform that wrote them, as
+/// bytecode is stored as is. Only programs consisting solely of script functions, whose types are
+/// built-in types, can be written.
+class SY_API ProgramImage final {
+  public:
+    ProgramImage() = default;
+
+    /// Unmaps the image. All functions of `program()` must have returned by then.
+    ~ProgramImage() noexcept;
+
+    ProgramImage(ProgramImage&& other) noexcept;
+
+    ProgramImage& operator=(ProgramImage&& other) noexcept;
+
+    ProgramImage(const ProgramImage& other) = delete;
+
+    ProgramImage& operator=(const ProgramImage& other) = delete;
+
+    /// Writes all modules of `program`, including their functions, bytecode, and names, to the
+    /// file at `path`, replacing it if it exists.
+    [[nodiscard]] static Result<void, ProgramImageError> write(const Program& program,
+                                                               StringSlice path) noexcept;
+
+    /// Maps the image at `path`. The image's tables are checked and set up, and the bytecode of
+    /// every function is verified, failing with `ProgramImageError::InvalidImage` if it could be
+    /// unsafe to run. Each function's bytecode is only relocated when it's first called.
+    [[nodiscard]] static Result<ProgramImage, ProgramImageError> load(StringSlice path) noexcept;
+
+    /// # Debug Asserts
+    /// The image must be loaded.
+    [[nodiscard]] const Program& program() const noexcept;
+
+  private:
+    void destroy() noexcept;
+
+    void* inner_ = nullptr;
+};
+
+} // namespace sy
+
+#endif // SY_PROGRAM_PROGRAM_IMAGE_HPP_
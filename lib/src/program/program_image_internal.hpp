@@ -0,0 +1,72 @@
+#pragma once
+#ifndef SY_PROGRAM_PROGRAM_IMAGE_INTERNAL_HPP_
+#define SY_PROGRAM_PROGRAM_IMAGE_INTERNAL_HPP_
+
+#include "../core/core.h"
+#include <atomic>
+
+namespace sy {
+struct Bytecode;
+class RawFunction;
+
+/// Pointer operand within the bytecode of a program image, stored as an index rather than an
+/// address, as addresses differ between processes.
+struct ImageRelocation {
+    enum Kind : uint32_t {
+        /// `target` is the index of a function within the image, over all modules.
+        Function = 0,
+        /// `target` is the index of a built-in type. See `imageBuiltinType(...)`.
+        Type = 1,
+    };
+
+    /// Bytecode index of the operand, relative to the start of its function.
+    uint64_t bytecodeIndex;
+    Kind kind;
+    uint32_t target;
+};
+
+/// Lazily relocated bytecode of a script function loaded from a program image. The bytecode is
+/// mapped from the image file copy-on-write, so only the pages of functions that are called are
+/// ever written to. Loading verifies a relocated copy of every function, so relocating in place
+/// produces verified bytecode.
+class ImageFunction final {
+  public:
+    ImageFunction() = default;
+
+    ImageFunction(const ImageFunction& other) = delete;
+
+    ImageFunction& operator=(const ImageFunction& other) = delete;
+
+    ImageFunction(Bytecode* bytecode, const ImageRelocation* relocations, size_t relocationsLen,
+                  const RawFunction* imageFunctions) noexcept
+        : bytecode_(bytecode), relocations_(relocations), relocationsLen_(relocationsLen),
+          imageFunctions_(imageFunctions) {}
+
+    /// Writes the pointer operands of the function's bytecode, if not already written. Thread
+    /// safe, with concurrent callers waiting for the first to finish.
+    void ensureRelocated() noexcept {
+        if (this->state_.load(std::memory_order_acquire) != RELOCATED) {
+            this->relocate();
+        }
+    }
+
+    /// Writes the pointer operands into `bytecode`, a copy of the function's bytecode.
+    void relocateInto(Bytecode* bytecode) const noexcept;
+
+  private:
+    void relocate() noexcept;
+
+    static constexpr uint32_t PENDING = 0;
+    static constexpr uint32_t RELOCATING = 1;
+    static constexpr uint32_t RELOCATED = 2;
+
+    std::atomic<uint32_t> state_{PENDING};
+    Bytecode* bytecode_ = nullptr;
+    const ImageRelocation* relocations_ = nullptr;
+    size_t relocationsLen_ = 0;
+    /// All functions of the image, indexed by `ImageRelocation::target`.
+    const RawFunction* imageFunctions_ = nullptr;
+};
+} // namespace sy
+
+#endif // SY_PROGRAM_PROGRAM_IMAGE_INTERNAL_HPP_
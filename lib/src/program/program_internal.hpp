@@ -13,6 +13,13 @@
 namespace sy {
 struct Bytecode;
 class RawFunction;
+class JitFunctionState;
+class CallSiteCache;
+class FunctionProfile;
+class ProgramProfile;
+class ImageFunction;
+class LazyFunction;
+struct FileAst;
 
 /// Extra metadata for script functions.
 /// Corresponds with `SyFunction::fptr` if `SyFunction::tag == SyFunctionTypeScript`.
@@ -27,6 +34,59 @@ struct InterpreterFunctionScriptInfo {
     const int16_t* unwindSlots;
     /// Length of `unwindSlots`.
     uint16_t unwindLen;
+    /// Native code tier of this function. Can be null, in which case the function is always
+    /// interpreted. Script info is kept in protected memory, so the mutable JIT state lives
+    /// outside of it.
+    JitFunctionState* jit;
+    /// Inline caches of the indirect call sites within `bytecode`, indexed by the cache index
+    /// operand of `CallSrcNoReturn`, `CallSrcWithReturn`, and `TailCallSrc`. Can be null if there
+    /// are no cached call sites. Mutable like `jit`, so also lives outside of protected memory.
+    CallSiteCache* callSiteCaches;
+    /// Length of `callSiteCaches`.
+    uint32_t callSiteCachesLen;
+    /// Profile recorded while the program is being profiled. Can be null, in which case the
+    /// function is never profiled. Mutable like `jit`, so also lives outside of protected memory.
+    FunctionProfile* profile;
+    /// Pointer operands of `bytecode` that are yet to be relocated, for functions loaded from a
+    /// `ProgramImage`. Null for all other functions. Must be relocated before `bytecode` runs.
+    ImageFunction* image;
+    /// Body of a function that has yet to be compiled, for programs compiled with
+    /// `Compiler::setLazyFunctionCompilation(true)`. Null for all other functions. Every other
+    /// field must only be read once the function is compiled. See `ensureFunctionCompiled(...)`.
+    LazyFunction* lazy;
+};
+
+/// Immutable index over the names of a module's functions or types, built once all of them are
+/// known, and living in protected memory alongside them. Qualified names are unique, so are found
+/// through an open addressing hash table. Unqualified names may be shared by many elements within
+/// different namespaces, so elements are also sorted by unqualified name, with all elements sharing
+/// one being contiguous.
+template <typename T> class NameIndex final {
+  public:
+    /// `elements`, `qualifiedNames`, and `names` must all be `len` long, and outlive the index.
+    [[nodiscard]] Result<void, AllocErr> build(Allocator protAlloc, const T* elements,
+                                               const String* qualifiedNames, const String* names,
+                                               size_t len) noexcept;
+
+    [[nodiscard]] bool isBuilt() const noexcept { return this->built_; }
+
+    [[nodiscard]] Option<const T*> findQualified(StringSlice qualifiedName) const noexcept;
+
+    /// @return All elements named `name`, in no particular order. Empty if there are none.
+    [[nodiscard]] Slice<const T*> findUnqualified(StringSlice name) const noexcept;
+
+  private:
+    const T* elements_ = nullptr;
+    const String* qualifiedNames_ = nullptr;
+    const String* names_ = nullptr;
+    size_t len_ = 0;
+    /// Index of an element plus one, or zero for an empty slot. Its length is a power of two of at
+    /// least twice `len_`, so probe sequences stay short.
+    const uint32_t* slots_ = nullptr;
+    size_t slotsMask_ = 0;
+    /// All elements, sorted by unqualified name.
+    const T** byName_ = nullptr;
+    bool built_ = false;
 };
 
 struct ProgramModuleInternal {
@@ -41,6 +101,8 @@ struct ProgramModuleInternal {
     String* allTypeNames = nullptr;
     String* allTypeQualifiedNames = nullptr;
     size_t allTypesLen = 0;
+    NameIndex<RawFunction> functionIndex{};
+    NameIndex<Type> typeIndex{};
 
     /// Allocates all required memory for future operations, but the allocated
     /// arrays are left in an uninitialized state.
@@ -48,7 +110,17 @@ struct ProgramModuleInternal {
                                                          SemVer version, size_t functionCount,
                                                          size_t structCount);
 
+    /// Builds `functionIndex` and `typeIndex`. Must be called once all functions and types, along
+    /// with their names, are written, and before any lookups.
+    [[nodiscard]] Result<void, AllocErr> buildLookupIndex(Allocator protAlloc) noexcept;
+
     Option<const RawFunction*> getFunctionByQualifiedName(StringSlice qualifiedName) const noexcept;
+
+    Slice<const RawFunction*> getFunctionsByUnqualifiedName(StringSlice name) const noexcept;
+
+    Option<const Type*> getTypeByQualifiedName(StringSlice qualifiedName) const noexcept;
+
+    Slice<const Type*> getTypesByUnqualifiedName(StringSlice name) const noexcept;
 };
 
 struct ProgramInternal {
@@ -58,6 +130,12 @@ struct ProgramInternal {
     MapUnmanaged<StringSlice, DynArrayUnmanaged<ProgramModule*>> moduleVersions;
     CompileErrorReporter errReporter = nullptr;
     void* errReporterArg = nullptr;
+    /// Null if the interpreter is built without `SYNC_INTERPRETER_PROFILER`. Lives outside of
+    /// protected memory.
+    ProgramProfile* profile = nullptr;
+    /// Parsed files of modules whose functions are compiled lazily, kept until the functions are
+    /// compiled. Lives outside of protected memory.
+    DynArrayUnmanaged<FileAst*> lazyFiles{};
 };
 
 } // namespace sy
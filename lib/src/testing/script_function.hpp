@@ -0,0 +1,107 @@
+//! Test only
+#pragma once
+#ifndef SY_TESTING_SCRIPT_FUNCTION_HPP_
+#define SY_TESTING_SCRIPT_FUNCTION_HPP_
+
+#include "../interpreter/bytecode.hpp"
+#include "../program/program_internal.hpp"
+#include "../types/function/function.hpp"
+
+namespace sy {
+namespace testing {
+
+/// Script function running bytecode written by hand, for testing the interpreter and its tiers
+/// without the compiler. Neither the bytecode, nor the types of its arguments are owned. Any other
+/// fields of `info` and `function`, such as `info.jit`, or `function.argsTypes`, can be set after
+/// construction.
+struct TestScriptFunction {
+    InterpreterFunctionScriptInfo info{};
+    RawFunction function{};
+
+    TestScriptFunction(const Bytecode* bytecode, size_t bytecodeCount, uint16_t stackSpaceRequired,
+                       const Type* returnType, StringSlice qualifiedName = "test") noexcept {
+        this->info.stackSpaceRequired = stackSpaceRequired;
+        this->info.bytecodeCount = bytecodeCount;
+        this->info.bytecode = bytecode;
+
+        this->function.name = qualifiedName;
+        this->function.qualifiedName = qualifiedName;
+        this->function.returnType = returnType;
+        this->function.tag = FunctionType::Script;
+        this->function.fptr = reinterpret_cast<void*>(&this->info);
+    }
+
+    TestScriptFunction(const TestScriptFunction& other) = delete;
+
+    TestScriptFunction& operator=(const TestScriptFunction& other) = delete;
+};
+
+template <typename OperandsT> inline OperandsT makeOperands() noexcept {
+    OperandsT operands{};
+    operands.reserveOpcode = static_cast<uint64_t>(OperandsT::OPCODE);
+    return operands;
+}
+
+inline Bytecode loadImmediate(ScalarTag tag, uint16_t dst, uint32_t immediate) noexcept {
+    auto operands = makeOperands<operators::LoadImmediateScalar>();
+    operands.scalarTag = static_cast<uint64_t>(tag);
+    operands.dst = dst;
+    operands.immediate = immediate;
+    return Bytecode(operands);
+}
+
+inline Bytecode setScalarType(ScalarTag tag, uint16_t dst) noexcept {
+    auto operands = makeOperands<operators::SetType>();
+    operands.dst = dst;
+    operands.isScalar = true;
+    operands.scalarTag = static_cast<uint64_t>(tag);
+    return Bytecode(operands);
+}
+
+/// Loads and types `dst` as an `i32` in a single operation.
+inline Bytecode loadI32(uint16_t dst, int32_t immediate) noexcept {
+    auto operands = makeOperands<operators::LoadImmediateScalarSetType>();
+    operands.scalarTag = static_cast<uint64_t>(ScalarTag::I32);
+    operands.dst = dst;
+    operands.immediate = static_cast<uint32_t>(immediate);
+    return Bytecode(operands);
+}
+
+template <typename OperandsT>
+inline Bytecode binaryScalarOp(ScalarTag tag, uint16_t dst, uint16_t lhs, uint16_t rhs) noexcept {
+    auto operands = makeOperands<OperandsT>();
+    operands.isScalar = true;
+    operands.scalarTag = static_cast<uint64_t>(tag);
+    operands.dst = dst;
+    operands.lhs = lhs;
+    operands.rhs = rhs;
+    return Bytecode(operands);
+}
+
+inline Bytecode addI32(uint16_t dst, uint16_t lhs, uint16_t rhs) noexcept {
+    return binaryScalarOp<operators::Add>(ScalarTag::I32, dst, lhs, rhs);
+}
+
+inline Bytecode jump(int32_t amount) noexcept {
+    auto operands = makeOperands<operators::Jump>();
+    operands.amount = amount;
+    return Bytecode(operands);
+}
+
+inline Bytecode jumpIfFalse(uint16_t src, int32_t amount) noexcept {
+    auto operands = makeOperands<operators::JumpIfFalse>();
+    operands.src = src;
+    operands.amount = amount;
+    return Bytecode(operands);
+}
+
+inline Bytecode returnValue(uint16_t src) noexcept {
+    auto operands = makeOperands<operators::ReturnValue>();
+    operands.src = src;
+    return Bytecode(operands);
+}
+
+} // namespace testing
+} // namespace sy
+
+#endif // SY_TESTING_SCRIPT_FUNCTION_HPP_
@@ -88,6 +88,7 @@ void sy::internal::SpinYielder::yield(volatile void* address, uint32_t compariso
             }
         }
 
+        this->counter += 1;
         this->backoffMultiplier *= 2;
         if (this->backoffMultiplier > MAX_BACKOFF) {
             this->backoffMultiplier = 1;
@@ -122,6 +123,17 @@ void sy::internal::SpinYielder::yield(volatile void* address, uint32_t compariso
     }
 }
 
+void sy::internal::wakeAllOnAddress(void* address) noexcept {
+#if defined(_MSC_VER) || defined(_WIN32)
+    WakeByAddressAll(address);
+#elif defined(__linux__)
+    syscall(__NR_futex, address, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    // Sleeping is yielding on every other platform, so there's nothing to wake.
+    (void)address;
+#endif
+}
+
 void sy::internal::acquireAtomicFence(std::atomic<uint32_t>& fence) {
 #ifdef SYNC_TSAN_ENABLED
     __tsan_mutex_pre_lock(&fence, 0);
@@ -29,8 +29,16 @@ struct SpinYielder {
     int backoffMultiplier = 1;
 
     void yield(volatile void* address, uint32_t comparisonValue) noexcept;
+
+    /// Whether the next `yield(...)` sleeps until another thread calls `wakeAllOnAddress(...)` or
+    /// similar on `address`, so waiters can tell the waking side that they need waking.
+    bool willSleep() const noexcept { return this->counter >= SLEEP_THRESHOLD; }
 };
 
+/// Wakes every thread sleeping in `SpinYielder::yield(...)` on `address`. Waking an address that
+/// was already freed is harmless, as sleepers always recheck their condition.
+void wakeAllOnAddress(void* address) noexcept;
+
 static inline void pause() {
 #if defined(__EMSCRIPTEN__)
     __asm__ __volatile__("" ::: "memory");
@@ -0,0 +1,231 @@
+#include "work_stealing_deque.hpp"
+#include "../core/core_internal.h"
+#include <new>
+
+using namespace sy;
+
+struct sy::WorkStealingDeque::Buffer {
+    std::atomic<void*>* items;
+    /// Capacity minus one. Capacity is always a power of two.
+    int64_t mask;
+    /// The buffer this one was grown from, if any.
+    Buffer* previous;
+
+    void put(int64_t index, void* item) noexcept {
+        this->items[index & this->mask].store(item, std::memory_order_relaxed);
+    }
+
+    void* get(int64_t index) const noexcept {
+        return this->items[index & this->mask].load(std::memory_order_relaxed);
+    }
+};
+
+static constexpr int64_t INITIAL_CAPACITY = 64;
+
+sy::WorkStealingDeque::~WorkStealingDeque() noexcept {
+    Allocator alloc{};
+    Buffer* buffer = this->buffer_.load(std::memory_order_relaxed);
+    while (buffer != nullptr) {
+        Buffer* previous = buffer->previous;
+        alloc.freeArray(buffer->items, static_cast<size_t>(buffer->mask + 1));
+        alloc.freeObject(buffer);
+        buffer = previous;
+    }
+}
+
+Result<void, AllocErr> sy::WorkStealingDeque::push(void* item) noexcept {
+    sy_assert(item != nullptr, "Cannot push null items, as they mean the deque is empty");
+
+    const int64_t bottom = this->bottom_.load(std::memory_order_relaxed);
+    const int64_t top = this->top_.load(std::memory_order_acquire);
+    Buffer* buffer = this->buffer_.load(std::memory_order_relaxed);
+    if (buffer == nullptr || (bottom - top) > buffer->mask) {
+        auto growRes = this->grow(buffer, top, bottom);
+        if (growRes.hasErr()) {
+            return Error(AllocErr::OutOfMemory);
+        }
+        buffer = growRes.value();
+    }
+
+    buffer->put(bottom, item);
+    this->bottom_.store(bottom + 1, std::memory_order_release);
+    return {};
+}
+
+void* sy::WorkStealingDeque::pop() noexcept {
+    Buffer* buffer = this->buffer_.load(std::memory_order_relaxed);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    // Sequentially consistent rather than the paper's fences, which thread sanitizers don't
+    // support. Either way, thieves must see the reservation before `top_` is read.
+    const int64_t bottom = this->bottom_.load(std::memory_order_relaxed) - 1;
+    this->bottom_.store(bottom, std::memory_order_seq_cst);
+    int64_t top = this->top_.load(std::memory_order_seq_cst);
+
+    if (top > bottom) { // empty
+        this->bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    void* item = buffer->get(bottom);
+    if (top == bottom) {
+        // Last item, so race any thieves for it.
+        if (!this->top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        this->bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+void* sy::WorkStealingDeque::steal() noexcept {
+    int64_t top = this->top_.load(std::memory_order_seq_cst);
+    const int64_t bottom = this->bottom_.load(std::memory_order_seq_cst);
+    if (top >= bottom) {
+        return nullptr;
+    }
+
+    const Buffer* buffer = this->buffer_.load(std::memory_order_acquire);
+    void* item = buffer->get(top);
+    if (!this->top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+size_t sy::WorkStealingDeque::approximateLen() const noexcept {
+    const int64_t bottom = this->bottom_.load(std::memory_order_relaxed);
+    const int64_t top = this->top_.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+}
+
+Result<WorkStealingDeque::Buffer*, AllocErr>
+sy::WorkStealingDeque::grow(Buffer* buffer, int64_t top, int64_t bottom) noexcept {
+    const int64_t capacity = buffer == nullptr ? INITIAL_CAPACITY : (buffer->mask + 1) * 2;
+    Allocator alloc{};
+    auto itemsRes = alloc.allocArray<std::atomic<void*>>(static_cast<size_t>(capacity));
+    if (itemsRes.hasErr()) {
+        return Error(AllocErr::OutOfMemory);
+    }
+    auto newRes = alloc.allocObject<Buffer>();
+    if (newRes.hasErr()) {
+        alloc.freeArray(itemsRes.value(), static_cast<size_t>(capacity));
+        return Error(AllocErr::OutOfMemory);
+    }
+
+    std::atomic<void*>* items = itemsRes.value();
+    for (int64_t i = 0; i < capacity; i++) {
+        new (&items[i]) std::atomic<void*>(nullptr);
+    }
+    Buffer* newBuffer = newRes.value();
+    newBuffer->items = items;
+    newBuffer->mask = capacity - 1;
+    newBuffer->previous = buffer;
+    for (int64_t i = top; i < bottom; i++) {
+        newBuffer->put(i, buffer->get(i));
+    }
+    this->buffer_.store(newBuffer, std::memory_order_release);
+    return newBuffer;
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../doctest.h"
+#include <thread>
+
+TEST_CASE("[WorkStealingDeque] owner pops in LIFO order and thieves steal in FIFO order") {
+    WorkStealingDeque deque;
+    CHECK_EQ(deque.pop(), nullptr);
+    CHECK_EQ(deque.steal(), nullptr);
+
+    int items[4] = {};
+    for (int& item : items) {
+        REQUIRE(deque.push(&item));
+    }
+    CHECK_EQ(deque.approximateLen(), 4);
+    CHECK_EQ(deque.steal(), &items[0]);
+    CHECK_EQ(deque.pop(), &items[3]);
+    CHECK_EQ(deque.steal(), &items[1]);
+    CHECK_EQ(deque.pop(), &items[2]);
+    CHECK_EQ(deque.pop(), nullptr);
+    CHECK_EQ(deque.steal(), nullptr);
+    CHECK_EQ(deque.approximateLen(), 0);
+}
+
+TEST_CASE("[WorkStealingDeque] grows past its initial capacity") {
+    WorkStealingDeque deque;
+    constexpr size_t COUNT = 1000;
+    int* items = new int[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        REQUIRE(deque.push(&items[i]));
+    }
+    for (size_t i = 0; i < COUNT / 2; i++) {
+        CHECK_EQ(deque.steal(), &items[i]);
+    }
+    for (size_t i = COUNT; i > COUNT / 2; i--) {
+        CHECK_EQ(deque.pop(), &items[i - 1]);
+    }
+    CHECK_EQ(deque.pop(), nullptr);
+    delete[] items;
+}
+
+TEST_CASE("[WorkStealingDeque] every item is taken exactly once under concurrent stealing") {
+    WorkStealingDeque deque;
+    constexpr size_t COUNT = 20000;
+    constexpr size_t THIEVES = 4;
+    std::atomic<uint32_t>* taken = new std::atomic<uint32_t>[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        taken[i].store(0);
+    }
+    // Item pointers are offset by one, as null means empty.
+    auto toItem = [](size_t i) { return reinterpret_cast<void*>(i + 1); };
+    auto fromItem = [](void* item) { return reinterpret_cast<size_t>(item) - 1; };
+
+    std::atomic<bool> done{false};
+    std::thread thieves[THIEVES];
+    for (std::thread& thief : thieves) {
+        thief = std::thread([&]() {
+            while (!done.load()) {
+                void* item = deque.steal();
+                if (item != nullptr) {
+                    taken[fromItem(item)].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (size_t i = 0; i < COUNT; i++) {
+        CHECK(deque.push(toItem(i)));
+        if ((i % 3) == 0) {
+            void* item = deque.pop();
+            if (item != nullptr) {
+                taken[fromItem(item)].fetch_add(1);
+            }
+        }
+    }
+    while (void* item = deque.pop()) {
+        taken[fromItem(item)].fetch_add(1);
+    }
+    while (deque.approximateLen() > 0) {
+        std::this_thread::yield();
+    }
+    done.store(true);
+    for (std::thread& thief : thieves) {
+        thief.join();
+    }
+
+    size_t wrongCount = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        if (taken[i].load() != 1) {
+            wrongCount += 1;
+        }
+    }
+    CHECK_EQ(wrongCount, 0);
+    delete[] taken;
+}
+
+#endif // SYNC_LIB_WITH_TESTS
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef SY_THREADING_WORK_STEALING_DEQUE_HPP_
+#define SY_THREADING_WORK_STEALING_DEQUE_HPP_
+
+#include "../core/core.h"
+#include "../mem/allocator.hpp"
+#include "../types/result/result.hpp"
+#include "alloc_cache_align.hpp"
+#include <atomic>
+
+namespace sy {
+
+#if defined(_MSC_VER)
+// Supress warning for struct padding due to alignment specifier
+// https://learn.microsoft.com/en-us/cpp/error-messages/compiler-warnings/compiler-warning-level-4-c4324?view=msvc-170
+#pragma warning(push)
+#pragma warning(disable : 4324)
+#endif
+/// Chase-Lev work stealing deque of non-null pointers. Only the thread owning the deque may push
+/// and pop, which happen at the bottom, in LIFO order. Any thread may steal from the top, in FIFO
+/// order, so the oldest and typically largest work is what gets stolen.
+///
+/// Based on "Correct and Efficient Work-Stealing for Weak Memory Models" by Lê et al. The ring
+/// buffer grows when full. Buffers that were grown out of are kept until the deque is destroyed,
+/// as thieves may still be reading from them.
+class WorkStealingDeque final {
+  public:
+    WorkStealingDeque() = default;
+
+    ~WorkStealingDeque() noexcept;
+
+    WorkStealingDeque(const WorkStealingDeque& other) = delete;
+
+    WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+    /// Pushes `item` to the bottom of the deque. Only callable by the owning thread.
+    [[nodiscard]] Result<void, AllocErr> push(void* item) noexcept;
+
+    /// Pops the most recently pushed item. Only callable by the owning thread.
+    /// @return The item, or `nullptr` if the deque is empty.
+    [[nodiscard]] void* pop() noexcept;
+
+    /// Steals the least recently pushed item. Callable by any thread.
+    /// @return The item, or `nullptr` if the deque is empty or another thread took the item first.
+    [[nodiscard]] void* steal() noexcept;
+
+    /// Approximate amount of items in the deque, as other threads may be pushing or stealing.
+    [[nodiscard]] size_t approximateLen() const noexcept;
+
+  private:
+    struct Buffer;
+
+    [[nodiscard]] Result<Buffer*, AllocErr> grow(Buffer* buffer, int64_t top,
+                                                 int64_t bottom) noexcept;
+
+    alignas(ALLOC_CACHE_ALIGN) std::atomic<int64_t> top_{0};
+    alignas(ALLOC_CACHE_ALIGN) std::atomic<int64_t> bottom_{0};
+    std::atomic<Buffer*> buffer_{nullptr};
+};
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+} // namespace sy
+
+#endif // SY_THREADING_WORK_STEALING_DEQUE_HPP_
@@ -238,6 +238,10 @@ StringSlice sy::AnyError::message() const noexcept {
             return StringSlice("Arithmetic Error");
         case Exceptional::Capacity:
             return StringSlice("Capacity Error");
+        case Exceptional::Cancelled:
+            return StringSlice("Cancelled");
+        case Exceptional::Signature:
+            return StringSlice("Signature Mismatch");
         case Exceptional::Other:
         default:
             return StringSlice("Unknown Exception");
@@ -488,7 +488,7 @@ void* sy::RawDynArrayUnmanaged::Iterator::operator*() const noexcept { return cu
 
 sy::RawDynArrayUnmanaged::Iterator& sy::RawDynArrayUnmanaged::Iterator::operator++() noexcept {
     uint8_t* ptr = reinterpret_cast<uint8_t*>(this->current);
-    this->current = ptr - this->size;
+    this->current = ptr + this->size;
     return *this;
 }
 
@@ -511,7 +511,7 @@ const void* sy::RawDynArrayUnmanaged::ConstIterator::operator*() const noexcept
 sy::RawDynArrayUnmanaged::ConstIterator&
 sy::RawDynArrayUnmanaged::ConstIterator::operator++() noexcept {
     const uint8_t* ptr = reinterpret_cast<const uint8_t*>(this->current);
-    this->current = ptr - this->size;
+    this->current = ptr + this->size;
     return *this;
 }
 
@@ -527,7 +527,7 @@ inline Result<void, AllocErr> DynArrayUnmanaged<T>::reserve(Allocator& alloc, si
 }
 
 template <typename T> inline DynArray<T>& DynArray<T>::operator=(DynArray&& other) noexcept {
-    this->inner_.moveAssign(other.inner_, this->alloc_);
+    this->inner_.moveAssign(std::move(other.inner_), this->alloc_);
     this->alloc_ = other.alloc_; // now own the memory from the other allocator
     return *this;
 }
@@ -1,4 +1,5 @@
 #include "function.h"
+#include "../../compiler/lazy_function.hpp"
 #include "../../core/core_internal.h"
 #include "../../interpreter/interpreter.hpp"
 #include "../../interpreter/stack/stack.hpp"
@@ -7,8 +8,10 @@
 #include "../../program/program_internal.hpp"
 #include "../../threading/alloc_cache_align.hpp"
 #include "../type_info.h"
+#include "../task/task_internal.hpp"
 #include "../type_info.hpp"
 #include "function.hpp"
+#include "function_internal.hpp"
 #include <cstring>
 #include <new>
 #include <utility>
@@ -82,6 +85,9 @@ class alignas(ALLOC_CACHE_ALIGN) ArgBuf {
     size_t typesAndOffsetsCapacity = 0;
     void* retDst = nullptr;
     const RawFunction* func = nullptr;
+    /// If non-null, the arguments are referenced in place from here rather than stored within
+    /// `values`, with `count` being the amount of them.
+    const BorrowedArg* borrowed = nullptr;
 
     // False sharing must be avoided, since arg buffers are intended to be threadlocal.
 };
@@ -169,6 +175,9 @@ void ArgBuf::push(const Arg& arg) {
 
 ArgBuf::Arg ArgBuf::at(size_t index) const {
     sy_assert(index < this->count, "C function argument Index out of bounds");
+    if (this->borrowed != nullptr) {
+        return Arg{this->borrowed[index].mem, this->borrowed[index].type};
+    }
     Arg a{};
     a.mem = const_cast<void*>(reinterpret_cast<const void*>(&this->values[this->offsets[index]]));
     a.type = this->types[index];
@@ -178,6 +187,7 @@ ArgBuf::Arg ArgBuf::at(size_t index) const {
 void ArgBuf::take(void* outValue, size_t index) {
     sy_assert(outValue != nullptr, "Cannot store argument to null memory");
     sy_assert(index < this->count, "C function argument index out of bounds");
+    sy_assert(this->borrowed == nullptr, "Cannot take borrowed arguments out of the buffer");
 
     const Type* type = this->types[index];
     sy_assert(type != nullptr, "Cannot take argument twice");
@@ -214,26 +224,20 @@ void ArgBuf::setReturnValue(const void* value, const size_t sizeOfType) {
 size_t ArgBuf::nextOffset(const size_t sizeType, const size_t alignType) const {
     sy_assert(this->values != nullptr, "Cannot get the next offset from an invalid memory address");
 
-    const size_t valuesAddr = reinterpret_cast<size_t>(this->values);
-    const size_t remainder = (valuesAddr % alignType);
-    if (this->count == 0 && remainder == 0) {
-        return 0;
-    }
-    const size_t requiredShift = alignType - (valuesAddr % alignType);
-
-    if (this->count == 0) {
-        if ((requiredShift + sizeType) > this->valuesCapacity) {
-            return INVALID_OFFSET;
-        }
-
-        return requiredShift;
-    } else {
-        if ((this->offsets[this->count - 1] + requiredShift + sizeType) > this->valuesCapacity) {
-            return INVALID_OFFSET;
-        }
-
-        return this->offsets[this->count - 1] + requiredShift;
+    // Arguments go after the previous one, aligned by address, as `values` may be less aligned
+    // than the type.
+    const size_t previousEnd =
+        this->count == 0
+            ? 0
+            : this->offsets[this->count - 1] + this->types[this->count - 1]->sizeType;
+    const size_t misalignment =
+        (reinterpret_cast<size_t>(this->values) + previousEnd) % alignType;
+    const size_t offset =
+        misalignment == 0 ? previousEnd : previousEnd + (alignType - misalignment);
+    if ((offset + sizeType) > this->valuesCapacity) {
+        return INVALID_OFFSET;
     }
+    return offset;
 }
 
 void ArgBuf::reallocate(const size_t sizeNewType) {
@@ -425,9 +429,8 @@ bool sy::RawFunction::CallArgs::push(void* argMem, const Type* typeInfo) {
         sy_assert(newOffset <= UINT16_MAX, "Cannot push argument. Would overflow script stack");
         sy_assert(newOffset <= scriptInfo->stackSpaceRequired,
                   "Pushing argument would overflow this function's script stack");
-        (void)newOffset;
 
-        this->_offset = static_cast<uint16_t>(slotsOccupied);
+        this->_offset = static_cast<uint16_t>(newOffset);
     } else if (this->func->tag == FunctionType::C) {
         const ArgBuf::Arg arg = {argMem, reinterpret_cast<const sy::Type*>(typeInfo)};
         cArgBufs.bufAt(this->_offset).push(arg);
@@ -457,8 +460,10 @@ sy::Result<void, sy::AnyError> sy::RawFunction::CallArgs::call(void* retDst) noe
             buf.setReturnDestination(retDst);
         }
         auto err = cfunc(handler);
-        buf.func = nullptr;
-        buf.clear();
+        // Nested calls may have reallocated the argument buffers.
+        ArgBuf& bufAfter = cArgBufs.bufAt(handlerIndex);
+        bufAfter.func = nullptr;
+        bufAfter.clear();
         cArgBufs.popBuf();
         this->func = nullptr;
         return err;
@@ -467,17 +472,66 @@ sy::Result<void, sy::AnyError> sy::RawFunction::CallArgs::call(void* retDst) noe
     }
 }
 
+Result<void, AnyError> sy::callCFunctionBorrowedArgs(const RawFunction* function,
+                                                     const BorrowedArg* args,
+                                                     uint16_t argsCount, void* retDst) noexcept {
+    sy_assert(function->tag == FunctionType::C, "Expected C function");
+    sy_assert(argsCount == function->argsLen, "Mismatched number of arguments passed to function");
+
+    const uint32_t handlerIndex = cArgBufs.pushNewBuf();
+    {
+        ArgBuf& buf = cArgBufs.bufAt(handlerIndex);
+        buf.borrowed = args;
+        buf.count = argsCount;
+        buf.func = function;
+        if (retDst != nullptr) {
+            buf.setReturnDestination(retDst);
+        }
+    }
+
+    const auto cfunc = (c_function_t)(function->fptr);
+    auto err = cfunc(FunctionHandler{handlerIndex});
+
+    // Nested calls may have reallocated the argument buffers.
+    ArgBuf& buf = cArgBufs.bufAt(handlerIndex);
+    buf.borrowed = nullptr;
+    buf.func = nullptr;
+    buf.retDst = nullptr;
+    cArgBufs.popBuf();
+    return err;
+}
+
 Result<RawTask, AnyError> sy::RawFunction::CallArgs::callParallel() noexcept {
     sy_assert_release(this->pushedCount == this->func->argsLen,
                       "Did not push enough arguments for function");
 
-    /*
-    1. submit task to thread pool
-    2. when ran, create a new stack and swap the current threadlocal active stack
-    3. when finish, restore the previous threadlocal active stack
-    */
+    const RawFunction* function = this->func;
+    auto taskRes = detail::TaskUtils::createTask(function);
+    if (taskRes.hasErr()) {
+        return Error(taskRes.takeErr());
+    }
+    void* task = taskRes.value();
+
+    // The call happens on another thread, likely after this returns, so the arguments are moved
+    // into the task, to be pushed again by whichever thread runs it.
+    void* const* args = detail::TaskUtils::taskArgs(task);
+    if (function->tag == FunctionType::Script) {
+        Stack::getActiveStack().takeScriptFunctionArgs(function, args);
+    } else if (function->tag == FunctionType::C) {
+        ArgBuf& buf = cArgBufs.bufAt(this->_offset);
+        for (uint16_t i = 0; i < function->argsLen; i++) {
+            const ArgBuf::Arg arg = buf.at(i);
+            memcpy(args[i], arg.mem, arg.type->sizeType);
+        }
+        buf.func = nullptr;
+        buf.clear();
+        cArgBufs.popBuf();
+    } else {
+        sync_unreachable();
+    }
+    this->func = nullptr;
 
-    return Error(AnyError(Exceptional::Capacity));
+    return detail::TaskUtils::submitTask(task);
 }
 
 sy::RawFunction::CallArgs sy::RawFunction::startCall() const {
@@ -485,6 +539,9 @@ sy::RawFunction::CallArgs sy::RawFunction::startCall() const {
     callArgs.func = this;
     if (this->tag == FunctionType::C) {
         callArgs._offset = static_cast<uint16_t>(cArgBufs.pushNewBuf());
+    } else {
+        // Arguments are pushed into a frame sized by the compiled function.
+        ensureFunctionCompiled(this);
     }
     return callArgs;
 }
@@ -26,6 +26,10 @@ enum class FunctionType : int32_t {
 
 class FunctionHandler {
     friend class RawFunction;
+    friend Result<void, AnyError> callCFunctionBorrowedArgs(const RawFunction* function,
+                                                            const struct BorrowedArg* args,
+                                                            uint16_t argsCount,
+                                                            void* retDst) noexcept;
 
   public:
     /// Moves a function argument out of the argument buffer, taking ownership of it.
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef SY_TYPES_FUNCTION_FUNCTION_INTERNAL_HPP_
+#define SY_TYPES_FUNCTION_FUNCTION_INTERNAL_HPP_
+
+#include "../../core/core.h"
+#include "../anyerror/anyerror.hpp"
+#include "../result/result.hpp"
+
+namespace sy {
+class Type;
+class RawFunction;
+
+/// Argument of a C function call that lives in memory owned by the caller, such as a script
+/// frame slot.
+struct BorrowedArg {
+    void* mem;
+    const Type* type;
+};
+
+/// Calls a C function, with its `FunctionHandler` referencing `args` in place rather than copying
+/// them into an argument buffer. The caller keeps ownership of every argument, destroying them as
+/// usual after the call. `FunctionHandler::takeArg(...)` references the caller's memory, so moving
+/// from it leaves a moved-from object there, and arguments can't be taken out of the buffer with
+/// `ArgBuf::take(...)`. `args` must remain valid until this returns, and each argument must be
+/// aligned to its type.
+/// @param retDst Where the return value is written. Must be null if the function does not return
+/// a value.
+Result<void, AnyError> callCFunctionBorrowedArgs(const RawFunction* function,
+                                                 const BorrowedArg* args, uint16_t argsCount,
+                                                 void* retDst) noexcept;
+} // namespace sy
+
+#endif // SY_TYPES_FUNCTION_FUNCTION_INTERNAL_HPP_
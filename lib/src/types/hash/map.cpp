@@ -14,6 +14,17 @@ sy::RawMapUnmanaged::~RawMapUnmanaged() noexcept {
     sy_assert_release(this->groupCount_ == 0, "RawMapUnmanaged memory leak detected");
 }
 
+sy::RawMapUnmanaged::RawMapUnmanaged(RawMapUnmanaged&& other) noexcept
+    : count_(other.count_), groups_(other.groups_), groupCount_(other.groupCount_), available_(other.available_),
+      iterFirst_(other.iterFirst_), iterLast_(other.iterLast_) {
+    other.count_ = 0;
+    other.groups_ = nullptr;
+    other.groupCount_ = 0;
+    other.available_ = 0;
+    other.iterFirst_ = nullptr;
+    other.iterLast_ = nullptr;
+}
+
 void sy::RawMapUnmanaged::destroy(Allocator& alloc, void (*destructKey)(void* ptr), void (*destructValue)(void* ptr),
                                   size_t keySize, size_t keyAlign, size_t valueSize, size_t valueAlign) noexcept {
     Group* groups = asGroupsMut(this->groups_);
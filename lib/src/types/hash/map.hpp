@@ -21,6 +21,10 @@ class SY_API RawMapUnmanaged final {
 
     ~RawMapUnmanaged() noexcept;
 
+    RawMapUnmanaged(RawMapUnmanaged&& other) noexcept;
+
+    RawMapUnmanaged& operator=(RawMapUnmanaged&& other) = delete;
+
     void destroy(Allocator& alloc, void (*destructKey)(void* ptr), void (*destructValue)(void* ptr), size_t keySize,
                  size_t keyAlign, size_t valueSize, size_t valueAlign) noexcept;
 
@@ -197,6 +201,10 @@ template <typename K, typename V> class MapUnmanaged final {
 
     ~MapUnmanaged() noexcept = default;
 
+    MapUnmanaged(MapUnmanaged&& other) noexcept = default;
+
+    MapUnmanaged& operator=(MapUnmanaged&& other) = delete;
+
     void destroy(Allocator& alloc) noexcept;
 
     [[nodiscard]] size_t len() const { return this->inner_.len(); }
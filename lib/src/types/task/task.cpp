@@ -1,66 +1,393 @@
 #include "task.hpp"
+#include "task.h"
 #include "../../core/core_internal.h"
 #include "../../interpreter/stack/stack.hpp"
+#include "../../threading/locks/locks_internal.hpp"
 #include "../../threading/locks/rwlock.hpp"
 #include "../function/function.hpp"
 #include "../option/option.hpp"
 #include "../type_info.hpp"
+#include "task_internal.hpp"
+#include <atomic>
 #include <cstring>
+#include <new>
 
 using namespace sy;
 
+static_assert(sizeof(TaskExecutor) == sizeof(SyTaskExecutor));
+static_assert(alignof(TaskExecutor) == alignof(SyTaskExecutor));
+
+extern "C" {
+SY_API void sy_task_executor_run(SyTaskExecutor task) {
+    reinterpret_cast<TaskExecutor*>(&task)->run();
+}
+}
+
+static size_t alignedTo(size_t offset, size_t align) {
+    return ((offset + align - 1) / align) * align;
+}
+
 namespace sy {
+/// Start of a task's allocation, which is followed by the return value, then an array of pointers
+/// to each argument, then the arguments themselves.
 struct TaskHeader {
+    /// Not done, and no thread is sleeping until it is.
+    static constexpr uint32_t RUNNING = 0;
+    /// Not done, and at least one thread is sleeping on `state_` until it is.
+    static constexpr uint32_t AWAITED = 1;
+    static constexpr uint32_t DONE = 2;
+    /// Not done, and `listenerFn_` is called once it is.
+    static constexpr uint32_t LISTENED = 3;
+
+    /// Called on the thread finishing the task, once it's done. The listener may free the task, but
+    /// nothing else may until the listener returns.
+    using ListenerFn = void (*)(void* context, TaskHeader* task);
+
     Allocator alloc_;
-    SyAtomicBool isDone_;
+    std::atomic<uint32_t> state_;
+    /// One for the task's owner, plus one per task created while this one was running, as their
+    /// cancellation tokens link to this task's. The allocation is freed once none are left.
+    std::atomic<uint32_t> refs_;
+    /// The task that was running when this one was created, if any.
+    TaskHeader* parent_;
+    TaskCancelToken cancel_;
+    /// Only set while `state_` is `LISTENED`.
+    ListenerFn listenerFn_;
+    void* listenerContext_;
     RwLock lock_;
     Option<AnyError> encounteredErr_;
     const RawFunction* function_;
-    Stack stack_;
+    /// Null if the function takes no arguments.
+    void** args_;
+    size_t valueOffset_;
+    size_t allocSize_;
+    size_t allocAlign_;
 
     const Type* valType() const { return this->function_->returnType; }
 
     uintptr_t valueMemLocation() const {
-        const size_t memOffset =
-            sizeof(TaskHeader) + paddingForType<TaskHeader>(this->valType()->alignType);
         const uint8_t* asBytes = reinterpret_cast<const uint8_t*>(this);
-        return reinterpret_cast<uintptr_t>(&asBytes[memOffset]);
+        return reinterpret_cast<uintptr_t>(&asBytes[this->valueOffset_]);
     }
 
     const void* valueMem() const { return reinterpret_cast<const void*>(this->valueMemLocation()); }
 
     void* valueMemMut() { return reinterpret_cast<void*>(this->valueMemLocation()); }
 
-    void destroy() {
-        const size_t allocAlign = this->valType()->alignType < SYNC_CACHE_LINE_SIZE
-                                      ? SYNC_CACHE_LINE_SIZE
-                                      : this->valType()->alignType;
-        const size_t fullAllocSize = sizeof(TaskHeader) +
-                                     paddingForType<TaskHeader>(this->valType()->alignType) +
-                                     this->valType()->sizeType;
+    static Result<TaskHeader*, AllocErr> create(const RawFunction* function, Allocator alloc,
+                                                TaskHeader* parent) {
+        size_t allocAlign = SYNC_CACHE_LINE_SIZE;
+        size_t offset = sizeof(TaskHeader);
+
+        size_t valueOffset = offset;
+        if (function->returnType != nullptr) {
+            const size_t align = function->returnType->alignType;
+            allocAlign = align > allocAlign ? align : allocAlign;
+            valueOffset = alignedTo(offset, align);
+            offset = valueOffset + function->returnType->sizeType;
+        }
+
+        const size_t argsOffset = alignedTo(offset, alignof(void*));
+        offset = argsOffset + (sizeof(void*) * function->argsLen);
+        // Offsets of each argument are recomputed the same way below, once allocated.
+        for (uint16_t i = 0; i < function->argsLen; i++) {
+            const Type* argType = function->argsTypes[i];
+            allocAlign = argType->alignType > allocAlign ? argType->alignType : allocAlign;
+            offset = alignedTo(offset, argType->alignType) + argType->sizeType;
+        }
+
+        auto memRes = alloc.allocAlignedArray<uint8_t>(offset, allocAlign);
+        if (memRes.hasErr()) {
+            return Error(AllocErr::OutOfMemory);
+        }
+        uint8_t* mem = memRes.value();
 
-        sy::Allocator alloc = this->alloc_;
-        uint8_t* mem = reinterpret_cast<uint8_t*>(this);
+        TaskHeader* header = new (mem) TaskHeader();
+        header->alloc_ = alloc;
+        header->state_.store(RUNNING, std::memory_order_relaxed);
+        header->refs_.store(1, std::memory_order_relaxed);
+        header->parent_ = parent;
+        if (parent != nullptr) {
+            parent->refs_.fetch_add(1, std::memory_order_relaxed);
+            header->cancel_.link(&parent->cancel_);
+        }
+        header->function_ = function;
+        header->listenerFn_ = nullptr;
+        header->listenerContext_ = nullptr;
+        header->args_ = nullptr;
+        header->valueOffset_ = valueOffset;
+        header->allocSize_ = offset;
+        header->allocAlign_ = allocAlign;
 
-        this->~TaskHeader();
-        alloc.freeAlignedArray(mem, fullAllocSize, allocAlign);
+        if (function->argsLen > 0) {
+            header->args_ = reinterpret_cast<void**>(&mem[argsOffset]);
+            size_t argOffset = argsOffset + (sizeof(void*) * function->argsLen);
+            for (uint16_t i = 0; i < function->argsLen; i++) {
+                const Type* argType = function->argsTypes[i];
+                argOffset = alignedTo(argOffset, argType->alignType);
+                header->args_[i] = &mem[argOffset];
+                argOffset += argType->sizeType;
+            }
+        }
+        return header;
+    }
+
+    /// Sets the listener called once the task is done. Only the task's owner may set listeners.
+    /// @return `false` if the task is already done, in which case no listener is set.
+    bool listen(ListenerFn fn, void* context) noexcept {
+        this->listenerFn_ = fn;
+        this->listenerContext_ = context;
+        uint32_t expected = RUNNING;
+        return this->state_.compare_exchange_strong(expected, LISTENED, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire);
+    }
+
+    /// Removes the listener set by `listen(...)`.
+    /// @return `false` if the task finished first, in which case the listener is called regardless.
+    bool unlisten() noexcept {
+        uint32_t expected = LISTENED;
+        return this->state_.compare_exchange_strong(expected, RUNNING, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire);
+    }
+
+    /// Marks the task as done, then wakes whatever is waiting on it.
+    void finish() noexcept {
+        // The awaiting thread may free the task as soon as it's done, so only the address is used
+        // after. Listeners instead hold off anything freeing the task until they return.
+        void* stateAddress = &this->state_;
+        const uint32_t previous = this->state_.exchange(DONE, std::memory_order_acq_rel);
+        if (previous == AWAITED) {
+            internal::wakeAllOnAddress(stateAddress);
+        } else if (previous == LISTENED) {
+            this->listenerFn_(this->listenerContext_, this);
+        }
+    }
+
+    /// Destroys the arguments of a task that won't run.
+    void destroyArgs() noexcept {
+        for (uint16_t i = 0; i < this->function_->argsLen; i++) {
+            this->function_->argsTypes[i]->destroyObject(this->args_[i]);
+        }
+    }
+
+    /// Releases the owner's reference. Tasks created while this one was running may still be
+    /// linked to its cancellation token, in which case the last of them frees it instead.
+    void destroy() {
+        TaskHeader* task = this;
+        while (task != nullptr && task->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            TaskHeader* parent = task->parent_;
+            const size_t fullAllocSize = task->allocSize_;
+            const size_t allocAlign = task->allocAlign_;
+            sy::Allocator alloc = task->alloc_;
+            uint8_t* mem = reinterpret_cast<uint8_t*>(task);
+
+            task->cancel_.unlink();
+            task->~TaskHeader();
+            alloc.freeAlignedArray(mem, fullAllocSize, allocAlign);
+            task = parent;
+        }
     }
 };
 
 } // namespace sy
 
+void TaskCancelToken::link(TaskCancelToken* parentToken) noexcept {
+    std::lock_guard<std::mutex> lock(parentToken->childrenMutex);
+    this->parent = parentToken;
+    this->nextSibling = parentToken->firstChild;
+    if (parentToken->firstChild != nullptr) {
+        parentToken->firstChild->prevSibling = this;
+    }
+    parentToken->firstChild = this;
+    // Cancelling the parent sets its flag before walking its children, so either this sees the
+    // flag, or the cancellation sees this token.
+    if (parentToken->isCancelled()) {
+        this->cancelled.store(true, std::memory_order_relaxed);
+    }
+}
+
+void TaskCancelToken::unlink() noexcept {
+    if (this->parent == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(this->parent->childrenMutex);
+    if (this->prevSibling != nullptr) {
+        this->prevSibling->nextSibling = this->nextSibling;
+    } else {
+        this->parent->firstChild = this->nextSibling;
+    }
+    if (this->nextSibling != nullptr) {
+        this->nextSibling->prevSibling = this->prevSibling;
+    }
+    this->parent = nullptr;
+}
+
+void TaskCancelToken::cancel() noexcept {
+    // Whatever cancelled this token first already cancelled its children, and tokens linked after
+    // copy the flag.
+    if (this->cancelled.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(this->childrenMutex);
+    for (TaskCancelToken* child = this->firstChild; child != nullptr; child = child->nextSibling) {
+        child->cancel();
+    }
+}
+
+/// The task running on this thread, which tasks created by it are linked to.
+static thread_local TaskHeader* runningTask = nullptr;
+
+/// How many queued tasks this thread is running inline while awaiting others.
+static thread_local uint32_t awaitHelpDepth = 0;
+
+/// Runs one queued task, unless this thread is already `MAX_AWAIT_HELP_DEPTH` tasks deep in doing
+/// so, as any queued task may await others in turn.
+/// @return `false` if no task ran.
+static bool helpRunQueuedTask() noexcept {
+    if (awaitHelpDepth >= MAX_AWAIT_HELP_DEPTH) {
+        return false;
+    }
+    awaitHelpDepth += 1;
+    const bool ran = runQueuedTask();
+    awaitHelpDepth -= 1;
+    return ran;
+}
+
+const TaskCancelToken* sy::runningTaskCancelToken() noexcept {
+    return runningTask == nullptr ? nullptr : &runningTask->cancel_;
+}
+
 const TaskHeader* asHeader(const void* inner) { return reinterpret_cast<const TaskHeader*>(inner); }
 
 TaskHeader* asHeaderMut(void* inner) { return reinterpret_cast<TaskHeader*>(inner); }
 
+Result<void*, AnyError> detail::TaskUtils::createTask(const RawFunction* function) noexcept {
+    auto headerRes = TaskHeader::create(function, Allocator(), runningTask);
+    if (headerRes.hasErr()) {
+        return Error(AnyError(Exceptional::OOM));
+    }
+    return reinterpret_cast<void*>(headerRes.value());
+}
+
+void* const* detail::TaskUtils::taskArgs(void* task) noexcept { return asHeaderMut(task)->args_; }
+
+void detail::TaskUtils::destroyTask(void* task) noexcept { asHeaderMut(task)->destroy(); }
+
+Result<RawTask, AnyError> detail::TaskUtils::submitTask(void* task) noexcept {
+    if (auto res = submitToTaskPool(TaskExecutor(task)); res.hasErr()) {
+        asHeaderMut(task)->destroy();
+        return Error(res.takeErr());
+    }
+    return RawTask(task);
+}
+
+namespace {
+/// Stacks that tasks ran on, kept per thread so later tasks reuse their already grown nodes rather
+/// than allocating their own. A task run inline while another is awaited on the same thread takes
+/// a different stack, as the awaiting task's stack is still in use.
+class TaskStackPool {
+  public:
+    TaskStackPool() = default;
+
+    ~TaskStackPool() noexcept {
+        for (size_t i = 0; i < this->len_; i++) {
+            destroyStack(this->stacks_[i]);
+        }
+    }
+
+    TaskStackPool(const TaskStackPool& other) = delete;
+
+    TaskStackPool& operator=(const TaskStackPool& other) = delete;
+
+    /// @return An empty stack, or null if allocating one failed.
+    Stack* acquire() noexcept {
+        if (this->len_ > 0) {
+            this->len_ -= 1;
+            return this->stacks_[this->len_];
+        }
+        Allocator alloc{};
+        auto stackRes = alloc.allocObject<Stack>();
+        if (stackRes.hasErr()) {
+            return nullptr;
+        }
+        return new (stackRes.value()) Stack();
+    }
+
+    void release(Stack* stack) noexcept {
+        // Frames left behind would be seen by the next task, so such a stack isn't reused.
+        if (this->len_ == CAPACITY || stack->getCurrentFrame().has_value()) {
+            destroyStack(stack);
+            return;
+        }
+        this->stacks_[this->len_] = stack;
+        this->len_ += 1;
+    }
+
+  private:
+    /// Covers tasks run inline while awaiting, a few levels deep.
+    static constexpr size_t CAPACITY = 8;
+
+    static void destroyStack(Stack* stack) noexcept {
+        stack->~Stack();
+        Allocator alloc{};
+        alloc.freeObject(stack);
+    }
+
+    Stack* stacks_[CAPACITY] = {};
+    size_t len_ = 0;
+};
+
+thread_local TaskStackPool taskStackPool{};
+} // namespace
+
 void TaskExecutor::run() noexcept {
+    sy_assert(this->inner_ != nullptr, "Task has already run");
     TaskHeader* header = asHeaderMut(this->inner_);
     this->inner_ = nullptr;
+    const RawFunction* function = header->function_;
 
-    Stack* previous = Stack::setActiveStack(&header->stack_);
+    // Tasks cancelled while still queued fail without running at all.
+    if (header->cancel_.isCancelled()) {
+        header->destroyArgs();
+        header->encounteredErr_ = Option<AnyError>(AnyError(Exceptional::Cancelled));
+        header->finish();
+        return;
+    }
 
+    Stack* stack = taskStackPool.acquire();
+    if (stack == nullptr) {
+        header->destroyArgs();
+        header->encounteredErr_ = Option<AnyError>(AnyError(Exceptional::OOM));
+        header->finish();
+        return;
+    }
+    Stack* previous = Stack::setActiveStack(stack);
+    TaskHeader* previousTask = runningTask;
+    runningTask = header;
+    {
+        RawFunction::CallArgs callArgs = function->startCall();
+        bool pushedAll = true;
+        for (uint16_t i = 0; i < function->argsLen; i++) {
+            if (callArgs.push(header->args_[i], function->argsTypes[i]) == false) {
+                pushedAll = false;
+                break;
+            }
+        }
+
+        if (pushedAll) {
+            void* retDst = header->valType() == nullptr ? nullptr : header->valueMemMut();
+            auto res = callArgs.call(retDst);
+            if (res.hasErr()) {
+                header->encounteredErr_ = Option<AnyError>(res.takeErr());
+            }
+        } else {
+            header->encounteredErr_ = Option<AnyError>(AnyError(Exceptional::Capacity));
+        }
+    }
+    runningTask = previousTask;
     (void)Stack::setActiveStack(previous);
-    sy_atomic_bool_store(&header->isDone_, true, SY_MEMORY_ORDER_SEQ_CST);
+    taskStackPool.release(stack);
+    header->finish();
 }
 
 RawTask::RawTask(RawTask&& other) noexcept {
@@ -74,7 +401,11 @@ sy::RawTask::~RawTask() noexcept {
 
     auto res = this->awaitDone(nullptr);
     if (res.hasErr()) {
-        syncFatalErrorHandlerFn("Failed to handle Sync program error in Task");
+        // Cancelled tasks are expected to fail, so dropping them is how they're discarded.
+        const Option<Exceptional> kind = res.takeErr().exceptional();
+        if (!kind.hasValue() || kind.value() != Exceptional::Cancelled) {
+            syncFatalErrorHandlerFn("Failed to handle Sync program error in Task");
+        }
     }
 
     this->inner_ = nullptr;
@@ -83,12 +414,33 @@ sy::RawTask::~RawTask() noexcept {
 const Type* sy::RawTask::retType() const noexcept { return asHeader(this->inner_)->valType(); }
 
 Result<bool, AnyError> RawTask::isDone() const noexcept {
-    return sy_atomic_bool_load(&asHeader(this->inner_)->isDone_, SY_MEMORY_ORDER_SEQ_CST);
+    return asHeader(this->inner_)->state_.load(std::memory_order_acquire) == TaskHeader::DONE;
 }
 
 Result<void, AnyError> RawTask::awaitDone(void* outReturn) noexcept {
-    while (!this->isDone()) {
-        sy_thread_yield();
+    std::atomic<uint32_t>& state = asHeaderMut(this->inner_)->state_;
+    internal::SpinYielder yielder;
+    while (true) {
+        uint32_t current = state.load(std::memory_order_acquire);
+        if (current == TaskHeader::DONE) {
+            break;
+        }
+        // The awaited task may be queued behind others, or even on this thread's own deque, so
+        // running queued tasks until it's done can't deadlock a pool of busy workers. Past the
+        // helping depth, this waits for other threads to run it instead.
+        if (helpRunQueuedTask()) {
+            yielder = internal::SpinYielder{};
+            continue;
+        }
+        // Only tasks with sleeping waiters pay for a wake when they finish.
+        if (current == TaskHeader::RUNNING && yielder.willSleep()) {
+            if (!state.compare_exchange_strong(current, TaskHeader::AWAITED,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire)) {
+                continue;
+            }
+        }
+        yielder.yield(&state, TaskHeader::AWAITED);
     }
 
     auto res = this->getIfDone(outReturn);
@@ -100,8 +452,18 @@ Result<void, AnyError> RawTask::awaitDone(void* outReturn) noexcept {
     return {};
 }
 
+void RawTask::cancel() noexcept {
+    sy_assert(this->inner_ != nullptr, "Cannot cancel a task that was already awaited");
+    asHeaderMut(this->inner_)->cancel_.cancel();
+}
+
+bool RawTask::currentIsCancelled() noexcept {
+    const TaskCancelToken* token = runningTaskCancelToken();
+    return token != nullptr && token->isCancelled();
+}
+
 Result<bool, AnyError> RawTask::getIfDone(void* outReturn) noexcept {
-    if (!this->isDone()) {
+    if (!this->isDone().value()) {
         return false;
     }
 
@@ -130,3 +492,165 @@ Result<bool, AnyError> RawTask::getIfDone(void* outReturn) noexcept {
     this->inner_ = nullptr;
     return true;
 }
+
+/// Runs queued tasks up to the helping depth, then sleeps on `word`, until `isReady` returns true
+/// for its value. Whatever makes `word` ready must wake it.
+template <typename F> static void helpUntil(std::atomic<uint32_t>& word, F isReady) noexcept {
+    internal::SpinYielder yielder;
+    while (true) {
+        const uint32_t current = word.load(std::memory_order_acquire);
+        if (isReady(current)) {
+            return;
+        }
+        if (helpRunQueuedTask()) {
+            yielder = internal::SpinYielder{};
+            continue;
+        }
+        yielder.yield(&word, current);
+    }
+}
+
+namespace {
+struct AllListener {
+    std::atomic<uint32_t> remaining;
+};
+
+struct AnyListener {
+    std::atomic<TaskHeader*> first{nullptr};
+    /// How many listened tasks finished and are done using the listener.
+    std::atomic<uint32_t> fired{0};
+};
+} // namespace
+
+static void onAllTaskDone(void* context, TaskHeader* task) {
+    (void)task;
+    std::atomic<uint32_t>* remaining = &reinterpret_cast<AllListener*>(context)->remaining;
+    // Only the last task wakes the awaiting thread, which may return as soon as it's woken.
+    if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        internal::wakeAllOnAddress(remaining);
+    }
+}
+
+static void onAnyTaskDone(void* context, TaskHeader* task) {
+    AnyListener* listener = reinterpret_cast<AnyListener*>(context);
+    TaskHeader* expected = nullptr;
+    (void)listener->first.compare_exchange_strong(expected, task, std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed);
+    void* firedAddress = &listener->fired;
+    listener->fired.fetch_add(1, std::memory_order_acq_rel);
+    internal::wakeAllOnAddress(firedAddress);
+}
+
+/// Moves the finished `antecedent`'s return value into `context`, the continuation task, then
+/// submits the continuation. Errors skip the continuation, failing it with the same error.
+static void startContinuation(void* context, TaskHeader* antecedent) {
+    TaskHeader* next = reinterpret_cast<TaskHeader*>(context);
+    if (antecedent->encounteredErr_.hasValue()) {
+        next->encounteredErr_ = Option<AnyError>(antecedent->encounteredErr_.value());
+        antecedent->destroy();
+        next->finish();
+        return;
+    }
+
+    if (antecedent->valType() != nullptr) {
+        memcpy(next->args_[0], antecedent->valueMem(), antecedent->valType()->sizeType);
+    }
+    antecedent->destroy();
+    if (auto res = submitToTaskPool(detail::TaskUtils::makeExecutor(next)); res.hasErr()) {
+        if (next->function_->argsLen > 0) {
+            next->function_->argsTypes[0]->destroyObject(next->args_[0]);
+        }
+        next->encounteredErr_ = Option<AnyError>(res.takeErr());
+        next->finish();
+    }
+}
+
+Result<void, AnyError> RawTask::awaitAll(RawTask* tasks, size_t len,
+                                         void* const* outReturns) noexcept {
+    sy_assert(len <= UINT32_MAX, "Too many tasks to await at once");
+    AllListener listener{};
+    listener.remaining.store(static_cast<uint32_t>(len), std::memory_order_relaxed);
+    for (size_t i = 0; i < len; i++) {
+        sy_assert(tasks[i].inner_ != nullptr, "Cannot await a task that was already awaited");
+        if (!asHeaderMut(tasks[i].inner_)->listen(&onAllTaskDone, &listener)) {
+            listener.remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+    helpUntil(listener.remaining, [](uint32_t remaining) { return remaining == 0; });
+
+    Option<AnyError> firstErr{};
+    for (size_t i = 0; i < len; i++) {
+        void* outReturn = outReturns == nullptr ? nullptr : outReturns[i];
+        auto res = tasks[i].getIfDone(outReturn);
+        if (res.hasErr() && !firstErr.hasValue()) {
+            firstErr = Option<AnyError>(res.takeErr());
+        }
+    }
+    if (firstErr.hasValue()) {
+        return Error(firstErr.value());
+    }
+    return {};
+}
+
+size_t RawTask::awaitAny(const RawTask* tasks, size_t len) noexcept {
+    sy_assert(len > 0, "Cannot await any of no tasks");
+    for (size_t i = 0; i < len; i++) {
+        sy_assert(tasks[i].inner_ != nullptr, "Cannot await a task that was already awaited");
+        if (tasks[i].isDone().value()) {
+            return i;
+        }
+    }
+
+    AnyListener listener{};
+    size_t listened = 0;
+    for (; listened < len; listened++) {
+        if (!asHeaderMut(tasks[listened].inner_)->listen(&onAnyTaskDone, &listener)) {
+            break;
+        }
+    }
+    const size_t doneDuringListen = listened;
+    if (doneDuringListen == len) {
+        helpUntil(listener.fired, [](uint32_t fired) { return fired > 0; });
+    }
+
+    // The tasks go back to being awaitable as usual, but those that finished meanwhile are still
+    // calling the listener, which lives on this stack.
+    uint32_t finished = 0;
+    for (size_t i = 0; i < listened; i++) {
+        if (!asHeaderMut(tasks[i].inner_)->unlisten()) {
+            finished += 1;
+        }
+    }
+    helpUntil(listener.fired, [finished](uint32_t fired) { return fired == finished; });
+
+    const TaskHeader* first = listener.first.load(std::memory_order_acquire);
+    for (size_t i = 0; i < listened; i++) {
+        if (asHeader(tasks[i].inner_) == first) {
+            return i;
+        }
+    }
+    return doneDuringListen;
+}
+
+Result<RawTask, AnyError> RawTask::then(const RawFunction* continuation) noexcept {
+    sy_assert(this->inner_ != nullptr, "Cannot continue a task that was already awaited");
+    const Type* valType = this->retType();
+    if (valType == nullptr) {
+        sy_assert(continuation->argsLen == 0, "Continuation of a void task takes no arguments");
+    } else {
+        sy_assert(continuation->argsLen == 1 && continuation->argsTypes[0] == valType,
+                  "Continuation must take the task's return value as its only argument");
+    }
+
+    auto nextRes = detail::TaskUtils::createTask(continuation);
+    if (nextRes.hasErr()) {
+        return Error(nextRes.takeErr());
+    }
+    void* next = nextRes.value();
+    TaskHeader* header = asHeaderMut(this->inner_);
+    this->inner_ = nullptr;
+    if (!header->listen(&startContinuation, next)) {
+        startContinuation(next, header);
+    }
+    return RawTask(next);
+}
@@ -0,0 +1,61 @@
+//! API
+#pragma once
+#ifndef SY_TYPES_TASK_TASK_H_
+#define SY_TYPES_TASK_TASK_H_
+
+#include "../../core/core.h"
+
+/// A task ready to run, handed to the task scheduler by parallel calls. Must be run exactly once,
+/// through `sy_task_executor_run(...)`.
+typedef struct SyTaskExecutor {
+    void* inner_;
+} SyTaskExecutor;
+
+/// Queues `task` to be run on some thread at some later point.
+/// @return `false` if the task could not be queued, failing the parallel call that started it.
+typedef bool (*sy_task_scheduler_submit_fn)(void* self, SyTaskExecutor task);
+
+/// Queues each of the `len` tasks of `tasks`, which is only valid for the duration of the call.
+/// @return The amount of leading tasks that were queued. The parallel calls of the remaining tasks
+/// fail.
+typedef size_t (*sy_task_scheduler_submit_batch_fn)(void* self, const SyTaskExecutor* tasks,
+                                                    size_t len);
+
+/// @return How many tasks the scheduler can run at once, used to decide how finely work is split.
+/// Zero if unknown.
+typedef uint32_t (*sy_task_scheduler_worker_count_hint_fn)(const void* self);
+
+typedef struct SyTaskSchedulerVTable {
+    /// Non-null.
+    sy_task_scheduler_submit_fn submitFn;
+    /// Nullable, in which case `submitFn` is called for each task.
+    sy_task_scheduler_submit_batch_fn submitBatchFn;
+    /// Nullable, in which case the hardware thread count is used.
+    sy_task_scheduler_worker_count_hint_fn workerCountHintFn;
+} SyTaskSchedulerVTable;
+
+/// Host supplied executor of parallel tasks, such as an engine's job system, used instead of the
+/// built in task pool.
+typedef struct SyTaskScheduler {
+    void* ptr;
+    const SyTaskSchedulerVTable* vtable;
+} SyTaskScheduler;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Runs the task's function on the calling thread, then marks the task as done. The calling thread
+/// may be any thread, including one owned by the host.
+SY_API void sy_task_executor_run(SyTaskExecutor task);
+
+/// Makes every parallel call submit its task to `scheduler`, which is copied, rather than the built
+/// in task pool. If `scheduler` is `NULL`, the built in task pool is used again. Must not be called
+/// while tasks may be started, and the built in task pool must not be running.
+SY_API void sy_task_scheduler_set_global(const SyTaskScheduler* scheduler);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // SY_TYPES_TASK_TASK_H_
@@ -11,20 +11,114 @@ class RawFunction;
 class Type;
 
 namespace detail {
-class TaskUtils {
-  public:
-};
+class TaskUtils;
 } // namespace detail
 
+/// A task ready to run, submitted to the task pool or host scheduler by
+/// `RawFunction::CallArgs::callParallel()`. Can be bitcast to `c::SyTaskExecutor`.
 class SY_API TaskExecutor {
   public:
+    /// Runs the task's function on the calling thread, then marks the task as done. The function
+    /// runs on a stack pooled by the calling thread, so tasks reuse the stacks of earlier tasks.
+    /// Can only be called once.
     void run() noexcept;
 
   private:
-    friend class TaskUtils;
+    friend class detail::TaskUtils;
+
+    explicit TaskExecutor(void* inner) : inner_(inner) {}
+
     void* inner_;
 };
 
+/// Host supplied executor of parallel tasks, such as an engine's job system, so that parallel calls
+/// don't spawn threads competing with the host's own. Can be bitcast to `c::SyTaskScheduler`.
+class SY_API TaskScheduler final {
+  public:
+    struct VTable {
+        using submit_fn = bool (*)(void* self, TaskExecutor task);
+        using submit_batch_fn = size_t (*)(void* self, const TaskExecutor* tasks, size_t len);
+        using worker_count_hint_fn = uint32_t (*)(const void* self);
+
+        /// Non-null.
+        submit_fn submitFn;
+        /// Nullable, in which case `submitFn` is called for each task.
+        submit_batch_fn submitBatchFn;
+        /// Nullable, in which case the hardware thread count is used.
+        worker_count_hint_fn workerCountHintFn;
+    };
+
+    TaskScheduler(void* ptr, const VTable* vtable) : ptr_(ptr), vtable_(vtable) {}
+
+    /// @return `false` if the task could not be queued.
+    [[nodiscard]] bool submit(TaskExecutor task) const noexcept;
+
+    /// @return The amount of leading tasks that were queued.
+    [[nodiscard]] size_t submitBatch(const TaskExecutor* tasks, size_t len) const noexcept;
+
+    /// @return How many tasks the scheduler can run at once, or zero if unknown.
+    [[nodiscard]] uint32_t workerCountHint() const noexcept;
+
+    /// Makes every parallel call submit its task to `scheduler`, which is copied, rather than
+    /// `TaskPool`. If `scheduler` is null, `TaskPool` is used again.
+    /// # Debug Asserts
+    /// `TaskPool` must not be running. Must not be called while tasks may be started.
+    static void setGlobal(const TaskScheduler* scheduler) noexcept;
+
+  private:
+    void* ptr_;
+    const VTable* vtable_;
+};
+
+/// Interface for C++ specific task schedulers.
+class SY_API ITaskScheduler {
+  public:
+    virtual ~ITaskScheduler() {}
+
+    /// The returned scheduler references this object, so it must outlive its use.
+    TaskScheduler asScheduler();
+
+  protected:
+    /// Queues `task`, which must eventually be run exactly once through `TaskExecutor::run()`.
+    /// @return `false` if the task could not be queued.
+    virtual bool submit(TaskExecutor task) noexcept = 0;
+
+    /// Submits each task one by one unless overridden.
+    /// @return The amount of leading tasks that were queued.
+    virtual size_t submitBatch(const TaskExecutor* tasks, size_t len) noexcept;
+
+    /// @return How many tasks the scheduler can run at once, or zero if unknown.
+    virtual uint32_t workerCountHint() const noexcept { return 0; }
+
+  private:
+    static bool submitImpl(void* self, TaskExecutor task) noexcept;
+    static size_t submitBatchImpl(void* self, const TaskExecutor* tasks, size_t len) noexcept;
+    static uint32_t workerCountHintImpl(const void* self) noexcept;
+};
+
+/// Built in pool of worker threads that tasks started by `RawFunction::CallArgs::callParallel()`
+/// run on. Each worker owns a work stealing deque. Tasks started by a worker are pushed onto its
+/// own deque, while tasks started by any other thread go through a shared queue. Idle workers steal
+/// from the other workers' deques before sleeping. Unused while a host scheduler is set through
+/// `TaskScheduler::setGlobal(...)`.
+class SY_API TaskPool {
+  public:
+    /// Starts the pool with `workerCount` workers, or one per hardware thread if `workerCount` is
+    /// zero. Does nothing if the pool is already running. The pool is otherwise started with the
+    /// default amount of workers when the first task is started.
+    [[nodiscard]] static Result<void, AnyError> start(uint32_t workerCount = 0) noexcept;
+
+    /// Waits for all started tasks to finish running, including tasks they start, then joins the
+    /// workers. The pool can be started again afterwards. Other threads may keep starting tasks
+    /// while the pool is shutting down, which either run before it stops, or start a new pool.
+    /// # Debug Asserts
+    /// Must not be called from within a task.
+    static void shutdown() noexcept;
+
+    /// @return The amount of workers of the running pool, or zero if it isn't running.
+    [[nodiscard]] static uint32_t workerCount() noexcept;
+};
+
 class SY_API RawTask {
   public:
     RawTask(RawTask&& other) noexcept;
@@ -41,12 +135,59 @@ class SY_API RawTask {
 
     Result<bool, AnyError> isDone() const noexcept;
 
+    /// Waits for the task to finish, then moves its return value into `outReturn`, or destroys the
+    /// value if `outReturn` is null. While waiting, tasks queued on `TaskPool` are run on the
+    /// calling thread, which may include this task. Once nothing is queued, the thread sleeps until
+    /// the task is done.
     Result<void, AnyError> awaitDone(void* outReturn) noexcept;
 
     Result<bool, AnyError> getIfDone(void* outReturn) noexcept;
 
+    /// Requests that the task stops, along with every task created while it was running, and in
+    /// turn the tasks those created. Cancellation is cooperative. Tasks that haven't started never
+    /// run, interpreted scripts stop at their next backward jump or call, unwinding their frames,
+    /// and C functions may check `currentIsCancelled()`. Cancelled tasks fail with
+    /// `Exceptional::Cancelled`, unless they finish first. Unlike other errors, dropping a task
+    /// that failed this way is fine. Loops compiled to native code only check once they leave the
+    /// native code.
+    /// # Debug Asserts
+    /// The task must not have been awaited already.
+    void cancel() noexcept;
+
+    /// @return `true` if the task running on the calling thread has been cancelled, either directly
+    /// or through the task it was started from. Always `false` outside of tasks.
+    [[nodiscard]] static bool currentIsCancelled() noexcept;
+
+    /// Waits for every task to finish with a single wait, rather than waking once per task. Each
+    /// task's return value is moved into the matching element of `outReturns`, or destroyed if
+    /// `outReturns` or the element is null. Every task is consumed, even if some fail.
+    /// @return The error of the first failed task, by index, if any.
+    /// # Debug Asserts
+    /// None of `tasks` may have been awaited already.
+    static Result<void, AnyError> awaitAll(RawTask* tasks, size_t len,
+                                           void* const* outReturns) noexcept;
+
+    /// Waits for at least one of `tasks` to finish, without consuming any of them. The finished
+    /// task's result can then be taken through `getIfDone(...)` or `awaitDone(...)`.
+    /// @return The index of the first task found to be done.
+    /// # Debug Asserts
+    /// `len` must be non-zero, and none of `tasks` may have been awaited already.
+    static size_t awaitAny(const RawTask* tasks, size_t len) noexcept;
+
+    /// Consumes this task, starting `continuation` with its return value once it finishes, without
+    /// any thread waiting for it to. If this task fails, `continuation` doesn't run, and the
+    /// returned task fails with the same error.
+    /// @return The task of `continuation`.
+    /// # Debug Asserts
+    /// `continuation` must take exactly this task's return value, or nothing if it returns
+    /// nothing.
+    Result<RawTask, AnyError> then(const RawFunction* continuation) noexcept;
+
   private:
-    friend class TaskUtils;
+    friend class detail::TaskUtils;
+
+    explicit RawTask(void* inner) : inner_(inner) {}
+
     void* inner_;
 };
 } // namespace sy
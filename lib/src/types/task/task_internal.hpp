@@ -0,0 +1,99 @@
+#pragma once
+#ifndef SY_TYPES_TASK_TASK_INTERNAL_HPP_
+#define SY_TYPES_TASK_TASK_INTERNAL_HPP_
+
+#include "../../core/core.h"
+#include "task.hpp"
+#include <atomic>
+#include <mutex>
+
+namespace sy {
+/// Cancellation flag of a task. Cancelling a task also cancels every task started while it was
+/// running, so each token links to the token of the task that was running when its task was
+/// created. Cancellation is pushed down the links as it happens, so checking a token never walks
+/// them.
+struct TaskCancelToken {
+    /// Set once this task, or any task it was started from, is cancelled.
+    std::atomic<bool> cancelled{false};
+    /// Null for tasks created outside of any task. Kept alive for as long as this token is.
+    TaskCancelToken* parent = nullptr;
+    /// Tokens linked to this one, each linked to the next through `nextSibling`. Guarded by
+    /// `childrenMutex`, as are the sibling links of each child.
+    TaskCancelToken* firstChild = nullptr;
+    TaskCancelToken* prevSibling = nullptr;
+    TaskCancelToken* nextSibling = nullptr;
+    std::mutex childrenMutex{};
+
+    /// @return `true` if this task, or any task it was started from, has been cancelled.
+    [[nodiscard]] bool isCancelled() const noexcept {
+        return this->cancelled.load(std::memory_order_relaxed);
+    }
+
+    /// Links this token to `parentToken`, which is cancelled if it already was.
+    void link(TaskCancelToken* parentToken) noexcept;
+
+    /// Removes this token from its parent's, if linked. Must be called before it's destroyed.
+    void unlink() noexcept;
+
+    /// Cancels this token, and every token linked to it.
+    void cancel() noexcept;
+};
+
+/// @return The cancellation token of the task running on the calling thread, or null if no task
+/// is running on it.
+[[nodiscard]] const TaskCancelToken* runningTaskCancelToken() noexcept;
+
+namespace detail {
+class TaskUtils {
+  public:
+    /// Allocates a task for a call of `function`, with memory for each of its arguments, but
+    /// doesn't start it. See `taskArgs(...)`.
+    [[nodiscard]] static Result<void*, AnyError> createTask(const RawFunction* function) noexcept;
+
+    /// @return Memory for each argument of the task's function, with element `i` being sized and
+    /// aligned for `function->argsTypes[i]`. The arguments must be moved in before the task is
+    /// submitted.
+    [[nodiscard]] static void* const* taskArgs(void* task) noexcept;
+
+    /// Submits the task to the task pool, starting the pool if it isn't running. If submission
+    /// fails, the task is freed.
+    [[nodiscard]] static Result<RawTask, AnyError> submitTask(void* task) noexcept;
+
+    /// Frees a task that was never submitted, or that has finished running without a `RawTask`
+    /// owning it.
+    static void destroyTask(void* task) noexcept;
+
+    /// Makes the returned handle own `task`, which must have been submitted or run.
+    static RawTask ownTask(void* task) noexcept { return RawTask(task); }
+
+    static TaskExecutor makeExecutor(void* task) noexcept { return TaskExecutor(task); }
+
+    static void* executorTask(const TaskExecutor& executor) noexcept { return executor.inner_; }
+};
+} // namespace detail
+
+/// Submits `task` to the host scheduler if one is set. Otherwise pushes it onto the running task
+/// pool, starting the pool with the default amount of workers if it isn't running. Defined
+/// alongside the pool.
+[[nodiscard]] Result<void, AnyError> submitToTaskPool(TaskExecutor task) noexcept;
+
+/// Submits all of `tasks` at once, the same way as `submitToTaskPool(...)`.
+/// @return The amount of leading tasks that were submitted. The rest must be freed by the caller.
+[[nodiscard]] size_t submitBatchToTaskPool(const TaskExecutor* tasks, size_t len) noexcept;
+
+/// Runs one task queued on the task pool inline on the calling thread, so threads awaiting a task
+/// help finish work rather than block. Tasks given to a host scheduler can't be run this way.
+/// @return `false` if there was no such task.
+bool runQueuedTask() noexcept;
+
+/// How many queued tasks a thread awaiting tasks may run nested in each other. Each nests deeper in
+/// the thread's native stack, so past this awaiting threads sleep, leaving the queued tasks to
+/// other threads.
+constexpr uint32_t MAX_AWAIT_HELP_DEPTH = 64;
+
+/// @return How many tasks can usefully run at once, being the host scheduler's worker count hint,
+/// or the task pool's worker count, falling back to the hardware thread count.
+[[nodiscard]] uint32_t taskParallelism() noexcept;
+} // namespace sy
+
+#endif // SY_TYPES_TASK_TASK_INTERNAL_HPP_
@@ -0,0 +1,1383 @@
+#include "../../core/core_internal.h"
+#include "../../mem/allocator.hpp"
+#include "../../threading/alloc_cache_align.hpp"
+#include "../../threading/work_stealing_deque.hpp"
+#include "task.h"
+#include "task.hpp"
+#include "task_internal.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+
+using namespace sy;
+
+namespace {
+class WorkStealingPool;
+
+#if defined(_MSC_VER)
+// Supress warning for struct padding due to alignment specifier
+// https://learn.microsoft.com/en-us/cpp/error-messages/compiler-warnings/compiler-warning-level-4-c4324?view=msvc-170
+#pragma warning(push)
+#pragma warning(disable : 4324)
+#endif
+struct alignas(ALLOC_CACHE_ALIGN) Worker {
+    WorkStealingDeque deque{};
+    WorkStealingPool* pool = nullptr;
+    uint32_t index = 0;
+    /// Where the next steal attempt starts, so idle workers don't all hit the same victim.
+    uint32_t nextVictim = 0;
+    std::thread thread{};
+};
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+/// The worker the current thread is, if any.
+thread_local Worker* currentWorker = nullptr;
+
+/// Tasks are stored as the `inner_` of their `TaskExecutor`s, as the deques store pointers.
+class WorkStealingPool {
+  public:
+    WorkStealingPool() = default;
+
+    ~WorkStealingPool() noexcept;
+
+    WorkStealingPool(const WorkStealingPool& other) = delete;
+
+    WorkStealingPool& operator=(const WorkStealingPool& other) = delete;
+
+    [[nodiscard]] Result<void, AnyError> start(uint32_t workerCount) noexcept;
+
+    /// Waits for all submitted tasks to run, then joins the workers.
+    void stop() noexcept;
+
+    /// @return The amount of leading tasks that were submitted, which is less than `len` if
+    /// memory ran out.
+    [[nodiscard]] size_t submitBatch(const TaskExecutor* tasks, size_t len) noexcept;
+
+    [[nodiscard]] uint32_t workerCount() const noexcept { return this->workerCount_; }
+
+    /// Runs one queued task on the calling thread, which may be a worker of this pool or any other
+    /// thread.
+    /// @return `false` if no task was queued.
+    bool runOne(Worker* worker) noexcept;
+
+  private:
+    void workerMain(Worker* worker) noexcept;
+
+    /// @param worker Null if the calling thread isn't a worker of this pool.
+    /// @return A task from the worker's own deque, the shared queue, or stolen from another
+    /// worker, in that order. Null if there is none.
+    void* findTask(Worker* worker) noexcept;
+
+    void* popInjected() noexcept;
+
+    Worker* workers_ = nullptr;
+    uint32_t workerCount_ = 0;
+
+    /// Ring buffer of tasks submitted by threads that aren't workers.
+    std::mutex injectedMutex_{};
+    void** injected_ = nullptr;
+    size_t injectedHead_ = 0;
+    size_t injectedLen_ = 0;
+    size_t injectedCapacity_ = 0;
+
+    /// Tasks submitted but not yet taken by a worker.
+    std::atomic<size_t> pending_{0};
+    std::atomic<uint32_t> sleeping_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleepMutex_{};
+    std::condition_variable wake_{};
+};
+} // namespace
+
+WorkStealingPool::~WorkStealingPool() noexcept {
+    sy_assert(this->workers_ == nullptr, "Pool must be stopped before being destroyed");
+    if (this->injected_ != nullptr) {
+        Allocator alloc{};
+        alloc.freeArray(this->injected_, this->injectedCapacity_);
+    }
+}
+
+Result<void, AnyError> WorkStealingPool::start(uint32_t workerCount) noexcept {
+    sy_assert(workerCount > 0, "Pool requires at least one worker");
+
+    Allocator alloc{};
+    auto workersRes = alloc.allocAlignedArray<Worker>(workerCount, ALLOC_CACHE_ALIGN);
+    if (workersRes.hasErr()) {
+        return Error(AnyError(Exceptional::OOM));
+    }
+    this->workers_ = workersRes.value();
+    for (uint32_t i = 0; i < workerCount; i++) {
+        Worker* worker = new (&this->workers_[i]) Worker();
+        worker->pool = this;
+        worker->index = i;
+        worker->nextVictim = (i + 1) % workerCount;
+    }
+    this->workerCount_ = workerCount;
+    this->stopping_.store(false);
+
+    for (uint32_t i = 0; i < workerCount; i++) {
+        Worker* worker = &this->workers_[i];
+        try {
+            worker->thread = std::thread([this, worker]() { this->workerMain(worker); });
+        } catch (...) {
+            const Exceptional err = internal::translateCurrentException();
+            this->stop();
+            return Error(AnyError(err));
+        }
+    }
+    return {};
+}
+
+void WorkStealingPool::stop() noexcept {
+    if (this->workers_ == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex_);
+        this->stopping_.store(true);
+    }
+    this->wake_.notify_all();
+
+    Allocator alloc{};
+    for (uint32_t i = 0; i < this->workerCount_; i++) {
+        Worker& worker = this->workers_[i];
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
+    }
+    for (uint32_t i = 0; i < this->workerCount_; i++) {
+        this->workers_[i].~Worker();
+    }
+    alloc.freeAlignedArray(this->workers_, this->workerCount_, ALLOC_CACHE_ALIGN);
+    this->workers_ = nullptr;
+    this->workerCount_ = 0;
+}
+
+size_t WorkStealingPool::submitBatch(const TaskExecutor* tasks, size_t len) noexcept {
+    // Counted before being published, as workers may take them and count them down as soon as
+    // they are. Tasks that fail to be published are taken back off below.
+    this->pending_.fetch_add(len, std::memory_order_seq_cst);
+
+    size_t submitted = 0;
+    Worker* worker = currentWorker;
+    if (worker != nullptr && worker->pool == this) {
+        for (; submitted < len; submitted++) {
+            if (worker->deque.push(detail::TaskUtils::executorTask(tasks[submitted])).hasErr()) {
+                break;
+            }
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(this->injectedMutex_);
+        if ((this->injectedCapacity_ - this->injectedLen_) < len) {
+            Allocator alloc{};
+            size_t newCapacity = this->injectedCapacity_ == 0 ? 64 : this->injectedCapacity_ * 2;
+            while ((newCapacity - this->injectedLen_) < len) {
+                newCapacity *= 2;
+            }
+            auto newRes = alloc.allocArray<void*>(newCapacity);
+            if (newRes.hasErr()) {
+                this->pending_.fetch_sub(len, std::memory_order_relaxed);
+                return 0;
+            }
+            void** newInjected = newRes.value();
+            for (size_t i = 0; i < this->injectedLen_; i++) {
+                newInjected[i] =
+                    this->injected_[(this->injectedHead_ + i) % this->injectedCapacity_];
+            }
+            if (this->injected_ != nullptr) {
+                alloc.freeArray(this->injected_, this->injectedCapacity_);
+            }
+            this->injected_ = newInjected;
+            this->injectedHead_ = 0;
+            this->injectedCapacity_ = newCapacity;
+        }
+        for (; submitted < len; submitted++) {
+            const size_t index =
+                (this->injectedHead_ + this->injectedLen_) % this->injectedCapacity_;
+            this->injected_[index] = detail::TaskUtils::executorTask(tasks[submitted]);
+            this->injectedLen_ += 1;
+        }
+    }
+    if (submitted < len) {
+        this->pending_.fetch_sub(len - submitted, std::memory_order_relaxed);
+    }
+    if (submitted == 0) {
+        return 0;
+    }
+
+    // Paired with sleeping workers counting themselves before checking `pending_`, so either the
+    // worker sees the task, or the task's submitter sees the worker.
+    if (this->sleeping_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(this->sleepMutex_);
+        if (submitted == 1) {
+            this->wake_.notify_one();
+        } else {
+            this->wake_.notify_all();
+        }
+    }
+    return submitted;
+}
+
+void WorkStealingPool::workerMain(Worker* worker) noexcept {
+    currentWorker = worker;
+    while (true) {
+        if (this->runOne(worker)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(this->sleepMutex_);
+        this->sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        this->wake_.wait(lock, [this]() {
+            return this->pending_.load(std::memory_order_seq_cst) > 0 || this->stopping_.load();
+        });
+        this->sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        if (this->stopping_.load() && this->pending_.load(std::memory_order_seq_cst) == 0) {
+            break;
+        }
+    }
+    currentWorker = nullptr;
+}
+
+bool WorkStealingPool::runOne(Worker* worker) noexcept {
+    // Spares awaiting threads from taking the shared queue's lock while nothing is queued.
+    if (this->pending_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    void* task = this->findTask(worker);
+    if (task == nullptr) {
+        return false;
+    }
+    this->pending_.fetch_sub(1, std::memory_order_relaxed);
+    detail::TaskUtils::makeExecutor(task).run();
+    return true;
+}
+
+void* WorkStealingPool::findTask(Worker* worker) noexcept {
+    if (worker != nullptr) {
+        if (void* task = worker->deque.pop()) {
+            return task;
+        }
+    }
+    if (void* task = this->popInjected()) {
+        return task;
+    }
+    const uint32_t firstVictim = worker != nullptr ? worker->nextVictim : 0;
+    for (uint32_t i = 0; i < this->workerCount_; i++) {
+        const uint32_t victim = (firstVictim + i) % this->workerCount_;
+        if (worker != nullptr && victim == worker->index) {
+            continue;
+        }
+        if (void* task = this->workers_[victim].deque.steal()) {
+            if (worker != nullptr) {
+                worker->nextVictim = victim;
+            }
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void* WorkStealingPool::popInjected() noexcept {
+    std::lock_guard<std::mutex> lock(this->injectedMutex_);
+    if (this->injectedLen_ == 0) {
+        return nullptr;
+    }
+    void* task = this->injected_[this->injectedHead_];
+    this->injectedHead_ = (this->injectedHead_ + 1) % this->injectedCapacity_;
+    this->injectedLen_ -= 1;
+    return task;
+}
+
+static std::mutex globalPoolMutex{};
+static std::atomic<WorkStealingPool*> globalPool{nullptr};
+/// Threads that aren't workers of the global pool using it without holding `globalPoolMutex`.
+/// Shutting the pool down waits for them before freeing it.
+static std::atomic<uint32_t> globalPoolUsers{0};
+
+namespace {
+/// Keeps the global pool from being freed while a thread that isn't one of its workers uses it.
+class GlobalPoolRef {
+  public:
+    GlobalPoolRef() noexcept {
+        // Paired with shutting down clearing `globalPool` before waiting for users, so either this
+        // sees no pool, or shutting down sees this user.
+        globalPoolUsers.fetch_add(1, std::memory_order_seq_cst);
+        this->pool_ = globalPool.load(std::memory_order_seq_cst);
+    }
+
+    ~GlobalPoolRef() noexcept { globalPoolUsers.fetch_sub(1, std::memory_order_release); }
+
+    GlobalPoolRef(const GlobalPoolRef& other) = delete;
+
+    GlobalPoolRef& operator=(const GlobalPoolRef& other) = delete;
+
+    /// @return Null if the pool isn't running.
+    [[nodiscard]] WorkStealingPool* pool() const noexcept { return this->pool_; }
+
+  private:
+    WorkStealingPool* pool_;
+};
+} // namespace
+
+static uint32_t defaultWorkerCount() {
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads == 0 ? 1 : static_cast<uint32_t>(hardwareThreads);
+}
+
+Result<void, AnyError> sy::TaskPool::start(uint32_t workerCount) noexcept {
+    std::lock_guard<std::mutex> lock(globalPoolMutex);
+    if (globalPool.load(std::memory_order_acquire) != nullptr) {
+        return {};
+    }
+
+    Allocator alloc{};
+    auto poolRes = alloc.allocObject<WorkStealingPool>();
+    if (poolRes.hasErr()) {
+        return Error(AnyError(Exceptional::OOM));
+    }
+    WorkStealingPool* pool = new (poolRes.value()) WorkStealingPool();
+    if (auto res = pool->start(workerCount == 0 ? defaultWorkerCount() : workerCount);
+        res.hasErr()) {
+        pool->~WorkStealingPool();
+        alloc.freeObject(pool);
+        return res;
+    }
+    globalPool.store(pool, std::memory_order_release);
+    return {};
+}
+
+void sy::TaskPool::shutdown() noexcept {
+    sy_assert(currentWorker == nullptr, "Cannot shut down the task pool from within a task");
+    WorkStealingPool* pool = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(globalPoolMutex);
+        pool = globalPool.exchange(nullptr, std::memory_order_seq_cst);
+    }
+    if (pool == nullptr) {
+        return;
+    }
+    // Users may be running tasks inline that use the pool mutex, so are waited on without it. Any
+    // tasks they submit are run by `stop()`.
+    while (globalPoolUsers.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+    pool->stop();
+    pool->~WorkStealingPool();
+    Allocator alloc{};
+    alloc.freeObject(pool);
+}
+
+uint32_t sy::TaskPool::workerCount() noexcept {
+    std::lock_guard<std::mutex> lock(globalPoolMutex);
+    WorkStealingPool* pool = globalPool.load(std::memory_order_acquire);
+    return pool == nullptr ? 0 : pool->workerCount();
+}
+
+static_assert(sizeof(TaskScheduler) == sizeof(SyTaskScheduler));
+static_assert(alignof(TaskScheduler) == alignof(SyTaskScheduler));
+static_assert(sizeof(TaskScheduler::VTable) == sizeof(SyTaskSchedulerVTable));
+static_assert(alignof(TaskScheduler::VTable) == alignof(SyTaskSchedulerVTable));
+static_assert(offsetof(TaskScheduler::VTable, submitFn) ==
+              offsetof(SyTaskSchedulerVTable, submitFn));
+static_assert(offsetof(TaskScheduler::VTable, submitBatchFn) ==
+              offsetof(SyTaskSchedulerVTable, submitBatchFn));
+static_assert(offsetof(TaskScheduler::VTable, workerCountHintFn) ==
+              offsetof(SyTaskSchedulerVTable, workerCountHintFn));
+
+/// Only written by `TaskScheduler::setGlobal(...)`, which can't race with tasks being started.
+static SyTaskScheduler hostSchedulerStorage{};
+static std::atomic<const TaskScheduler*> hostScheduler{nullptr};
+
+extern "C" {
+SY_API void sy_task_scheduler_set_global(const SyTaskScheduler* scheduler) {
+    TaskScheduler::setGlobal(reinterpret_cast<const TaskScheduler*>(scheduler));
+}
+}
+
+bool sy::TaskScheduler::submit(TaskExecutor task) const noexcept {
+    return this->vtable_->submitFn(this->ptr_, task);
+}
+
+size_t sy::TaskScheduler::submitBatch(const TaskExecutor* tasks, size_t len) const noexcept {
+    if (this->vtable_->submitBatchFn != nullptr) {
+        return this->vtable_->submitBatchFn(this->ptr_, tasks, len);
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (this->vtable_->submitFn(this->ptr_, tasks[i]) == false) {
+            return i;
+        }
+    }
+    return len;
+}
+
+uint32_t sy::TaskScheduler::workerCountHint() const noexcept {
+    if (this->vtable_->workerCountHintFn == nullptr) {
+        return 0;
+    }
+    return this->vtable_->workerCountHintFn(this->ptr_);
+}
+
+void sy::TaskScheduler::setGlobal(const TaskScheduler* scheduler) noexcept {
+    sy_assert(currentWorker == nullptr, "Cannot set the task scheduler from within a task");
+    std::lock_guard<std::mutex> lock(globalPoolMutex);
+    sy_assert(globalPool.load(std::memory_order_acquire) == nullptr,
+              "Task pool must be shut down before setting the task scheduler");
+    if (scheduler == nullptr) {
+        hostScheduler.store(nullptr, std::memory_order_release);
+        return;
+    }
+    sy_assert(scheduler->vtable_ != nullptr && scheduler->vtable_->submitFn != nullptr,
+              "Task scheduler must be able to submit tasks");
+    hostSchedulerStorage = *reinterpret_cast<const SyTaskScheduler*>(scheduler);
+    hostScheduler.store(reinterpret_cast<const TaskScheduler*>(&hostSchedulerStorage),
+                        std::memory_order_release);
+}
+
+TaskScheduler sy::ITaskScheduler::asScheduler() {
+    static const TaskScheduler::VTable vtable = {&ITaskScheduler::submitImpl,
+                                                 &ITaskScheduler::submitBatchImpl,
+                                                 &ITaskScheduler::workerCountHintImpl};
+    return TaskScheduler(reinterpret_cast<void*>(this), &vtable);
+}
+
+size_t sy::ITaskScheduler::submitBatch(const TaskExecutor* tasks, size_t len) noexcept {
+    for (size_t i = 0; i < len; i++) {
+        if (this->submit(tasks[i]) == false) {
+            return i;
+        }
+    }
+    return len;
+}
+
+bool sy::ITaskScheduler::submitImpl(void* self, TaskExecutor task) noexcept {
+    return reinterpret_cast<ITaskScheduler*>(self)->submit(task);
+}
+
+size_t sy::ITaskScheduler::submitBatchImpl(void* self, const TaskExecutor* tasks,
+                                           size_t len) noexcept {
+    return reinterpret_cast<ITaskScheduler*>(self)->submitBatch(tasks, len);
+}
+
+uint32_t sy::ITaskScheduler::workerCountHintImpl(const void* self) noexcept {
+    return reinterpret_cast<const ITaskScheduler*>(self)->workerCountHint();
+}
+
+/// Submits `len` tasks to the built in pool, started if it isn't running. Tasks started by tasks
+/// stay on the pool running them, even while it's shutting down.
+/// @return The amount of leading tasks that were submitted.
+static Result<size_t, AnyError> submitBatchToPool(const TaskExecutor* tasks, size_t len) noexcept {
+    if (currentWorker != nullptr) {
+        return currentWorker->pool->submitBatch(tasks, len);
+    }
+    while (true) {
+        {
+            const GlobalPoolRef ref{};
+            if (ref.pool() != nullptr) {
+                return ref.pool()->submitBatch(tasks, len);
+            }
+        }
+        if (auto res = TaskPool::start(); res.hasErr()) {
+            return Error(res.takeErr());
+        }
+    }
+}
+
+Result<void, AnyError> sy::submitToTaskPool(TaskExecutor task) noexcept {
+    if (const TaskScheduler* host = hostScheduler.load(std::memory_order_acquire)) {
+        if (host->submit(task) == false) {
+            return Error(AnyError(Exceptional::Capacity));
+        }
+        return {};
+    }
+
+    auto submitRes = submitBatchToPool(&task, 1);
+    if (submitRes.hasErr()) {
+        return Error(submitRes.takeErr());
+    }
+    if (submitRes.value() == 0) {
+        return Error(AnyError(Exceptional::OOM));
+    }
+    return {};
+}
+
+size_t sy::submitBatchToTaskPool(const TaskExecutor* tasks, size_t len) noexcept {
+    if (len == 0) {
+        return 0;
+    }
+    if (const TaskScheduler* host = hostScheduler.load(std::memory_order_acquire)) {
+        return host->submitBatch(tasks, len);
+    }
+
+    auto submitRes = submitBatchToPool(tasks, len);
+    if (submitRes.hasErr()) {
+        return 0;
+    }
+    return submitRes.value();
+}
+
+bool sy::runQueuedTask() noexcept {
+    if (currentWorker != nullptr) {
+        return currentWorker->pool->runOne(currentWorker);
+    }
+    if (hostScheduler.load(std::memory_order_acquire) != nullptr) {
+        return false;
+    }
+    const GlobalPoolRef ref{};
+    return ref.pool() != nullptr && ref.pool()->runOne(nullptr);
+}
+
+uint32_t sy::taskParallelism() noexcept {
+    if (const TaskScheduler* host = hostScheduler.load(std::memory_order_acquire)) {
+        const uint32_t hint = host->workerCountHint();
+        return hint == 0 ? defaultWorkerCount() : hint;
+    }
+    if (currentWorker != nullptr) {
+        return currentWorker->pool->workerCount();
+    }
+    const uint32_t running = TaskPool::workerCount();
+    return running == 0 ? defaultWorkerCount() : running;
+}
+
+#if SYNC_LIB_WITH_TESTS
+
+#include "../../doctest.h"
+#include "../../interpreter/jit.hpp"
+#include "../../testing/script_function.hpp"
+#include "../type_info.hpp"
+#include <chrono>
+#include <vector>
+
+using namespace sy::testing;
+
+namespace {
+int32_t fortyTwo() { return 42; }
+
+int64_t multiplyAdd(int64_t value, int32_t multiplier, int64_t addend) {
+    return (value * multiplier) + addend;
+}
+
+std::atomic<int32_t> sideEffectSum{0};
+
+void addToSum(int32_t value) { sideEffectSum.fetch_add(value); }
+
+Result<int32_t, AnyError> failIfNegative(int32_t value) {
+    if (value < 0) {
+        return Error(AnyError(Exceptional::Arithmetic));
+    }
+    return value;
+}
+
+/// Set by the test using it, as C functions can't capture.
+const Function<int64_t(int64_t)>* treeFunction = nullptr;
+
+/// Counts the nodes of a binary tree of `depth`, with each subtree counted by a child task.
+int64_t countTree(int64_t depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    const RawFunction* raw = reinterpret_cast<const RawFunction*>(treeFunction);
+    int64_t total = 1;
+    for (int i = 0; i < 2; i++) {
+        RawFunction::CallArgs callArgs = raw->startCall();
+        int64_t childDepth = depth - 1;
+        if (!callArgs.push(&childDepth, Reflect<int64_t>::get())) {
+            return -1;
+        }
+        auto taskRes = callArgs.callParallel();
+        if (taskRes.hasErr()) {
+            return -1;
+        }
+        RawTask child = taskRes.takeValue();
+        int64_t childCount = 0;
+        if (child.awaitDone(&childCount).hasErr()) {
+            return -1;
+        }
+        total += childCount;
+    }
+    return total;
+}
+
+/// Set by the test using it.
+const Function<int64_t(int64_t)>* chainFunction = nullptr;
+
+/// How many links of the chain the current thread is running nested in each other.
+thread_local uint32_t chainNesting = 0;
+std::atomic<uint32_t> maxChainNesting{0};
+
+/// Awaits a chain of `depth` tasks, each started and awaited by the one before it.
+/// @return The length of the chain.
+int64_t awaitChain(int64_t depth) {
+    chainNesting += 1;
+    uint32_t seen = maxChainNesting.load();
+    while (seen < chainNesting && !maxChainNesting.compare_exchange_weak(seen, chainNesting)) {
+    }
+    int64_t childLength = 0;
+    if (depth > 0) {
+        const RawFunction* raw = reinterpret_cast<const RawFunction*>(chainFunction);
+        RawFunction::CallArgs callArgs = raw->startCall();
+        int64_t childDepth = depth - 1;
+        if (!callArgs.push(&childDepth, Reflect<int64_t>::get())) {
+            return -1;
+        }
+        auto taskRes = callArgs.callParallel();
+        if (taskRes.hasErr()) {
+            return -1;
+        }
+        RawTask child = taskRes.takeValue();
+        if (child.awaitDone(&childLength).hasErr()) {
+            return -1;
+        }
+    }
+    chainNesting -= 1;
+    return childLength + 1;
+}
+
+std::atomic<bool> blockerStarted{false};
+std::atomic<bool> blockerReleased{false};
+
+void blockUntilReleased() {
+    blockerStarted.store(true);
+    while (!blockerReleased.load()) {
+        std::this_thread::yield();
+    }
+}
+
+int64_t addOne(int64_t value) { return value + 1; }
+
+std::atomic<int32_t> continuationRuns{0};
+
+int32_t countContinuation(int32_t value) {
+    continuationRuns.fetch_add(1);
+    return value;
+}
+
+const Stack* recordedStacks[2] = {};
+
+void recordStack(int32_t slot) { recordedStacks[slot] = &Stack::getActiveStack(); }
+
+/// Set by the test using it. Runs on the outer task, running the inner one inline.
+TaskExecutor* nestedExecutor = nullptr;
+
+void runNestedTask(int32_t slot) {
+    recordStack(slot);
+    nestedExecutor->run();
+    // The nested task didn't disturb this task's stack.
+    if (&Stack::getActiveStack() != recordedStacks[slot]) {
+        recordedStacks[slot] = nullptr;
+    }
+}
+
+std::thread::id recordedThread{};
+
+void recordThread() { recordedThread = std::this_thread::get_id(); }
+
+/// Set by the test using it.
+const Function<void(int32_t)>* adderFunction = nullptr;
+
+std::vector<RawTask> startedTasks{};
+
+/// Starts `addToSum(value)` as a task kept in `startedTasks`, without awaiting it.
+void startAdder(int32_t value) {
+    const RawFunction* raw = reinterpret_cast<const RawFunction*>(adderFunction);
+    RawFunction::CallArgs callArgs = raw->startCall();
+    if (!callArgs.push(&value, Reflect<int32_t>::get())) {
+        return;
+    }
+    auto taskRes = callArgs.callParallel();
+    if (taskRes.hasValue()) {
+        startedTasks.push_back(taskRes.takeValue());
+    }
+}
+
+/// Set by the test using it, to the task running `cancelThenStartAdder(...)`.
+RawTask* selfCancelledTask = nullptr;
+
+/// Cancels its own task, then starts an adder, which is cancelled with it.
+void cancelThenStartAdder(int32_t value) {
+    selfCancelledTask->cancel();
+    startAdder(value);
+}
+
+std::atomic<uint32_t> spinIterations{0};
+
+void countSpin() { spinIterations.fetch_add(1); }
+
+/// Set by the test using it. A script that never returns.
+const RawFunction* spinFunction = nullptr;
+
+Result<void, AnyError> awaitSpinningChild() {
+    auto taskRes = spinFunction->startCall().callParallel();
+    if (taskRes.hasErr()) {
+        return Error(taskRes.takeErr());
+    }
+    RawTask child = taskRes.takeValue();
+    return child.awaitDone(nullptr);
+}
+
+template <typename Ret, typename... Args>
+RawTask startTask(const Function<Ret(Args...)>& function, Args... args) {
+    const RawFunction* raw = reinterpret_cast<const RawFunction*>(&function);
+    RawFunction::CallArgs callArgs = raw->startCall();
+    const bool pushedAll =
+        (... && callArgs.push(static_cast<void*>(&args), Reflect<Args>::get()));
+    REQUIRE(pushedAll);
+    auto taskRes = callArgs.callParallel();
+    REQUIRE(taskRes);
+    return taskRes.takeValue();
+}
+} // namespace
+
+TEST_CASE("[TaskPool] C functions run in parallel and return their values") {
+    REQUIRE(TaskPool::start(4));
+    CHECK_EQ(TaskPool::workerCount(), 4);
+
+    const Function<int64_t(int64_t, int32_t, int64_t)> function(multiplyAdd);
+    constexpr int64_t COUNT = 200;
+    for (int64_t i = 0; i < COUNT; i++) {
+        RawTask task = startTask(function, i, int32_t{3}, int64_t{7});
+        CHECK_EQ(task.retType(), Reflect<int64_t>::get());
+        int64_t result = 0;
+        REQUIRE(task.awaitDone(&result));
+        CHECK_EQ(result, (i * 3) + 7);
+    }
+
+    TaskPool::shutdown();
+    CHECK_EQ(TaskPool::workerCount(), 0);
+}
+
+TEST_CASE("[TaskPool] shutting down waits for every started task") {
+    sideEffectSum.store(0);
+    REQUIRE(TaskPool::start(3));
+    const Function<void(int32_t)> function(addToSum);
+    {
+        // Each task is awaited when its handle is destroyed, so the handles are kept alive.
+        constexpr int32_t COUNT = 64;
+        alignas(RawTask) unsigned char taskMem[COUNT][sizeof(RawTask)];
+        for (int32_t i = 0; i < COUNT; i++) {
+            new (taskMem[i]) RawTask(startTask(function, i));
+        }
+        TaskPool::shutdown();
+        for (int32_t i = 0; i < COUNT; i++) {
+            RawTask* task = reinterpret_cast<RawTask*>(taskMem[i]);
+            CHECK(task->isDone().value());
+            task->~RawTask();
+        }
+        CHECK_EQ(sideEffectSum.load(), (COUNT * (COUNT - 1)) / 2);
+    }
+}
+
+TEST_CASE("[TaskPool] submitting while the pool shuts down") {
+    const Function<int32_t()> function(fortyTwo);
+    const RawFunction* raw = reinterpret_cast<const RawFunction*>(&function);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> wrong{0};
+    std::vector<std::thread> submitters{};
+    for (int i = 0; i < 4; i++) {
+        submitters.emplace_back([raw, &stop, &wrong]() {
+            while (!stop.load()) {
+                // Restarts the pool whenever it was shut down.
+                auto taskRes = raw->startCall().callParallel();
+                int32_t result = 0;
+                if (taskRes.hasErr() || taskRes.value().awaitDone(&result).hasErr() ||
+                    result != 42) {
+                    wrong.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 64; i++) {
+        std::this_thread::yield();
+        TaskPool::shutdown();
+    }
+    stop.store(true);
+    for (std::thread& submitter : submitters) {
+        submitter.join();
+    }
+    TaskPool::shutdown();
+    CHECK_EQ(wrong.load(), 0);
+}
+
+TEST_CASE("[TaskPool] errors of parallel calls are returned when awaited") {
+    const Function<int32_t(int32_t)> function(failIfNegative);
+    RawTask succeeds = startTask(function, int32_t{5});
+    RawTask fails = startTask(function, int32_t{-5});
+    int32_t result = 0;
+    REQUIRE(succeeds.awaitDone(&result));
+    CHECK_EQ(result, 5);
+    auto failed = fails.awaitDone(&result);
+    REQUIRE(failed.hasErr());
+    CHECK_EQ(failed.takeErr().exceptional().value(), Exceptional::Arithmetic);
+    TaskPool::shutdown();
+}
+
+TEST_CASE("[TaskPool] script functions run in parallel with their arguments moved") {
+    // return x + x;
+    const Bytecode bytecode[] = {addI32(1, 0, 0), setScalarType(ScalarTag::I32, 1),
+                                 returnValue(1)};
+    TestScriptFunction script(bytecode, 3, 2, Reflect<int32_t>::get(), "test.double");
+    const Type* argsTypes[1] = {Reflect<int32_t>::get()};
+    script.function.argsTypes = argsTypes;
+    script.function.argsLen = 1;
+    const RawFunction& function = script.function;
+
+    REQUIRE(TaskPool::start(4));
+    constexpr int32_t COUNT = 128;
+    alignas(RawTask) unsigned char taskMem[COUNT][sizeof(RawTask)];
+    for (int32_t i = 0; i < COUNT; i++) {
+        RawFunction::CallArgs callArgs = function.startCall();
+        int32_t arg = i;
+        REQUIRE(callArgs.push(&arg, Reflect<int32_t>::get()));
+        auto taskRes = callArgs.callParallel();
+        REQUIRE(taskRes);
+        new (taskMem[i]) RawTask(taskRes.takeValue());
+    }
+    // Moving the arguments out leaves nothing behind on the caller's stack.
+    CHECK_FALSE(Stack::getActiveStack().getCurrentFrame().has_value());
+
+    for (int32_t i = 0; i < COUNT; i++) {
+        RawTask* task = reinterpret_cast<RawTask*>(taskMem[i]);
+        int32_t result = 0;
+        CHECK(task->awaitDone(&result));
+        CHECK_EQ(result, i * 2);
+        task->~RawTask();
+    }
+    TaskPool::shutdown();
+}
+
+namespace {
+/// Stands in for a host's job system, which runs queued tasks whenever the host decides to.
+class QueueScheduler final : public ITaskScheduler {
+  public:
+    std::vector<TaskExecutor> queued{};
+
+  protected:
+    bool submit(TaskExecutor task) noexcept override {
+        this->queued.push_back(task);
+        return true;
+    }
+
+    uint32_t workerCountHint() const noexcept override { return 6; }
+};
+
+struct CHostQueue {
+    SyTaskExecutor tasks[16];
+    size_t len;
+    size_t batchCalls;
+};
+
+bool cHostRefuse(void* self, SyTaskExecutor task) {
+    (void)self;
+    (void)task;
+    return false;
+}
+
+size_t cHostSubmitBatch(void* self, const SyTaskExecutor* tasks, size_t len) {
+    CHostQueue* queue = reinterpret_cast<CHostQueue*>(self);
+    queue->batchCalls += 1;
+    size_t submitted = 0;
+    for (; submitted < len && queue->len < 16; submitted++) {
+        queue->tasks[queue->len] = tasks[submitted];
+        queue->len += 1;
+    }
+    return submitted;
+}
+} // namespace
+
+TEST_CASE("[TaskScheduler] parallel calls run on the host scheduler instead of the task pool") {
+    QueueScheduler host{};
+    const TaskScheduler scheduler = host.asScheduler();
+    TaskScheduler::setGlobal(&scheduler);
+    CHECK_EQ(taskParallelism(), 6);
+
+    const Function<int64_t(int64_t, int32_t, int64_t)> function(multiplyAdd);
+    constexpr int64_t COUNT = 10;
+    std::vector<RawTask> tasks{};
+    for (int64_t i = 0; i < COUNT; i++) {
+        tasks.push_back(startTask(function, i, int32_t{2}, int64_t{1}));
+    }
+    CHECK_EQ(host.queued.size(), COUNT);
+    CHECK_EQ(TaskPool::workerCount(), 0);
+    CHECK_FALSE(tasks[0].isDone().value());
+
+    // The host may run tasks on any of its threads.
+    std::thread hostThread([&host]() {
+        for (TaskExecutor& executor : host.queued) {
+            executor.run();
+        }
+    });
+    hostThread.join();
+    for (int64_t i = 0; i < COUNT; i++) {
+        int64_t result = 0;
+        REQUIRE(tasks[static_cast<size_t>(i)].awaitDone(&result));
+        CHECK_EQ(result, (i * 2) + 1);
+    }
+
+    TaskScheduler::setGlobal(nullptr);
+    CHECK_EQ(TaskPool::workerCount(), 0);
+}
+
+TEST_CASE("[TaskScheduler] C host schedulers submit in batches and may refuse tasks") {
+    const Function<int32_t()> function(fortyTwo);
+    CHostQueue queue{};
+    const SyTaskSchedulerVTable vtable = {&cHostRefuse, &cHostSubmitBatch, nullptr};
+    const SyTaskScheduler scheduler = {&queue, &vtable};
+    sy_task_scheduler_set_global(&scheduler);
+    CHECK_EQ(taskParallelism(), std::thread::hardware_concurrency() == 0
+                                    ? 1
+                                    : std::thread::hardware_concurrency());
+
+    {
+        // A refused task fails its parallel call.
+        const RawFunction* raw = reinterpret_cast<const RawFunction*>(&function);
+        auto taskRes = raw->startCall().callParallel();
+        REQUIRE(taskRes.hasErr());
+        CHECK_EQ(taskRes.takeErr().exceptional().value(), Exceptional::Capacity);
+    }
+
+    constexpr size_t COUNT = 20;
+    std::vector<TaskExecutor> executors{};
+    for (size_t i = 0; i < COUNT; i++) {
+        auto createRes =
+            detail::TaskUtils::createTask(reinterpret_cast<const RawFunction*>(&function));
+        REQUIRE(createRes);
+        executors.push_back(detail::TaskUtils::makeExecutor(createRes.value()));
+    }
+    const size_t submitted = submitBatchToTaskPool(executors.data(), COUNT);
+    CHECK_EQ(submitted, 16);
+    CHECK_EQ(queue.batchCalls, 1);
+    CHECK_EQ(queue.len, 16);
+    for (size_t i = submitted; i < COUNT; i++) {
+        detail::TaskUtils::destroyTask(detail::TaskUtils::executorTask(executors[i]));
+    }
+    for (size_t i = 0; i < queue.len; i++) {
+        sy_task_executor_run(queue.tasks[i]);
+        detail::TaskUtils::destroyTask(detail::TaskUtils::executorTask(executors[i]));
+    }
+
+    sy_task_scheduler_set_global(nullptr);
+}
+
+TEST_CASE("[TaskPool] batches of tasks are submitted at once") {
+    REQUIRE(TaskPool::start(2));
+    CHECK_EQ(taskParallelism(), 2);
+    const Function<void(int32_t)> function(addToSum);
+    sideEffectSum.store(0);
+
+    constexpr int32_t COUNT = 100;
+    std::vector<TaskExecutor> executors{};
+    for (int32_t i = 0; i < COUNT; i++) {
+        auto createRes =
+            detail::TaskUtils::createTask(reinterpret_cast<const RawFunction*>(&function));
+        REQUIRE(createRes);
+        void* task = createRes.value();
+        *reinterpret_cast<int32_t*>(detail::TaskUtils::taskArgs(task)[0]) = i;
+        executors.push_back(detail::TaskUtils::makeExecutor(task));
+    }
+    CHECK_EQ(submitBatchToTaskPool(executors.data(), COUNT), COUNT);
+    TaskPool::shutdown();
+    CHECK_EQ(sideEffectSum.load(), (COUNT * (COUNT - 1)) / 2);
+    for (TaskExecutor& executor : executors) {
+        detail::TaskUtils::destroyTask(detail::TaskUtils::executorTask(executor));
+    }
+}
+
+TEST_CASE("[RawTask] awaiting threads sleep until their tasks finish") {
+    QueueScheduler host{};
+    const TaskScheduler scheduler = host.asScheduler();
+    TaskScheduler::setGlobal(&scheduler);
+
+    const Function<int64_t(int64_t, int32_t, int64_t)> function(multiplyAdd);
+    constexpr size_t COUNT = 16;
+    std::vector<RawTask> tasks{};
+    for (size_t i = 0; i < COUNT; i++) {
+        tasks.push_back(startTask(function, static_cast<int64_t>(i), int32_t{3}, int64_t{0}));
+    }
+
+    std::atomic<size_t> correct{0};
+    std::vector<std::thread> awaiters{};
+    for (size_t i = 0; i < COUNT; i++) {
+        awaiters.emplace_back([&tasks, &correct, i]() {
+            int64_t result = 0;
+            if (tasks[i].awaitDone(&result).hasValue() && result == static_cast<int64_t>(i) * 3) {
+                correct.fetch_add(1);
+            }
+        });
+    }
+    // Long enough for the awaiting threads to go past spinning and sleep.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(correct.load(), 0);
+
+    for (TaskExecutor& executor : host.queued) {
+        executor.run();
+    }
+    for (std::thread& awaiter : awaiters) {
+        awaiter.join();
+    }
+    CHECK_EQ(correct.load(), COUNT);
+    TaskScheduler::setGlobal(nullptr);
+}
+
+TEST_CASE("[TaskPool] tasks awaiting their own child tasks don't deadlock a single worker") {
+    const Function<int64_t(int64_t)> function(countTree);
+    treeFunction = &function;
+    REQUIRE(TaskPool::start(1));
+
+    // Without the worker running the children it waits on, nothing else could run them.
+    RawTask root = startTask(function, int64_t{6});
+    int64_t count = 0;
+    REQUIRE(root.awaitDone(&count));
+    CHECK_EQ(count, 127);
+
+    TaskPool::shutdown();
+    treeFunction = nullptr;
+}
+
+TEST_CASE("[RawTask] awaiting threads stop running queued tasks past the helping depth") {
+    const Function<int64_t(int64_t)> function(awaitChain);
+    chainFunction = &function;
+    maxChainNesting.store(0);
+    REQUIRE(TaskPool::start(4));
+
+    // Deeper than any one thread may nest, so the chain is finished by several of them.
+    constexpr int64_t DEPTH = MAX_AWAIT_HELP_DEPTH * 2;
+    RawTask root = startTask(function, DEPTH);
+    int64_t length = 0;
+    REQUIRE(root.awaitDone(&length));
+    CHECK_EQ(length, DEPTH + 1);
+    CHECK_LE(maxChainNesting.load(), MAX_AWAIT_HELP_DEPTH + 1);
+
+    TaskPool::shutdown();
+    chainFunction = nullptr;
+}
+
+TEST_CASE("[RawTask] awaiting threads run queued tasks inline") {
+    blockerStarted.store(false);
+    blockerReleased.store(false);
+    recordedThread = std::thread::id{};
+    REQUIRE(TaskPool::start(1));
+
+    const Function<void()> blockFunction(blockUntilReleased);
+    const Function<void()> recordFunction(recordThread);
+    RawTask blocker = startTask(blockFunction);
+    while (!blockerStarted.load()) {
+        std::this_thread::yield();
+    }
+    // The only worker is busy, so awaiting runs the task on this thread.
+    RawTask recorder = startTask(recordFunction);
+    REQUIRE(recorder.awaitDone(nullptr));
+    CHECK_EQ(recordedThread, std::this_thread::get_id());
+
+    blockerReleased.store(true);
+    REQUIRE(blocker.awaitDone(nullptr));
+    TaskPool::shutdown();
+}
+
+TEST_CASE("[RawTask] awaitAll returns every value, and the first error") {
+    const Function<int64_t(int64_t, int32_t, int64_t)> function(multiplyAdd);
+    constexpr size_t COUNT = 200;
+    std::vector<RawTask> tasks{};
+    for (size_t i = 0; i < COUNT; i++) {
+        tasks.push_back(startTask(function, static_cast<int64_t>(i), int32_t{4}, int64_t{1}));
+    }
+    int64_t results[COUNT] = {};
+    void* outReturns[COUNT] = {};
+    for (size_t i = 0; i < COUNT; i++) {
+        outReturns[i] = &results[i];
+    }
+    REQUIRE(RawTask::awaitAll(tasks.data(), COUNT, outReturns));
+    for (size_t i = 0; i < COUNT; i++) {
+        CHECK_EQ(results[i], (static_cast<int64_t>(i) * 4) + 1);
+    }
+
+    const Function<int32_t(int32_t)> failing(failIfNegative);
+    std::vector<RawTask> mixed{};
+    mixed.push_back(startTask(failing, int32_t{1}));
+    mixed.push_back(startTask(failing, int32_t{-1}));
+    mixed.push_back(startTask(failing, int32_t{3}));
+    int32_t mixedResults[3] = {};
+    void* mixedOut[3] = {&mixedResults[0], &mixedResults[1], &mixedResults[2]};
+    auto res = RawTask::awaitAll(mixed.data(), mixed.size(), mixedOut);
+    REQUIRE(res.hasErr());
+    CHECK_EQ(res.takeErr().exceptional().value(), Exceptional::Arithmetic);
+    CHECK_EQ(mixedResults[0], 1);
+    CHECK_EQ(mixedResults[2], 3);
+    TaskPool::shutdown();
+}
+
+TEST_CASE("[RawTask] awaitAny returns a finished task without consuming the others") {
+    QueueScheduler host{};
+    const TaskScheduler scheduler = host.asScheduler();
+    TaskScheduler::setGlobal(&scheduler);
+
+    const Function<int64_t(int64_t, int32_t, int64_t)> function(multiplyAdd);
+    constexpr size_t COUNT = 5;
+    std::vector<RawTask> tasks{};
+    for (size_t i = 0; i < COUNT; i++) {
+        tasks.push_back(startTask(function, static_cast<int64_t>(i), int32_t{1}, int64_t{10}));
+    }
+
+    // Only one task finishes, while the awaiting thread is already waiting.
+    std::thread hostThread([&host]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        host.queued[3].run();
+    });
+    CHECK_EQ(RawTask::awaitAny(tasks.data(), COUNT), 3);
+    hostThread.join();
+    // Already finished tasks are found without waiting.
+    CHECK_EQ(RawTask::awaitAny(tasks.data(), COUNT), 3);
+
+    for (size_t i = 0; i < COUNT; i++) {
+        if (i != 3) {
+            host.queued[i].run();
+        }
+    }
+    int64_t results[COUNT] = {};
+    void* outReturns[COUNT] = {&results[0], &results[1], &results[2], &results[3], &results[4]};
+    REQUIRE(RawTask::awaitAll(tasks.data(), COUNT, outReturns));
+    for (size_t i = 0; i < COUNT; i++) {
+        CHECK_EQ(results[i], static_cast<int64_t>(i) + 10);
+    }
+    TaskScheduler::setGlobal(nullptr);
+}
+
+TEST_CASE("[RawTask] continuations start once their task finishes") {
+    const Function<int64_t(int64_t, int32_t, int64_t)> function(multiplyAdd);
+    const Function<int64_t(int64_t)> continuation(addOne);
+    const RawFunction* rawContinuation = reinterpret_cast<const RawFunction*>(&continuation);
+
+    constexpr int64_t COUNT = 50;
+    std::vector<RawTask> tasks{};
+    for (int64_t i = 0; i < COUNT; i++) {
+        RawTask first = startTask(function, i, int32_t{2}, int64_t{0});
+        auto secondRes = first.then(rawContinuation);
+        REQUIRE(secondRes);
+        auto thirdRes = secondRes.value().then(rawContinuation);
+        REQUIRE(thirdRes);
+        tasks.push_back(thirdRes.takeValue());
+    }
+    for (int64_t i = 0; i < COUNT; i++) {
+        int64_t result = 0;
+        REQUIRE(tasks[static_cast<size_t>(i)].awaitDone(&result));
+        CHECK_EQ(result, (i * 2) + 2);
+    }
+    TaskPool::shutdown();
+}
+
+TEST_CASE("[RawTask] continuations of finished or failed tasks") {
+    QueueScheduler host{};
+    const TaskScheduler scheduler = host.asScheduler();
+    TaskScheduler::setGlobal(&scheduler);
+    continuationRuns.store(0);
+
+    const Function<int32_t(int32_t)> failing(failIfNegative);
+    const Function<int32_t(int32_t)> continuation(countContinuation);
+    const RawFunction* rawContinuation = reinterpret_cast<const RawFunction*>(&continuation);
+
+    // Finished before the continuation is added, so it's submitted straight away.
+    RawTask finished = startTask(failing, int32_t{7});
+    host.queued[0].run();
+    auto afterFinishedRes = finished.then(rawContinuation);
+    REQUIRE(afterFinishedRes);
+    REQUIRE_EQ(host.queued.size(), 2);
+    host.queued[1].run();
+    int32_t result = 0;
+    REQUIRE(afterFinishedRes.value().awaitDone(&result));
+    CHECK_EQ(result, 7);
+    CHECK_EQ(continuationRuns.load(), 1);
+
+    RawTask fails = startTask(failing, int32_t{-7});
+    auto afterFailedRes = fails.then(rawContinuation);
+    REQUIRE(afterFailedRes);
+    host.queued[2].run();
+    // The failure finishes the continuation's task without it ever being submitted.
+    CHECK_EQ(host.queued.size(), 3);
+    auto failed = afterFailedRes.value().awaitDone(&result);
+    REQUIRE(failed.hasErr());
+    CHECK_EQ(failed.takeErr().exceptional().value(), Exceptional::Arithmetic);
+    CHECK_EQ(continuationRuns.load(), 1);
+    TaskScheduler::setGlobal(nullptr);
+}
+
+TEST_CASE("[TaskExecutor] tasks reuse the stacks of earlier tasks on the same thread") {
+    QueueScheduler host{};
+    const TaskScheduler scheduler = host.asScheduler();
+    TaskScheduler::setGlobal(&scheduler);
+    const Function<void(int32_t)> record(recordStack);
+    const Function<void(int32_t)> nested(runNestedTask);
+    const Stack* callerStack = &Stack::getActiveStack();
+
+    RawTask first = startTask(record, int32_t{0});
+    RawTask second = startTask(record, int32_t{1});
+    host.queued[0].run();
+    host.queued[1].run();
+    REQUIRE(first.awaitDone(nullptr));
+    REQUIRE(second.awaitDone(nullptr));
+    CHECK_NE(recordedStacks[0], callerStack);
+    CHECK_EQ(recordedStacks[0], recordedStacks[1]);
+    CHECK_EQ(&Stack::getActiveStack(), callerStack);
+
+    // A task run while another is running on the same thread gets a stack of its own.
+    const Stack* pooled = recordedStacks[0];
+    RawTask outer = startTask(nested, int32_t{0});
+    RawTask inner = startTask(record, int32_t{1});
+    nestedExecutor = &host.queued[3];
+    host.queued[2].run();
+    REQUIRE(outer.awaitDone(nullptr));
+    REQUIRE(inner.awaitDone(nullptr));
+    CHECK_EQ(recordedStacks[0], pooled);
+    CHECK_NE(recordedStacks[1], pooled);
+    CHECK_NE(recordedStacks[1], nullptr);
+
+    nestedExecutor = nullptr;
+    TaskScheduler::setGlobal(nullptr);
+}
+
+TEST_CASE("[RawTask] cancelled tasks never start, nor do the tasks they started") {
+    QueueScheduler host{};
+    const TaskScheduler scheduler = host.asScheduler();
+    TaskScheduler::setGlobal(&scheduler);
+    sideEffectSum.store(0);
+    const Function<void(int32_t)> adder(addToSum);
+    adderFunction = &adder;
+
+    RawTask cancelled = startTask(adder, int32_t{1});
+    RawTask kept = startTask(adder, int32_t{2});
+    cancelled.cancel();
+    host.queued[0].run();
+    host.queued[1].run();
+    auto res = cancelled.awaitDone(nullptr);
+    REQUIRE(res.hasErr());
+    CHECK_EQ(res.takeErr().exceptional().value(), Exceptional::Cancelled);
+    REQUIRE(kept.awaitDone(nullptr));
+    CHECK_EQ(sideEffectSum.load(), 2);
+
+    // Tasks created while a task was running are cancelled along with it, even once it's done.
+    const Function<void(int32_t)> starter(startAdder);
+    RawTask parent = startTask(starter, int32_t{4});
+    host.queued[2].run();
+    REQUIRE_EQ(startedTasks.size(), 1);
+    parent.cancel();
+    host.queued[3].run();
+    CHECK(parent.awaitDone(nullptr));
+    auto childRes = startedTasks[0].awaitDone(nullptr);
+    REQUIRE(childRes.hasErr());
+    CHECK_EQ(childRes.takeErr().exceptional().value(), Exceptional::Cancelled);
+    CHECK_EQ(sideEffectSum.load(), 2);
+    startedTasks.clear();
+
+    // As are tasks created after it was cancelled.
+    const Function<void(int32_t)> selfCanceller(cancelThenStartAdder);
+    RawTask selfCancelled = startTask(selfCanceller, int32_t{16});
+    selfCancelledTask = &selfCancelled;
+    host.queued[4].run();
+    REQUIRE_EQ(startedTasks.size(), 1);
+    host.queued[5].run();
+    CHECK(selfCancelled.awaitDone(nullptr));
+    auto lateRes = startedTasks[0].awaitDone(nullptr);
+    REQUIRE(lateRes.hasErr());
+    CHECK_EQ(lateRes.takeErr().exceptional().value(), Exceptional::Cancelled);
+    CHECK_EQ(sideEffectSum.load(), 2);
+    startedTasks.clear();
+    selfCancelledTask = nullptr;
+
+    {
+        // Dropping a cancelled task discards it, rather than being a fatal error.
+        RawTask dropped = startTask(adder, int32_t{8});
+        dropped.cancel();
+        host.queued[6].run();
+    }
+    CHECK_EQ(sideEffectSum.load(), 2);
+
+    adderFunction = nullptr;
+    TaskScheduler::setGlobal(nullptr);
+}
+
+TEST_CASE("[RawTask] cancelling a task stops its scripts, and those of the tasks it started") {
+    const Function<void()> count(countSpin);
+    operators::CallImmediateNoReturn call{};
+    call.reserveOpcode = static_cast<uint64_t>(operators::CallImmediateNoReturn::OPCODE);
+    call.argCount = 0;
+    Bytecode countPtr;
+    countPtr.value = reinterpret_cast<uint64_t>(&count);
+    // while (true) { countSpin(); }
+    const Bytecode bytecode[] = {Bytecode(call), countPtr, jump(-2),
+                                 Bytecode(makeOperands<operators::Return>())};
+    TestScriptFunction script(bytecode, 4, 2, nullptr, "test.spin");
+    const RawFunction& function = script.function;
+
+    REQUIRE(TaskPool::start(2));
+    {
+        spinIterations.store(0);
+        auto taskRes = function.startCall().callParallel();
+        REQUIRE(taskRes);
+        RawTask spinning = taskRes.takeValue();
+        while (spinIterations.load() == 0) {
+            std::this_thread::yield();
+        }
+        spinning.cancel();
+        auto res = spinning.awaitDone(nullptr);
+        REQUIRE(res.hasErr());
+        CHECK_EQ(res.takeErr().exceptional().value(), Exceptional::Cancelled);
+    }
+    {
+        // The parent is a C function, so only its child notices, failing the parent in turn.
+        spinFunction = &function;
+        spinIterations.store(0);
+        const Function<void()> awaitChild(awaitSpinningChild);
+        RawTask parent = startTask(awaitChild);
+        while (spinIterations.load() == 0) {
+            std::this_thread::yield();
+        }
+        parent.cancel();
+        auto res = parent.awaitDone(nullptr);
+        REQUIRE(res.hasErr());
+        CHECK_EQ(res.takeErr().exceptional().value(), Exceptional::Cancelled);
+        spinFunction = nullptr;
+    }
+    TaskPool::shutdown();
+}
+
+#if SY_JIT_SUPPORTED
+TEST_CASE("[RawTask] cancelling a task stops its natively compiled loops") {
+    // while (true) {}, which natively compiled would never check for cancellation.
+    const Bytecode loopBytecode[] = {Bytecode(), jump(-1),
+                                     Bytecode(makeOperands<operators::Return>())};
+    TestScriptFunction loop(loopBytecode, 3, 2, nullptr, "test.loop");
+    JitFunctionState jit{};
+    loop.info.jit = &jit;
+    REQUIRE(jit.compile(&loop.info));
+
+    const Function<void()> count(countSpin);
+    auto call = makeOperands<operators::CallImmediateNoReturn>();
+    call.argCount = 0;
+    Bytecode countPtr;
+    countPtr.value = reinterpret_cast<uint64_t>(&count);
+    Bytecode loopPtr;
+    loopPtr.value = reinterpret_cast<uint64_t>(&loop.function);
+    // countSpin(); loop();
+    const Bytecode bytecode[] = {Bytecode(call), countPtr, Bytecode(call), loopPtr,
+                                 Bytecode(makeOperands<operators::Return>())};
+    TestScriptFunction script(bytecode, 5, 2, nullptr, "test.startLoop");
+
+    REQUIRE(TaskPool::start(1));
+    spinIterations.store(0);
+    auto taskRes = script.function.startCall().callParallel();
+    REQUIRE(taskRes);
+    RawTask task = taskRes.takeValue();
+    while (spinIterations.load() == 0) {
+        std::this_thread::yield();
+    }
+    task.cancel();
+    auto res = task.awaitDone(nullptr);
+    REQUIRE(res.hasErr());
+    CHECK_EQ(res.takeErr().exceptional().value(), Exceptional::Cancelled);
+    TaskPool::shutdown();
+}
+#endif // SY_JIT_SUPPORTED
+
+#endif // SYNC_LIB_WITH_TESTS